@@ -0,0 +1,113 @@
+# Compare host benchmark results against a stored baseline.
+#
+# Both files hold lines of "<name> <ns per op> [<iterations>]" as printed by
+# tools/iaq_bench.c; lines starting with # are ignored. A benchmark fails if
+# it is more than TOLERANCE_PERCENT slower than its baseline; the default of
+# 25 % is above the run-to-run spread of the ns-scale benchmarks on a shared
+# CI host. Baselines are only comparable on the machine they were recorded
+# on; record one per CI host with UPDATE_BASELINE=ON.
+#
+# With BENCH_COMMAND the benchmark is run first and its output written to
+# RESULT_FILE, so a single ctest entry can run and compare it.
+#
+# Usage:
+#   cmake -DRESULT_FILE=<results> -DBASELINE_FILE=<baseline>
+#         [-DBENCH_COMMAND=<benchmark>] [-DTOLERANCE_PERCENT=<percent>]
+#         [-DUPDATE_BASELINE=ON] -P bench_compare.cmake
+
+cmake_minimum_required(VERSION 3.13)
+
+if (DEFINED BENCH_COMMAND)
+    execute_process(COMMAND ${BENCH_COMMAND}
+        OUTPUT_FILE "${RESULT_FILE}"
+        RESULT_VARIABLE bench_result)
+    if (NOT bench_result EQUAL 0)
+        message(FATAL_ERROR "${BENCH_COMMAND} failed: ${bench_result}")
+    endif ()
+endif ()
+if (NOT DEFINED RESULT_FILE OR NOT EXISTS "${RESULT_FILE}")
+    message(FATAL_ERROR "RESULT_FILE not found: ${RESULT_FILE}")
+endif ()
+if (NOT DEFINED BASELINE_FILE)
+    message(FATAL_ERROR "BASELINE_FILE not set")
+endif ()
+if (NOT DEFINED TOLERANCE_PERCENT)
+    set(TOLERANCE_PERCENT 25)
+endif ()
+
+# Reads a result file into <prefix>_names and <prefix>_<name> (ns per op * 100)
+function (read_results file prefix)
+    file(STRINGS "${file}" lines)
+    set(names "")
+    foreach (line IN LISTS lines)
+        if (line MATCHES "^([A-Za-z0-9_/]+)[ \t]+([0-9]+)\\.([0-9][0-9])")
+            list(APPEND names ${CMAKE_MATCH_1})
+            math(EXPR value "${CMAKE_MATCH_2} * 100 + ${CMAKE_MATCH_3}")
+            set(${prefix}_${CMAKE_MATCH_1} ${value} PARENT_SCOPE)
+        endif ()
+    endforeach ()
+    set(${prefix}_names "${names}" PARENT_SCOPE)
+endfunction ()
+
+# ns * 100 -> "ns.hh", right-aligned to 9 characters
+function (format_ns value out)
+    math(EXPR whole "${value} / 100")
+    math(EXPR frac "${value} % 100")
+    if (frac LESS 10)
+        set(frac "0${frac}")
+    endif ()
+    set(text "${whole}.${frac}")
+    string(LENGTH "${text}" len)
+    math(EXPR pad "9 - ${len}")
+    string(REPEAT " " ${pad} padding)
+    set(${out} "${padding}${text}" PARENT_SCOPE)
+endfunction ()
+
+if (UPDATE_BASELINE)
+    file(READ "${RESULT_FILE}" results)
+    file(WRITE "${BASELINE_FILE}" "${results}")
+    message(STATUS "Baseline written to ${BASELINE_FILE}")
+    return()
+endif ()
+if (NOT EXISTS "${BASELINE_FILE}")
+    message(FATAL_ERROR "BASELINE_FILE not found: ${BASELINE_FILE}")
+endif ()
+
+read_results("${RESULT_FILE}" result)
+read_results("${BASELINE_FILE}" base)
+
+set(regressed FALSE)
+message(STATUS "Benchmark                baseline       now  change")
+foreach (name IN LISTS result_names)
+    format_ns(${result_${name}} now)
+    string(LENGTH "${name}" name_len)
+    math(EXPR pad "24 - ${name_len}")
+    string(REPEAT " " ${pad} padding)
+    if (NOT DEFINED base_${name})
+        message(STATUS "${name}${padding}        - ${now}  new")
+        continue()
+    endif ()
+
+    format_ns(${base_${name}} base)
+    if (base_${name} GREATER 0)
+        math(EXPR change "(${result_${name}} - ${base_${name}}) * 100 / ${base_${name}}")
+    else ()
+        set(change 0)
+    endif ()
+    set(status "")
+    if (change GREATER TOLERANCE_PERCENT)
+        set(status "  REGRESSION")
+        set(regressed TRUE)
+    endif ()
+    message(STATUS "${name}${padding}${base} ${now}  ${change} %${status}")
+endforeach ()
+
+foreach (name IN LISTS base_names)
+    if (NOT DEFINED result_${name})
+        message(WARNING "Benchmark ${name} is in the baseline but was not run")
+    endif ()
+endforeach ()
+
+if (regressed)
+    message(FATAL_ERROR "Benchmarks more than ${TOLERANCE_PERCENT} % slower than ${BASELINE_FILE}")
+endif ()
@@ -0,0 +1,260 @@
+# Check the flash and RAM use of a linked image against its budget.
+#
+# Sums the allocated output sections of a GNU ld map file (SES or CMake
+# build). Sections in RAM count as RAM; sections with a load address in
+# flash (.data) count against both. The SoftDevice reservations
+# (.reserved_flash/.reserved_ram) are not part of the application.
+#
+# With BASELINE_FILE, the input sections are also attributed to subsystems by
+# object file name and compared against the per-subsystem baseline and budget
+# in that file (see subsystem_budget.txt). UPDATE_BASELINE=ON rewrites the
+# baseline columns from this map and keeps the budgets.
+#
+# Usage:
+#   cmake -DMAP_FILE=<file.map> -DFLASH_BUDGET=<bytes> -DRAM_BUDGET=<bytes>
+#         [-DFLASH_END_MAX=<address>]
+#         [-DBASELINE_FILE=<subsystem_budget.txt> [-DUPDATE_BASELINE=ON]]
+#         -P check_map_budget.cmake
+#
+# A budget of 0 disables that check. Fails the build if a budget is exceeded.
+# FLASH_END_MAX is the first address the linker's FLASH region must not reach
+# (the IAQ flash store, app_iaq_store.h); it is read from the map's memory
+# configuration, so a linker script or SES project that still covers the
+# store fails even while the code is small.
+
+cmake_minimum_required(VERSION 3.13)
+
+if (NOT DEFINED MAP_FILE OR NOT EXISTS "${MAP_FILE}")
+    message(FATAL_ERROR "MAP_FILE not found: ${MAP_FILE}")
+endif ()
+if (NOT DEFINED FLASH_BUDGET)
+    set(FLASH_BUDGET 0)
+endif ()
+if (NOT DEFINED RAM_BUDGET)
+    set(RAM_BUDGET 0)
+endif ()
+if (NOT DEFINED FLASH_END_MAX)
+    set(FLASH_END_MAX 0)
+endif ()
+
+set(RAM_BASE 0x20000000)
+
+# Object file -> subsystem, first match wins. SDK libraries come before the
+# application so app_timer.o and friends are not counted as application code.
+set(SUBSYSTEM_RULES
+    "iaq_lib=^(lib_iaq_2nd_gen\\.a|zmod4xxx|zmod_helper|hs[34x]xxx)"
+    "sdk=^(app_timer|app_scheduler|app_fifo|app_uart|app_error|app_util_platform|nrfx_|nrf_drv_|nrf_sdh|nrf_log|nrf_balloc|nrf_memobj|nrf_ringbuf|nrf_atomic|nrf_fprintf|nrf_pwr_mgmt|nrf_section_iter|nrf_strerror|ble_)"
+    "app=^(main|mesh_vendor_model|mesh_vendor_client|app_|iaq_sample|iaq_codec|iaq_history|iaq_bulk|iaq_ext|env_input|twi_budget|twi_bus|power_model|node_table|publish_retry|sensor_cadence|ble_softdevice_support|mesh_provisionee|mesh_app_utils|simple_hal|rtt_input|mesh_adv|assertion_handler_weak)\\."
+    "access=^(access|device_state_manager|composition_data|mesh_config|mesh_opt|nrf_mesh_opt|flash_manager|mesh_flash|nrf_flash|mesh_stack|mesh_mem_stdlib)"
+    "models=^(config_server|health_server|sensor_setup_server|model_common|packed_index_list)\\."
+    "friendship=^(friend|core_tx_friend|lpn|core_tx_lpn|mesh_lpn_subman)"
+    "prov=^(prov|nrf_mesh_prov|provisioning)"
+    "gatt=^(mesh_gatt|proxy)"
+    "bearer=^(ad_listener|ad_type_filter|adv_packet_filter|advertiser|bearer_handler|broadcast|filter_engine|gap_address_filter|radio_config|rssi_filter|scanner|mesh_pa_lna)\\."
+    "crypto=^(uECC|aes|ccm_soft|enc|nrf_mesh_keygen)\\."
+    "rtt=^SEGGER_RTT"
+    "libc=\\.a\\("
+    "startup=^(thumb_crt0|ses_startup|system_nrf52|gcc_startup)"
+    "core=\\.o(bj)?$")
+
+file(READ "${MAP_FILE}" map_content)
+string(FIND "${map_content}" "Linker script and memory map" map_start)
+if (map_start EQUAL -1)
+    message(FATAL_ERROR "${MAP_FILE} does not look like a GNU ld map file")
+endif ()
+
+# FLASH region as the linker saw it: "FLASH <origin> <length> <attributes>"
+set(flash_region_error FALSE)
+if (FLASH_END_MAX)
+    string(SUBSTRING "${map_content}" 0 ${map_start} memory_configuration)
+    if (NOT memory_configuration MATCHES "\nFLASH[ ]+(0x[0-9a-fA-F]+)[ ]+(0x[0-9a-fA-F]+)")
+        message(FATAL_ERROR "${MAP_FILE}: no FLASH region in the memory configuration")
+    endif ()
+    math(EXPR flash_region_end "${CMAKE_MATCH_1} + ${CMAKE_MATCH_2}")
+    math(EXPR flash_end_max "${FLASH_END_MAX}")
+    if (flash_region_end GREATER flash_end_max)
+        set(flash_region_error TRUE)
+        math(EXPR flash_region_end "${flash_region_end}" OUTPUT_FORMAT HEXADECIMAL)
+        math(EXPR flash_end_max "${flash_end_max}" OUTPUT_FORMAT HEXADECIMAL)
+    endif ()
+endif ()
+
+string(SUBSTRING "${map_content}" ${map_start} -1 map_content)
+
+# Output sections start in column 0. Names longer than the address column put
+# the address on the next line.
+string(REGEX MATCHALL
+    "\n\\.[A-Za-z0-9_.]+[ \n]+0x[0-9a-fA-F]+[ ]+0x[0-9a-fA-F]+( load address 0x[0-9a-fA-F]+)?"
+    sections "${map_content}")
+
+set(flash_used 0)
+set(ram_used 0)
+
+foreach (section IN LISTS sections)
+    string(REGEX REPLACE "[ \n]+" ";" fields "${section}")
+    list(FILTER fields EXCLUDE REGEX "^$")
+    list(GET fields 0 name)
+    list(GET fields 1 address)
+    list(GET fields 2 size)
+
+    if (name MATCHES "^\\.reserved_" OR size MATCHES "^0x0+$" OR address MATCHES "^0x0+$")
+        continue()
+    endif ()
+
+    math(EXPR address_value "${address}")
+    math(EXPR size_value "${size}")
+    if (address_value GREATER_EQUAL ${RAM_BASE})
+        math(EXPR ram_used "${ram_used} + ${size_value}")
+        if (section MATCHES "load address")
+            math(EXPR flash_used "${flash_used} + ${size_value}")
+        endif ()
+    else ()
+        math(EXPR flash_used "${flash_used} + ${size_value}")
+    endif ()
+endforeach ()
+
+get_filename_component(map_name "${MAP_FILE}" NAME)
+message(STATUS "${map_name}: flash ${flash_used} / ${FLASH_BUDGET} bytes, RAM ${ram_used} / ${RAM_BUDGET} bytes")
+
+set(over_budget FALSE)
+if (flash_region_error)
+    message(SEND_ERROR "${map_name}: FLASH region ends at ${flash_region_end}, past ${flash_end_max}")
+    set(over_budget TRUE)
+endif ()
+if (FLASH_BUDGET GREATER 0 AND flash_used GREATER FLASH_BUDGET)
+    message(SEND_ERROR "${map_name}: flash use ${flash_used} exceeds budget ${FLASH_BUDGET}")
+    set(over_budget TRUE)
+endif ()
+if (RAM_BUDGET GREATER 0 AND ram_used GREATER RAM_BUDGET)
+    message(SEND_ERROR "${map_name}: RAM use ${ram_used} exceeds budget ${RAM_BUDGET}")
+    set(over_budget TRUE)
+endif ()
+
+if (DEFINED BASELINE_FILE)
+    set(subsystems "")
+    foreach (rule IN LISTS SUBSYSTEM_RULES)
+        string(REGEX REPLACE "=.*" "" subsystem "${rule}")
+        list(APPEND subsystems ${subsystem})
+        set(flash_${subsystem} 0)
+        set(ram_${subsystem} 0)
+    endforeach ()
+    list(APPEND subsystems other)
+    set(flash_other 0)
+    set(ram_other 0)
+
+    # Input sections are indented by one space; the object file ends the line
+    string(REGEX MATCHALL
+        "\n [.A-Z][^ \n]*[ \n]+0x[0-9a-fA-F]+[ ]+0x[0-9a-fA-F]+ [^\n]+"
+        input_sections "${map_content}")
+
+    # Merged string sections (.str1.*) are listed with their pre-merge size
+    # and overlap what follows; clip each entry at the start of the next one.
+    list(APPEND input_sections "\n .end 0x0 0x0 end")
+    set(pending_size 0)
+    foreach (input IN LISTS input_sections)
+        if (NOT input MATCHES "^\n ([^ \n]+)[ \n]+(0x[0-9a-fA-F]+)[ ]+(0x[0-9a-fA-F]+) (.+)$")
+            continue()
+        endif ()
+        set(name "${CMAKE_MATCH_1}")
+        set(object "${CMAKE_MATCH_4}")
+        math(EXPR address_value "${CMAKE_MATCH_2}")
+        math(EXPR size_value "${CMAKE_MATCH_3}")
+
+        if (name MATCHES "^\\.(debug|comment|ARM\\.attributes)" OR
+            (address_value EQUAL 0 AND NOT name STREQUAL ".end"))
+            continue()
+        endif ()
+
+        if (pending_size GREATER 0)
+            math(EXPR pending_end "${pending_address} + ${pending_size}")
+            if (address_value GREATER_EQUAL pending_address AND address_value LESS pending_end)
+                math(EXPR pending_size "${address_value} - ${pending_address}")
+            endif ()
+
+            if (pending_address GREATER_EQUAL ${RAM_BASE})
+                math(EXPR ram_${pending_subsystem} "${ram_${pending_subsystem}} + ${pending_size}")
+                # Initialized RAM also occupies flash for its load image
+                if (NOT pending_name MATCHES "^(\\.bss|\\.tbss|\\.non_init|\\.noinit|COMMON)")
+                    math(EXPR flash_${pending_subsystem} "${flash_${pending_subsystem}} + ${pending_size}")
+                endif ()
+            else ()
+                math(EXPR flash_${pending_subsystem} "${flash_${pending_subsystem}} + ${pending_size}")
+            endif ()
+        endif ()
+
+        string(REGEX REPLACE "^.*[/\\\\]" "" object "${object}")
+        set(subsystem other)
+        foreach (rule IN LISTS SUBSYSTEM_RULES)
+            string(REGEX REPLACE "=.*" "" rule_name "${rule}")
+            string(REGEX REPLACE "^[^=]*=" "" rule_regex "${rule}")
+            if (object MATCHES "${rule_regex}")
+                set(subsystem ${rule_name})
+                break()
+            endif ()
+        endforeach ()
+
+        set(pending_name "${name}")
+        set(pending_address ${address_value})
+        set(pending_size ${size_value})
+        set(pending_subsystem ${subsystem})
+    endforeach ()
+
+    # Baseline rows: <subsystem> <flash> <ram> <flash budget> <ram budget>
+    set(baseline_header "")
+    if (EXISTS "${BASELINE_FILE}")
+        file(STRINGS "${BASELINE_FILE}" baseline_lines)
+        foreach (line IN LISTS baseline_lines)
+            if (line MATCHES "^#" OR line STREQUAL "")
+                string(APPEND baseline_header "${line}\n")
+            elseif (line MATCHES "^([a-z_]+)[ \t]+([0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)")
+                set(base_flash_${CMAKE_MATCH_1} ${CMAKE_MATCH_2})
+                set(base_ram_${CMAKE_MATCH_1} ${CMAKE_MATCH_3})
+                set(budget_flash_${CMAKE_MATCH_1} ${CMAKE_MATCH_4})
+                set(budget_ram_${CMAKE_MATCH_1} ${CMAKE_MATCH_5})
+            endif ()
+        endforeach ()
+    endif ()
+
+    message(STATUS "Subsystem         flash (delta)        RAM (delta)       budget flash/RAM")
+    set(baseline_out "${baseline_header}")
+    foreach (subsystem IN LISTS subsystems)
+        set(flash ${flash_${subsystem}})
+        set(ram ${ram_${subsystem}})
+        if (NOT DEFINED base_flash_${subsystem})
+            set(base_flash_${subsystem} 0)
+            set(base_ram_${subsystem} 0)
+            # New subsystem: budget it at its current size plus 10 %
+            math(EXPR budget_flash_${subsystem} "${flash} + ${flash} / 10")
+            math(EXPR budget_ram_${subsystem} "${ram} + ${ram} / 10")
+        endif ()
+        math(EXPR flash_delta "${flash} - ${base_flash_${subsystem}}")
+        math(EXPR ram_delta "${ram} - ${base_ram_${subsystem}}")
+
+        set(row "${subsystem}")
+        string(LENGTH "${row}" row_len)
+        math(EXPR pad "12 - ${row_len}")
+        string(REPEAT " " ${pad} padding)
+        message(STATUS "${row}${padding}${flash} (${flash_delta})\t${ram} (${ram_delta})\t${budget_flash_${subsystem}}/${budget_ram_${subsystem}}")
+
+        if (flash GREATER ${budget_flash_${subsystem}})
+            message(SEND_ERROR "${map_name}: ${subsystem} flash ${flash} exceeds budget ${budget_flash_${subsystem}}")
+            set(over_budget TRUE)
+        endif ()
+        if (ram GREATER ${budget_ram_${subsystem}})
+            message(SEND_ERROR "${map_name}: ${subsystem} RAM ${ram} exceeds budget ${budget_ram_${subsystem}}")
+            set(over_budget TRUE)
+        endif ()
+
+        string(APPEND baseline_out
+            "${subsystem}${padding}${flash}\t${ram}\t${budget_flash_${subsystem}}\t${budget_ram_${subsystem}}\n")
+    endforeach ()
+
+    if (UPDATE_BASELINE)
+        file(WRITE "${BASELINE_FILE}" "${baseline_out}")
+        message(STATUS "Baseline written to ${BASELINE_FILE}")
+    endif ()
+endif ()
+
+if (over_budget)
+    message(FATAL_ERROR "Image over budget")
+endif ()
@@ -0,0 +1,81 @@
+# Stack usage report from GCC -fstack-usage output.
+#
+# Collects the .su files below SU_DIR and lists the frames of the functions
+# matching FUNCTION_REGEX (by default the app_scheduler and timer handlers),
+# largest first. Frame sizes are per function; callees are not included, so
+# treat them as a lower bound on the stack a handler needs.
+#
+# Usage:
+#   cmake -DSU_DIR=<object dir> [-DFUNCTION_REGEX=<regex>] [-DREPORT_FILE=<file>]
+#         [-DSTACK_LIMIT=<bytes>] -P stack_usage_report.cmake
+#
+# STACK_LIMIT fails the build if any listed frame is larger.
+
+cmake_minimum_required(VERSION 3.13)
+
+if (NOT DEFINED SU_DIR OR NOT IS_DIRECTORY "${SU_DIR}")
+    message(FATAL_ERROR "SU_DIR not found: ${SU_DIR}")
+endif ()
+if (NOT DEFINED FUNCTION_REGEX)
+    set(FUNCTION_REGEX "(^scheduled_|_handler$|_handle$|_cb$)")
+endif ()
+if (NOT DEFINED STACK_LIMIT)
+    set(STACK_LIMIT 0)
+endif ()
+
+file(GLOB_RECURSE su_files "${SU_DIR}/*.su")
+if (NOT su_files)
+    message(WARNING "No .su files below ${SU_DIR}; was the build done with -fstack-usage?")
+    return()
+endif ()
+
+# Sort key is the zero-padded frame size so the list can be sorted as strings
+set(entries "")
+foreach (su_file IN LISTS su_files)
+    file(STRINGS "${su_file}" lines)
+    foreach (line IN LISTS lines)
+        # <file>:<line>:<col>:<function>\t<bytes>\t<static|dynamic|dynamic,bounded>
+        if (NOT line MATCHES "^(.*):([0-9]+):[0-9]+:([^\t]+)\t([0-9]+)\t(.+)$")
+            continue()
+        endif ()
+        set(file "${CMAKE_MATCH_1}")
+        set(line_no "${CMAKE_MATCH_2}")
+        set(function "${CMAKE_MATCH_3}")
+        set(bytes "${CMAKE_MATCH_4}")
+        set(kind "${CMAKE_MATCH_5}")
+        if (NOT function MATCHES "${FUNCTION_REGEX}")
+            continue()
+        endif ()
+        get_filename_component(file "${file}" NAME)
+        string(LENGTH "${bytes}" bytes_len)
+        math(EXPR pad "8 - ${bytes_len}")
+        string(REPEAT "0" ${pad} key)
+        list(APPEND entries "${key}${bytes}|${function}|${file}:${line_no}|${kind}")
+    endforeach ()
+endforeach ()
+
+list(SORT entries ORDER DESCENDING)
+
+set(report "Stack frames of handlers matching ${FUNCTION_REGEX} (bytes, callees excluded)\n")
+set(over_limit FALSE)
+foreach (entry IN LISTS entries)
+    string(REPLACE "|" ";" fields "${entry}")
+    list(GET fields 0 bytes)
+    list(GET fields 1 function)
+    list(GET fields 2 location)
+    list(GET fields 3 kind)
+    math(EXPR bytes "${bytes}")
+    string(APPEND report "${bytes}\t${kind}\t${function}\t${location}\n")
+    if (STACK_LIMIT GREATER 0 AND bytes GREATER STACK_LIMIT)
+        message(SEND_ERROR "${function} (${location}) uses ${bytes} bytes of stack, limit ${STACK_LIMIT}")
+        set(over_limit TRUE)
+    endif ()
+endforeach ()
+
+message(STATUS "${report}")
+if (DEFINED REPORT_FILE)
+    file(WRITE "${REPORT_FILE}" "${report}")
+endif ()
+if (over_limit)
+    message(FATAL_ERROR "Handler stack frame over limit")
+endif ()
@@ -62,9 +62,43 @@
 #define APP_TIMER_ENABLED 1
 #define APP_TIMER_KEEPS_RTC_ACTIVE 1
 
+/** Replaced by the priority scheduler in app_sched_prio.c. */
+#define APP_SCHEDULER_ENABLED 0
+
 #define GPIOTE_ENABLED 1
 #define GPIOTE_CONFIG_NUM_OF_LOW_POWER_EVENTS 4
 
 /** @} end of APP_SDK_CONFIG */
 
+/**
+ * @defgroup APP_FEATURE_CONFIG Node role
+ *
+ * A sensor node samples the ZMOD4410 and publishes; a gateway receives and
+ * forwards over UART. The combined build does both. Drivers for a disabled
+ * role are compiled out of the SDK as well.
+ *
+ * @{
+ */
+#ifndef APP_FEATURE_SENSOR
+#define APP_FEATURE_SENSOR 1
+#endif
+
+#ifndef APP_FEATURE_GATEWAY
+#define APP_FEATURE_GATEWAY 1
+#endif
+
+#if !APP_FEATURE_SENSOR
+#define TWI_ENABLED 0
+#define TWI0_ENABLED 0
+#endif
+
+#if !APP_FEATURE_GATEWAY
+#define UART_ENABLED 0
+#define UART0_ENABLED 0
+#define APP_UART_ENABLED 0
+#define APP_FIFO_ENABLED 0
+#endif
+
+/** @} end of APP_FEATURE_CONFIG */
+
 #endif /* APP_CONFIG_H__ */
@@ -60,6 +60,70 @@
 
 /** The maximum message size in bytes. */
 #define APP_CONFIG_MAX_MESSAGE_BYTES           (256)
+
+/**
+ * Node profile.
+ *
+ * 0: mains-powered node (relay, GATT proxy, Friend for battery sensors).
+ * 1: battery sensor as Low Power Node. Relay and Friend are compiled out and the
+ *    scanner only runs in the receive windows after polling the Friend.
+ *
+ * Selected by the "LPN" build configurations of the SES project.
+ */
+#ifndef APP_PROFILE_LPN
+#define APP_PROFILE_LPN                (0)
+#endif
+
+/**
+ * Gateway sizing profile.
+ *
+ * 0: buffers and caches sized for a handful of nodes.
+ * 1: high-throughput gateway. Replay cache, message cache, scanner buffer,
+ *    SAR sessions, scheduler queue and UART FIFO are derived from the expected
+ *    number of nodes and their publish rate below. Costs RAM; check the
+ *    high-watermarks logged by app_buffer_stats before shrinking anything.
+ */
+#ifndef APP_PROFILE_GATEWAY_HT
+#define APP_PROFILE_GATEWAY_HT         (0)
+#endif
+
+#if APP_PROFILE_GATEWAY_HT
+/** Number of sensor nodes publishing to this gateway. */
+#ifndef APP_GATEWAY_NODE_COUNT
+#define APP_GATEWAY_NODE_COUNT         (200)
+#endif
+/** Messages per node per minute (sensor values, history and power status). */
+#ifndef APP_GATEWAY_MSG_PER_NODE_PER_MIN
+#define APP_GATEWAY_MSG_PER_NODE_PER_MIN (6)
+#endif
+/** Nodes sharing one publish group address. */
+#ifndef APP_GATEWAY_NODES_PER_GROUP
+#define APP_GATEWAY_NODES_PER_GROUP    (32)
+#endif
+/** History backfills (segmented) the gateway accepts at the same time; each
+ * node has up to IAQ_BULK_WINDOW (iaq_bulk.h) of them in flight. */
+#ifndef APP_GATEWAY_BACKFILL_PARALLEL
+#define APP_GATEWAY_BACKFILL_PARALLEL  (4)
+#endif
+/** Longest time the main loop may not run (flash erase, UART burst). */
+#ifndef APP_GATEWAY_STALL_MS
+#define APP_GATEWAY_STALL_MS           (100)
+#endif
+/** Publications are not synchronized, but the peak rate is assumed to reach
+ * this multiple of the mean over a stall. */
+#ifndef APP_GATEWAY_BURST_FACTOR
+#define APP_GATEWAY_BURST_FACTOR       (4)
+#endif
+
+/** Mean aggregate message rate in messages per 10 s. */
+#define APP_GATEWAY_MSG_PER_10S        ((APP_GATEWAY_NODE_COUNT * APP_GATEWAY_MSG_PER_NODE_PER_MIN) / 6)
+/** Messages arriving during one stall at the peak rate. */
+#define APP_GATEWAY_BURST_MSGS         (1 + (APP_GATEWAY_MSG_PER_10S * APP_GATEWAY_BURST_FACTOR * \
+                                             APP_GATEWAY_STALL_MS) / 10000)
+/** Publish groups the gateway subscribes to. */
+#define APP_GATEWAY_GROUP_COUNT        ((APP_GATEWAY_NODE_COUNT + APP_GATEWAY_NODES_PER_GROUP - 1) / \
+                                        APP_GATEWAY_NODES_PER_GROUP)
+#endif
 /** @} end of APP_SPECIFIC_DEFINES */
 
 /**
@@ -97,6 +161,7 @@
  */
 #define ACCESS_MODEL_COUNT (1 + /* Configuration server */  \
                             1 + /* Health server */  \
+                            1 + /* IAQ vendor model */  \
                             2   /* Sensor server and setup server */ )
 
 
@@ -114,14 +179,16 @@
  * @note This value must equal @ref ACCESS_MODEL_COUNT minus the number of
  * models operating on shared states.
  */
-#define ACCESS_SUBSCRIPTION_LIST_COUNT (2)
+#define ACCESS_SUBSCRIPTION_LIST_COUNT (2) /* Vendor model, sensor server (shared with setup) */
 
 /**
  * @defgroup ACCESS_RELIABLE_CONFIG Configuration of access layer reliable transfer
  * @{
  */
 
-/** Number of the allowed parallel transfers (size of the internal context pool). */
+/** Number of the allowed parallel transfers (size of the internal context pool).
+ * Only transfers this node originates use a context, so the gateway profile
+ * does not scale it with the node count. */
 #define ACCESS_RELIABLE_TRANSFER_COUNT (ACCESS_MODEL_COUNT)
 
 /** @} end of ACCESS_RELIABLE_CONFIG */
@@ -153,7 +220,12 @@
 /** Maximum number of virtual addresses. */
 #define DSM_VIRTUAL_ADDR_MAX                            (1)
 /** Maximum number of non-virtual addresses. One for each of the servers and a group address. */
+#if APP_PROFILE_GATEWAY_HT
+/** The gateway subscribes to every publish group. */
+#define DSM_NONVIRTUAL_ADDR_MAX                         (ACCESS_MODEL_COUNT + APP_GATEWAY_GROUP_COUNT)
+#else
 #define DSM_NONVIRTUAL_ADDR_MAX                         (ACCESS_MODEL_COUNT + 1)
+#endif
 /** @} end of DSM_CONFIG */
 
 /** @} */
@@ -175,6 +247,49 @@
 #define MESH_FEATURE_GATT_PROXY_ENABLED                 (1)
 /** @} end of MESH_CONFIG_GATT */
 
+/**
+ * @defgroup MESH_CONFIG_FRIENDSHIP Friendship configuration defines
+ * @{
+ */
+#if APP_PROFILE_LPN
+/** LPN feature. */
+#define MESH_FEATURE_LPN_ENABLED                        (1)
+/** A node cannot be a Friend and an LPN at the same time. */
+#define MESH_FEATURE_FRIEND_ENABLED                     (0)
+/** Relaying would keep the scanner on. */
+#define MESH_FEATURE_RELAY_ENABLED                      (0)
+#else
+#define MESH_FEATURE_LPN_ENABLED                        (0)
+/** Friend feature. To be enabled only in combination with linking the friend files. */
+#define MESH_FEATURE_FRIEND_ENABLED                     (1)
+/** Number of LPNs this node can be Friend to at the same time. */
+#define MESH_FRIEND_FRIENDSHIP_COUNT                    (2)
+/** Friend queue size per friendship. Must hold every sensor message that
+ * arrives for a sleeping LPN within one poll interval. */
+#define MESH_FRIEND_QUEUE_SIZE                          (16)
+#endif
+/** @} end of MESH_CONFIG_FRIENDSHIP */
+
+#if APP_PROFILE_GATEWAY_HT
+/**
+ * @defgroup MESH_CONFIG_GATEWAY_HT Network and bearer sizing for the gateway profile
+ * @{
+ */
+/** Every source needs its own replay protection entry; messages from sources
+ * beyond the cache size are dropped. Spare entries cover the provisioner and
+ * replaced nodes. */
+#define REPLAY_CACHE_ENTRIES                            (APP_GATEWAY_NODE_COUNT + 8)
+/** The network message cache must remember each packet until relayed copies
+ * stop arriving, about two seconds with a few relay hops. */
+#define MSG_CACHE_ENTRY_COUNT                           (32 + (APP_GATEWAY_MSG_PER_10S * APP_GATEWAY_BURST_FACTOR) / 5)
+/** Scanner packet buffer: a burst of advertisements, each received up to
+ * three times through relays, at about 48 bytes per buffered packet. */
+#define SCANNER_BUFFER_SIZE                             (256 + APP_GATEWAY_BURST_MSGS * 3 * 48)
+/** Segmented RX sessions: one per backfill plus two for configuration. */
+#define TRANSPORT_SAR_SESSIONS_MAX                      (APP_GATEWAY_BACKFILL_PARALLEL + 2)
+/** @} end of MESH_CONFIG_GATEWAY_HT */
+#endif
+
 /**
  * @defgroup BLE_SOFTDEVICE_SUPPORT_CONFIG BLE SoftDevice support module configuration.
  * @ingroup MESH_API_GROUP_APP_SUPPORT
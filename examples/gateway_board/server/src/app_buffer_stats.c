@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "app_buffer_stats.h"
+#include "app_timer.h"
+#include "nrf_error.h"
+#include "scanner.h"
+#include "log.h"
+
+#include "app_uart_gateway.h"
+#include "app_sched_prio.h"
+
+#if APP_BUFFER_STATS_REPORT_INTERVAL_MS
+APP_TIMER_DEF(m_report_timer_id);
+
+static void scheduled_buffer_report_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)p_event_data;
+    (void)event_size;
+    app_buffer_stats_log();
+}
+
+static void report_timer_handler(void * p_context)
+{
+    (void)p_context;
+    (void)APP_SCHED_PUT(APP_SCHED_CLASS_BACKGROUND, NULL, 0, scheduled_buffer_report_handler);
+}
+#endif
+
+void app_buffer_stats_init(void)
+{
+#if APP_BUFFER_STATS_REPORT_INTERVAL_MS
+    ret_code_t rc = app_timer_create(&m_report_timer_id, APP_TIMER_MODE_REPEATED, report_timer_handler);
+    if (rc == NRF_SUCCESS)
+    {
+        rc = app_timer_start(m_report_timer_id, APP_TIMER_TICKS(APP_BUFFER_STATS_REPORT_INTERVAL_MS), NULL);
+    }
+    if (rc != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Buffer stats timer failed: 0x%x\n", rc);
+    }
+#endif
+}
+
+void app_buffer_stats_get(app_buffer_stats_t * p_stats)
+{
+    memset(p_stats, 0, sizeof(*p_stats));
+
+    p_stats->scanner_dropped = scanner_stats_get()->out_of_memory;
+
+    app_uart_gateway_fifo_stats_get(&p_stats->uart_max, &p_stats->uart_size, &p_stats->uart_dropped);
+}
+
+void app_buffer_stats_log(void)
+{
+    app_buffer_stats_t stats;
+    app_buffer_stats_get(&stats);
+
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO,
+          "Buffers: scanner dropped %u, uart %u/%u dropped %u\n",
+          stats.scanner_dropped,
+          stats.uart_max, stats.uart_size, stats.uart_dropped);
+
+    if (stats.scanner_dropped > 0 || stats.uart_dropped > 0)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Messages dropped; increase the gateway sizing profile\n");
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef APP_BUFFER_STATS_H__
+#define APP_BUFFER_STATS_H__
+
+#include <stdint.h>
+
+#include "app_config.h"
+
+/*
+ * High-watermarks of the queues between the radio and the UART.
+ *
+ * Scanner packet buffer: the mesh stack does not expose its fill level, only
+ * the packets it dropped because the buffer was full.
+ * UART TX FIFO: peak bytes queued since the FIFO last ran empty (an upper
+ * bound on its fill level) and lines dropped because it was full.
+ *
+ * Scheduler queues are covered by app_sched_stats.
+ *
+ * Any non-zero drop count means the sizing profile (APP_PROFILE_GATEWAY_HT in
+ * nrf_mesh_config_app.h) is too small for the traffic.
+ */
+
+/* Interval between periodic reports on RTT; 0 reports only on request. */
+#ifndef APP_BUFFER_STATS_REPORT_INTERVAL_MS
+#if APP_FEATURE_GATEWAY
+#define APP_BUFFER_STATS_REPORT_INTERVAL_MS (60 * 1000)
+#else
+#define APP_BUFFER_STATS_REPORT_INTERVAL_MS 0
+#endif
+#endif
+
+typedef struct
+{
+    uint32_t scanner_dropped;   /* Packets dropped, scanner buffer full */
+    uint16_t uart_max;          /* UART TX FIFO high-watermark, bytes */
+    uint16_t uart_size;
+    uint16_t uart_dropped;      /* Lines dropped, UART TX FIFO full */
+} app_buffer_stats_t;
+
+/** @brief Start the periodic report, if enabled. Call after app_timer_init(). */
+void app_buffer_stats_init(void);
+
+/** @brief Snapshot of the high-watermarks and drop counters since boot. */
+void app_buffer_stats_get(app_buffer_stats_t * p_stats);
+
+/** @brief Log the current snapshot on RTT. */
+void app_buffer_stats_log(void);
+
+#endif /* APP_BUFFER_STATS_H__ */
@@ -0,0 +1,194 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "app_friendship.h"
+#include "app_timer.h"
+#include "app_sched_prio.h"
+#include "nrf_error.h"
+#include "nrf_mesh_events.h"
+#include "log.h"
+
+#include "app_power.h"
+
+#if MESH_FEATURE_LPN_ENABLED
+#include "mesh_lpn.h"
+#include "mesh_friendship_types.h"
+#if MESH_FEATURE_GATT_PROXY_ENABLED
+#include "proxy.h"
+#endif
+#endif
+
+#if MESH_FEATURE_FRIEND_ENABLED
+#include "mesh_friend.h"
+#endif
+
+static nrf_mesh_evt_handler_t m_mesh_evt_handler;
+static bool m_lpn_established;
+
+#if MESH_FEATURE_LPN_ENABLED
+APP_TIMER_DEF(m_lpn_retry_timer_id);
+static uint8_t m_receive_window_ms;
+
+static void friend_request_send(void)
+{
+    if (mesh_lpn_is_in_friendship())
+    {
+        return;
+    }
+
+    mesh_lpn_friend_request_t freq;
+    freq.friend_criteria.friend_queue_size_min_log = MESH_FRIENDSHIP_MIN_FRIEND_QUEUE_SIZE_16;
+    freq.friend_criteria.receive_window_factor = MESH_FRIENDSHIP_RECEIVE_WINDOW_FACTOR_1_0;
+    freq.friend_criteria.rssi_factor = MESH_FRIENDSHIP_RSSI_FACTOR_2_0;
+    freq.poll_timeout_ms = APP_LPN_POLL_TIMEOUT_MS;
+    freq.receive_delay_ms = APP_LPN_RECEIVE_DELAY_MS;
+
+    uint32_t status = mesh_lpn_friend_request(freq, MESH_LPN_FRIEND_REQUEST_TIMEOUT_MAX_MS);
+    if (status == NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Friend Request sent\n");
+    }
+    else
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Friend Request failed: 0x%x\n", status);
+        (void)app_timer_start(m_lpn_retry_timer_id, APP_TIMER_TICKS(APP_LPN_RETRY_INTERVAL_MS), NULL);
+    }
+}
+
+static void scheduled_friend_request(void * p_event_data, uint16_t event_size)
+{
+    (void)p_event_data;
+    (void)event_size;
+    friend_request_send();
+}
+
+static void lpn_retry_timer_handler(void * p_context)
+{
+    (void)p_context;
+    app_power_wake_mark(APP_POWER_SRC_TIMER);
+    (void)APP_SCHED_PUT(APP_SCHED_CLASS_BACKGROUND, NULL, 0, scheduled_friend_request);
+}
+
+static void lpn_evt_handle(const nrf_mesh_evt_t * p_evt)
+{
+    switch (p_evt->type)
+    {
+        case NRF_MESH_EVT_LPN_FRIEND_OFFER:
+        {
+            const nrf_mesh_evt_lpn_friend_offer_t * p_offer = &p_evt->params.friend_offer;
+            __LOG(LOG_SRC_APP, LOG_LEVEL_INFO,
+                  "Friend offer from 0x%04x: window %u ms, queue %u, rssi %d\n",
+                  p_offer->src, p_offer->offer.receive_window_ms,
+                  p_offer->offer.queue_size, p_offer->offer.measured_rssi);
+
+            m_receive_window_ms = p_offer->offer.receive_window_ms;
+            uint32_t status = mesh_lpn_friend_accept(p_offer);
+            if (status != NRF_SUCCESS)
+            {
+                __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Friend accept failed: 0x%x\n", status);
+            }
+            break;
+        }
+
+        case NRF_MESH_EVT_LPN_FRIEND_REQUEST_TIMEOUT:
+            __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "No Friend found, retrying in %u s\n",
+                  APP_LPN_RETRY_INTERVAL_MS / 1000);
+            (void)app_timer_start(m_lpn_retry_timer_id, APP_TIMER_TICKS(APP_LPN_RETRY_INTERVAL_MS), NULL);
+            break;
+
+        case NRF_MESH_EVT_FRIENDSHIP_ESTABLISHED:
+            if (p_evt->params.friendship_established.role == NRF_MESH_FRIENDSHIP_ROLE_LPN)
+            {
+                m_lpn_established = true;
+                (void)mesh_lpn_poll_interval_set(APP_LPN_POLL_INTERVAL_MS);
+#if MESH_FEATURE_GATT_PROXY_ENABLED
+                /* Connectable advertising would undo most of the savings */
+                (void)proxy_stop();
+#endif
+                /* Radio is on for roughly one receive window per poll */
+                app_power_radio_duty_set(power_model_lpn_rx_permille(m_receive_window_ms, APP_LPN_POLL_INTERVAL_MS));
+                __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Friendship established with 0x%04x\n",
+                      p_evt->params.friendship_established.friend_src);
+            }
+            break;
+
+        case NRF_MESH_EVT_FRIENDSHIP_TERMINATED:
+            if (p_evt->params.friendship_terminated.role == NRF_MESH_FRIENDSHIP_ROLE_LPN)
+            {
+                m_lpn_established = false;
+                app_power_radio_duty_set(1000);
+#if MESH_FEATURE_GATT_PROXY_ENABLED
+                (void)proxy_start();
+#endif
+                __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Friendship terminated, reason %u\n",
+                      p_evt->params.friendship_terminated.reason);
+                if (p_evt->params.friendship_terminated.reason != NRF_MESH_EVT_FRIENDSHIP_TERMINATED_REASON_USER)
+                {
+                    (void)app_timer_start(m_lpn_retry_timer_id, APP_TIMER_TICKS(APP_LPN_RETRY_INTERVAL_MS), NULL);
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+#endif /* MESH_FEATURE_LPN_ENABLED */
+
+static void mesh_evt_cb(const nrf_mesh_evt_t * p_evt)
+{
+#if MESH_FEATURE_LPN_ENABLED
+    lpn_evt_handle(p_evt);
+#else
+    switch (p_evt->type)
+    {
+        case NRF_MESH_EVT_FRIENDSHIP_ESTABLISHED:
+            __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Now Friend of LPN 0x%04x\n",
+                  p_evt->params.friendship_established.lpn_src);
+            break;
+
+        case NRF_MESH_EVT_FRIENDSHIP_TERMINATED:
+            __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Friendship with LPN 0x%04x ended, reason %u\n",
+                  p_evt->params.friendship_terminated.lpn_src,
+                  p_evt->params.friendship_terminated.reason);
+            break;
+
+        default:
+            break;
+    }
+#endif
+}
+
+void app_friendship_init(void)
+{
+    m_mesh_evt_handler.evt_cb = mesh_evt_cb;
+    nrf_mesh_evt_handler_add(&m_mesh_evt_handler);
+
+#if MESH_FEATURE_LPN_ENABLED
+    mesh_lpn_init();
+
+    ret_code_t rc = app_timer_create(&m_lpn_retry_timer_id, APP_TIMER_MODE_SINGLE_SHOT, lpn_retry_timer_handler);
+    if (rc != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "LPN timer create failed: 0x%x\n", rc);
+    }
+#endif
+}
+
+void app_friendship_start(void)
+{
+#if MESH_FEATURE_LPN_ENABLED
+    friend_request_send();
+#elif MESH_FEATURE_FRIEND_ENABLED
+    if (!mesh_friend_is_enabled())
+    {
+        mesh_friend_enable();
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Friend feature enabled\n");
+    }
+#endif
+}
+
+bool app_friendship_is_lpn_established(void)
+{
+    return m_lpn_established;
+}
@@ -0,0 +1,51 @@
+#ifndef APP_FRIENDSHIP_H__
+#define APP_FRIENDSHIP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "nrf_mesh_config_core.h"
+
+/*
+ * Friendship handling for both node profiles (see APP_PROFILE_LPN).
+ *
+ * LPN profile: once provisioned the node asks for a Friend and keeps asking
+ * until one accepts. While the friendship lasts, the scanner and the GATT
+ * proxy advertiser are off and the node polls the Friend every
+ * APP_LPN_POLL_INTERVAL_MS for queued messages (config, history requests).
+ * Publishing is unaffected; the LPN transmits directly.
+ *
+ * Mains profile: the node acts as Friend and queues messages for its LPNs.
+ */
+
+/* Time between polls to the Friend. Messages to the LPN wait this long. */
+#ifndef APP_LPN_POLL_INTERVAL_MS
+#define APP_LPN_POLL_INTERVAL_MS        (10 * 1000)
+#endif
+
+/* Friendship is terminated by the Friend if it has not been polled within
+ * this time. Must leave room for a few lost polls. */
+#ifndef APP_LPN_POLL_TIMEOUT_MS
+#define APP_LPN_POLL_TIMEOUT_MS         (4 * APP_LPN_POLL_INTERVAL_MS)
+#endif
+
+/* Delay between a friend poll and the Friend's reply. */
+#ifndef APP_LPN_RECEIVE_DELAY_MS
+#define APP_LPN_RECEIVE_DELAY_MS        (100)
+#endif
+
+/* Back-off before a new Friend Request after a timeout or a lost friendship. */
+#ifndef APP_LPN_RETRY_INTERVAL_MS
+#define APP_LPN_RETRY_INTERVAL_MS       (30 * 1000)
+#endif
+
+/** @brief Register for friendship events. Call after mesh_stack_init(). */
+void app_friendship_init(void);
+
+/** @brief Start looking for a Friend (LPN) or enable the Friend feature. Call once provisioned. */
+void app_friendship_start(void);
+
+/** @brief true if an LPN currently has a Friend. Always false in the mains profile. */
+bool app_friendship_is_lpn_established(void);
+
+#endif /* APP_FRIENDSHIP_H__ */
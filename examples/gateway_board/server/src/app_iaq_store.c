@@ -0,0 +1,233 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "app_iaq_store.h"
+#include "flash_manager.h"
+#include "nrf_error.h"
+#include "log.h"
+
+/* Handle layout inside our flash_manager area:
+ * 0x1000 + slot  : sample slots (slot = seq % APP_IAQ_STORE_CAPACITY)
+ * 0x2000         : metadata (drain cursor and boot counter) */
+#define STORE_SAMPLE_HANDLE_BASE    0x1000
+#define STORE_SAMPLE_HANDLE_MASK    0xF000
+#define STORE_META_HANDLE           0x2000
+
+#if APP_IAQ_STORE_CAPACITY > 0x0FFF
+#error "APP_IAQ_STORE_CAPACITY must fit in the sample handle range"
+#endif
+
+typedef struct
+{
+    uint32_t drained_seq;   /* First sequence number not yet delivered */
+    uint16_t boot;
+    uint16_t reserved;
+} store_meta_t;
+
+static flash_manager_t m_flash_manager;
+static bool m_area_added = false;
+static bool m_index_built = false;
+
+static uint32_t m_next_seq = 0;
+static store_meta_t m_meta;
+static uint32_t m_dropped_count = 0;
+
+static fm_handle_t sample_handle(uint32_t seq)
+{
+    return (fm_handle_t)(STORE_SAMPLE_HANDLE_BASE + (seq % APP_IAQ_STORE_CAPACITY));
+}
+
+static uint32_t oldest_pending_seq(void)
+{
+    uint32_t oldest = (m_next_seq > APP_IAQ_STORE_CAPACITY) ? (m_next_seq - APP_IAQ_STORE_CAPACITY) : 0;
+    return (m_meta.drained_seq > oldest) ? m_meta.drained_seq : oldest;
+}
+
+static void write_complete_cb(const flash_manager_t * p_manager,
+                              const fm_entry_t * p_entry,
+                              fm_result_t result)
+{
+    (void)p_manager;
+
+    if (result != FM_RESULT_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "History write failed: handle=0x%04X result=%u\n",
+              p_entry->header.handle, result);
+    }
+}
+
+static fm_iterate_action_t scan_cb(const fm_entry_t * p_entry, void * p_args)
+{
+    (void)p_args;
+
+    const app_iaq_store_sample_t * p_sample = (const app_iaq_store_sample_t *)p_entry->data;
+    if (p_sample->seq + 1 > m_next_seq)
+    {
+        m_next_seq = p_sample->seq + 1;
+    }
+    return FM_ITERATE_ACTION_CONTINUE;
+}
+
+static bool meta_write(void)
+{
+    fm_entry_t * p_entry = flash_manager_entry_alloc(&m_flash_manager, STORE_META_HANDLE, sizeof(m_meta));
+    if (p_entry == NULL)
+    {
+        return false;
+    }
+
+    memcpy(p_entry->data, &m_meta, sizeof(m_meta));
+    flash_manager_entry_commit(p_entry);
+    return true;
+}
+
+/* The area is only readable once flash_manager has finished building it, so the
+ * in-RAM index is rebuilt on first use rather than in init. */
+static bool store_ready(void)
+{
+    if (m_index_built)
+    {
+        return true;
+    }
+
+    if (!m_area_added || m_flash_manager.internal.state != FM_STATE_READY)
+    {
+        return false;
+    }
+
+    const fm_handle_filter_t filter =
+    {
+        .mask  = STORE_SAMPLE_HANDLE_MASK,
+        .match = STORE_SAMPLE_HANDLE_BASE
+    };
+
+    m_next_seq = 0;
+    (void)flash_manager_entries_read(&m_flash_manager, &filter, scan_cb, NULL);
+
+    uint32_t length = sizeof(m_meta);
+    if (flash_manager_entry_read(&m_flash_manager, STORE_META_HANDLE, &m_meta, &length) != NRF_SUCCESS ||
+        length != sizeof(m_meta))
+    {
+        memset(&m_meta, 0, sizeof(m_meta));
+    }
+
+    m_meta.boot++;
+    (void)meta_write();
+
+    m_index_built = true;
+
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "History store ready: boot=%u next_seq=%u pending=%u\n",
+          m_meta.boot, m_next_seq, m_next_seq - oldest_pending_seq());
+    return true;
+}
+
+void app_iaq_store_init(void)
+{
+    flash_manager_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.p_area = (const flash_manager_page_t *)APP_IAQ_STORE_FLASH_AREA_START;
+    config.page_count = APP_IAQ_STORE_FLASH_PAGE_COUNT;
+    config.min_available_space = 0;
+    config.write_complete_cb = write_complete_cb;
+
+    uint32_t status = flash_manager_add(&m_flash_manager, &config);
+    if (status != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "History store init failed: 0x%x\n", status);
+        return;
+    }
+
+    m_area_added = true;
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "History store: %u pages at 0x%05X, %u samples\n",
+          APP_IAQ_STORE_FLASH_PAGE_COUNT, APP_IAQ_STORE_FLASH_AREA_START, APP_IAQ_STORE_CAPACITY);
+}
+
+bool app_iaq_store_append(app_iaq_store_sample_t * p_sample)
+{
+    if (!store_ready())
+    {
+        m_dropped_count++;
+        return false;
+    }
+
+    /* Writes are queued and flushed by the mesh flash module; while defrag runs
+     * the queue can be full, in which case the sample is lost. */
+    fm_entry_t * p_entry = flash_manager_entry_alloc(&m_flash_manager,
+                                                     sample_handle(m_next_seq),
+                                                     sizeof(app_iaq_store_sample_t));
+    if (p_entry == NULL)
+    {
+        m_dropped_count++;
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "History store busy, sample dropped (%u total)\n",
+              m_dropped_count);
+        return false;
+    }
+
+    p_sample->seq = m_next_seq;
+    p_sample->boot = m_meta.boot;
+    memcpy(p_entry->data, p_sample, sizeof(app_iaq_store_sample_t));
+    flash_manager_entry_commit(p_entry);
+
+    m_next_seq++;
+    return true;
+}
+
+uint32_t app_iaq_store_pending_count(void)
+{
+    if (!store_ready())
+    {
+        return 0;
+    }
+
+    return m_next_seq - oldest_pending_seq();
+}
+
+uint32_t app_iaq_store_oldest_seq(void)
+{
+    return oldest_pending_seq();
+}
+
+uint32_t app_iaq_store_peek_from(uint32_t seq, app_iaq_store_sample_t * p_samples, uint32_t max_count)
+{
+    if (!store_ready() || seq < oldest_pending_seq())
+    {
+        return 0;
+    }
+
+    uint32_t count = 0;
+    for (; seq < m_next_seq && count < max_count; seq++)
+    {
+        const fm_entry_t * p_entry = flash_manager_entry_get(&m_flash_manager, sample_handle(seq));
+        if (p_entry == NULL)
+        {
+            break;  /* Still in the flash write queue */
+        }
+
+        const app_iaq_store_sample_t * p_stored = (const app_iaq_store_sample_t *)p_entry->data;
+        if (p_stored->seq != seq)
+        {
+            break;
+        }
+
+        p_samples[count++] = *p_stored;
+    }
+
+    return count;
+}
+
+void app_iaq_store_ack_until(uint32_t next_seq)
+{
+    if (!store_ready() || next_seq <= oldest_pending_seq())
+    {
+        return;
+    }
+
+    m_meta.drained_seq = (next_seq < m_next_seq) ? next_seq : m_next_seq;
+
+    if (!meta_write())
+    {
+        /* Cursor stays correct in RAM; worst case a batch is resent after reset. */
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "History cursor not persisted\n");
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef APP_IAQ_STORE_H__
+#define APP_IAQ_STORE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "app_config.h"
+#include "iaq_sample.h"
+
+/*
+ * Store-and-forward history of IAQ readings.
+ *
+ * Readings that could not be published (node unprovisioned, publication not
+ * configured, publish error) are appended to a dedicated flash_manager area.
+ * Every sample slot has its own flash_manager handle, so rewriting a slot
+ * invalidates the old copy and flash_manager's defragmentation rotates the
+ * pages, which gives us wear leveling for free.
+ *
+ * tools/iaq_store_sim.c runs this store against a model of flash_manager to
+ * check ring wrap and power loss and to measure append cost and erase stalls.
+ */
+
+/* First address of the history area. Must be page aligned, right above the
+ * application region and below the mesh persistent storage, which the mesh
+ * stack places downward from the bootloader (0x78000). On nRF52832 + S132:
+ *
+ *   0x26000..0x6FFFF  application (FLASH in linker/ and FLASH_PH_SIZE in the SES project)
+ *   0x70000..0x73FFF  this area
+ *   0x74000..0x77FFF  mesh_config pages and the flash_manager recovery page
+ *
+ * Both builds check the application region against this address in
+ * cmake/check_map_budget.cmake (FLASH_END_MAX). */
+#ifndef APP_IAQ_STORE_FLASH_AREA_START
+#define APP_IAQ_STORE_FLASH_AREA_START  0x70000
+#endif
+
+/* Number of flash pages reserved for the history area. */
+#ifndef APP_IAQ_STORE_FLASH_PAGE_COUNT
+#define APP_IAQ_STORE_FLASH_PAGE_COUNT  4
+#endif
+
+/* Number of samples kept in the ring. Oldest samples are overwritten first.
+ * Leave room for at least one page of stale entries so defrag always has
+ * something to reclaim. */
+#ifndef APP_IAQ_STORE_CAPACITY
+#define APP_IAQ_STORE_CAPACITY          384
+#endif
+
+/* Compact fixed-point sample, 16 bytes (a multiple of the flash word size). */
+typedef struct
+{
+    uint32_t seq;           /* Monotonic sequence number, survives reboots */
+    uint32_t timestamp_s;   /* Seconds since sampling started in boot `boot` */
+    uint16_t boot;          /* Boot counter at capture time */
+    iaq_sample_t value;
+} app_iaq_store_sample_t;
+
+#if APP_FEATURE_SENSOR
+/**
+ * @brief Register the history flash area. Call after mesh_stack_init().
+ */
+void app_iaq_store_init(void);
+
+/**
+ * @brief Append a sample to the ring. seq and boot are filled in by the store.
+ *
+ * @return true if the write was queued to flash.
+ */
+bool app_iaq_store_append(app_iaq_store_sample_t * p_sample);
+
+/** @brief Number of samples waiting to be drained to the gateway. */
+uint32_t app_iaq_store_pending_count(void);
+
+/** @brief Sequence number of the oldest pending sample. */
+uint32_t app_iaq_store_oldest_seq(void);
+
+/**
+ * @brief Copy up to max_count pending samples from seq onwards, without removing them.
+ *
+ * Lets a sender with several transfers in flight read past the ones not yet
+ * acknowledged.
+ *
+ * @return Number of samples copied; 0 if seq is not pending.
+ */
+uint32_t app_iaq_store_peek_from(uint32_t seq, app_iaq_store_sample_t * p_samples, uint32_t max_count);
+
+/**
+ * @brief Mark every pending sample before next_seq as delivered.
+ *
+ * The drain cursor is persisted so delivered samples are not resent after a reset.
+ */
+void app_iaq_store_ack_until(uint32_t next_seq);
+#else
+/* Gateway-only build: nothing to store, the flash area stays unused */
+static inline void app_iaq_store_init(void) {}
+#endif
+
+#endif /* APP_IAQ_STORE_H__ */
@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "app_iaq_trace.h"
+
+#if APP_IAQ_TRACE_ENABLED
+
+#include "SEGGER_RTT.h"
+#include "log.h"
+
+/* Host tools read the record as a byte stream; keep the layout fixed */
+typedef char record_size_check_t[(sizeof(app_iaq_trace_record_t) == 56) ? 1 : -1];
+
+static uint8_t m_rtt_buffer[APP_IAQ_TRACE_RTT_BUFFER_SIZE];
+static uint32_t m_seq;
+static uint32_t m_dropped;
+static bool m_ready;
+
+void app_iaq_trace_init(void)
+{
+    /* Skip mode: a record that does not fit is dropped whole, never blocks the sensor */
+    int ret = SEGGER_RTT_ConfigUpBuffer(APP_IAQ_TRACE_RTT_CHANNEL, "IAQTrace",
+                                        m_rtt_buffer, sizeof(m_rtt_buffer),
+                                        SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    if (ret < 0)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "IAQ trace: RTT channel %u not available\n",
+              APP_IAQ_TRACE_RTT_CHANNEL);
+        return;
+    }
+
+    m_ready = true;
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "IAQ trace on RTT channel %u (%u byte records)\n",
+          APP_IAQ_TRACE_RTT_CHANNEL, (unsigned)sizeof(app_iaq_trace_record_t));
+}
+
+void app_iaq_trace_record(uint32_t timestamp_ms,
+                          const uint8_t * p_adc,
+                          int8_t calc_status,
+                          float iaq, float tvoc, float eco2)
+{
+    if (!m_ready)
+    {
+        return;
+    }
+
+    app_iaq_trace_record_t record;
+    record.sync = APP_IAQ_TRACE_SYNC;
+    record.version = APP_IAQ_TRACE_VERSION;
+    record.calc_status = calc_status;
+    record.seq = m_seq++;
+    record.timestamp_ms = timestamp_ms;
+    memcpy(record.adc, p_adc, sizeof(record.adc));
+    record.iaq = iaq;
+    record.tvoc = tvoc;
+    record.eco2 = eco2;
+
+    if (SEGGER_RTT_Write(APP_IAQ_TRACE_RTT_CHANNEL, &record, sizeof(record)) != sizeof(record))
+    {
+        if (m_dropped++ == 0)
+        {
+            __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "IAQ trace: RTT channel full, dropping records\n");
+        }
+    }
+}
+
+#endif /* APP_IAQ_TRACE_ENABLED */
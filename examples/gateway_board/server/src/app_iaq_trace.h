@@ -0,0 +1,79 @@
+#ifndef APP_IAQ_TRACE_H__
+#define APP_IAQ_TRACE_H__
+
+#include <stdint.h>
+
+/*
+ * Binary trace of the IAQ measurement pipeline.
+ *
+ * With APP_IAQ_TRACE_ENABLED every completed ZMOD4410 measurement is written
+ * to RTT up channel APP_IAQ_TRACE_RTT_CHANNEL as one fixed-size record: the
+ * raw ADC frame, the calc_iaq_2nd_gen() status and its float outputs.
+ * Capture the channel to a file with the J-Link RTT Logger, e.g.
+ *
+ *   JLinkRTTLogger -Device NRF52832_XXAA -If SWD -Speed 4000 -RTTChannel 1 iaq.trace
+ *
+ * and feed it to tools/iaq_trace_replay.c, which runs the same code as the
+ * node from the algorithm outputs onwards (iaq_sample.c).
+ *
+ * Records never block: if the host does not drain the channel fast enough,
+ * whole records are dropped and counted (see the sequence number).
+ */
+
+#ifndef APP_IAQ_TRACE_ENABLED
+#define APP_IAQ_TRACE_ENABLED       0
+#endif
+
+/* RTT up channel for the trace; channel 0 carries the log. */
+#ifndef APP_IAQ_TRACE_RTT_CHANNEL
+#define APP_IAQ_TRACE_RTT_CHANNEL   1
+#endif
+
+/* RTT buffer size. At one record per second, 1 kB covers ~20 s without a host. */
+#ifndef APP_IAQ_TRACE_RTT_BUFFER_SIZE
+#define APP_IAQ_TRACE_RTT_BUFFER_SIZE 1024
+#endif
+
+#define APP_IAQ_TRACE_SYNC          0x5154  /* "TQ" on the wire */
+#define APP_IAQ_TRACE_VERSION       1
+#define APP_IAQ_TRACE_ADC_LEN       32      /* ZMOD4410_ADC_DATA_LEN, IAQ 2nd Gen */
+
+/* One record, 56 bytes, little endian. Floats are IEEE 754 single precision. */
+typedef struct __attribute__((packed))
+{
+    uint16_t sync;          /* APP_IAQ_TRACE_SYNC */
+    uint8_t  version;       /* APP_IAQ_TRACE_VERSION */
+    int8_t   calc_status;   /* calc_iaq_2nd_gen() return value */
+    uint32_t seq;           /* Record counter; gaps are dropped records */
+    uint32_t timestamp_ms;  /* Sampling uptime */
+    uint8_t  adc[APP_IAQ_TRACE_ADC_LEN];
+    float    iaq;
+    float    tvoc;
+    float    eco2;
+} app_iaq_trace_record_t;
+
+#if APP_IAQ_TRACE_ENABLED
+/** @brief Set up the RTT channel. */
+void app_iaq_trace_init(void);
+
+/**
+ * @brief Record one measurement. Float outputs are only meaningful if
+ * calc_status is IAQ_2ND_GEN_OK.
+ */
+void app_iaq_trace_record(uint32_t timestamp_ms,
+                          const uint8_t * p_adc,
+                          int8_t calc_status,
+                          float iaq, float tvoc, float eco2);
+#else
+static inline void app_iaq_trace_init(void) {}
+static inline void app_iaq_trace_record(uint32_t timestamp_ms,
+                                        const uint8_t * p_adc,
+                                        int8_t calc_status,
+                                        float iaq, float tvoc, float eco2)
+{
+    (void)timestamp_ms; (void)p_adc; (void)calc_status;
+    (void)iaq; (void)tvoc; (void)eco2;
+}
+#endif
+
+#endif /* APP_IAQ_TRACE_H__ */
@@ -0,0 +1,212 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "app_power.h"
+#include "app_timer.h"
+#include "app_sched_prio.h"
+#include "app_util_platform.h"
+#include "nrf_error.h"
+#include "nrf_soc.h"
+#include "log.h"
+
+#include "mesh_vendor_model.h"
+
+#define SRC_NONE  APP_POWER_SRC_COUNT
+
+typedef struct
+{
+    uint32_t wakeups;
+    uint64_t active_ticks;
+} wake_stats_t;
+
+APP_TIMER_DEF(m_report_timer_id);
+
+static uint32_t m_last_cnt;
+static uint64_t m_now_ticks;
+static uint64_t m_wake_ticks;
+static uint64_t m_sleep_ticks;
+static bool m_slept;
+
+static volatile app_power_src_t m_wake_src = SRC_NONE;
+static wake_stats_t m_wake_stats[APP_POWER_SRC_COUNT];
+
+static uint64_t m_periph_since[APP_POWER_SRC_COUNT];
+static uint64_t m_periph_ticks[APP_POWER_SRC_COUNT];
+static bool m_periph_on[APP_POWER_SRC_COUNT];
+
+/* Radio RX time weighted by duty cycle, in ticks * per mille */
+static uint16_t m_radio_duty = APP_POWER_SCAN_DUTY_PERMILLE;
+static uint64_t m_radio_since;
+static uint64_t m_radio_weighted;
+
+/* The RTC counter is 24 bits and wraps after 512 s; the measurement timer
+ * wakes us far more often than that, so diffing against the last read keeps
+ * a 64-bit tick count. */
+static uint64_t ticks_now(void)
+{
+    uint64_t now;
+
+    CRITICAL_REGION_ENTER();
+    uint32_t cnt = app_timer_cnt_get();
+    m_now_ticks += app_timer_cnt_diff_compute(cnt, m_last_cnt);
+    m_last_cnt = cnt;
+    now = m_now_ticks;
+    CRITICAL_REGION_EXIT();
+
+    return now;
+}
+
+static uint32_t ticks_to_ms(uint64_t ticks)
+{
+    return (uint32_t)((ticks * 1000) / APP_TIMER_CLOCK_FREQ);
+}
+
+static uint16_t sat_u16(uint32_t val)
+{
+    return (val > UINT16_MAX) ? UINT16_MAX : (uint16_t)val;
+}
+
+static void scheduled_report_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)p_event_data;
+    (void)event_size;
+
+    app_power_report_t report;
+    app_power_report_get(&report);
+
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO,
+          "Power: uptime=%us duty=%u.%u%% avg=%uuA wakes tmr/twi/rad/uart=%u/%u/%u/%u\n",
+          report.uptime_s,
+          report.duty_permille / 10, report.duty_permille % 10,
+          report.avg_current_ua,
+          report.wakeups[APP_POWER_SRC_TIMER], report.wakeups[APP_POWER_SRC_TWI],
+          report.wakeups[APP_POWER_SRC_RADIO], report.wakeups[APP_POWER_SRC_UART]);
+
+    (void)mesh_publish_power_status(&report);
+}
+
+static void report_timer_handler(void * p_context)
+{
+    (void)p_context;
+    app_power_wake_mark(APP_POWER_SRC_TIMER);
+    (void)APP_SCHED_PUT(APP_SCHED_CLASS_BACKGROUND, NULL, 0, scheduled_report_handler);
+}
+
+void app_power_init(void)
+{
+    m_last_cnt = app_timer_cnt_get();
+    m_now_ticks = 0;
+    m_wake_ticks = 0;
+    m_sleep_ticks = 0;
+    m_slept = false;
+    memset(m_wake_stats, 0, sizeof(m_wake_stats));
+    memset(m_periph_ticks, 0, sizeof(m_periph_ticks));
+    m_radio_since = 0;
+    m_radio_weighted = 0;
+
+    ret_code_t rc = app_timer_create(&m_report_timer_id, APP_TIMER_MODE_REPEATED, report_timer_handler);
+    if (rc == NRF_SUCCESS)
+    {
+        rc = app_timer_start(m_report_timer_id, APP_TIMER_TICKS(APP_POWER_REPORT_INTERVAL_MS), NULL);
+    }
+    if (rc != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Power report timer failed: 0x%x\n", rc);
+    }
+}
+
+void app_power_idle(void)
+{
+    uint64_t now = ticks_now();
+
+    /* Charge the active period that just ended to whoever woke us */
+    app_power_src_t src = m_wake_src;
+    if (src == SRC_NONE)
+    {
+        src = APP_POWER_SRC_RADIO;
+    }
+    m_wake_stats[src].active_ticks += now - m_wake_ticks;
+    if (m_slept)
+    {
+        m_wake_stats[src].wakeups++;
+    }
+    m_wake_src = SRC_NONE;
+
+    (void)sd_app_evt_wait();
+
+    uint64_t woke = ticks_now();
+    m_slept = (woke != now);
+    m_sleep_ticks += woke - now;
+    m_wake_ticks = woke;
+}
+
+void app_power_wake_mark(app_power_src_t src)
+{
+    if (m_wake_src == SRC_NONE && src < APP_POWER_SRC_COUNT)
+    {
+        m_wake_src = src;
+    }
+}
+
+void app_power_periph_on(app_power_src_t src)
+{
+    if (src < APP_POWER_SRC_COUNT && !m_periph_on[src])
+    {
+        m_periph_on[src] = true;
+        m_periph_since[src] = ticks_now();
+    }
+}
+
+void app_power_periph_off(app_power_src_t src)
+{
+    if (src < APP_POWER_SRC_COUNT && m_periph_on[src])
+    {
+        m_periph_on[src] = false;
+        m_periph_ticks[src] += ticks_now() - m_periph_since[src];
+    }
+}
+
+void app_power_radio_duty_set(uint16_t duty_permille)
+{
+    uint64_t now = ticks_now();
+
+    m_radio_weighted += (now - m_radio_since) * m_radio_duty;
+    m_radio_since = now;
+    m_radio_duty = (duty_permille > 1000) ? 1000 : duty_permille;
+}
+
+void app_power_report_get(app_power_report_t * p_report)
+{
+    uint64_t now = ticks_now();
+    uint64_t periph[APP_POWER_SRC_COUNT];
+
+    for (uint32_t i = 0; i < APP_POWER_SRC_COUNT; i++)
+    {
+        periph[i] = m_periph_ticks[i] + (m_periph_on[i] ? now - m_periph_since[i] : 0);
+        p_report->wakeups[i] = sat_u16(m_wake_stats[i].wakeups);
+        p_report->active_ms[i] = sat_u16(ticks_to_ms(m_wake_stats[i].active_ticks));
+    }
+
+    p_report->uptime_s = ticks_to_ms(now) / 1000;
+
+    if (now == 0)
+    {
+        p_report->duty_permille = 0;
+        p_report->avg_current_ua = 0;
+        return;
+    }
+
+    power_model_times_t times =
+    {
+        .total = now,
+        .active = now - m_sleep_ticks,
+        .twi = periph[APP_POWER_SRC_TWI],
+        .uart = periph[APP_POWER_SRC_UART],
+        .radio_rx_permille = m_radio_weighted + (now - m_radio_since) * m_radio_duty,
+        .radio_tx = 0,
+    };
+    p_report->duty_permille = power_model_duty_permille(&times);
+    uint32_t avg = power_model_avg_ua(&times);
+    p_report->avg_current_ua = sat_u16(avg);
+}
@@ -0,0 +1,74 @@
+#ifndef APP_POWER_H__
+#define APP_POWER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "power_model.h"
+
+/*
+ * Sleep-state accounting and energy estimate.
+ *
+ * main() sleeps through app_power_idle(). Time between wake-up and the next
+ * sleep is charged to the source that woke the CPU; interrupt handlers report
+ * themselves with app_power_wake_mark(). Wake-ups nobody claims come from the
+ * SoftDevice or the mesh stack and are charged to the radio.
+ *
+ * Peripherals that are powered down between uses report their on-time with
+ * app_power_periph_on()/app_power_periph_off(). The energy estimate is
+ * power_model_avg_ua() over these times. Radio TX time is not visible to the
+ * application and is left out; tools/power_model.c adds it per profile.
+ * tools/power_trace_sim.c runs this accounting over an event trace on the
+ * host and checks its reports against the trace.
+ */
+
+/* Interval between power status reports (RTT and vendor status message). */
+#ifndef APP_POWER_REPORT_INTERVAL_MS
+#define APP_POWER_REPORT_INTERVAL_MS    (10 * 60 * 1000)
+#endif
+
+/* Initial fraction of time the mesh scanner keeps the radio in RX, in per
+ * mille. A relay/proxy node scans continuously; an LPN lowers this with
+ * app_power_radio_duty_set() once it has a Friend. */
+#ifndef APP_POWER_SCAN_DUTY_PERMILLE
+#define APP_POWER_SCAN_DUTY_PERMILLE    1000
+#endif
+
+typedef enum
+{
+    APP_POWER_SRC_TIMER,
+    APP_POWER_SRC_TWI,
+    APP_POWER_SRC_RADIO,
+    APP_POWER_SRC_UART,
+    APP_POWER_SRC_COUNT
+} app_power_src_t;
+
+typedef struct
+{
+    uint32_t uptime_s;
+    uint16_t duty_permille;                     /* CPU active time per mille */
+    uint16_t avg_current_ua;                    /* Estimated average current */
+    uint16_t wakeups[APP_POWER_SRC_COUNT];      /* Wake-ups per source, saturating */
+    uint16_t active_ms[APP_POWER_SRC_COUNT];    /* CPU active time per source, saturating */
+} app_power_report_t;
+
+/** @brief Initialize accounting and start the periodic report timer. */
+void app_power_init(void);
+
+/** @brief Sleep until the next event, accounting active and sleep time. Call from the main loop. */
+void app_power_idle(void);
+
+/** @brief Claim the current wake-up for src. Safe to call from interrupt context. */
+void app_power_wake_mark(app_power_src_t src);
+
+/** @brief Record that a power-managed peripheral was switched on/off. */
+void app_power_periph_on(app_power_src_t src);
+void app_power_periph_off(app_power_src_t src);
+
+/** @brief Update the radio RX duty cycle (per mille) used by the estimate from now on. */
+void app_power_radio_duty_set(uint16_t duty_permille);
+
+/** @brief Snapshot of the accounting since boot. */
+void app_power_report_get(app_power_report_t * p_report);
+
+#endif /* APP_POWER_H__ */
@@ -0,0 +1,194 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "app_sched_prio.h"
+#include "app_sched_stats.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include "nrf_error.h"
+
+typedef struct
+{
+    app_sched_prio_handler_t handler;
+    uint32_t put_ticks;
+    uint16_t size;
+    uint8_t stats_id;
+    uint32_t data[(APP_SCHED_PAYLOAD_MAX + sizeof(uint32_t) - 1) / sizeof(uint32_t)];
+} event_t;
+
+typedef struct
+{
+    event_t * p_events;
+    uint16_t size;
+    uint16_t budget;
+    uint16_t head;
+    uint16_t count;
+    uint16_t depth_max;
+    uint32_t put_failures;
+    uint32_t runs;
+    uint32_t latency_ticks_max;
+    uint64_t latency_ticks_total;
+} class_queue_t;
+
+static event_t m_sensor_events[APP_SCHED_SENSOR_QUEUE_SIZE];
+static event_t m_mesh_rx_events[APP_SCHED_MESH_RX_QUEUE_SIZE];
+static event_t m_uart_tx_events[APP_SCHED_UART_TX_QUEUE_SIZE];
+static event_t m_background_events[APP_SCHED_BACKGROUND_QUEUE_SIZE];
+
+static class_queue_t m_queues[APP_SCHED_CLASS_COUNT] =
+{
+    [APP_SCHED_CLASS_SENSOR]     = { m_sensor_events, APP_SCHED_SENSOR_QUEUE_SIZE, APP_SCHED_SENSOR_QUEUE_SIZE },
+    [APP_SCHED_CLASS_MESH_RX]    = { m_mesh_rx_events, APP_SCHED_MESH_RX_QUEUE_SIZE, APP_SCHED_MESH_RX_BUDGET },
+    [APP_SCHED_CLASS_UART_TX]    = { m_uart_tx_events, APP_SCHED_UART_TX_QUEUE_SIZE, APP_SCHED_UART_TX_BUDGET },
+    [APP_SCHED_CLASS_BACKGROUND] = { m_background_events, APP_SCHED_BACKGROUND_QUEUE_SIZE, APP_SCHED_BACKGROUND_BUDGET },
+};
+
+static uint32_t ticks_to_us(uint64_t ticks)
+{
+    return (uint32_t)((ticks * 1000000) / APP_TIMER_CLOCK_FREQ);
+}
+
+void app_sched_prio_init(void)
+{
+    for (uint32_t i = 0; i < APP_SCHED_CLASS_COUNT; i++)
+    {
+        class_queue_t * p_queue = &m_queues[i];
+        p_queue->head = 0;
+        p_queue->count = 0;
+        p_queue->depth_max = 0;
+        p_queue->put_failures = 0;
+        p_queue->runs = 0;
+        p_queue->latency_ticks_max = 0;
+        p_queue->latency_ticks_total = 0;
+    }
+}
+
+uint32_t app_sched_prio_put(app_sched_class_t cls, const void * p_event_data, uint16_t event_size,
+                            app_sched_prio_handler_t handler, const char * p_name)
+{
+    class_queue_t * p_queue = &m_queues[cls];
+    uint8_t stats_id = app_sched_stats_handler_id(handler, p_name);
+    uint32_t status = NRF_SUCCESS;
+
+    if (event_size > APP_SCHED_PAYLOAD_MAX)
+    {
+        status = NRF_ERROR_INVALID_LENGTH;
+    }
+    else
+    {
+        CRITICAL_REGION_ENTER();
+        if (p_queue->count == p_queue->size)
+        {
+            p_queue->put_failures++;
+            status = NRF_ERROR_NO_MEM;
+        }
+        else
+        {
+            event_t * p_event = &p_queue->p_events[(p_queue->head + p_queue->count) % p_queue->size];
+            p_event->handler = handler;
+            p_event->put_ticks = app_timer_cnt_get();
+            p_event->size = event_size;
+            p_event->stats_id = stats_id;
+            if (event_size > 0)
+            {
+                memcpy(p_event->data, p_event_data, event_size);
+            }
+
+            p_queue->count++;
+            if (p_queue->count > p_queue->depth_max)
+            {
+                p_queue->depth_max = p_queue->count;
+            }
+        }
+        CRITICAL_REGION_EXIT();
+    }
+
+    if (status != NRF_SUCCESS)
+    {
+        app_sched_stats_put_failed(stats_id, p_name, status);
+    }
+    return status;
+}
+
+static bool run_one(app_sched_class_t cls)
+{
+    class_queue_t * p_queue = &m_queues[cls];
+    event_t event;
+    bool found = false;
+
+    /* Copy out so the slot can be reused by an interrupt while the handler runs */
+    CRITICAL_REGION_ENTER();
+    if (p_queue->count > 0)
+    {
+        event = p_queue->p_events[p_queue->head];
+        p_queue->head = (p_queue->head + 1) % p_queue->size;
+        p_queue->count--;
+        found = true;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (!found)
+    {
+        return false;
+    }
+
+    uint32_t start = app_timer_cnt_get();
+    uint32_t latency = app_timer_cnt_diff_compute(start, event.put_ticks);
+    p_queue->runs++;
+    p_queue->latency_ticks_total += latency;
+    if (latency > p_queue->latency_ticks_max)
+    {
+        p_queue->latency_ticks_max = latency;
+    }
+
+    event.handler((event.size > 0) ? (void *)event.data : NULL, event.size);
+
+    app_sched_stats_handler_ran(event.stats_id, app_timer_cnt_diff_compute(app_timer_cnt_get(), start));
+    return true;
+}
+
+static void sensor_drain(void)
+{
+    while (run_one(APP_SCHED_CLASS_SENSOR))
+    {
+    }
+}
+
+void app_sched_prio_execute(void)
+{
+    sensor_drain();
+
+    for (uint32_t cls = APP_SCHED_CLASS_SENSOR + 1; cls < APP_SCHED_CLASS_COUNT; cls++)
+    {
+        for (uint16_t n = 0; n < m_queues[cls].budget && run_one((app_sched_class_t)cls); n++)
+        {
+            /* The sensor cycle goes ahead of every other event */
+            sensor_drain();
+        }
+    }
+}
+
+bool app_sched_prio_is_pending(void)
+{
+    for (uint32_t i = 0; i < APP_SCHED_CLASS_COUNT; i++)
+    {
+        if (m_queues[i].count > 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void app_sched_prio_class_stats_get(app_sched_class_t cls, app_sched_class_stats_t * p_stats)
+{
+    const class_queue_t * p_queue = &m_queues[cls];
+
+    p_stats->depth_max = p_queue->depth_max;
+    p_stats->size = p_queue->size;
+    p_stats->put_failures = p_queue->put_failures;
+    p_stats->runs = p_queue->runs;
+    p_stats->latency_max_us = ticks_to_us(p_queue->latency_ticks_max);
+    p_stats->latency_avg_us = (p_queue->runs > 0) ? ticks_to_us(p_queue->latency_ticks_total / p_queue->runs) : 0;
+}
@@ -0,0 +1,99 @@
+#ifndef APP_SCHED_PRIO_H__
+#define APP_SCHED_PRIO_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "nrf_mesh_config_core.h"
+
+/*
+ * Priority event scheduler for the main loop (replaces app_scheduler).
+ *
+ * Work posted from interrupt context is queued per class and run in main
+ * context by app_sched_prio_execute(). The sensor queue is drained before
+ * every event of another class, so a measurement cycle waits for at most one
+ * running handler no matter how many RX events are queued. The other classes
+ * run at most their budget of events per call, highest class first, so a
+ * flood in one class cannot hold the loop.
+ *
+ * Queue depth, put failures and the latency from put to start are tracked
+ * per class; execution time per handler in app_sched_stats.
+ */
+
+typedef enum
+{
+    APP_SCHED_CLASS_SENSOR,         /* Timing-critical ZMOD measurement cycle */
+    APP_SCHED_CLASS_MESH_RX,        /* Processing of received sensor messages */
+    APP_SCHED_CLASS_UART_TX,        /* UART link housekeeping */
+    APP_SCHED_CLASS_BACKGROUND,     /* Reports, publish retries, friendship */
+    APP_SCHED_CLASS_COUNT
+} app_sched_class_t;
+
+/* Queue sizes, in events. */
+#ifndef APP_SCHED_SENSOR_QUEUE_SIZE
+#define APP_SCHED_SENSOR_QUEUE_SIZE     4
+#endif
+#ifndef APP_SCHED_MESH_RX_QUEUE_SIZE
+#if APP_PROFILE_GATEWAY_HT
+/* Two bursts, in case the loop stalls while the first is processed */
+#define APP_SCHED_MESH_RX_QUEUE_SIZE    (2 * APP_GATEWAY_BURST_MSGS)
+#else
+#define APP_SCHED_MESH_RX_QUEUE_SIZE    16
+#endif
+#endif
+#ifndef APP_SCHED_UART_TX_QUEUE_SIZE
+#define APP_SCHED_UART_TX_QUEUE_SIZE    4
+#endif
+#ifndef APP_SCHED_BACKGROUND_QUEUE_SIZE
+#define APP_SCHED_BACKGROUND_QUEUE_SIZE 8
+#endif
+
+/* Events run per app_sched_prio_execute() call. The sensor class has no budget. */
+#ifndef APP_SCHED_MESH_RX_BUDGET
+#define APP_SCHED_MESH_RX_BUDGET        4
+#endif
+#ifndef APP_SCHED_UART_TX_BUDGET
+#define APP_SCHED_UART_TX_BUDGET        2
+#endif
+#ifndef APP_SCHED_BACKGROUND_BUDGET
+#define APP_SCHED_BACKGROUND_BUDGET     1
+#endif
+
+/* Largest event data accepted by APP_SCHED_PUT(). */
+#ifndef APP_SCHED_PAYLOAD_MAX
+#define APP_SCHED_PAYLOAD_MAX           16
+#endif
+
+typedef void (*app_sched_prio_handler_t)(void * p_event_data, uint16_t event_size);
+
+typedef struct
+{
+    uint16_t depth_max;         /* Queue high-watermark, events */
+    uint16_t size;
+    uint32_t put_failures;
+    uint32_t runs;
+    uint32_t latency_max_us;    /* Put to start of the handler */
+    uint32_t latency_avg_us;
+} app_sched_class_stats_t;
+
+/** @brief Post an event to a class queue. Safe to call from interrupt context.
+ *  @return NRF_SUCCESS, NRF_ERROR_NO_MEM if the queue is full or
+ *          NRF_ERROR_INVALID_LENGTH if the data is larger than APP_SCHED_PAYLOAD_MAX. */
+#define APP_SCHED_PUT(cls, p_data, size, handler) \
+    app_sched_prio_put((cls), (p_data), (size), (handler), #handler)
+
+void app_sched_prio_init(void);
+
+/** @brief Use APP_SCHED_PUT() instead. */
+uint32_t app_sched_prio_put(app_sched_class_t cls, const void * p_event_data, uint16_t event_size,
+                            app_sched_prio_handler_t handler, const char * p_name);
+
+/** @brief Run queued events within the class budgets. Call from the main loop. */
+void app_sched_prio_execute(void);
+
+/** @brief true if events are still queued; the main loop must not sleep then. */
+bool app_sched_prio_is_pending(void);
+
+void app_sched_prio_class_stats_get(app_sched_class_t cls, app_sched_class_stats_t * p_stats);
+
+#endif /* APP_SCHED_PRIO_H__ */
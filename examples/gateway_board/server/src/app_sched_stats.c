@@ -0,0 +1,213 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "app_sched_stats.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include "nrf_error.h"
+#include "log.h"
+
+#include "mesh_vendor_model.h"
+
+typedef struct
+{
+    app_sched_prio_handler_t handler;
+    const char * p_name;
+    uint32_t runs;
+    uint32_t put_failures;
+    uint32_t exec_ticks_total;
+    uint32_t exec_ticks_max;
+} handler_stats_t;
+
+APP_TIMER_DEF(m_report_timer_id);
+
+static handler_stats_t m_handlers[APP_SCHED_STATS_HANDLER_MAX];
+static uint8_t m_handler_count;
+
+static uint32_t ticks_to_us(uint32_t ticks)
+{
+    return (uint32_t)(((uint64_t)ticks * 1000000) / APP_TIMER_CLOCK_FREQ);
+}
+
+uint8_t app_sched_stats_handler_id(app_sched_prio_handler_t handler, const char * p_name)
+{
+    uint8_t id = APP_SCHED_STATS_ID_NONE;
+
+    CRITICAL_REGION_ENTER();
+    for (uint8_t i = 0; i < m_handler_count; i++)
+    {
+        if (m_handlers[i].handler == handler)
+        {
+            id = i;
+            break;
+        }
+    }
+    if (id == APP_SCHED_STATS_ID_NONE && m_handler_count < APP_SCHED_STATS_HANDLER_MAX)
+    {
+        id = m_handler_count++;
+        m_handlers[id].handler = handler;
+        m_handlers[id].p_name = p_name;
+    }
+    CRITICAL_REGION_EXIT();
+
+    return id;
+}
+
+void app_sched_stats_put_failed(uint8_t id, const char * p_name, uint32_t status)
+{
+    if (id == APP_SCHED_STATS_ID_NONE)
+    {
+        return;
+    }
+
+    /* Puts fail in interrupt context too; the count must not lose an increment */
+    uint32_t failures;
+    CRITICAL_REGION_ENTER();
+    failures = m_handlers[id].put_failures++;
+    CRITICAL_REGION_EXIT();
+
+    if (failures == 0)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Scheduler put failed for %s: 0x%x\n", p_name, status);
+    }
+}
+
+void app_sched_stats_handler_ran(uint8_t id, uint32_t ticks)
+{
+    if (id == APP_SCHED_STATS_ID_NONE)
+    {
+        return;
+    }
+
+    handler_stats_t * p_stats = &m_handlers[id];
+    p_stats->runs++;
+    p_stats->exec_ticks_total += ticks;
+    if (ticks > p_stats->exec_ticks_max)
+    {
+        p_stats->exec_ticks_max = ticks;
+    }
+}
+
+/* "scheduled_meas_handler" -> "meas" */
+static void short_name_copy(char * p_dst, const char * p_name)
+{
+    static const char prefix[] = "scheduled_";
+    static const char suffix[] = "_handler";
+
+    size_t len = strlen(p_name);
+    if (strncmp(p_name, prefix, sizeof(prefix) - 1) == 0)
+    {
+        p_name += sizeof(prefix) - 1;
+        len -= sizeof(prefix) - 1;
+    }
+    if (len > sizeof(suffix) - 1 && strcmp(&p_name[len - (sizeof(suffix) - 1)], suffix) == 0)
+    {
+        len -= sizeof(suffix) - 1;
+    }
+
+    memset(p_dst, 0, APP_SCHED_STATS_NAME_LEN);
+    memcpy(p_dst, p_name, (len < APP_SCHED_STATS_NAME_LEN) ? len : APP_SCHED_STATS_NAME_LEN);
+}
+
+/* Failing handlers first, then the slowest */
+static bool is_worse(const handler_stats_t * p_a, const handler_stats_t * p_b)
+{
+    if (p_a->put_failures != p_b->put_failures)
+    {
+        return p_a->put_failures > p_b->put_failures;
+    }
+    return p_a->exec_ticks_max > p_b->exec_ticks_max;
+}
+
+void app_sched_stats_report_get(app_sched_stats_report_t * p_report)
+{
+    memset(p_report, 0, sizeof(*p_report));
+
+    for (uint32_t cls = 0; cls < APP_SCHED_CLASS_COUNT; cls++)
+    {
+        app_sched_class_stats_t stats;
+        app_sched_prio_class_stats_get((app_sched_class_t)cls, &stats);
+
+        app_sched_stats_class_t * p_class = &p_report->classes[cls];
+        p_class->depth_max = (stats.depth_max > UINT8_MAX) ? UINT8_MAX : (uint8_t)stats.depth_max;
+        p_class->queue_size = (stats.size > UINT8_MAX) ? UINT8_MAX : (uint8_t)stats.size;
+        p_class->put_failures = (stats.put_failures > UINT16_MAX) ? UINT16_MAX : (uint16_t)stats.put_failures;
+        p_class->latency_max_us = stats.latency_max_us;
+    }
+
+    /* Selection of the worst handlers; the table is small */
+    bool taken[APP_SCHED_STATS_HANDLER_MAX] = { false };
+    while (p_report->row_count < APP_SCHED_STATS_ROWS && p_report->row_count < m_handler_count)
+    {
+        uint8_t worst = APP_SCHED_STATS_ID_NONE;
+        for (uint8_t i = 0; i < m_handler_count; i++)
+        {
+            if (!taken[i] && (worst == APP_SCHED_STATS_ID_NONE || is_worse(&m_handlers[i], &m_handlers[worst])))
+            {
+                worst = i;
+            }
+        }
+        taken[worst] = true;
+
+        app_sched_stats_row_t * p_row = &p_report->rows[p_report->row_count++];
+        short_name_copy(p_row->name, m_handlers[worst].p_name);
+        p_row->put_failures = (m_handlers[worst].put_failures > UINT16_MAX) ?
+                              UINT16_MAX : (uint16_t)m_handlers[worst].put_failures;
+        p_row->exec_max_us = ticks_to_us(m_handlers[worst].exec_ticks_max);
+    }
+}
+
+void app_sched_stats_log(void)
+{
+    static const char * const class_names[APP_SCHED_CLASS_COUNT] = { "sensor", "mesh_rx", "uart_tx", "background" };
+
+    for (uint32_t cls = 0; cls < APP_SCHED_CLASS_COUNT; cls++)
+    {
+        app_sched_class_stats_t stats;
+        app_sched_prio_class_stats_get((app_sched_class_t)cls, &stats);
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO,
+              "Sched %s: depth max %u/%u, put failures %u, runs %u, latency avg/max %u/%u us\n",
+              class_names[cls], stats.depth_max, stats.size, stats.put_failures, stats.runs,
+              stats.latency_avg_us, stats.latency_max_us);
+    }
+    for (uint8_t i = 0; i < m_handler_count; i++)
+    {
+        const handler_stats_t * p_stats = &m_handlers[i];
+        uint32_t avg_ticks = (p_stats->runs > 0) ? p_stats->exec_ticks_total / p_stats->runs : 0;
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "  %s: runs %u, put failures %u, exec avg/max %u/%u us\n",
+              p_stats->p_name, p_stats->runs, p_stats->put_failures,
+              ticks_to_us(avg_ticks), ticks_to_us(p_stats->exec_ticks_max));
+    }
+}
+
+static void scheduled_diag_report_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)p_event_data;
+    (void)event_size;
+
+    app_sched_stats_log();
+
+    app_sched_stats_report_t report;
+    app_sched_stats_report_get(&report);
+    (void)mesh_publish_sched_diag(&report);
+}
+
+static void report_timer_handler(void * p_context)
+{
+    (void)p_context;
+    (void)APP_SCHED_PUT(APP_SCHED_CLASS_BACKGROUND, NULL, 0, scheduled_diag_report_handler);
+}
+
+void app_sched_stats_init(void)
+{
+    ret_code_t rc = app_timer_create(&m_report_timer_id, APP_TIMER_MODE_REPEATED, report_timer_handler);
+    if (rc == NRF_SUCCESS)
+    {
+        rc = app_timer_start(m_report_timer_id, APP_TIMER_TICKS(APP_SCHED_STATS_REPORT_INTERVAL_MS), NULL);
+    }
+    if (rc != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Scheduler stats timer failed: 0x%x\n", rc);
+    }
+}
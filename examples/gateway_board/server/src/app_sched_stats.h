@@ -0,0 +1,74 @@
+#ifndef APP_SCHED_STATS_H__
+#define APP_SCHED_STATS_H__
+
+#include <stdint.h>
+
+#include "app_sched_prio.h"
+
+/*
+ * Scheduler instrumentation.
+ *
+ * app_sched_prio reports every put failure and handler run here. Per handler
+ * this keeps the number of runs, put failures and execution time; together
+ * with the per-class queue depth and latency from app_sched_prio it is logged
+ * on RTT and published as a vendor diagnostics message.
+ */
+
+/* Handlers tracked individually; further handlers run untracked. */
+#ifndef APP_SCHED_STATS_HANDLER_MAX
+#define APP_SCHED_STATS_HANDLER_MAX     20
+#endif
+
+/* Interval between reports (RTT and diagnostics message). */
+#ifndef APP_SCHED_STATS_REPORT_INTERVAL_MS
+#define APP_SCHED_STATS_REPORT_INTERVAL_MS (10 * 60 * 1000)
+#endif
+
+/* Handlers included in the diagnostics message, worst first. */
+#define APP_SCHED_STATS_ROWS            4
+/* Handler name length in the diagnostics message ("scheduled_" and "_handler" stripped). */
+#define APP_SCHED_STATS_NAME_LEN        10
+
+#define APP_SCHED_STATS_ID_NONE         0xFF
+
+typedef struct
+{
+    uint8_t depth_max;                      /* Queue high-watermark, events */
+    uint8_t queue_size;
+    uint16_t put_failures;                  /* Saturating */
+    uint32_t latency_max_us;                /* Put to start of the handler */
+} app_sched_stats_class_t;
+
+typedef struct
+{
+    char name[APP_SCHED_STATS_NAME_LEN];    /* Not NUL-terminated if full length */
+    uint16_t put_failures;                  /* Saturating */
+    uint32_t exec_max_us;
+} app_sched_stats_row_t;
+
+typedef struct
+{
+    app_sched_stats_class_t classes[APP_SCHED_CLASS_COUNT];
+    uint8_t row_count;
+    app_sched_stats_row_t rows[APP_SCHED_STATS_ROWS];
+} app_sched_stats_report_t;
+
+/** @brief Start the report timer. Call after app_timer_init(). */
+void app_sched_stats_init(void);
+
+/** @brief Id of the handler's counters, or APP_SCHED_STATS_ID_NONE if the table is full. */
+uint8_t app_sched_stats_handler_id(app_sched_prio_handler_t handler, const char * p_name);
+
+/** @brief Record a failed put. Safe to call from interrupt context. */
+void app_sched_stats_put_failed(uint8_t id, const char * p_name, uint32_t status);
+
+/** @brief Record a handler run of the given length in app_timer ticks. */
+void app_sched_stats_handler_ran(uint8_t id, uint32_t ticks);
+
+/** @brief Summary with the handlers that failed most, then ran longest. */
+void app_sched_stats_report_get(app_sched_stats_report_t * p_report);
+
+/** @brief Log all classes and tracked handlers on RTT. */
+void app_sched_stats_log(void);
+
+#endif /* APP_SCHED_STATS_H__ */
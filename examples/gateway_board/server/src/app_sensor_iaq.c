@@ -1,18 +1,28 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
-#include <math.h>
+#include <stdlib.h>
 
 #include "app_sensor_iaq.h"
 #include "app_timer.h"
-#include "app_scheduler.h"
-#include "nrf_drv_twi.h"
+#include "app_sched_prio.h"
 #include "nrf_error.h"
 #include "nrf_assert.h"
 #include "nrf_delay.h"
+#include "nrf.h"
 
 #include "log.h"
 #include "mesh_vendor_model.h"
+#include "app_iaq_store.h"
+#include "iaq_bulk.h"
+#include "iaq_sample.h"
+#include "app_power.h"
+#include "app_iaq_trace.h"
+#include "app_sensor_sig.h"
+#include "iaq_ext.h"
+#include "env_input.h"
+#include "twi_budget.h"
+#include "app_twi_bus.h"
 
 #include "zmod4xxx.h"
 #include "zmod4410_config_iaq2.h"
@@ -22,15 +32,70 @@
 #define APP_SENSOR_IAQ_MEAS_INTERVAL_MS 1000
 #endif
 
-#ifndef TWI_SCL_PIN
-#define TWI_SCL_PIN 27
+/* Bus priority of the ZMOD4410 window (app_twi_bus.h), and the time from the
+ * timer tick by which it must be done: the algorithm expects the samples at
+ * the sequencer's interval. */
+#ifndef APP_SENSOR_IAQ_BUS_PRIORITY
+#define APP_SENSOR_IAQ_BUS_PRIORITY 2
 #endif
-#ifndef TWI_SDA_PIN
-#define TWI_SDA_PIN 26
+#ifndef APP_SENSOR_IAQ_BUS_DEADLINE_MS
+#define APP_SENSOR_IAQ_BUS_DEADLINE_MS 100
+#endif
+
+/* Set to 1 to log DWT cycle counts for the float section of the measurement
+ * (calc_iaq_2nd_gen plus the fixed-point conversion). Used to compare the
+ * SoftFP and Hard float ABI builds on target. */
+#ifndef APP_SENSOR_IAQ_PROFILE
+#define APP_SENSOR_IAQ_PROFILE 0
+#endif
+#define PROFILE_REPORT_INTERVAL 60
+
+/* Extended telemetry (iaq_ext.h): the IAQ 2nd Gen outputs a live reading
+ * leaves out, published every APP_SENSOR_IAQ_EXT_PERIOD_S for offline model
+ * training. APP_SENSOR_IAQ_EXT_RMOX adds the per-step MOx resistances, which
+ * take the message from 3 to 7 segments. APP_SENSOR_IAQ_EXT_REL_IAQ needs an
+ * IAQ 2nd Gen library whose results carry rel_iaq. */
+#ifndef APP_SENSOR_IAQ_EXT_ENABLED
+#define APP_SENSOR_IAQ_EXT_ENABLED 0
+#endif
+#ifndef APP_SENSOR_IAQ_EXT_PERIOD_S
+#define APP_SENSOR_IAQ_EXT_PERIOD_S 300
+#endif
+#ifndef APP_SENSOR_IAQ_EXT_RMOX
+#define APP_SENSOR_IAQ_EXT_RMOX 1
+#endif
+#ifndef APP_SENSOR_IAQ_EXT_REL_IAQ
+#define APP_SENSOR_IAQ_EXT_REL_IAQ 0
+#endif
+
+/* Temperature and humidity compensation (env_input.h). APP_SENSOR_IAQ_ENV_LOCAL
+ * reads an SHT4x on the ZMOD4410's bus, in its own window right after the
+ * ZMOD4410's, and shares it every APP_SENSOR_IAQ_ENV_SHARE_S (0: never) as
+ * vendor Env Values. Env Values from APP_SENSOR_IAQ_ENV_MESH_SRC (0: any node)
+ * stand in while no local reading is fresh. */
+#ifndef APP_SENSOR_IAQ_ENV_LOCAL
+#define APP_SENSOR_IAQ_ENV_LOCAL 0
+#endif
+#ifndef APP_SENSOR_IAQ_ENV_SHARE_S
+#define APP_SENSOR_IAQ_ENV_SHARE_S 60
+#endif
+#ifndef APP_SENSOR_IAQ_ENV_MESH_SRC
+#define APP_SENSOR_IAQ_ENV_MESH_SRC 0
+#endif
+#ifndef APP_SENSOR_IAQ_ENV_BUS_PRIORITY
+#define APP_SENSOR_IAQ_ENV_BUS_PRIORITY 1
+#endif
+/* The result is read a cycle after the conversion is started, so the SHT4x
+ * only needs its window within the cycle */
+#ifndef APP_SENSOR_IAQ_ENV_BUS_DEADLINE_MS
+#define APP_SENSOR_IAQ_ENV_BUS_DEADLINE_MS (APP_SENSOR_IAQ_MEAS_INTERVAL_MS / 2)
+#endif
+
+#if APP_IAQ_TRACE_ENABLED && (ZMOD4410_ADC_DATA_LEN != APP_IAQ_TRACE_ADC_LEN)
+#error "ZMOD4410 ADC frame size does not match the trace record"
 #endif
 
 #define ZMOD4410_I2C_ADDR 0x32
-#define TWI_INSTANCE_ID 0
 
 #ifndef IAQ_2ND_GEN_OK
 #define IAQ_2ND_GEN_OK 0
@@ -39,15 +104,12 @@
 #define IAQ_2ND_GEN_STABILIZATION 1
 #endif
 
-#define IAQ_THRESHOLD       0.5f
-#define TVOC_THRESHOLD      0.05f
-#define ECO2_THRESHOLD      10.0f 
-
 
 static uint16_t m_sample_count = 0;
+static uint32_t m_uptime_ms = 0;
 static bool m_algorithm_stable = false;
 
-static const nrf_drv_twi_t m_twi = NRF_DRV_TWI_INSTANCE(TWI_INSTANCE_ID);
+static uint8_t m_bus_zmod = TWI_BUS_CLIENT_NONE;
 APP_TIMER_DEF(m_iaq_timer_id);
 
 static zmod4xxx_dev_t m_zmod_dev;
@@ -60,61 +122,227 @@ static bool m_sensor_initialized = false;
 static bool m_timer_running = false;
 
 typedef struct {
-    float last_iaq;
-    float last_tvoc;
-    float last_eco2;
+    sensor_cadence_t cadence[IAQ_SAMPLE_PROPERTY_COUNT];
+    iaq_sample_t published;
+    uint32_t published_ms;
     bool first_reading;
-} sensor_thresholds_t;
+} publish_cadence_t;
 
-static sensor_thresholds_t m_thresholds = {
-    .last_iaq = 0.0f,
-    .last_tvoc = 0.0f,
-    .last_eco2 = 0.0f,
+static publish_cadence_t m_cadence = {
     .first_reading = true
 };
 
+static iaq_history_t m_history;
+
+/* Samples read from the store per flash peek while filling a bulk transfer */
+#define BACKFILL_PEEK_CHUNK 8
+
+static iaq_bulk_sender_t m_bulk;
+
+/* Reference for the alarm fast path: the level last alerted on, or the
+ * highest level since the alert was re-armed; 0 before the first reading */
+static uint8_t m_alert_level;
+static bool m_alert_sent;
+static uint32_t m_alert_ms;             // Uptime of the last accepted alert
+
+static env_input_t m_env;
+static env_input_source_t m_env_source = ENV_INPUT_SOURCE_DEFAULT;
+#if APP_SENSOR_IAQ_ENV_LOCAL
+static uint8_t m_bus_env = TWI_BUS_CLIENT_NONE;
+static bool m_env_pending;              // SHT4x measurement started in the previous window
+static uint32_t m_env_share_next_ms;
+#endif
+
+#if APP_SENSOR_IAQ_EXT_ENABLED
+/* Captured from the measurement, sent from the BACKGROUND class */
+static iaq_ext_values_t m_ext;
+static uint32_t m_ext_uptime_s;
+static uint32_t m_ext_next_ms;
+static uint8_t m_ext_seq;
+#endif
+
 static void meas_timer_handler(void * p_context);
-static void scheduled_meas_handler(void * p_event_data, uint16_t event_size);
-static bool should_publish_data(float iaq, float tvoc, float eco2);
+static void meas_window(void);
+static bool should_publish_data(const iaq_sample_t * p_sample);
+
+#if APP_SENSOR_IAQ_PROFILE
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t count;
+} cycle_stats_t;
+
+static cycle_stats_t m_calc_cycles = { .min = UINT32_MAX };
+
+static void profile_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
 
-static bool is_valid_float(float val)
+static void profile_record(uint32_t cycles)
 {
-    if (val != val)
+    if (cycles < m_calc_cycles.min) m_calc_cycles.min = cycles;
+    if (cycles > m_calc_cycles.max) m_calc_cycles.max = cycles;
+    m_calc_cycles.total += cycles;
+    m_calc_cycles.count++;
+
+    if (m_calc_cycles.count % PROFILE_REPORT_INTERVAL == 0)
     {
-        return false;
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO,
+              "IAQ calc cycles (%s ABI): min=%u avg=%u max=%u over %u samples\n",
+#if defined(__ARM_PCS_VFP)
+              "hard",
+#else
+              "softfp",
+#endif
+              m_calc_cycles.min,
+              (uint32_t)(m_calc_cycles.total / m_calc_cycles.count),
+              m_calc_cycles.max,
+              m_calc_cycles.count);
     }
-    if (val > 1e10f || val < -1e10f)
+}
+#endif
+
+/* Buffer a reading that could not be published so it can be backfilled later. */
+static void store_unpublished(const iaq_sample_t * p_value)
+{
+    app_iaq_store_sample_t sample;
+    memset(&sample, 0, sizeof(sample));
+
+    sample.timestamp_s = m_uptime_ms / 1000;
+    sample.value = *p_value;
+
+    if (app_iaq_store_append(&sample))
     {
-        return false;
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Reading stored for backfill (seq %u)\n", sample.seq);
+    }
+}
+
+/* Start the next bulk transfer of stored readings when the sender's window
+ * and pacing allow (iaq_bulk.h). Runs once per measurement after the live
+ * reading, so backfill never delays live data; stored samples are dropped
+ * only when the gateway acknowledges them. */
+static void backfill_step(void)
+{
+    static uint8_t s_payload[MESH_VENDOR_BULK_PAYLOAD_MAX];
+    static app_iaq_store_sample_t s_chunk[BACKFILL_PEEK_CHUNK];
+
+    if (iaq_bulk_sender_check_timeout(&m_bulk, m_uptime_ms))
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Backfill not acknowledged, resending from seq %u\n",
+              m_bulk.next_seq);
+    }
+
+    /* Segments already handed to the advertiser would delay an alarm */
+    uint32_t first_seq;
+    if (app_iaq_store_pending_count() == 0 || !mesh_vendor_model_is_ready() ||
+        mesh_vendor_model_alert_in_flight() ||
+        !iaq_bulk_sender_ready(&m_bulk, app_iaq_store_oldest_seq(), m_uptime_ms, &first_seq))
+    {
+        return;
+    }
+
+    /* The sender hands out transfer numbers in order, so the next one is known */
+    iaq_bulk_writer_t writer;
+    iaq_bulk_writer_init(&writer, s_payload, sizeof(s_payload), m_bulk.next_transfer);
+
+    bool full = false;
+    while (!full)
+    {
+        uint32_t count = app_iaq_store_peek_from(first_seq + writer.count, s_chunk, BACKFILL_PEEK_CHUNK);
+        if (count == 0)
+        {
+            break;
+        }
+        for (uint32_t i = 0; i < count && !full; i++)
+        {
+            full = !iaq_bulk_writer_add(&writer, &s_chunk[i]);
+        }
+    }
+
+    if (writer.count > 0 && mesh_publish_sensor_bulk(s_payload, writer.length) == NRF_SUCCESS)
+    {
+        (void)iaq_bulk_sender_sent(&m_bulk, first_seq, writer.count, m_uptime_ms);
+    }
+}
+
+#if APP_SENSOR_IAQ_EXT_ENABLED
+static void scheduled_ext_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)p_event_data;
+    (void)event_size;
+
+    uint8_t payload[IAQ_EXT_PAYLOAD_MAX];
+    uint16_t length = iaq_ext_pack(&m_ext, m_ext_seq, m_ext_uptime_s, payload);
+
+    uint32_t status = NRF_ERROR_INVALID_STATE;
+    if (mesh_vendor_model_is_ready())
+    {
+        status = mesh_publish_sensor_ext(payload, length);
+    }
+    if (status == NRF_SUCCESS)
+    {
+        m_ext_seq++;
+    }
+    else
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_DBG1, "Ext values not sent: 0x%08X\n", status);
     }
-    return true;
 }
 
-static bool should_publish_data(float iaq, float tvoc, float eco2)
+/* Copy out the outputs the live reading leaves out; packing and publishing
+ * wait for the BACKGROUND class. Results are only valid after IAQ_2ND_GEN_OK. */
+static void ext_capture(void)
 {
-    if (m_thresholds.first_reading) {
-        m_thresholds.first_reading = false;
-        m_thresholds.last_iaq = iaq;
-        m_thresholds.last_tvoc = tvoc;
-        m_thresholds.last_eco2 = eco2;
+    m_ext.fields = IAQ_EXT_FIELD_ETOH | IAQ_EXT_FIELD_LOG_RCDA;
+    m_ext.etoh = m_iaq_results.etoh;
+    m_ext.log_rcda = m_iaq_results.log_rcda;
+#if APP_SENSOR_IAQ_EXT_REL_IAQ
+    m_ext.fields |= IAQ_EXT_FIELD_REL_IAQ;
+    m_ext.rel_iaq = m_iaq_results.rel_iaq;
+#endif
+#if APP_SENSOR_IAQ_EXT_RMOX
+    uint32_t count = sizeof(m_iaq_results.rmox) / sizeof(m_iaq_results.rmox[0]);
+    if (count > IAQ_EXT_RMOX_MAX)
+    {
+        count = IAQ_EXT_RMOX_MAX;
+    }
+    m_ext.fields |= IAQ_EXT_FIELD_RMOX;
+    m_ext.rmox_count = (uint8_t)count;
+    memcpy(m_ext.rmox, m_iaq_results.rmox, count * sizeof(m_ext.rmox[0]));
+#endif
+    m_ext_uptime_s = m_uptime_ms / 1000;
+
+    (void)APP_SCHED_PUT(APP_SCHED_CLASS_BACKGROUND, NULL, 0, scheduled_ext_handler);
+}
+#endif
+
+static bool should_publish_data(const iaq_sample_t * p_sample)
+{
+    if (m_cadence.first_reading) {
+        m_cadence.first_reading = false;
+        m_cadence.published = *p_sample;
+        m_cadence.published_ms = m_uptime_ms;
         __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "First reading - publishing to MQTT\n");
         return true;
     }
     
-    bool iaq_changed = fabsf(iaq - m_thresholds.last_iaq) >= IAQ_THRESHOLD;
-    bool tvoc_changed = fabsf(tvoc - m_thresholds.last_tvoc) >= TVOC_THRESHOLD;
-    bool eco2_changed = fabsf(eco2 - m_thresholds.last_eco2) >= ECO2_THRESHOLD;
+    uint8_t due = iaq_sample_due(m_cadence.cadence, &m_cadence.published,
+                                 m_uptime_ms - m_cadence.published_ms,
+                                 mesh_vendor_model_publish_period_ms(), p_sample);
     
-    if (iaq_changed || tvoc_changed || eco2_changed) {
-        m_thresholds.last_iaq = iaq;
-        m_thresholds.last_tvoc = tvoc;
-        m_thresholds.last_eco2 = eco2;
+    if (due != 0) {
+        m_cadence.published = *p_sample;
+        m_cadence.published_ms = m_uptime_ms;
         
         __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, 
-              "Threshold exceeded - IAQ: %s, TVOC: %s, eCO2: %s\n",
-              iaq_changed ? "YES" : "NO",
-              tvoc_changed ? "YES" : "NO",
-              eco2_changed ? "YES" : "NO");
+              "Publish due - IAQ: %s, TVOC: %s, eCO2: %s\n",
+              (due & IAQ_SAMPLE_CHANGED_IAQ) ? "YES" : "NO",
+              (due & IAQ_SAMPLE_CHANGED_TVOC) ? "YES" : "NO",
+              (due & IAQ_SAMPLE_CHANGED_ECO2) ? "YES" : "NO");
         return true;
     }
     
@@ -126,14 +354,14 @@ static int8_t hal_i2c_read(uint8_t dev_addr, uint8_t reg_addr, uint8_t *data, ui
 {
     ret_code_t err;
     
-    err = nrf_drv_twi_tx(&m_twi, dev_addr, &reg_addr, 1, true);
+    err = app_twi_bus_tx(dev_addr, &reg_addr, 1, true);
     if (err != NRF_SUCCESS)
     {
         __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "I2C read tx failed: 0x%x\n", err);
         return -1;
     }
     
-    err = nrf_drv_twi_rx(&m_twi, dev_addr, data, len);
+    err = app_twi_bus_rx(dev_addr, data, len);
     if (err != NRF_SUCCESS)
     {
         __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "I2C read rx failed: 0x%x\n", err);
@@ -157,7 +385,7 @@ static int8_t hal_i2c_write(uint8_t dev_addr, uint8_t reg_addr, uint8_t *data, u
     buf[0] = reg_addr;
     memcpy(&buf[1], data, len);
     
-    err = nrf_drv_twi_tx(&m_twi, dev_addr, buf, len + 1, false);
+    err = app_twi_bus_tx(dev_addr, buf, len + 1, false);
     if (err != NRF_SUCCESS)
     {
         __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "I2C write failed: 0x%x\n", err);
@@ -172,23 +400,60 @@ static void hal_delay_ms(uint32_t ms)
     nrf_delay_ms(ms);
 }
 
-static bool sensor_init_zmod(void)
+#if APP_SENSOR_IAQ_ENV_LOCAL
+/* SHT4x bus window: collect the result started one cycle ago, then start the
+ * next one. */
+static void env_window(void)
 {
-    int8_t ret;
-    
-    nrf_drv_twi_config_t config = NRF_DRV_TWI_DEFAULT_CONFIG;
-    config.scl = TWI_SCL_PIN;
-    config.sda = TWI_SDA_PIN;
-    config.frequency = NRF_DRV_TWI_FREQ_100K;
-    
-    ret_code_t err = nrf_drv_twi_init(&m_twi, &config, NULL, NULL);
-    if (err != NRF_SUCCESS)
+    if (m_env_pending)
     {
-        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "TWI init failed: 0x%x\n", err);
-        return false;
+        uint8_t raw[ENV_SHT4X_RESULT_LEN];
+        env_input_value_t value;
+        if (app_twi_bus_rx(ENV_SHT4X_I2C_ADDR, raw, sizeof(raw)) == NRF_SUCCESS &&
+            env_input_sht4x_decode(raw, &value) &&
+            env_input_update(&m_env, ENV_INPUT_SOURCE_LOCAL, &value, m_uptime_ms))
+        {
+            if (APP_SENSOR_IAQ_ENV_SHARE_S > 0 && mesh_vendor_model_is_ready() &&
+                (int32_t)(m_uptime_ms - m_env_share_next_ms) >= 0 &&
+                mesh_publish_env_values(&value) == NRF_SUCCESS)
+            {
+                m_env_share_next_ms = m_uptime_ms + APP_SENSOR_IAQ_ENV_SHARE_S * 1000;
+            }
+        }
+        else
+        {
+            __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "SHT4x read failed\n");
+        }
     }
-    nrf_drv_twi_enable(&m_twi);
-    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "TWI initialized\n");
+
+    uint8_t cmd = ENV_SHT4X_CMD_MEASURE_HIGH;
+    m_env_pending = (app_twi_bus_tx(ENV_SHT4X_I2C_ADDR, &cmd, 1, false) == NRF_SUCCESS);
+}
+#endif
+
+/* Feed this cycle's compensation inputs to the algorithm */
+static void env_apply(void)
+{
+    env_input_value_t value;
+    env_input_source_t source = env_input_get(&m_env, m_uptime_ms, &value);
+
+    m_iaq_inputs.temperature_degc = (float)value.temp_x100 * 0.01f;
+    m_iaq_inputs.humidity_pct = (float)value.rh_x100 * 0.01f;
+
+    if (source != m_env_source)
+    {
+        static const char * const p_names[] = { "local", "mesh", "default" };
+        uint32_t temp_abs = (uint32_t)abs(value.temp_x100);
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Compensation input: %s, %s%u.%02u degC, %u.%02u %%RH\n",
+              p_names[source], (value.temp_x100 < 0) ? "-" : "", temp_abs / 100, temp_abs % 100,
+              value.rh_x100 / 100, value.rh_x100 % 100);
+        m_env_source = source;
+    }
+}
+
+static bool sensor_init_zmod(void)
+{
+    int8_t ret;
     
     m_zmod_dev.i2c_addr = ZMOD4410_I2C_ADDR;
     m_zmod_dev.pid = ZMOD4410_PID;
@@ -223,6 +488,17 @@ static bool sensor_init_zmod(void)
     
     m_sample_count = 0;
     m_algorithm_stable = false;
+
+    env_input_init(&m_env);
+    env_apply();
+
+    uint32_t window_us = twi_budget_cycle_us(twi_budget_zmod_cycle, TWI_BUDGET_ZMOD_CYCLE_COUNT, APP_TWI_BUS_FREQ_HZ);
+#if APP_SENSOR_IAQ_ENV_LOCAL
+    window_us += twi_budget_cycle_us(twi_budget_env_cycle, TWI_BUDGET_ENV_CYCLE_COUNT, APP_TWI_BUS_FREQ_HZ);
+#endif
+    __LOG(LOG_SRC_APP, twi_budget_fits(window_us, APP_SENSOR_IAQ_MEAS_INTERVAL_MS) ? LOG_LEVEL_INFO : LOG_LEVEL_WARN,
+          "TWI window per cycle: %u us (budget %u us)\n",
+          window_us, APP_SENSOR_IAQ_MEAS_INTERVAL_MS * TWI_BUDGET_CYCLE_PERMILLE);
     
     memset(&m_iaq_results, 0, sizeof(m_iaq_results));
     
@@ -234,47 +510,32 @@ static bool sensor_init_zmod(void)
     }
     
     __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "ZMOD4410 initialized successfully\n");
-    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Thresholds - IAQ: %.2f, TVOC: %.2f, eCO2: %.0f\n",
-          (double)IAQ_THRESHOLD, (double)TVOC_THRESHOLD, (double)ECO2_THRESHOLD);
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Thresholds - IAQ: %u.%u, TVOC: %u.%02u, eCO2: %u\n",
+          IAQ_SAMPLE_IAQ_THRESHOLD_X10 / 10, IAQ_SAMPLE_IAQ_THRESHOLD_X10 % 10,
+          IAQ_SAMPLE_TVOC_THRESHOLD_X100 / 100, IAQ_SAMPLE_TVOC_THRESHOLD_X100 % 100,
+          IAQ_SAMPLE_ECO2_THRESHOLD);
     
     return true;
 }
 
-static void scheduled_meas_handler(void * p_event_data, uint16_t event_size)
+/* Runs the algorithm on the ADC result of the last window, with the bus
+ * already released */
+static void scheduled_calc_handler(void * p_event_data, uint16_t event_size)
 {
     (void)p_event_data;
     (void)event_size;
-    
-    if (!m_sensor_initialized)
-    {
-        return;
-    }
-    
+
     int8_t ret;
-    uint8_t status;
-    
-    ret = zmod4xxx_read_status(&m_zmod_dev, &status);
-    if (ret)
-    {
-        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Failed to read status: %d\n", ret);
-        return;
-    }
-    
-    if ((status & STATUS_SEQUENCER_RUNNING_MASK) != 0)
-    {
-        return;
-    }
-    
-    ret = zmod4xxx_read_adc_result(&m_zmod_dev, m_zmod_adc_result);
-    if (ret)
-    {
-        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Failed to read ADC: %d\n", ret);
-        goto start_next;
-    }
-    
+
     m_iaq_inputs.adc_result = m_zmod_adc_result;
+    env_apply();
     
+#if APP_SENSOR_IAQ_PROFILE
+    uint32_t calc_start = DWT->CYCCNT;
+#endif
     ret = calc_iaq_2nd_gen(&m_iaq_handle, &m_zmod_dev, NULL, &m_iaq_inputs, &m_iaq_results);
+    app_iaq_trace_record(m_uptime_ms, m_zmod_adc_result, ret,
+                         m_iaq_results.iaq, m_iaq_results.tvoc, m_iaq_results.eco2);
     
     m_sample_count++;
     
@@ -284,12 +545,12 @@ static void scheduled_meas_handler(void * p_event_data, uint16_t event_size)
         {
             __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Stabilizing... sample %u (algorithm warming up)\n", m_sample_count);
         }
-        goto start_next;
+        return;
     }
     else if (ret != IAQ_2ND_GEN_OK)
     {
         __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "IAQ calc error: %d\n", ret);
-        goto start_next;
+        return;
     }
     
     if (!m_algorithm_stable)
@@ -299,72 +560,197 @@ static void scheduled_meas_handler(void * p_event_data, uint16_t event_size)
               "*** Sensor stabilized after %u samples ***\n", m_sample_count);
     }
     
-    if (!is_valid_float(m_iaq_results.iaq) || 
-        !is_valid_float(m_iaq_results.tvoc) || 
-        !is_valid_float(m_iaq_results.eco2))
+#if APP_SENSOR_IAQ_EXT_ENABLED
+    if (iaq_ext_due(&m_ext_next_ms, m_uptime_ms, APP_SENSOR_IAQ_EXT_PERIOD_S * 1000))
     {
-        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Invalid IAQ results (NaN or overflow)\n");
-        goto start_next;
+        ext_capture();
     }
-    
-    int16_t iaq_int = (int16_t)(m_iaq_results.iaq);
-    int16_t iaq_frac = (int16_t)((m_iaq_results.iaq - (float)iaq_int) * 10.0f);
-    if (iaq_frac < 0) iaq_frac = -iaq_frac;
-    
-    uint16_t tvoc_int = (uint16_t)(m_iaq_results.tvoc);
-    uint16_t tvoc_frac = (uint16_t)((m_iaq_results.tvoc - (float)tvoc_int) * 100.0f);
-    
-    uint16_t eco2_int = (uint16_t)(m_iaq_results.eco2);
-    
-    if (iaq_int < 0 || iaq_int > 500 || eco2_int > 10000)
+#endif
+
+    /* Single float -> fixed-point conversion; everything below is integer math */
+    iaq_sample_t sample;
+    bool sample_valid = iaq_sample_from_float(m_iaq_results.iaq, m_iaq_results.tvoc, m_iaq_results.eco2, &sample);
+#if APP_SENSOR_IAQ_PROFILE
+    profile_record(DWT->CYCCNT - calc_start);
+#endif
+    if (!sample_valid)
     {
-        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, 
-              "IAQ values out of range: iaq=%d, eco2=%u\n", iaq_int, eco2_int);
-        goto start_next;
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Invalid IAQ results (NaN or out of range)\n");
+        return;
     }
     
     __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, 
-          "IAQ: %d.%d, TVOC: %u.%02u mg/m3, eCO2: %u ppm\n",
-          iaq_int, iaq_frac,
-          tvoc_int, tvoc_frac,
-          eco2_int);
+          "IAQ: %u.%u, TVOC: %u.%02u mg/m3, eCO2: %u ppm\n",
+          sample.iaq_x10 / 10, sample.iaq_x10 % 10,
+          sample.tvoc_x100 / 100, sample.tvoc_x100 % 100,
+          sample.eco2);
     
-    if (should_publish_data(m_iaq_results.iaq, m_iaq_results.tvoc, m_iaq_results.eco2))
+    iaq_history_add(&m_history, &sample, m_uptime_ms);
+
+    /* Alarm fast path: a rise into the poor/bad levels goes out acknowledged
+     * right away, and the reading itself is published whatever the cadence.
+     * A reading hovering at a level boundary would otherwise alert on every
+     * crossing: the reference only falls MESH_VENDOR_ALERT_HYSTERESIS levels
+     * below it, and a rise within the hold-off waits for it to end. The level
+     * is latched only once the alert is accepted, so a refused one is raised
+     * again with the next reading. */
+    uint8_t level = iaq_sample_level(sample.iaq_x10);
+    if (level + MESH_VENDOR_ALERT_HYSTERESIS <= m_alert_level ||
+        (level < MESH_VENDOR_ALERT_LEVEL && level > m_alert_level))
+    {
+        m_alert_level = level;
+    }
+
+    bool alarm = false;
+    if (level >= MESH_VENDOR_ALERT_LEVEL && level > m_alert_level &&
+        (!m_alert_sent || m_uptime_ms - m_alert_ms >= MESH_VENDOR_ALERT_HOLDOFF_MS) &&
+        mesh_vendor_model_is_ready() &&
+        mesh_publish_sensor_alert(&sample, m_alert_level) == NRF_SUCCESS)
     {
+        m_alert_level = level;
+        m_alert_sent = true;
+        m_alert_ms = m_uptime_ms;
+        alarm = true;
+    }
+
+    /* The SIG Sensor Server runs its own cadence on every reading */
+    app_sensor_sig_update(&sample, m_uptime_ms);
+
+    bool publish = should_publish_data(&sample);
+    if (alarm && !publish)
+    {
+        m_cadence.published = sample;
+        m_cadence.published_ms = m_uptime_ms;
+        publish = true;
+    }
+
+    if (publish)
+    {
+        uint32_t status = NRF_ERROR_INVALID_STATE;
         if (mesh_vendor_model_is_ready())
         {
-            mesh_publish_sensor_values(
-                m_iaq_results.iaq,
-                m_iaq_results.tvoc,
-                m_iaq_results.eco2
-            );
+            status = mesh_publish_sensor_values(&sample, m_uptime_ms / 1000);
+        }
+
+        if (status == NRF_SUCCESS)
+        {
             __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Published to mesh network\n");
         }
+        else if (status == NRF_ERROR_BUSY)
+        {
+            __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Publish deferred to retry queue\n");
+        }
         else
         {
-            __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Vendor model not ready, skipping publish\n");
+            __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Mesh not reachable, storing reading\n");
+            store_unpublished(&sample);
         }
     }
+
+    backfill_step();
+}
+
+/* ZMOD4410 bus window, run from the SENSOR class once the bus is granted:
+ * collect the finished measurement and start the next one. The algorithm
+ * runs after the window so it does not hold the bus. */
+static void meas_window(void)
+{
+    if (!m_sensor_initialized)
+    {
+        return;
+    }
+
+    m_uptime_ms += APP_SENSOR_IAQ_MEAS_INTERVAL_MS;
     
-start_next:
+    int8_t ret;
+    uint8_t status;
+    
+    ret = zmod4xxx_read_status(&m_zmod_dev, &status);
+    if (ret)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Failed to read status: %d\n", ret);
+        return;
+    }
+    
+    if ((status & STATUS_SEQUENCER_RUNNING_MASK) != 0)
+    {
+        return;
+    }
+    
+    ret = zmod4xxx_read_adc_result(&m_zmod_dev, m_zmod_adc_result);
+    bool adc_valid = (ret == 0);
+    if (!adc_valid)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Failed to read ADC: %d\n", ret);
+    }
+
     ret = zmod4xxx_start_measurement(&m_zmod_dev);
     if (ret)
     {
         __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Failed to start next measurement: %d\n", ret);
     }
+
+    /* The sensor class is drained before anything else runs, so the result
+     * buffer is processed long before the next window overwrites it */
+    if (adc_valid)
+    {
+        (void)APP_SCHED_PUT(APP_SCHED_CLASS_SENSOR, NULL, 0, scheduled_calc_handler);
+    }
 }
 
 static void meas_timer_handler(void * p_context)
 {
     (void)p_context;
-    app_sched_event_put(NULL, 0, scheduled_meas_handler);
+    app_power_wake_mark(APP_POWER_SRC_TIMER);
+    /* A request still pending from the last tick means the loop or the bus is
+     * stuck; the two ticks get one window and this cycle is skipped. The
+     * arbiter's statistics show which. */
+    (void)app_twi_bus_request(m_bus_zmod, APP_SENSOR_IAQ_BUS_DEADLINE_MS);
+#if APP_SENSOR_IAQ_ENV_LOCAL
+    (void)app_twi_bus_request(m_bus_env, APP_SENSOR_IAQ_ENV_BUS_DEADLINE_MS);
+#endif
+}
+
+void app_sensor_iaq_env_received(uint16_t src_addr, const env_input_value_t * p_value)
+{
+    if (APP_SENSOR_IAQ_ENV_MESH_SRC != 0 && src_addr != APP_SENSOR_IAQ_ENV_MESH_SRC)
+    {
+        return;
+    }
+    if (!env_input_update(&m_env, ENV_INPUT_SOURCE_MESH, p_value, m_uptime_ms))
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Env values from 0x%04X out of range\n", src_addr);
+    }
 }
 
 void app_sensor_iaq_init(void)
 {
     __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "app_sensor_iaq_init\n");
     
-    m_sensor_initialized = sensor_init_zmod();
+#if APP_SENSOR_IAQ_PROFILE
+    profile_init();
+#endif
+    app_iaq_trace_init();
+    iaq_sample_cadence_default(m_cadence.cadence);
+    iaq_history_init(&m_history);
+    iaq_bulk_sender_init(&m_bulk);
+    
+    m_bus_zmod = app_twi_bus_client_add("zmod4410", APP_SENSOR_IAQ_BUS_PRIORITY, meas_window);
+#if APP_SENSOR_IAQ_ENV_LOCAL
+    m_bus_env = app_twi_bus_client_add("sht4x", APP_SENSOR_IAQ_ENV_BUS_PRIORITY, env_window);
+    if (m_bus_env == TWI_BUS_CLIENT_NONE)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "No TWI bus client for the SHT4x\n");
+        return;
+    }
+#endif
+
+    /* Initialization is blocking and runs before the timer, so the bus is idle */
+    if (m_bus_zmod != TWI_BUS_CLIENT_NONE && app_twi_bus_claim(m_bus_zmod))
+    {
+        m_sensor_initialized = sensor_init_zmod();
+        app_twi_bus_release(m_bus_zmod);
+    }
     
     if (!m_sensor_initialized)
     {
@@ -422,6 +808,51 @@ void app_sensor_iaq_stop(void)
 
 void app_sensor_iaq_reset_thresholds(void)
 {
-    m_thresholds.first_reading = true;
+    m_cadence.first_reading = true;
     __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Thresholds reset - next reading will publish\n");
 }
+
+bool app_sensor_iaq_cadence_get(iaq_sample_property_t property, sensor_cadence_t * p_cadence)
+{
+    if (property >= IAQ_SAMPLE_PROPERTY_COUNT)
+    {
+        return false;
+    }
+    *p_cadence = m_cadence.cadence[property];
+    return true;
+}
+
+bool app_sensor_iaq_cadence_set(iaq_sample_property_t property, const sensor_cadence_t * p_cadence)
+{
+    if (property >= IAQ_SAMPLE_PROPERTY_COUNT)
+    {
+        return false;
+    }
+    m_cadence.cadence[property] = *p_cadence;
+
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO,
+          "Cadence %u: divisor 2^%u, delta -%u/+%u%s, min interval 2^%u ms, fast %u..%u\n",
+          property, p_cadence->fast_divisor_log2,
+          p_cadence->delta_down, p_cadence->delta_up,
+          p_cadence->trigger_percent ? " (0.01 %)" : "",
+          p_cadence->min_interval_log2, p_cadence->fast_low, p_cadence->fast_high);
+    return true;
+}
+
+uint32_t app_sensor_iaq_series_get(uint32_t from, uint32_t to, iaq_sample_t * p_out, uint32_t max,
+                                   uint32_t * p_first, uint32_t * p_last, uint32_t * p_now)
+{
+    *p_now = iaq_history_bucket(m_uptime_ms);
+    return iaq_history_query(&m_history, from, to, p_out, max, p_first, p_last);
+}
+
+void app_sensor_iaq_bulk_ack(uint8_t transfer, uint32_t first_seq)
+{
+    uint32_t delivered_seq;
+    if (iaq_bulk_sender_ack(&m_bulk, transfer, first_seq, &delivered_seq))
+    {
+        app_iaq_store_ack_until(delivered_seq);
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Backfill delivered up to seq %u, %u pending\n",
+              delivered_seq, app_iaq_store_pending_count());
+    }
+}
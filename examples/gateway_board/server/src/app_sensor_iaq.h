@@ -3,10 +3,80 @@
 
 #include <stdbool.h>
 
+#include "app_config.h"
+#include "iaq_sample.h"
+#include "sensor_cadence.h"
+#include "iaq_history.h"
+#include "env_input.h"
+
+#if APP_FEATURE_SENSOR
 void app_sensor_iaq_init(void);
 void app_sensor_iaq_start(void);
 void app_sensor_iaq_stop(void);
 void app_sensor_iaq_reset_thresholds(void);
 
+/**
+ * @brief Read or change the publish cadence of one quantity of the vendor
+ * readings. Set over the mesh with the vendor Cadence Set message; the
+ * defaults (iaq_sample.h) are restored on reset.
+ *
+ * @return false if there is no such quantity.
+ */
+bool app_sensor_iaq_cadence_get(iaq_sample_property_t property, sensor_cadence_t * p_cadence);
+bool app_sensor_iaq_cadence_set(iaq_sample_property_t property, const sensor_cadence_t * p_cadence);
+
+/**
+ * @brief Read the RAM history, see iaq_history_query().
+ *
+ * @param[out] p_now Bucket currently being accumulated.
+ */
+uint32_t app_sensor_iaq_series_get(uint32_t from, uint32_t to, iaq_sample_t * p_out, uint32_t max,
+                                   uint32_t * p_first, uint32_t * p_last, uint32_t * p_now);
+
+/** @brief Bulk Ack from the gateway: free the stored samples it has received. */
+void app_sensor_iaq_bulk_ack(uint8_t transfer, uint32_t first_seq);
+
+/** @brief Env Values from a neighbour, a compensation input source (env_input.h). */
+void app_sensor_iaq_env_received(uint16_t src_addr, const env_input_value_t * p_value);
+#else
+/* Gateway-only build: no sensor attached */
+static inline void app_sensor_iaq_init(void) {}
+static inline void app_sensor_iaq_start(void) {}
+static inline void app_sensor_iaq_stop(void) {}
+static inline void app_sensor_iaq_reset_thresholds(void) {}
+static inline bool app_sensor_iaq_cadence_get(iaq_sample_property_t property, sensor_cadence_t * p_cadence)
+{
+    (void)property;
+    (void)p_cadence;
+    return false;
+}
+static inline bool app_sensor_iaq_cadence_set(iaq_sample_property_t property, const sensor_cadence_t * p_cadence)
+{
+    (void)property;
+    (void)p_cadence;
+    return false;
+}
+static inline uint32_t app_sensor_iaq_series_get(uint32_t from, uint32_t to, iaq_sample_t * p_out, uint32_t max,
+                                                 uint32_t * p_first, uint32_t * p_last, uint32_t * p_now)
+{
+    (void)p_out;
+    (void)max;
+    *p_first = from;
+    *p_last = to;
+    *p_now = 0;
+    return 0;
+}
+static inline void app_sensor_iaq_bulk_ack(uint8_t transfer, uint32_t first_seq)
+{
+    (void)transfer;
+    (void)first_seq;
+}
+static inline void app_sensor_iaq_env_received(uint16_t src_addr, const env_input_value_t * p_value)
+{
+    (void)src_addr;
+    (void)p_value;
+}
+#endif
+
 
 #endif // APP_SENSOR_IAQ_H__
@@ -0,0 +1,509 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "app_sensor_sig.h"
+#include "sensor_cadence.h"
+
+#if APP_FEATURE_SENSOR
+
+#include "sensor_setup_server.h"
+#include "access.h"
+#include "nrf_mesh.h"
+#include "nrf_error.h"
+#include "log.h"
+
+#define PROPERTY_COUNT                  2
+#define PROPERTY_VALUE_LEN              2       /* Both properties are uint16 */
+#define PROPERTY_VALUE_UNKNOWN          0xFFFF
+#define PROPERTY_VALUE_MAX              0xFFFE  /* "value is this or higher" */
+
+/* Marshalled Sensor Data, Format A: 2 octet header (11 bit property ID) + value */
+#define MARSHALLED_LEN                  (2 + PROPERTY_VALUE_LEN)
+/* Cadence: property ID, then the encoded cadence (both properties are uint16) */
+#define CADENCE_LEN                     (2 + SENSOR_CADENCE_ENCODED_LEN)
+/* Column Status: the property ID and Raw Value X of the request */
+#define COLUMN_STATUS_MAX               (2 + PROPERTY_VALUE_LEN)
+
+#define SAMPLING_FUNCTION_INSTANTANEOUS 0x01
+#define PERIOD_NOT_APPLICABLE           0x00
+#define PERIOD_1S                       64      /* 1.1^(n - 64) s */
+
+typedef struct
+{
+    uint16_t property_id;
+    sensor_cadence_t cadence;
+    /* Runtime */
+    uint16_t value;
+    uint16_t published;
+    uint32_t published_ms;
+    bool has_published;
+} sensor_property_t;
+
+static sensor_property_t m_properties[PROPERTY_COUNT] =
+{
+    {
+        .property_id = APP_SENSOR_SIG_PROPERTY_CO2,
+        .cadence =
+        {
+            .fast_divisor_log2 = APP_SENSOR_SIG_FAST_DIVISOR_LOG2,
+            .delta_down = APP_SENSOR_SIG_CO2_DELTA,
+            .delta_up = APP_SENSOR_SIG_CO2_DELTA,
+            .min_interval_log2 = APP_SENSOR_SIG_MIN_INTERVAL_LOG2,
+            .fast_low = APP_SENSOR_SIG_CO2_FAST_LOW,
+            .fast_high = PROPERTY_VALUE_UNKNOWN,
+        },
+        .value = PROPERTY_VALUE_UNKNOWN,
+    },
+    {
+        .property_id = APP_SENSOR_SIG_PROPERTY_VOC,
+        .cadence =
+        {
+            .fast_divisor_log2 = APP_SENSOR_SIG_FAST_DIVISOR_LOG2,
+            .delta_down = APP_SENSOR_SIG_VOC_DELTA,
+            .delta_up = APP_SENSOR_SIG_VOC_DELTA,
+            .min_interval_log2 = APP_SENSOR_SIG_MIN_INTERVAL_LOG2,
+            .fast_low = APP_SENSOR_SIG_VOC_FAST_LOW,
+            .fast_high = PROPERTY_VALUE_UNKNOWN,
+        },
+        .value = PROPERTY_VALUE_UNKNOWN,
+    },
+};
+
+/* Property count, then the IDs, as in the SDK sensor example */
+static uint16_t m_property_array[] = { PROPERTY_COUNT, APP_SENSOR_SIG_PROPERTY_CO2, APP_SENSOR_SIG_PROPERTY_VOC };
+
+static sensor_setup_server_t m_server;
+static bool m_server_ready = false;
+
+/* Time of the last reading, for the publications of the publish period */
+static uint32_t m_now_ms = 0;
+
+/* Publish period of the Sensor Server. Re-read only after a config server
+ * event invalidates it, so a reading never queries the stack. */
+static bool m_period_valid = false;
+static uint32_t m_period_ms = 0;
+
+/* Statuses built by the callbacks; the model sends them after they return */
+static sensor_descriptor_status_msg_pkt_t m_descriptor_status[PROPERTY_COUNT];
+static sensor_descriptor_status_msg_pkt_t m_descriptor_unknown;
+static uint8_t m_status[PROPERTY_COUNT * MARSHALLED_LEN];
+static uint8_t m_cadence_status[CADENCE_LEN];
+static uint8_t m_column_status[COLUMN_STATUS_MAX];
+static sensor_series_status_msg_pkt_t m_series_status;
+static sensor_settings_status_msg_pkt_t m_settings_status;
+static sensor_setting_status_msg_pkt_t m_setting_status;
+
+static uint8_t * put_u16(uint8_t * p, uint16_t v)
+{
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+    return p + 2;
+}
+
+static sensor_property_t * property_find(uint16_t property_id)
+{
+    for (uint32_t i = 0; i < PROPERTY_COUNT; i++)
+    {
+        if (m_properties[i].property_id == property_id)
+        {
+            return &m_properties[i];
+        }
+    }
+    return NULL;
+}
+
+static uint8_t * marshal_value(uint8_t * p, const sensor_property_t * p_property)
+{
+    /* Format A: bit 0 format (0), bits 1-4 length - 1, bits 5-15 property ID */
+    p = put_u16(p, (uint16_t)(((PROPERTY_VALUE_LEN - 1) << 1) | (p_property->property_id << 5)));
+    return put_u16(p, p_property->value);
+}
+
+static uint8_t * marshal_unknown(uint8_t * p, uint16_t property_id)
+{
+    /* Format B with length 0x7F: property ID only, no value */
+    *p++ = 0xFF;
+    return put_u16(p, property_id);
+}
+
+/* Cadence Status into m_cadence_status; an unknown property gets its ID only */
+static uint16_t cadence_status_build(uint16_t property_id)
+{
+    const sensor_property_t * p_property = property_find(property_id);
+    uint8_t * p = put_u16(m_cadence_status, property_id);
+
+    if (p_property != NULL)
+    {
+        p += sensor_cadence_encode(&p_property->cadence, p);
+    }
+    return (uint16_t)(p - m_cadence_status);
+}
+
+/* ---- Cadence ---- */
+
+static uint32_t publish_period_ms(void)
+{
+    static const uint32_t s_resolution_ms[] = { 100, 1000, 10000, 600000 };
+    access_publish_resolution_t resolution;
+    uint8_t steps;
+
+    if (!m_period_valid)
+    {
+        m_period_valid = true;
+        m_period_ms = 0;
+        if (access_model_publish_period_get(m_server.sensor_srv.model_handle, &resolution, &steps) == NRF_SUCCESS &&
+            (uint32_t)resolution < ARRAY_SIZE(s_resolution_ms))
+        {
+            m_period_ms = steps * s_resolution_ms[resolution];
+        }
+    }
+    return m_period_ms;
+}
+
+/* Status triggers and the fast cadence period. The publish period itself is
+ * the model's: its publish timeout calls sensor_publication_schedule_cb(). */
+static bool is_due(const sensor_property_t * p_property, uint32_t now_ms)
+{
+    if (p_property->value == PROPERTY_VALUE_UNKNOWN)
+    {
+        return false;
+    }
+
+    uint32_t period_ms = sensor_cadence_in_fast_range(&p_property->cadence, p_property->value) ?
+                         publish_period_ms() : 0;
+    uint32_t elapsed_ms = p_property->has_published ? now_ms - p_property->published_ms : SENSOR_CADENCE_NEVER;
+    return sensor_cadence_is_due(&p_property->cadence, p_property->value, p_property->published,
+                                 elapsed_ms, period_ms);
+}
+
+/* Publish the properties marked in p_due together in one Sensor Status */
+static void status_publish(const bool * p_due, uint32_t now_ms)
+{
+    uint8_t buf[PROPERTY_COUNT * MARSHALLED_LEN];
+    uint8_t * p = buf;
+
+    for (uint32_t i = 0; i < PROPERTY_COUNT; i++)
+    {
+        if (p_due[i])
+        {
+            p = marshal_value(p, &m_properties[i]);
+        }
+    }
+
+    if (p == buf)
+    {
+        return;
+    }
+
+    uint32_t status = sensor_server_status_publish(&m_server.sensor_srv, buf, (uint16_t)(p - buf),
+                                                   SENSOR_OPCODE_STATUS);
+    if (status != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_DBG1, "Sensor Status publish failed: 0x%x\n", status);
+        return;
+    }
+
+    for (uint32_t i = 0; i < PROPERTY_COUNT; i++)
+    {
+        if (p_due[i])
+        {
+            m_properties[i].published = m_properties[i].value;
+            m_properties[i].published_ms = now_ms;
+            m_properties[i].has_published = true;
+        }
+    }
+}
+
+/* ---- Sensor Setup Server callbacks ---- */
+
+static void sensor_descriptor_get_cb(const sensor_setup_server_t * p_self,
+                                     const access_message_rx_meta_t * p_meta,
+                                     uint16_t property_id,
+                                     sensor_descriptor_status_msg_pkt_t ** pp_out,
+                                     uint16_t * p_out_bytes)
+{
+    (void)p_self;
+    (void)p_meta;
+
+    if (property_id == SENSOR_NO_PROPERTY_ID)
+    {
+        *pp_out = m_descriptor_status;
+        *p_out_bytes = PROPERTY_COUNT * SENSOR_DESCRIPTOR_MSG_SIZE;
+        return;
+    }
+
+    for (uint32_t i = 0; i < PROPERTY_COUNT; i++)
+    {
+        if (m_properties[i].property_id == property_id)
+        {
+            *pp_out = &m_descriptor_status[i];
+            *p_out_bytes = SENSOR_DESCRIPTOR_MSG_SIZE;
+            return;
+        }
+    }
+
+    /* Unknown property: the ID only */
+    m_descriptor_unknown.property_id = property_id;
+    *pp_out = &m_descriptor_unknown;
+    *p_out_bytes = sizeof(uint16_t);
+}
+
+static void sensor_state_get_cb(const sensor_setup_server_t * p_self,
+                                const access_message_rx_meta_t * p_meta,
+                                uint16_t property_id,
+                                sensor_status_msg_pkt_t ** pp_out,
+                                uint16_t * p_out_bytes)
+{
+    (void)p_self;
+    (void)p_meta;
+    uint8_t * p = m_status;
+
+    if (property_id == SENSOR_NO_PROPERTY_ID)
+    {
+        for (uint32_t i = 0; i < PROPERTY_COUNT; i++)
+        {
+            p = marshal_value(p, &m_properties[i]);
+        }
+    }
+    else
+    {
+        const sensor_property_t * p_property = property_find(property_id);
+        p = (p_property != NULL) ? marshal_value(p, p_property) : marshal_unknown(p, property_id);
+    }
+
+    *pp_out = m_status;
+    *p_out_bytes = (uint16_t)(p - m_status);
+}
+
+/* Neither property has columns or series: reply with the request's identifying fields only */
+static void sensor_column_get_cb(const sensor_setup_server_t * p_self,
+                                 const access_message_rx_meta_t * p_meta,
+                                 const sensor_column_get_msg_pkt_t * p_in,
+                                 uint16_t in_bytes,
+                                 sensor_column_status_msg_pkt_t ** pp_out,
+                                 uint16_t * p_out_bytes)
+{
+    (void)p_self;
+    (void)p_meta;
+
+    if (in_bytes > sizeof(m_column_status))
+    {
+        in_bytes = sizeof(m_column_status);
+    }
+    memcpy(m_column_status, p_in, in_bytes);
+    *pp_out = (sensor_column_status_msg_pkt_t *)m_column_status;
+    *p_out_bytes = in_bytes;
+}
+
+static void sensor_series_get_cb(const sensor_setup_server_t * p_self,
+                                 const access_message_rx_meta_t * p_meta,
+                                 const sensor_series_get_msg_pkt_t * p_in,
+                                 uint16_t in_bytes,
+                                 sensor_series_status_msg_pkt_t ** pp_out,
+                                 uint16_t * p_out_bytes)
+{
+    (void)p_self;
+    (void)p_meta;
+    (void)in_bytes;
+
+    m_series_status.property_id = p_in->property_id;
+    *pp_out = &m_series_status;
+    *p_out_bytes = sizeof(uint16_t);
+}
+
+static void sensor_cadence_get_cb(const sensor_setup_server_t * p_self,
+                                  const access_message_rx_meta_t * p_meta,
+                                  uint16_t property_id,
+                                  sensor_cadence_status_msg_pkt_t ** pp_out,
+                                  uint16_t * p_out_bytes)
+{
+    (void)p_self;
+    (void)p_meta;
+
+    *pp_out = m_cadence_status;
+    *p_out_bytes = cadence_status_build(property_id);
+}
+
+static void sensor_cadence_set_cb(const sensor_setup_server_t * p_self,
+                                  const access_message_rx_meta_t * p_meta,
+                                  uint16_t property_id,
+                                  const sensor_cadence_set_msg_pkt_t * p_in,
+                                  uint16_t in_bytes,
+                                  sensor_cadence_status_msg_pkt_t ** pp_out,
+                                  uint16_t * p_out_bytes)
+{
+    (void)p_meta;
+    sensor_property_t * p_property = property_find(property_id);
+
+    *pp_out = m_cadence_status;
+    *p_out_bytes = 0;
+
+    if (p_property != NULL)
+    {
+        const uint8_t * p_data = (const uint8_t *)p_in + sizeof(uint16_t);
+        if (!sensor_cadence_decode(p_data, (uint16_t)(in_bytes - sizeof(uint16_t)), &p_property->cadence))
+        {
+            /* Prohibited values: the message is ignored */
+            return;
+        }
+
+        const sensor_cadence_t * p_cadence = &p_property->cadence;
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO,
+              "Sensor cadence 0x%04X: divisor 2^%u, delta -%u/+%u%s, min interval 2^%u ms, fast %u..%u\n",
+              property_id, p_cadence->fast_divisor_log2,
+              p_cadence->delta_down, p_cadence->delta_up,
+              p_cadence->trigger_percent ? " (0.01 %)" : "",
+              p_cadence->min_interval_log2, p_cadence->fast_low, p_cadence->fast_high);
+    }
+
+    /* The model replies to the acknowledged set; a new cadence is also published */
+    *p_out_bytes = cadence_status_build(property_id);
+    if (p_property != NULL)
+    {
+        (void)sensor_server_setup_status_publish(p_self, m_cadence_status, *p_out_bytes,
+                                                 SENSOR_OPCODE_CADENCE_STATUS);
+    }
+}
+
+/* No sensor settings: statuses carry the identifying fields only */
+static void sensor_settings_get_cb(const sensor_setup_server_t * p_self,
+                                   const access_message_rx_meta_t * p_meta,
+                                   uint16_t property_id,
+                                   sensor_settings_status_msg_pkt_t ** pp_out,
+                                   uint16_t * p_out_bytes)
+{
+    (void)p_self;
+    (void)p_meta;
+
+    m_settings_status.property_id = property_id;
+    *pp_out = &m_settings_status;
+    *p_out_bytes = sizeof(uint16_t);
+}
+
+static void sensor_setting_get_cb(const sensor_setup_server_t * p_self,
+                                  const access_message_rx_meta_t * p_meta,
+                                  uint16_t property_id,
+                                  uint16_t setting_property_id,
+                                  sensor_setting_status_msg_pkt_t ** pp_out,
+                                  uint16_t * p_out_bytes)
+{
+    (void)p_self;
+    (void)p_meta;
+
+    m_setting_status.property_id = property_id;
+    m_setting_status.setting_property_id = setting_property_id;
+    *pp_out = &m_setting_status;
+    *p_out_bytes = 2 * sizeof(uint16_t);
+}
+
+static void sensor_setting_set_cb(const sensor_setup_server_t * p_self,
+                                  const access_message_rx_meta_t * p_meta,
+                                  uint16_t property_id,
+                                  uint16_t setting_property_id,
+                                  const sensor_setting_set_msg_pkt_t * p_in,
+                                  uint16_t in_bytes,
+                                  sensor_setting_status_msg_pkt_t ** pp_out,
+                                  uint16_t * p_out_bytes)
+{
+    (void)p_in;
+    (void)in_bytes;
+    sensor_setting_get_cb(p_self, p_meta, property_id, setting_property_id, pp_out, p_out_bytes);
+}
+
+/* Publish timeout of the Sensor Server: the publish period has elapsed */
+static void sensor_publication_schedule_cb(const sensor_setup_server_t * p_self)
+{
+    (void)p_self;
+    bool due[PROPERTY_COUNT];
+
+    for (uint32_t i = 0; i < PROPERTY_COUNT; i++)
+    {
+        due[i] = (m_properties[i].value != PROPERTY_VALUE_UNKNOWN);
+    }
+    status_publish(due, m_now_ms);
+}
+
+static const sensor_setup_server_callbacks_t m_callbacks =
+{
+    .sensor_cbs =
+    {
+        .descriptor_get_cb = sensor_descriptor_get_cb,
+        .get_cb = sensor_state_get_cb,
+        .column_get_cb = sensor_column_get_cb,
+        .series_get_cb = sensor_series_get_cb,
+        .cadence_get_cb = sensor_cadence_get_cb,
+        .cadence_set_cb = sensor_cadence_set_cb,
+        .settings_get_cb = sensor_settings_get_cb,
+        .setting_get_cb = sensor_setting_get_cb,
+        .setting_set_cb = sensor_setting_set_cb,
+        .publication_schedule_cb = sensor_publication_schedule_cb,
+    }
+};
+
+static void descriptor_status_init(void)
+{
+    for (uint32_t i = 0; i < PROPERTY_COUNT; i++)
+    {
+        sensor_descriptor_pkt_t * p_descriptor = &m_descriptor_status[i].descriptors;
+
+        memset(p_descriptor, 0, sizeof(*p_descriptor));
+        p_descriptor->sensor_property_id = m_properties[i].property_id;
+        /* Tolerances unspecified */
+        p_descriptor->sensor_sampling_function = SAMPLING_FUNCTION_INSTANTANEOUS;
+        p_descriptor->sensor_measurement_period = PERIOD_NOT_APPLICABLE;
+        p_descriptor->sensor_update_interval = PERIOD_1S;   /* One measurement per second */
+    }
+}
+
+uint32_t app_sensor_sig_init(void)
+{
+    descriptor_status_init();
+
+    m_server.settings.force_segmented = false;
+    m_server.settings.transmic_size = NRF_MESH_TRANSMIC_SIZE_DEFAULT;
+    m_server.settings.property_array = m_property_array;
+    m_server.settings.p_callbacks = &m_callbacks;
+
+    /* Adds the Sensor Server and the Setup Server, which shares its subscription list */
+    uint32_t status = sensor_setup_server_init(&m_server, 0);
+    if (status != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Sensor Setup Server init failed: 0x%x\n", status);
+        return status;
+    }
+
+    m_server_ready = true;
+    m_period_valid = false;
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Sensor Server added, properties 0x%04X 0x%04X\n",
+          APP_SENSOR_SIG_PROPERTY_CO2, APP_SENSOR_SIG_PROPERTY_VOC);
+    return NRF_SUCCESS;
+}
+
+void app_sensor_sig_publication_invalidate(void)
+{
+    m_period_valid = false;
+}
+
+void app_sensor_sig_update(const iaq_sample_t * p_sample, uint32_t now_ms)
+{
+    if (!m_server_ready)
+    {
+        return;
+    }
+
+    uint32_t voc_ppb = (uint32_t)p_sample->tvoc_x100 * APP_SENSOR_SIG_VOC_PPB_PER_MG_M3 / 100;
+    m_properties[0].value = (p_sample->eco2 < PROPERTY_VALUE_MAX) ? p_sample->eco2 : PROPERTY_VALUE_MAX;
+    m_properties[1].value = (voc_ppb < PROPERTY_VALUE_MAX) ? (uint16_t)voc_ppb : PROPERTY_VALUE_MAX;
+    m_now_ms = now_ms;
+
+    /* Properties that are due go out together in one Sensor Status */
+    bool due[PROPERTY_COUNT];
+    for (uint32_t i = 0; i < PROPERTY_COUNT; i++)
+    {
+        due[i] = is_due(&m_properties[i], now_ms);
+    }
+    status_publish(due, now_ms);
+}
+
+#endif /* APP_FEATURE_SENSOR */
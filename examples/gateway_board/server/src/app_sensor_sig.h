@@ -0,0 +1,88 @@
+#ifndef APP_SENSOR_SIG_H__
+#define APP_SENSOR_SIG_H__
+
+#include <stdint.h>
+
+#include "app_config.h"
+#include "iaq_sample.h"
+
+/*
+ * SIG Sensor Server (0x1100) and Sensor Setup Server (0x1101) on element 0,
+ * next to the vendor model.
+ *
+ * Exposes eCO2 and TVOC as standard device properties so any Sensor Client
+ * can read them. The SDK Sensor Setup Server model (models/model_spec/sensor)
+ * adds both models, parses the requests, replies and publishes; this module
+ * supplies the property states through its callbacks.
+ *
+ * Sensor Status is published every model publish period from the model's
+ * publish timeout, and between periods under the Sensor Cadence state of each
+ * property: the period shortened by the fast cadence divisor while the value
+ * is in the fast cadence range, and status triggers on the delta since the
+ * last published value, rate limited by the status minimum interval. Cadence
+ * is set per property with Sensor Cadence Set. The cadence is evaluated by
+ * sensor_cadence.c: the SDK's examples/common app_sensor layer only creates
+ * cadence state, and so only answers Sensor Get, for Motion Sensed (0x0042).
+ *
+ * The IAQ index and rating have no device property and stay on the vendor
+ * opcode.
+ *
+ * tools/sensor_sig_check.c runs this file against a stubbed sensor model.
+ */
+
+/* Present Ambient Carbon Dioxide Concentration: Co2 Concentration, uint16 ppm */
+#define APP_SENSOR_SIG_PROPERTY_CO2     0x0077
+/* Present Ambient Volatile Organic Compounds Concentration: VOC Concentration, uint16 ppb */
+#define APP_SENSOR_SIG_PROPERTY_VOC     0x0078
+
+/* TVOC comes in mg/m3; converted to ppb as ethanol equivalent at 25 degC (24.45 / 46.07) */
+#ifndef APP_SENSOR_SIG_VOC_PPB_PER_MG_M3
+#define APP_SENSOR_SIG_VOC_PPB_PER_MG_M3    531
+#endif
+
+/* Default cadence. Deltas are in the units of the property; the minimum
+ * interval is 2^n ms. Fast cadence applies from the low bound up. */
+#ifndef APP_SENSOR_SIG_FAST_DIVISOR_LOG2
+#define APP_SENSOR_SIG_FAST_DIVISOR_LOG2    2           /* 4x faster */
+#endif
+#ifndef APP_SENSOR_SIG_MIN_INTERVAL_LOG2
+#define APP_SENSOR_SIG_MIN_INTERVAL_LOG2    13          /* 8.2 s */
+#endif
+#ifndef APP_SENSOR_SIG_CO2_DELTA
+#define APP_SENSOR_SIG_CO2_DELTA            50          /* ppm */
+#endif
+#ifndef APP_SENSOR_SIG_CO2_FAST_LOW
+#define APP_SENSOR_SIG_CO2_FAST_LOW         1000        /* ppm */
+#endif
+#ifndef APP_SENSOR_SIG_VOC_DELTA
+#define APP_SENSOR_SIG_VOC_DELTA            100         /* ppb */
+#endif
+#ifndef APP_SENSOR_SIG_VOC_FAST_LOW
+#define APP_SENSOR_SIG_VOC_FAST_LOW         1000        /* ppb */
+#endif
+
+#if APP_FEATURE_SENSOR
+/** @brief Add the Sensor Server and Setup Server models. Call from the models init callback. */
+uint32_t app_sensor_sig_init(void);
+
+/** @brief Drop the cached publish period. Call on config server events that change publication. */
+void app_sensor_sig_publication_invalidate(void);
+
+/**
+ * @brief Hand a new reading to the server and publish what the cadence makes due.
+ *
+ * @param now_ms Sampling uptime, monotonic.
+ */
+void app_sensor_sig_update(const iaq_sample_t * p_sample, uint32_t now_ms);
+#else
+/* Gateway-only build: no sensor to expose */
+static inline uint32_t app_sensor_sig_init(void) { return 0; }
+static inline void app_sensor_sig_publication_invalidate(void) {}
+static inline void app_sensor_sig_update(const iaq_sample_t * p_sample, uint32_t now_ms)
+{
+    (void)p_sample;
+    (void)now_ms;
+}
+#endif
+
+#endif /* APP_SENSOR_SIG_H__ */
@@ -0,0 +1,258 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "app_twi_bus.h"
+#include "app_timer.h"
+#include "app_sched_prio.h"
+#include "app_util_platform.h"
+#include "nrf_drv_twi.h"
+#include "nrf_error.h"
+
+#include "log.h"
+#include "app_power.h"
+#include "twi_bus.h"
+
+#ifndef TWI_SCL_PIN
+#define TWI_SCL_PIN 27
+#endif
+#ifndef TWI_SDA_PIN
+#define TWI_SDA_PIN 26
+#endif
+#define TWI_INSTANCE_ID 0
+
+static const nrf_drv_twi_t m_twi = NRF_DRV_TWI_INSTANCE(TWI_INSTANCE_ID);
+
+static twi_bus_t m_bus;
+static app_twi_bus_window_t m_windows[TWI_BUS_CLIENTS_MAX];
+static bool m_initialized;
+static bool m_enabled;
+static bool m_dispatch_queued;
+
+static uint64_t m_now_ticks;
+static uint32_t m_last_cnt;
+
+static void scheduled_window_handler(void * p_event_data, uint16_t event_size);
+
+/* The RTC counter wraps after 512 s; requests come every measurement, so
+ * diffing against the last read keeps the arbiter's microsecond clock. Call
+ * inside a critical region. */
+static uint32_t now_us(void)
+{
+    uint32_t cnt = app_timer_cnt_get();
+    m_now_ticks += app_timer_cnt_diff_compute(cnt, m_last_cnt);
+    m_last_cnt = cnt;
+    return (uint32_t)((m_now_ticks * 1000000) / APP_TIMER_CLOCK_FREQ);
+}
+
+/* The TWI holds the HFCLK while enabled; only keep it on while the bus is in use */
+static void twi_enable(void)
+{
+    if (!m_enabled)
+    {
+        nrf_drv_twi_enable(&m_twi);
+        app_power_periph_on(APP_POWER_SRC_TWI);
+        m_enabled = true;
+    }
+}
+
+static void twi_disable(void)
+{
+    if (m_enabled)
+    {
+        nrf_drv_twi_disable(&m_twi);
+        app_power_periph_off(APP_POWER_SRC_TWI);
+        m_enabled = false;
+    }
+}
+
+/* One event per window, so a queue of windows never floods the sensor class */
+static void dispatch(void)
+{
+    bool put = false;
+
+    CRITICAL_REGION_ENTER();
+    if (!m_dispatch_queued)
+    {
+        m_dispatch_queued = true;
+        put = true;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (put && APP_SCHED_PUT(APP_SCHED_CLASS_SENSOR, NULL, 0, scheduled_window_handler) != NRF_SUCCESS)
+    {
+        /* Retried on the next request or release */
+        m_dispatch_queued = false;
+    }
+}
+
+/* Disable the TWI if nothing is waiting, otherwise hand it to the next window */
+static void bus_idle(void)
+{
+    bool pending;
+
+    CRITICAL_REGION_ENTER();
+    pending = twi_bus_pending(&m_bus);
+    CRITICAL_REGION_EXIT();
+
+    if (pending)
+    {
+        dispatch();
+    }
+    else
+    {
+        twi_disable();
+    }
+}
+
+static void scheduled_window_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)p_event_data;
+    (void)event_size;
+
+    uint8_t client;
+
+    CRITICAL_REGION_ENTER();
+    m_dispatch_queued = false;
+    client = twi_bus_grant(&m_bus, now_us());
+    CRITICAL_REGION_EXIT();
+
+    if (client == TWI_BUS_CLIENT_NONE)
+    {
+        /* Claimed in the meantime; the claim's release dispatches again */
+        return;
+    }
+
+    twi_enable();
+    m_windows[client]();
+
+    CRITICAL_REGION_ENTER();
+    twi_bus_release(&m_bus, client, now_us());
+    CRITICAL_REGION_EXIT();
+
+    bus_idle();
+}
+
+bool app_twi_bus_init(void)
+{
+    nrf_drv_twi_config_t config = NRF_DRV_TWI_DEFAULT_CONFIG;
+    config.scl = TWI_SCL_PIN;
+    config.sda = TWI_SDA_PIN;
+    config.frequency = NRF_DRV_TWI_FREQ_100K;
+
+    ret_code_t err = nrf_drv_twi_init(&m_twi, &config, NULL, NULL);
+    if (err != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "TWI init failed: 0x%x\n", err);
+        return false;
+    }
+
+    m_last_cnt = app_timer_cnt_get();
+    twi_bus_init(&m_bus, 0);
+    m_initialized = true;
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "TWI initialized\n");
+    return true;
+}
+
+uint8_t app_twi_bus_client_add(const char * p_name, uint8_t priority, app_twi_bus_window_t window)
+{
+    if (!m_initialized)
+    {
+        return TWI_BUS_CLIENT_NONE;
+    }
+
+    uint8_t client;
+
+    CRITICAL_REGION_ENTER();
+    client = twi_bus_client_add(&m_bus, p_name, priority);
+    CRITICAL_REGION_EXIT();
+
+    if (client != TWI_BUS_CLIENT_NONE)
+    {
+        m_windows[client] = window;
+    }
+    return client;
+}
+
+bool app_twi_bus_request(uint8_t client, uint32_t within_ms)
+{
+    bool queued;
+
+    CRITICAL_REGION_ENTER();
+    queued = twi_bus_request(&m_bus, client, now_us(), within_ms * 1000);
+    CRITICAL_REGION_EXIT();
+
+    dispatch();
+    return queued;
+}
+
+bool app_twi_bus_claim(uint8_t client)
+{
+    bool claimed;
+
+    CRITICAL_REGION_ENTER();
+    claimed = twi_bus_claim(&m_bus, client, now_us());
+    CRITICAL_REGION_EXIT();
+
+    if (claimed)
+    {
+        twi_enable();
+    }
+    return claimed;
+}
+
+void app_twi_bus_release(uint8_t client)
+{
+    CRITICAL_REGION_ENTER();
+    twi_bus_release(&m_bus, client, now_us());
+    CRITICAL_REGION_EXIT();
+
+    bus_idle();
+}
+
+uint32_t app_twi_bus_tx(uint8_t addr, const uint8_t * p_data, uint8_t length, bool no_stop)
+{
+    if (m_bus.owner == TWI_BUS_CLIENT_NONE)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    return nrf_drv_twi_tx(&m_twi, addr, p_data, length, no_stop);
+}
+
+uint32_t app_twi_bus_rx(uint8_t addr, uint8_t * p_data, uint8_t length)
+{
+    if (m_bus.owner == TWI_BUS_CLIENT_NONE)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    return nrf_drv_twi_rx(&m_twi, addr, p_data, length);
+}
+
+void app_twi_bus_stats_log(void)
+{
+    if (!m_initialized)
+    {
+        return;
+    }
+
+    twi_bus_t bus;
+    uint16_t utilization;
+
+    CRITICAL_REGION_ENTER();
+    utilization = twi_bus_utilization_permille(&m_bus, now_us());
+    bus = m_bus;
+    CRITICAL_REGION_EXIT();
+
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "TWI bus: utilization %u.%u %% over %u s\n",
+          utilization / 10, utilization % 10, (uint32_t)(bus.elapsed_us / 1000000));
+    for (uint8_t i = 0; i < bus.count; i++)
+    {
+        const twi_bus_client_t * p_client = &bus.clients[i];
+        uint32_t wait_avg = (p_client->grants > 0) ? (uint32_t)(p_client->wait_total_us / p_client->grants) : 0;
+        uint32_t hold_avg = (p_client->grants > 0) ? (uint32_t)(p_client->hold_total_us / p_client->grants) : 0;
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO,
+              "  %s (prio %u): requests %u, windows %u, wait avg/max %u/%u us, hold avg/max %u/%u us, "
+              "deadline misses %u\n",
+              p_client->p_name, p_client->priority, p_client->requests, p_client->grants,
+              wait_avg, p_client->wait_max_us, hold_avg, p_client->hold_max_us, p_client->misses);
+    }
+}
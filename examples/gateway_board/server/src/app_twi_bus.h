@@ -0,0 +1,67 @@
+#ifndef APP_TWI_BUS_H__
+#define APP_TWI_BUS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "app_config.h"
+#include "twi_bus.h"
+
+/*
+ * TWI0, shared by the I2C devices of the sensor node.
+ *
+ * This module owns the TWI driver instance; devices get the bus through the
+ * arbiter in twi_bus.h. A device registers a window handler and asks for the
+ * bus with app_twi_bus_request(), from any context. Granted windows run one
+ * per event in the SENSOR scheduler class: the handler makes its transfers
+ * with app_twi_bus_tx()/app_twi_bus_rx() and the bus is released when it
+ * returns. A device waiting for the bus waits in the arbiter's queue, not in
+ * the scheduler, so other classes run between windows.
+ *
+ * The TWI is enabled for the first window and stays enabled while requests
+ * are pending, so windows requested together run back to back in one powered
+ * stretch; it is disabled, with its HFCLK request, when the queue is empty.
+ */
+
+#define APP_TWI_BUS_FREQ_HZ     100000      /* NRF_DRV_TWI_FREQ_100K, for twi_budget */
+
+/** @brief Runs a granted window. Transfers are only allowed from here or under a claim. */
+typedef void (*app_twi_bus_window_t)(void);
+
+#if APP_FEATURE_SENSOR
+/** @brief Initialize the TWI driver, left disabled until the first window. */
+bool app_twi_bus_init(void);
+
+/** @return Client id, or TWI_BUS_CLIENT_NONE if the table is full. */
+uint8_t app_twi_bus_client_add(const char * p_name, uint8_t priority, app_twi_bus_window_t window);
+
+/**
+ * @brief Ask for a window within within_ms. Safe to call from interrupt context.
+ *
+ * @return false if the client's previous request has not been granted yet;
+ *         the two are served by one window.
+ */
+bool app_twi_bus_request(uint8_t client, uint32_t within_ms);
+
+/**
+ * @brief Take the idle bus at once, for blocking work outside a window
+ * (sensor initialization). End with app_twi_bus_release().
+ *
+ * @return false if the bus is owned or a request is pending.
+ */
+bool app_twi_bus_claim(uint8_t client);
+void app_twi_bus_release(uint8_t client);
+
+/** @brief Blocking transfers on the bus owner's behalf; nrf_drv_twi_tx()/rx() semantics.
+ *  @return NRF_ERROR_INVALID_STATE outside a window or claim. */
+uint32_t app_twi_bus_tx(uint8_t addr, const uint8_t * p_data, uint8_t length, bool no_stop);
+uint32_t app_twi_bus_rx(uint8_t addr, uint8_t * p_data, uint8_t length);
+
+/** @brief Log bus utilization and the wait, hold time and deadline misses per client. */
+void app_twi_bus_stats_log(void);
+#else
+static inline bool app_twi_bus_init(void) { return false; }
+static inline void app_twi_bus_stats_log(void) {}
+#endif
+
+#endif /* APP_TWI_BUS_H__ */
@@ -4,23 +4,105 @@
 #include "nrf_uart.h"
 #include "boards.h"
 #include "log.h"
+#include "app_sched_prio.h"
+#include "app_util_platform.h"
+#include "app_power.h"
+#include "nrf_mesh_config_core.h"
+#include "iaq_codec.h"
+#include <stdio.h>
 #include <string.h>
 
-// FIFO buffer sizes
+// Longest JSON line sent to the ESP32 (history record)
+#define UART_LINE_MAX    128
+
+// FIFO buffer sizes (app_fifo needs powers of two)
+#if APP_PROFILE_GATEWAY_HT
+// One line per message of a burst arriving while the UART drains
+#define UART_TX_BUF_NEEDED (APP_GATEWAY_BURST_MSGS * UART_LINE_MAX)
+#if UART_TX_BUF_NEEDED <= 512
+#define UART_TX_BUF_SIZE 512
+#elif UART_TX_BUF_NEEDED <= 1024
+#define UART_TX_BUF_SIZE 1024
+#elif UART_TX_BUF_NEEDED <= 2048
+#define UART_TX_BUF_SIZE 2048
+#else
+#define UART_TX_BUF_SIZE 4096
+#endif
+// 115200 baud moves about 11.5 kB/s; leave 20 % headroom for the bursts
+#if (APP_GATEWAY_MSG_PER_10S * UART_LINE_MAX) / 10 > (11520 * 8) / 10
+#error "Gateway message rate exceeds the UART bandwidth"
+#endif
+#else
 #define UART_TX_BUF_SIZE 256
+#endif
 #define UART_RX_BUF_SIZE 256
 
+// History and series lines wait in their own FIFO and enter the UART FIFO one
+// line at a time, only once it has drained. Live readings and alarms then
+// queue behind at most one such line instead of a whole backfill transfer.
+#if APP_PROFILE_GATEWAY_HT
+#define UART_BULK_BUF_SIZE 2048
+#else
+#define UART_BULK_BUF_SIZE 1024
+#endif
+#if IAQ_EXT_LINE_MAX > UART_TX_BUF_SIZE || IAQ_EXT_LINE_MAX > UART_BULK_BUF_SIZE
+#error "Ext telemetry lines do not fit the UART FIFOs"
+#endif
+
 // Pin configuration
 #define UART_TX_PIN  6
 #define UART_RX_PIN  8
 
+// Nothing is received from the ESP32, so the UART (and the HFCLK request it
+// holds) is released once the TX FIFO drains and reopened on the next send.
+#ifndef APP_UART_GATEWAY_AUTO_POWER_DOWN
+#define APP_UART_GATEWAY_AUTO_POWER_DOWN 1
+#endif
+
 // FIFO buffers (allocated by APP_UART_FIFO_INIT macro)
 static uint8_t m_rx_buf[UART_RX_BUF_SIZE];
 static uint8_t m_tx_buf[UART_TX_BUF_SIZE];
 static bool m_uart_initialized = false;
+static bool m_uart_open = false;
+
+static app_fifo_t m_bulk_fifo;
+static uint8_t m_bulk_buf[UART_BULK_BUF_SIZE];
+static uint16_t m_bulk_lines;
+
+// Bytes queued since the TX FIFO last ran empty; bounds its fill level. The
+// TX_EMPTY event clears it from the UART IRQ, so it only grows in a critical
+// region.
+static uint16_t m_tx_pending;
+static uint16_t m_tx_pending_max;
+static uint16_t m_tx_dropped;
+
+static bool uart_open(void);
+static void uart_bulk_pump(void);
+
+static void scheduled_uart_tx_empty(void * p_event_data, uint16_t event_size)
+{
+    (void)p_event_data;
+    (void)event_size;
+
+    if (m_bulk_lines > 0)
+    {
+        uart_bulk_pump();
+        return;
+    }
+
+#if APP_UART_GATEWAY_AUTO_POWER_DOWN
+    if (m_uart_open && m_tx_pending == 0 && app_uart_close() == NRF_SUCCESS)
+    {
+        m_uart_open = false;
+        app_power_periph_off(APP_POWER_SRC_UART);
+    }
+#endif
+}
 
 static void uart_event_handle(app_uart_evt_t * p_event)
 {
+    app_power_wake_mark(APP_POWER_SRC_UART);
+
     switch (p_event->evt_type)
     {
         case APP_UART_DATA_READY:
@@ -39,6 +121,8 @@ static void uart_event_handle(app_uart_evt_t * p_event)
 
         case APP_UART_TX_EMPTY:
             // TX complete - buffer empty
+            m_tx_pending = 0;
+            (void)APP_SCHED_PUT(APP_SCHED_CLASS_UART_TX, NULL, 0, scheduled_uart_tx_empty);
             break;
 
         default:
@@ -46,15 +130,15 @@ static void uart_event_handle(app_uart_evt_t * p_event)
     }
 }
 
-void app_uart_gateway_init(void)
+static bool uart_open(void)
 {
-    if (m_uart_initialized)
+    if (m_uart_open)
     {
-        return;
+        return true;
     }
 
     uint32_t err_code;
-    
+
     app_uart_comm_params_t const comm_params =
     {
         .rx_pin_no    = UART_RX_PIN,
@@ -80,9 +164,201 @@ void app_uart_gateway_init(void)
     {
         __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, 
               "UART init failed: 0x%X\n", err_code);
+        return false;
+    }
+
+    m_uart_open = true;
+    app_power_periph_on(APP_POWER_SRC_UART);
+    return true;
+}
+
+static void tx_pending_add(uint16_t count)
+{
+    CRITICAL_REGION_ENTER();
+    m_tx_pending += count;
+    if (m_tx_pending > m_tx_pending_max)
+    {
+        m_tx_pending_max = (m_tx_pending < UART_TX_BUF_SIZE) ? m_tx_pending : UART_TX_BUF_SIZE;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+static void tx_dropped_count(void)
+{
+    if (m_tx_dropped < UINT16_MAX)
+    {
+        m_tx_dropped++;
+    }
+}
+
+/* Queue a string for transmission, reopening the UART if it was powered down.
+ * app_uart keeps its FIFO to itself, so the bytes queued since it last ran
+ * empty stand in for its fill level; a line that may not fit is dropped whole
+ * and counted, never cut short. */
+static void uart_put_string(const char * p_str, int len)
+{
+    if (!uart_open())
+    {
         return;
     }
-    
+
+    uint16_t pending = m_tx_pending;
+    if (pending > UART_TX_BUF_SIZE || (uint32_t)len > UART_TX_BUF_SIZE - pending)
+    {
+        tx_dropped_count();
+        return;
+    }
+
+    // Counted up front: TX_EMPTY can only come after the last of these bytes
+    tx_pending_add((uint16_t)len);
+    for (int i = 0; i < len; i++)
+    {
+        if (app_uart_put(p_str[i]) != NRF_SUCCESS)
+        {
+            // Only if the count restarted while an earlier line was being queued
+            tx_dropped_count();
+            break;
+        }
+    }
+}
+
+/* Move the oldest waiting bulk line into the UART FIFO. */
+static void uart_bulk_pump(void)
+{
+    if (m_bulk_lines == 0 || !uart_open())
+    {
+        return;
+    }
+
+    uint8_t c;
+    while (app_fifo_get(&m_bulk_fifo, &c) == NRF_SUCCESS)
+    {
+        if (app_uart_put(c) != NRF_SUCCESS)
+        {
+            // Cannot happen with the FIFO drained; skip the rest of the line
+            while (c != '\n' && app_fifo_get(&m_bulk_fifo, &c) == NRF_SUCCESS)
+            {
+            }
+            tx_dropped_count();
+            break;
+        }
+        tx_pending_add(1);
+        if (c == '\n')
+        {
+            break;
+        }
+    }
+    m_bulk_lines--;
+}
+
+/* Queue a history or series line behind live data. A line that does not fit
+ * is dropped whole and counted. */
+static void uart_put_bulk(const char * p_str, int len)
+{
+    uint32_t size = 0;
+    (void)app_fifo_write(&m_bulk_fifo, NULL, &size);
+    if (size < (uint32_t)len)
+    {
+        tx_dropped_count();
+        return;
+    }
+
+    size = (uint32_t)len;
+    (void)app_fifo_write(&m_bulk_fifo, (const uint8_t *)p_str, &size);
+    m_bulk_lines++;
+
+    if (m_tx_pending == 0)
+    {
+        uart_bulk_pump();
+    }
+}
+
+// The diagnostics go out as two lines, queues then handlers, each at most:
+// {"node":"0xFFFF","h":[  then per row ,["<name>",65535,4294967295]  then ],"diag":1}\n
+#define SCHED_DIAG_LINE_MAX (22 + APP_SCHED_STATS_ROWS * (APP_SCHED_STATS_NAME_LEN + 22) + 12 + 1)
+#define SCHED_DIAG_Q_LINE_MAX (22 + APP_SCHED_CLASS_COUNT * 27 + 12 + 1)
+STATIC_ASSERT(SCHED_DIAG_Q_LINE_MAX <= SCHED_DIAG_LINE_MAX);
+#if SCHED_DIAG_LINE_MAX > UART_TX_BUF_SIZE
+#error "Scheduler diagnostics lines do not fit the UART TX FIFO"
+#endif
+
+void app_uart_send_sched_diag(uint16_t node_addr, const app_sched_stats_report_t * p_report)
+{
+    if (!m_uart_initialized)
+    {
+        return;
+    }
+
+    char buf[SCHED_DIAG_LINE_MAX];
+    int len = snprintf(buf, sizeof(buf), "{\"node\":\"0x%04X\",\"q\":[", node_addr);
+
+    for (uint8_t i = 0; i < APP_SCHED_CLASS_COUNT && len > 0 && len < (int)sizeof(buf); i++)
+    {
+        len += snprintf(&buf[len], sizeof(buf) - len, "%s[%u,%u,%u,%lu]",
+                        (i > 0) ? "," : "",
+                        p_report->classes[i].depth_max, p_report->classes[i].queue_size,
+                        p_report->classes[i].put_failures,
+                        (unsigned long)p_report->classes[i].latency_max_us);
+    }
+    if (len > 0 && len < (int)sizeof(buf))
+    {
+        len += snprintf(&buf[len], sizeof(buf) - len, "],\"diag\":1}\n");
+    }
+
+    if (len > 0 && len < (int)sizeof(buf))
+    {
+        uart_put_string(buf, len);
+    }
+    else
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "UART buffer overflow: len=%d\n", len);
+    }
+
+    len = snprintf(buf, sizeof(buf), "{\"node\":\"0x%04X\",\"h\":[", node_addr);
+
+    for (uint8_t i = 0; i < p_report->row_count && len > 0 && len < (int)sizeof(buf); i++)
+    {
+        len += snprintf(&buf[len], sizeof(buf) - len, "%s[\"%.*s\",%u,%lu]",
+                        (i > 0) ? "," : "",
+                        APP_SCHED_STATS_NAME_LEN, p_report->rows[i].name,
+                        p_report->rows[i].put_failures,
+                        (unsigned long)p_report->rows[i].exec_max_us);
+    }
+    if (len > 0 && len < (int)sizeof(buf))
+    {
+        len += snprintf(&buf[len], sizeof(buf) - len, "],\"diag\":1}\n");
+    }
+
+    if (len > 0 && len < (int)sizeof(buf))
+    {
+        uart_put_string(buf, len);
+    }
+    else
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "UART buffer overflow: len=%d\n", len);
+    }
+}
+
+void app_uart_gateway_fifo_stats_get(uint16_t * p_max, uint16_t * p_size, uint16_t * p_dropped)
+{
+    *p_max = m_tx_pending_max;
+    *p_size = UART_TX_BUF_SIZE;
+    *p_dropped = m_tx_dropped;
+}
+
+void app_uart_gateway_init(void)
+{
+    if (m_uart_initialized)
+    {
+        return;
+    }
+
+    if (!uart_open())
+    {
+        return;
+    }
+
+    (void)app_fifo_init(&m_bulk_fifo, m_bulk_buf, sizeof(m_bulk_buf));
     m_uart_initialized = true;
     
     __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, 
@@ -91,45 +367,161 @@ void app_uart_gateway_init(void)
     
     // Send startup message
     const char *msg = "{\"status\":\"nRF52 Ready\"}\n";
-    for (int i = 0; msg[i]; i++)
-    {
-        app_uart_put(msg[i]);
-    }
+    uart_put_string(msg, (int)strlen(msg));
 }
 
-void app_uart_send_iaq_data(uint16_t node_addr, float iaq, float tvoc, float eco2)
+void app_uart_send_iaq_data(uint16_t node_addr, uint16_t iaq_x10, uint16_t tvoc_x100, uint16_t eco2)
 {
     if (!m_uart_initialized)
     {
         __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "UART not initialized!\n");
         return;
     }
+
+    const iaq_sample_t sample = { .iaq_x10 = iaq_x10, .tvoc_x100 = tvoc_x100, .eco2 = eco2 };
+    char buf[IAQ_CODEC_LINE_MAX];
+    int len = iaq_codec_format_values(buf, sizeof(buf), node_addr, &sample);
     
-    if (iaq != iaq || tvoc != tvoc || eco2 != eco2)
+    if (len > 0 && len < sizeof(buf))
+    {
+
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Sending UART: %s", buf);
+        
+        uart_put_string(buf, len);
+        
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "UART sent successfully\n");
+    }
+    else
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "UART buffer overflow: len=%d\n", len);
+    }
+}
+
+void app_uart_send_iaq_history(uint16_t node_addr, uint32_t seq, uint16_t boot, uint32_t timestamp_s,
+                               uint16_t iaq_x10, uint16_t tvoc_x100, uint16_t eco2)
+{
+    if (!m_uart_initialized)
     {
-        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "NaN detected in UART data!\n");
         return;
     }
 
-    char buf[96];
+    char buf[128];
     int len = snprintf(buf, sizeof(buf),
-                       "{\"node\":\"0x%04X\",\"iaq\":%d.%d,\"tvoc\":%d.%02d,\"eco2\":%d}\n",
+                       "{\"node\":\"0x%04X\",\"seq\":%lu,\"boot\":%u,\"t\":%lu,"
+                       "\"iaq\":%u.%u,\"tvoc\":%u.%02u,\"eco2\":%u,\"hist\":1}\n",
                        node_addr,
-                       (int)iaq, (int)((iaq - (int)iaq) * 10),
-                       (int)tvoc, (int)((tvoc - (int)tvoc) * 100),
-                       (int)(eco2 + 0.5f));
-    
+                       (unsigned long)seq, boot, (unsigned long)timestamp_s,
+                       iaq_x10 / 10, iaq_x10 % 10,
+                       tvoc_x100 / 100, tvoc_x100 % 100,
+                       eco2);
+
     if (len > 0 && len < sizeof(buf))
     {
+        uart_put_bulk(buf, len);
+    }
+    else
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "UART buffer overflow: len=%d\n", len);
+    }
+}
 
-        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Sending UART: %s", buf);
-        
-        for (int i = 0; i < len; i++)
-        {
-            app_uart_put(buf[i]);  
-        }
-        
-        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "UART sent successfully\n");
+void app_uart_send_iaq_series(uint16_t node_addr, uint32_t bucket, uint32_t age, const iaq_sample_t * p_sample)
+{
+    if (!m_uart_initialized)
+    {
+        return;
+    }
+
+    char buf[128];
+    int len = snprintf(buf, sizeof(buf),
+                       "{\"node\":\"0x%04X\",\"bucket\":%lu,\"age\":%lu,"
+                       "\"iaq\":%u.%u,\"tvoc\":%u.%02u,\"eco2\":%u,\"series\":1}\n",
+                       node_addr,
+                       (unsigned long)bucket, (unsigned long)age,
+                       p_sample->iaq_x10 / 10, p_sample->iaq_x10 % 10,
+                       p_sample->tvoc_x100 / 100, p_sample->tvoc_x100 % 100,
+                       p_sample->eco2);
+
+    if (len > 0 && len < sizeof(buf))
+    {
+        uart_put_bulk(buf, len);
+    }
+    else
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "UART buffer overflow: len=%d\n", len);
+    }
+}
+
+void app_uart_send_iaq_alert(uint16_t node_addr, uint8_t tid, uint8_t previous_level, uint8_t level,
+                             const iaq_sample_t * p_sample)
+{
+    if (!m_uart_initialized)
+    {
+        return;
+    }
+
+    char buf[128];
+    int len = snprintf(buf, sizeof(buf),
+                       "{\"node\":\"0x%04X\",\"tid\":%u,\"from\":%u,\"level\":%u,"
+                       "\"iaq\":%u.%u,\"tvoc\":%u.%02u,\"eco2\":%u,\"alert\":1}\n",
+                       node_addr, tid, previous_level, level,
+                       p_sample->iaq_x10 / 10, p_sample->iaq_x10 % 10,
+                       p_sample->tvoc_x100 / 100, p_sample->tvoc_x100 % 100,
+                       p_sample->eco2);
+
+    if (len > 0 && len < sizeof(buf))
+    {
+        uart_put_string(buf, len);
+    }
+    else
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "UART buffer overflow: len=%d\n", len);
+    }
+}
+
+void app_uart_send_iaq_ext(uint16_t node_addr, uint8_t seq, uint32_t uptime_s, const iaq_ext_values_t * p_values)
+{
+    if (!m_uart_initialized)
+    {
+        return;
+    }
+
+    char buf[IAQ_EXT_LINE_MAX];
+    int len = iaq_ext_format(buf, sizeof(buf), node_addr, seq, uptime_s, p_values);
+
+    if (len > 0 && len < sizeof(buf))
+    {
+        uart_put_bulk(buf, len);
+    }
+    else
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "UART buffer overflow: len=%d\n", len);
+    }
+}
+
+void app_uart_send_power_status(uint16_t node_addr, const app_power_report_t * p_report)
+{
+    if (!m_uart_initialized)
+    {
+        return;
+    }
+
+    char buf[160];
+    int len = snprintf(buf, sizeof(buf),
+                       "{\"node\":\"0x%04X\",\"uptime\":%lu,\"duty\":%u.%u,\"ua\":%u,"
+                       "\"wake\":[%u,%u,%u,%u],\"active_ms\":[%u,%u,%u,%u],\"pwr\":1}\n",
+                       node_addr,
+                       (unsigned long)p_report->uptime_s,
+                       p_report->duty_permille / 10, p_report->duty_permille % 10,
+                       p_report->avg_current_ua,
+                       p_report->wakeups[APP_POWER_SRC_TIMER], p_report->wakeups[APP_POWER_SRC_TWI],
+                       p_report->wakeups[APP_POWER_SRC_RADIO], p_report->wakeups[APP_POWER_SRC_UART],
+                       p_report->active_ms[APP_POWER_SRC_TIMER], p_report->active_ms[APP_POWER_SRC_TWI],
+                       p_report->active_ms[APP_POWER_SRC_RADIO], p_report->active_ms[APP_POWER_SRC_UART]);
+
+    if (len > 0 && len < sizeof(buf))
+    {
+        uart_put_string(buf, len);
     }
     else
     {
@@ -3,6 +3,13 @@
 
 #include <stdint.h>
 
+#include "app_config.h"
+#include "app_power.h"
+#include "app_sched_stats.h"
+#include "iaq_sample.h"
+#include "iaq_ext.h"
+
+#if APP_FEATURE_GATEWAY
 /**
  * @brief Initialize UART for ESP32-S3 communication
  * 
@@ -12,6 +19,70 @@ void app_uart_gateway_init(void);
 /* 
  * Sends JSON format: {"node":"0x0029","iaq":2.3,"tvoc":0.45,"eco2":680}\n
  */
-void app_uart_send_iaq_data(uint16_t node_addr, float iaq, float tvoc, float eco2);
+void app_uart_send_iaq_data(uint16_t node_addr, uint16_t iaq_x10, uint16_t tvoc_x100, uint16_t eco2);
+/*
+ * History and series lines are queued behind live readings and alerts, which
+ * wait for at most one of them.
+ *
+ * Sends one backfilled history sample:
+ * {"node":"0x0029","seq":12,"boot":3,"t":1234,"iaq":2.3,"tvoc":0.45,"eco2":680,"hist":1}\n
+ */
+void app_uart_send_iaq_history(uint16_t node_addr, uint32_t seq, uint16_t boot, uint32_t timestamp_s,
+                               uint16_t iaq_x10, uint16_t tvoc_x100, uint16_t eco2);
+/*
+ * Sends one bucket of a node's RAM history (Series Status), age in buckets
+ * before the node's current one:
+ * {"node":"0x0029","bucket":1234,"age":5,"iaq":2.3,"tvoc":0.45,"eco2":680,"series":1}\n
+ */
+void app_uart_send_iaq_series(uint16_t node_addr, uint32_t bucket, uint32_t age, const iaq_sample_t * p_sample);
+/*
+ * Sends an acknowledged IAQ alert, a rise to IAQ level 4 or 5, once per tid:
+ * {"node":"0x0029","tid":7,"from":3,"level":4,"iaq":4.2,"tvoc":1.85,"eco2":1350,"alert":1}\n
+ */
+void app_uart_send_iaq_alert(uint16_t node_addr, uint8_t tid, uint8_t previous_level, uint8_t level,
+                             const iaq_sample_t * p_sample);
+/*
+ * Sends a node's extended telemetry (iaq_ext_format()) behind live readings,
+ * like history lines.
+ */
+void app_uart_send_iaq_ext(uint16_t node_addr, uint8_t seq, uint32_t uptime_s, const iaq_ext_values_t * p_values);
+/*
+ * Sends a node's power status report:
+ * {"node":"0x0029","uptime":600,"duty":1.2,"ua":5480,"wake":[600,0,3000,0],"active_ms":[...],"pwr":1}\n
+ * wake/active_ms are ordered timer, twi, radio, uart.
+ */
+void app_uart_send_power_status(uint16_t node_addr, const app_power_report_t * p_report);
+/*
+ * Sends a node's scheduler diagnostics as two lines, to fit the TX FIFO. q lists
+ * [depth max, size, put failures, max latency us] per class (sensor, mesh_rx, uart_tx,
+ * background); h lists [name, put failures, max exec us]:
+ * {"node":"0x0029","q":[[1,4,0,30],...],"diag":1}\n
+ * {"node":"0x0029","h":[["meas",0,5400],...],"diag":1}\n
+ */
+void app_uart_send_sched_diag(uint16_t node_addr, const app_sched_stats_report_t * p_report);
+/*
+ * TX FIFO high-watermark and size in bytes, and lines dropped because the FIFO was full.
+ */
+void app_uart_gateway_fifo_stats_get(uint16_t * p_max, uint16_t * p_size, uint16_t * p_dropped);
+#else
+/* Sensor-only build: no UART link, received data is only logged */
+static inline void app_uart_gateway_init(void) {}
+static inline void app_uart_send_iaq_data(uint16_t node_addr, uint16_t iaq_x10, uint16_t tvoc_x100, uint16_t eco2) {}
+static inline void app_uart_send_iaq_history(uint16_t node_addr, uint32_t seq, uint16_t boot, uint32_t timestamp_s,
+                                             uint16_t iaq_x10, uint16_t tvoc_x100, uint16_t eco2) {}
+static inline void app_uart_send_iaq_series(uint16_t node_addr, uint32_t bucket, uint32_t age, const iaq_sample_t * p_sample) {}
+static inline void app_uart_send_iaq_alert(uint16_t node_addr, uint8_t tid, uint8_t previous_level, uint8_t level,
+                                           const iaq_sample_t * p_sample) {}
+static inline void app_uart_send_iaq_ext(uint16_t node_addr, uint8_t seq, uint32_t uptime_s,
+                                         const iaq_ext_values_t * p_values) {}
+static inline void app_uart_send_power_status(uint16_t node_addr, const app_power_report_t * p_report) {}
+static inline void app_uart_send_sched_diag(uint16_t node_addr, const app_sched_stats_report_t * p_report) {}
+static inline void app_uart_gateway_fifo_stats_get(uint16_t * p_max, uint16_t * p_size, uint16_t * p_dropped)
+{
+    *p_max = 0;
+    *p_size = 0;
+    *p_dropped = 0;
+}
+#endif
 
 #endif /* APP_UART_GATEWAY_H__ */
\ No newline at end of file
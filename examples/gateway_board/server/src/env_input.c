@@ -0,0 +1,83 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "env_input.h"
+
+void env_input_init(env_input_t * p_env)
+{
+    memset(p_env, 0, sizeof(*p_env));
+}
+
+bool env_input_update(env_input_t * p_env, env_input_source_t source, const env_input_value_t * p_value,
+                      uint32_t now_ms)
+{
+    if (source >= ENV_INPUT_SOURCE_COUNT ||
+        p_value->temp_x100 < ENV_INPUT_TEMP_X100_MIN || p_value->temp_x100 > ENV_INPUT_TEMP_X100_MAX ||
+        p_value->rh_x100 > ENV_INPUT_RH_X100_MAX)
+    {
+        return false;
+    }
+
+    p_env->values[source] = *p_value;
+    p_env->updated_ms[source] = now_ms;
+    p_env->valid |= (uint8_t)(1u << source);
+    return true;
+}
+
+env_input_source_t env_input_get(const env_input_t * p_env, uint32_t now_ms, env_input_value_t * p_value)
+{
+    for (uint32_t source = 0; source < ENV_INPUT_SOURCE_COUNT; source++)
+    {
+        if ((p_env->valid & (1u << source)) && now_ms - p_env->updated_ms[source] <= ENV_INPUT_MAX_AGE_MS)
+        {
+            *p_value = p_env->values[source];
+            return (env_input_source_t)source;
+        }
+    }
+
+    p_value->temp_x100 = ENV_INPUT_DEFAULT_TEMP_X100;
+    p_value->rh_x100 = ENV_INPUT_DEFAULT_RH_X100;
+    return ENV_INPUT_SOURCE_DEFAULT;
+}
+
+/* CRC-8, polynomial 0x31, init 0xFF (Sensirion) */
+static uint8_t sht4x_crc(const uint8_t * p_data)
+{
+    uint8_t crc = 0xFF;
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        crc ^= p_data[i];
+        for (uint32_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+bool env_input_sht4x_decode(const uint8_t p_raw[ENV_SHT4X_RESULT_LEN], env_input_value_t * p_value)
+{
+    if (sht4x_crc(&p_raw[0]) != p_raw[2] || sht4x_crc(&p_raw[3]) != p_raw[5])
+    {
+        return false;
+    }
+
+    uint32_t t_ticks = ((uint32_t)p_raw[0] << 8) | p_raw[1];
+    uint32_t rh_ticks = ((uint32_t)p_raw[3] << 8) | p_raw[4];
+
+    /* T = -45 + 175 * ticks / 65535, RH = -6 + 125 * ticks / 65535, in hundredths */
+    p_value->temp_x100 = (int16_t)((int32_t)((17500u * t_ticks + 32767u) / 65535u) - 4500);
+
+    int32_t rh_x100 = (int32_t)((12500u * rh_ticks + 32767u) / 65535u) - 600;
+    if (rh_x100 < 0)
+    {
+        rh_x100 = 0;
+    }
+    else if (rh_x100 > ENV_INPUT_RH_X100_MAX)
+    {
+        rh_x100 = ENV_INPUT_RH_X100_MAX;
+    }
+    p_value->rh_x100 = (uint16_t)rh_x100;
+    return true;
+}
@@ -0,0 +1,85 @@
+#ifndef ENV_INPUT_H__
+#define ENV_INPUT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Temperature and humidity for the IAQ algorithm's compensation inputs.
+ *
+ * Sources post readings as they arrive; once per measurement cycle the node
+ * takes the highest-priority source that is fresh (ENV_INPUT_MAX_AGE_MS),
+ * falling back to ENV_INPUT_DEFAULT_*, the conditions the IAQ 2nd Gen
+ * library assumes without a sensor. Sources in priority order:
+ *   local   a T/RH sensor on the node's own TWI bus (SHT4x, decoded here)
+ *   mesh    the vendor Env Values published by a neighbour with one
+ * No SDK dependencies, so tools/twi_budget_check.c runs it on the host.
+ */
+
+typedef enum
+{
+    ENV_INPUT_SOURCE_LOCAL,
+    ENV_INPUT_SOURCE_MESH,
+    ENV_INPUT_SOURCE_COUNT,
+    ENV_INPUT_SOURCE_DEFAULT = ENV_INPUT_SOURCE_COUNT
+} env_input_source_t;
+
+#ifndef ENV_INPUT_MAX_AGE_MS
+#define ENV_INPUT_MAX_AGE_MS        (5 * 60 * 1000)
+#endif
+#define ENV_INPUT_DEFAULT_TEMP_X100 2000    /* 20.00 degC */
+#define ENV_INPUT_DEFAULT_RH_X100   5000    /* 50.00 %RH */
+
+#define ENV_INPUT_TEMP_X100_MIN     (-4500)
+#define ENV_INPUT_TEMP_X100_MAX     13000
+#define ENV_INPUT_RH_X100_MAX       10000
+
+typedef struct
+{
+    int16_t temp_x100;      /* degC * 100 */
+    uint16_t rh_x100;       /* %RH * 100 */
+} env_input_value_t;
+
+typedef struct
+{
+    env_input_value_t values[ENV_INPUT_SOURCE_COUNT];
+    uint32_t updated_ms[ENV_INPUT_SOURCE_COUNT];
+    uint8_t valid;          /* Bit per source that has posted a reading */
+} env_input_t;
+
+void env_input_init(env_input_t * p_env);
+
+/**
+ * @brief Post a reading from a source.
+ *
+ * @return false if the reading is out of range or the source unknown; it is ignored.
+ */
+bool env_input_update(env_input_t * p_env, env_input_source_t source, const env_input_value_t * p_value,
+                      uint32_t now_ms);
+
+/**
+ * @brief Compensation input for this cycle.
+ *
+ * @return Source the value came from, ENV_INPUT_SOURCE_DEFAULT if none is fresh.
+ */
+env_input_source_t env_input_get(const env_input_t * p_env, uint32_t now_ms, env_input_value_t * p_value);
+
+/* ---- SHT4x, the local source ----
+ * One high-precision measurement per cycle, in the TWI window the ZMOD4410
+ * is read in: the result of the previous cycle's command is read, then the
+ * next command written, so the conversion (ENV_SHT4X_CONVERSION_MS) runs
+ * while the bus is off. */
+
+#define ENV_SHT4X_I2C_ADDR          0x44
+#define ENV_SHT4X_CMD_MEASURE_HIGH  0xFD
+#define ENV_SHT4X_CONVERSION_MS     9
+#define ENV_SHT4X_RESULT_LEN        6   /* [t u16 be][crc][rh u16 be][crc] */
+
+/**
+ * @brief Decode a measurement result.
+ *
+ * @return false on a CRC mismatch.
+ */
+bool env_input_sht4x_decode(const uint8_t p_raw[ENV_SHT4X_RESULT_LEN], env_input_value_t * p_value);
+
+#endif /* ENV_INPUT_H__ */
@@ -0,0 +1,271 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "iaq_bulk.h"
+
+static uint8_t * put_u16(uint8_t * p, uint16_t v)
+{
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+    return p + 2;
+}
+
+static uint8_t * put_u32(uint8_t * p, uint32_t v)
+{
+    p = put_u16(p, (uint16_t)(v & 0xFFFF));
+    return put_u16(p, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_u16(const uint8_t * p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t * p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint8_t * put_varint(uint8_t * p, uint32_t v)
+{
+    while (v >= 0x80)
+    {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static bool get_varint(const uint8_t ** pp, const uint8_t * p_end, uint32_t * p_v)
+{
+    uint32_t v = 0;
+    for (uint32_t shift = 0; shift < 35; shift += 7)
+    {
+        if (*pp >= p_end)
+        {
+            return false;
+        }
+        uint8_t byte = *(*pp)++;
+        v |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            *p_v = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint8_t * put_delta(uint8_t * p, uint16_t from, uint16_t to)
+{
+    int32_t d = (int32_t)to - (int32_t)from;
+    return put_varint(p, ((uint32_t)d << 1) ^ (uint32_t)(d >> 31));
+}
+
+static bool get_delta(const uint8_t ** pp, const uint8_t * p_end, uint16_t from, uint16_t * p_to)
+{
+    uint32_t z;
+    if (!get_varint(pp, p_end, &z))
+    {
+        return false;
+    }
+    int32_t d = (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+    *p_to = (uint16_t)((int32_t)from + d);
+    return true;
+}
+
+/* ---- Wire format ---- */
+
+void iaq_bulk_writer_init(iaq_bulk_writer_t * p_writer, uint8_t * p_buf, uint16_t size, uint8_t transfer)
+{
+    memset(p_writer, 0, sizeof(*p_writer));
+    p_writer->p_buf = p_buf;
+    p_writer->size = size;
+    p_writer->length = IAQ_BULK_HEADER_LEN;
+    p_buf[0] = transfer;
+}
+
+bool iaq_bulk_writer_add(iaq_bulk_writer_t * p_writer, const app_iaq_store_sample_t * p_sample)
+{
+    const app_iaq_store_sample_t * p_last = &p_writer->last;
+
+    if (p_writer->count == 0)
+    {
+        uint8_t * p = &p_writer->p_buf[1];
+        p = put_u32(p, p_sample->seq);
+        *p++ = 1;
+        p = put_u16(p, p_sample->boot);
+        p = put_u32(p, p_sample->timestamp_s);
+        p = put_u16(p, p_sample->value.iaq_x10);
+        p = put_u16(p, p_sample->value.tvoc_x100);
+        (void)put_u16(p, p_sample->value.eco2);
+    }
+    else
+    {
+        if (p_writer->count == UINT8_MAX ||
+            p_sample->seq != p_last->seq + 1 ||
+            p_sample->boot != p_last->boot)
+        {
+            return false;
+        }
+
+        uint8_t record[IAQ_BULK_RECORD_MAX];
+        uint8_t * p = record;
+        p = put_varint(p, p_sample->timestamp_s - p_last->timestamp_s);
+        p = put_delta(p, p_last->value.iaq_x10, p_sample->value.iaq_x10);
+        p = put_delta(p, p_last->value.tvoc_x100, p_sample->value.tvoc_x100);
+        p = put_delta(p, p_last->value.eco2, p_sample->value.eco2);
+
+        uint16_t record_len = (uint16_t)(p - record);
+        if (p_writer->length + record_len > p_writer->size)
+        {
+            return false;
+        }
+        memcpy(&p_writer->p_buf[p_writer->length], record, record_len);
+        p_writer->length += record_len;
+        p_writer->p_buf[5] = (uint8_t)(p_writer->count + 1);
+    }
+
+    p_writer->count++;
+    p_writer->last = *p_sample;
+    return true;
+}
+
+bool iaq_bulk_reader_init(iaq_bulk_reader_t * p_reader, const uint8_t * p_buf, uint16_t length)
+{
+    if (length < IAQ_BULK_HEADER_LEN || p_buf[5] == 0)
+    {
+        return false;
+    }
+
+    memset(p_reader, 0, sizeof(*p_reader));
+    p_reader->transfer = p_buf[0];
+    p_reader->count = p_buf[5];
+    p_reader->remaining = p_buf[5];
+    p_reader->p_next = &p_buf[IAQ_BULK_HEADER_LEN];
+    p_reader->p_end = &p_buf[length];
+
+    /* The first sample is held in full in the header */
+    app_iaq_store_sample_t * p_first = &p_reader->last;
+    p_first->seq = get_u32(&p_buf[1]);
+    p_first->boot = get_u16(&p_buf[6]);
+    p_first->timestamp_s = get_u32(&p_buf[8]);
+    p_first->value.iaq_x10 = get_u16(&p_buf[12]);
+    p_first->value.tvoc_x100 = get_u16(&p_buf[14]);
+    p_first->value.eco2 = get_u16(&p_buf[16]);
+    return true;
+}
+
+bool iaq_bulk_reader_next(iaq_bulk_reader_t * p_reader, app_iaq_store_sample_t * p_sample)
+{
+    if (p_reader->remaining == 0)
+    {
+        return false;
+    }
+
+    if (p_reader->remaining < p_reader->count)
+    {
+        app_iaq_store_sample_t next = p_reader->last;
+        uint32_t dt;
+        if (!get_varint(&p_reader->p_next, p_reader->p_end, &dt) ||
+            !get_delta(&p_reader->p_next, p_reader->p_end, next.value.iaq_x10, &next.value.iaq_x10) ||
+            !get_delta(&p_reader->p_next, p_reader->p_end, next.value.tvoc_x100, &next.value.tvoc_x100) ||
+            !get_delta(&p_reader->p_next, p_reader->p_end, next.value.eco2, &next.value.eco2))
+        {
+            p_reader->remaining = 0;
+            return false;
+        }
+        next.seq++;
+        next.timestamp_s += dt;
+        p_reader->last = next;
+    }
+
+    p_reader->remaining--;
+    *p_sample = p_reader->last;
+    return true;
+}
+
+/* ---- Sender flow control ---- */
+
+void iaq_bulk_sender_init(iaq_bulk_sender_t * p_sender)
+{
+    memset(p_sender, 0, sizeof(*p_sender));
+}
+
+bool iaq_bulk_sender_ready(iaq_bulk_sender_t * p_sender, uint32_t oldest_seq, uint32_t now_ms,
+                           uint32_t * p_first_seq)
+{
+    if (p_sender->inflight == IAQ_BULK_WINDOW ||
+        (p_sender->started && now_ms - p_sender->last_start_ms < IAQ_BULK_MIN_GAP_MS))
+    {
+        return false;
+    }
+
+    /* Samples overwritten in the store before they were sent are gone */
+    if (p_sender->next_seq < oldest_seq)
+    {
+        p_sender->next_seq = oldest_seq;
+    }
+    *p_first_seq = p_sender->next_seq;
+    return true;
+}
+
+uint8_t iaq_bulk_sender_sent(iaq_bulk_sender_t * p_sender, uint32_t first_seq, uint8_t count, uint32_t now_ms)
+{
+    iaq_bulk_inflight_t * p_transfer = &p_sender->window[p_sender->inflight++];
+
+    p_transfer->first_seq = first_seq;
+    p_transfer->count = count;
+    p_transfer->sent_ms = now_ms;
+    p_transfer->transfer = p_sender->next_transfer++;
+    p_transfer->acked = false;
+
+    p_sender->next_seq = first_seq + count;
+    p_sender->last_start_ms = now_ms;
+    p_sender->started = true;
+    return p_transfer->transfer;
+}
+
+bool iaq_bulk_sender_ack(iaq_bulk_sender_t * p_sender, uint8_t transfer, uint32_t first_seq,
+                         uint32_t * p_delivered_seq)
+{
+    for (uint32_t i = 0; i < p_sender->inflight; i++)
+    {
+        if (p_sender->window[i].transfer == transfer && p_sender->window[i].first_seq == first_seq)
+        {
+            p_sender->window[i].acked = true;
+            break;
+        }
+    }
+
+    /* The store is a FIFO: only a run of acknowledged transfers from the oldest frees samples */
+    uint32_t done = 0;
+    while (done < p_sender->inflight && p_sender->window[done].acked)
+    {
+        *p_delivered_seq = p_sender->window[done].first_seq + p_sender->window[done].count;
+        done++;
+    }
+    if (done == 0)
+    {
+        return false;
+    }
+
+    p_sender->inflight -= (uint8_t)done;
+    memmove(&p_sender->window[0], &p_sender->window[done], p_sender->inflight * sizeof(p_sender->window[0]));
+    return true;
+}
+
+bool iaq_bulk_sender_check_timeout(iaq_bulk_sender_t * p_sender, uint32_t now_ms)
+{
+    if (p_sender->inflight == 0 || now_ms - p_sender->window[0].sent_ms < IAQ_BULK_ACK_TIMEOUT_MS)
+    {
+        return false;
+    }
+
+    p_sender->next_seq = p_sender->window[0].first_seq;
+    p_sender->inflight = 0;
+    p_sender->timeouts++;
+    return true;
+}
@@ -0,0 +1,137 @@
+#ifndef IAQ_BULK_H__
+#define IAQ_BULK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "app_iaq_store.h"
+
+/*
+ * Bulk backfill of stored readings: wire format and sender flow control.
+ * No SDK dependencies; tools/iaq_bulk_sim.c runs the same code on the host.
+ *
+ * Bulk Data payload, one segmented message per transfer:
+ *   [transfer u8][first_seq u32][count u8][boot u16][timestamp_s u32]
+ *   [iaq_x10 u16][tvoc_x100 u16][eco2 u16]
+ * followed by count - 1 records of deltas against the previous sample,
+ * each a zigzag varint: [dt_s][iaq_x10][tvoc_x100][eco2]. Sequence numbers
+ * are contiguous and a transfer never spans a reboot.
+ *
+ * The gateway acknowledges every transfer with [transfer u8][first_seq u32].
+ * The sender keeps up to IAQ_BULK_WINDOW transfers in flight, starts them at
+ * least IAQ_BULK_MIN_GAP_MS apart so live readings get through in between,
+ * and frees stored samples only once every transfer before them has been
+ * acknowledged. If the oldest transfer is not acknowledged within
+ * IAQ_BULK_ACK_TIMEOUT_MS, everything from it onwards is sent again.
+ */
+
+#define IAQ_BULK_HEADER_LEN         18
+/* Longest delta record: a 32 bit and three 17 bit zigzag varints */
+#define IAQ_BULK_RECORD_MAX         14
+
+#ifndef IAQ_BULK_WINDOW
+#define IAQ_BULK_WINDOW             2
+#endif
+#ifndef IAQ_BULK_MIN_GAP_MS
+#define IAQ_BULK_MIN_GAP_MS         2000
+#endif
+#ifndef IAQ_BULK_ACK_TIMEOUT_MS
+#define IAQ_BULK_ACK_TIMEOUT_MS     10000
+#endif
+
+/* ---- Wire format ---- */
+
+typedef struct
+{
+    uint8_t * p_buf;
+    uint16_t size;
+    uint16_t length;
+    uint8_t count;
+    app_iaq_store_sample_t last;
+} iaq_bulk_writer_t;
+
+typedef struct
+{
+    const uint8_t * p_next;
+    const uint8_t * p_end;
+    uint8_t transfer;
+    uint8_t count;
+    uint8_t remaining;
+    app_iaq_store_sample_t last;
+} iaq_bulk_reader_t;
+
+/** @brief Start a payload in p_buf; size must be at least IAQ_BULK_HEADER_LEN. */
+void iaq_bulk_writer_init(iaq_bulk_writer_t * p_writer, uint8_t * p_buf, uint16_t size, uint8_t transfer);
+
+/**
+ * @brief Append the next sample.
+ *
+ * @return false if it does not fit, is not the next sequence number or comes
+ *         from another boot; the payload is unchanged and ends the transfer.
+ */
+bool iaq_bulk_writer_add(iaq_bulk_writer_t * p_writer, const app_iaq_store_sample_t * p_sample);
+
+/**
+ * @brief Check a received payload and prepare to read its samples.
+ *
+ * @return false if the header is truncated or the count is 0.
+ */
+bool iaq_bulk_reader_init(iaq_bulk_reader_t * p_reader, const uint8_t * p_buf, uint16_t length);
+
+/** @brief Next sample, oldest first. @return false at the end or on a truncated record. */
+bool iaq_bulk_reader_next(iaq_bulk_reader_t * p_reader, app_iaq_store_sample_t * p_sample);
+
+/* ---- Sender flow control ---- */
+
+typedef struct
+{
+    uint32_t first_seq;
+    uint32_t sent_ms;
+    uint8_t transfer;
+    uint8_t count;
+    bool acked;
+} iaq_bulk_inflight_t;
+
+typedef struct
+{
+    iaq_bulk_inflight_t window[IAQ_BULK_WINDOW];  /* Oldest first */
+    uint8_t inflight;
+    uint8_t next_transfer;
+    bool started;
+    uint32_t next_seq;          /* First sequence number not sent yet */
+    uint32_t last_start_ms;
+    uint32_t timeouts;
+} iaq_bulk_sender_t;
+
+void iaq_bulk_sender_init(iaq_bulk_sender_t * p_sender);
+
+/**
+ * @brief Whether a new transfer may start now, and from which sample.
+ *
+ * @param oldest_seq Oldest sample still waiting in the store; the sender
+ *                   skips ahead to it if samples were overwritten.
+ */
+bool iaq_bulk_sender_ready(iaq_bulk_sender_t * p_sender, uint32_t oldest_seq, uint32_t now_ms,
+                           uint32_t * p_first_seq);
+
+/** @brief Record a transfer that was handed to the mesh. @return Its transfer number. */
+uint8_t iaq_bulk_sender_sent(iaq_bulk_sender_t * p_sender, uint32_t first_seq, uint8_t count, uint32_t now_ms);
+
+/**
+ * @brief Process an acknowledgement.
+ *
+ * @param[out] p_delivered_seq First sequence number not yet delivered, for the store.
+ *
+ * @return true if the store can drop samples up to *p_delivered_seq.
+ */
+bool iaq_bulk_sender_ack(iaq_bulk_sender_t * p_sender, uint8_t transfer, uint32_t first_seq,
+                         uint32_t * p_delivered_seq);
+
+/**
+ * @brief Go back to the oldest unacknowledged transfer if it timed out.
+ *
+ * @return true if transfers were abandoned and will be sent again.
+ */
+bool iaq_bulk_sender_check_timeout(iaq_bulk_sender_t * p_sender, uint32_t now_ms);
+
+#endif /* IAQ_BULK_H__ */
@@ -0,0 +1,131 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "iaq_codec.h"
+
+#define FIELD_MAX(bits)     ((1u << (bits)) - 1u)
+
+/* The word is handled as two 32-bit halves, no field straddles bit 32
+ * (iaq_codec.h): 64-bit shifts are library calls on Cortex-M. Positions in
+ * the high half are taken modulo 32. */
+static inline uint32_t field_put(uint32_t value, uint32_t pos, uint32_t bits)
+{
+    if (value > FIELD_MAX(bits))
+    {
+        value = FIELD_MAX(bits);
+    }
+    return value << (pos % 32);
+}
+
+static inline uint32_t field_get(uint32_t half, uint32_t pos, uint32_t bits)
+{
+    return (half >> (pos % 32)) & FIELD_MAX(bits);
+}
+
+static inline void put_u32(uint8_t * p_buf, uint32_t value)
+{
+    p_buf[0] = (uint8_t)value;
+    p_buf[1] = (uint8_t)(value >> 8);
+    p_buf[2] = (uint8_t)(value >> 16);
+    p_buf[3] = (uint8_t)(value >> 24);
+}
+
+static inline uint32_t get_u32(const uint8_t * p_buf)
+{
+    return (uint32_t)p_buf[0] | ((uint32_t)p_buf[1] << 8) | ((uint32_t)p_buf[2] << 16) | ((uint32_t)p_buf[3] << 24);
+}
+
+uint8_t iaq_codec_values_pack(const iaq_sample_t * p_sample, const iaq_codec_meta_t * p_meta, uint8_t * p_buf)
+{
+    uint32_t lo = field_put(p_meta->flags, IAQ_CODEC_FLAGS_POS, IAQ_CODEC_FLAGS_BITS)
+                | field_put(IAQ_CODEC_VERSION, IAQ_CODEC_VERSION_POS, IAQ_CODEC_VERSION_BITS)
+                | field_put(p_meta->seq, IAQ_CODEC_SEQ_POS, IAQ_CODEC_SEQ_BITS)
+                | field_put(p_sample->iaq_x10, IAQ_CODEC_IAQ_POS, IAQ_CODEC_IAQ_BITS)
+                | field_put(p_meta->prev_level, IAQ_CODEC_PREV_LEVEL_POS, IAQ_CODEC_PREV_LEVEL_BITS);
+    uint32_t hi = field_put(p_sample->tvoc_x100, IAQ_CODEC_TVOC_POS, IAQ_CODEC_TVOC_BITS)
+                | field_put(p_sample->eco2, IAQ_CODEC_ECO2_POS, IAQ_CODEC_ECO2_BITS);
+
+    put_u32(&p_buf[0], lo);
+    put_u32(&p_buf[4], hi);
+    return IAQ_CODEC_VALUES_LEN;
+}
+
+void iaq_codec_values_flags_set(uint8_t * p_buf, uint8_t flags)
+{
+    /* Flags sit in the low bits of the first byte */
+    p_buf[0] |= (uint8_t)((flags & FIELD_MAX(IAQ_CODEC_FLAGS_BITS)) << IAQ_CODEC_FLAGS_POS);
+}
+
+uint8_t iaq_codec_values_version(const uint8_t * p_buf, uint8_t length)
+{
+    if (length == 0)
+    {
+        return 0;
+    }
+
+    switch (p_buf[0] >> IAQ_CODEC_VERSION_POS)
+    {
+        case 0:
+            return (length >= IAQ_CODEC_VALUES_V1_LEN) ? 1 : 0;
+        case 2:
+            return (length >= IAQ_CODEC_VALUES_LEN) ? 2 : 0;
+        default:
+            return 0;
+    }
+}
+
+static void values_unpack_v1(const uint8_t * p_buf, iaq_sample_t * p_sample, iaq_codec_meta_t * p_meta)
+{
+    p_meta->level = p_buf[0];
+    p_meta->flags = 0;
+    p_meta->seq = 0;
+    p_meta->prev_level = 0;
+    p_sample->tvoc_x100 = (uint16_t)(p_buf[1] | (p_buf[2] << 8));
+    p_sample->eco2 = (uint16_t)(p_buf[3] | (p_buf[4] << 8));
+    p_sample->iaq_x10 = p_buf[5];
+}
+
+static void values_unpack_v2(const uint8_t * p_buf, iaq_sample_t * p_sample, iaq_codec_meta_t * p_meta)
+{
+    uint32_t lo = get_u32(&p_buf[0]);
+    uint32_t hi = get_u32(&p_buf[4]);
+
+    p_meta->flags = (uint8_t)field_get(lo, IAQ_CODEC_FLAGS_POS, IAQ_CODEC_FLAGS_BITS);
+    p_meta->seq = (uint8_t)field_get(lo, IAQ_CODEC_SEQ_POS, IAQ_CODEC_SEQ_BITS);
+    p_meta->prev_level = (uint8_t)field_get(lo, IAQ_CODEC_PREV_LEVEL_POS, IAQ_CODEC_PREV_LEVEL_BITS);
+    p_sample->iaq_x10 = (uint16_t)field_get(lo, IAQ_CODEC_IAQ_POS, IAQ_CODEC_IAQ_BITS);
+    p_sample->tvoc_x100 = (uint16_t)field_get(hi, IAQ_CODEC_TVOC_POS, IAQ_CODEC_TVOC_BITS);
+    p_sample->eco2 = (uint16_t)field_get(hi, IAQ_CODEC_ECO2_POS, IAQ_CODEC_ECO2_BITS);
+    p_meta->level = iaq_sample_level(p_sample->iaq_x10);
+}
+
+bool iaq_codec_values_unpack(const uint8_t * p_buf, uint8_t length,
+                             iaq_sample_t * p_sample, iaq_codec_meta_t * p_meta)
+{
+    uint8_t version = iaq_codec_values_version(p_buf, length);
+    switch (version)
+    {
+        case 1:
+            values_unpack_v1(p_buf, p_sample, p_meta);
+            break;
+        case 2:
+            values_unpack_v2(p_buf, p_sample, p_meta);
+            break;
+        default:
+            return false;
+    }
+
+    p_meta->version = version;
+    return true;
+}
+
+int iaq_codec_format_values(char * p_buf, size_t size, uint16_t node_addr, const iaq_sample_t * p_sample)
+{
+    return snprintf(p_buf, size,
+                    "{\"node\":\"0x%04X\",\"iaq\":%u.%u,\"tvoc\":%u.%02u,\"eco2\":%u}\n",
+                    node_addr,
+                    p_sample->iaq_x10 / 10, p_sample->iaq_x10 % 10,
+                    p_sample->tvoc_x100 / 100, p_sample->tvoc_x100 % 100,
+                    p_sample->eco2);
+}
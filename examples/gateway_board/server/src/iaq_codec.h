@@ -0,0 +1,127 @@
+#ifndef IAQ_CODEC_H__
+#define IAQ_CODEC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "iaq_sample.h"
+
+/*
+ * Wire formats of a live reading: the vendor Sensor Values payload on the
+ * mesh and the JSON line the gateway writes to UART. No SDK dependencies, so
+ * the per-message path can be benchmarked on the host (tools/iaq_bench.c).
+ *
+ * Sensor Values payload, version 2: one little-endian 64-bit word of
+ *   [flags:5][version:3][seq:8][iaq_x10:13][prev_level:3][tvoc_x100:16][eco2:14][reserved:2]
+ * from bit 0 up. Values above a field's range are sent saturated.
+ *
+ * Version 1, still decoded for nodes on older firmware:
+ *   [iaq_level u8][tvoc_x100 u16][eco2 u16][iaq_x10 u8]
+ * Its first byte is the level, 1..5, so the version field of the first byte
+ * reads 0 for it. iaq_x10 wraps above IAQ 25.5.
+ */
+
+#define IAQ_CODEC_VERSION           2
+#define IAQ_CODEC_VALUES_LEN        8
+#define IAQ_CODEC_VALUES_V1_LEN     6
+
+/* Field positions and widths in the version 2 word */
+#define IAQ_CODEC_FLAGS_POS         0
+#define IAQ_CODEC_FLAGS_BITS        5
+#define IAQ_CODEC_VERSION_POS       5
+#define IAQ_CODEC_VERSION_BITS      3
+#define IAQ_CODEC_SEQ_POS           8
+#define IAQ_CODEC_SEQ_BITS          8
+#define IAQ_CODEC_IAQ_POS           16
+#define IAQ_CODEC_IAQ_BITS          13
+#define IAQ_CODEC_PREV_LEVEL_POS    29
+#define IAQ_CODEC_PREV_LEVEL_BITS   3
+#define IAQ_CODEC_TVOC_POS          32
+#define IAQ_CODEC_TVOC_BITS         16
+#define IAQ_CODEC_ECO2_POS          48
+#define IAQ_CODEC_ECO2_BITS         14
+#define IAQ_CODEC_LAYOUT_BITS       62
+
+/* Layout checks: fields follow each other without overlap, none straddles
+ * bit 32, the word fits the payload, each field holds its whole range, and
+ * version 1 payloads (first byte 1..5) read as version 0. */
+#if IAQ_CODEC_FLAGS_POS + IAQ_CODEC_FLAGS_BITS != IAQ_CODEC_VERSION_POS || \
+    IAQ_CODEC_VERSION_POS + IAQ_CODEC_VERSION_BITS != IAQ_CODEC_SEQ_POS || \
+    IAQ_CODEC_SEQ_POS + IAQ_CODEC_SEQ_BITS != IAQ_CODEC_IAQ_POS || \
+    IAQ_CODEC_IAQ_POS + IAQ_CODEC_IAQ_BITS != IAQ_CODEC_PREV_LEVEL_POS || \
+    IAQ_CODEC_PREV_LEVEL_POS + IAQ_CODEC_PREV_LEVEL_BITS != IAQ_CODEC_TVOC_POS || \
+    IAQ_CODEC_TVOC_POS + IAQ_CODEC_TVOC_BITS != IAQ_CODEC_ECO2_POS || \
+    IAQ_CODEC_ECO2_POS + IAQ_CODEC_ECO2_BITS != IAQ_CODEC_LAYOUT_BITS
+#error "Sensor Values fields overlap or leave a gap"
+#endif
+#if IAQ_CODEC_TVOC_POS != 32
+#error "Sensor Values fields must split at bit 32, see iaq_codec.c"
+#endif
+#if IAQ_CODEC_LAYOUT_BITS > IAQ_CODEC_VALUES_LEN * 8
+#error "Sensor Values fields do not fit IAQ_CODEC_VALUES_LEN"
+#endif
+#if IAQ_SAMPLE_IAQ_X10_MAX >= (1 << IAQ_CODEC_IAQ_BITS) || \
+    IAQ_SAMPLE_ECO2_MAX >= (1 << IAQ_CODEC_ECO2_BITS) || \
+    IAQ_SAMPLE_LEVEL_MAX >= (1 << IAQ_CODEC_PREV_LEVEL_BITS) || \
+    IAQ_CODEC_VERSION >= (1 << IAQ_CODEC_VERSION_BITS)
+#error "Sensor Values field too narrow for its range"
+#endif
+#if IAQ_CODEC_VERSION_POS + IAQ_CODEC_VERSION_BITS != 8 || IAQ_SAMPLE_LEVEL_MAX >= (1 << IAQ_CODEC_VERSION_POS)
+#error "Version 1 payloads would not decode as version 0"
+#endif
+
+/* Status flags */
+#define IAQ_CODEC_FLAG_ALARM        0x01    /* Level rose to MESH_VENDOR_ALERT_LEVEL or above */
+#define IAQ_CODEC_FLAG_RETRIED      0x02    /* Sent late, from the node's retry queue */
+
+/* Longest UART line produced by iaq_codec_format_values(), including '\n' */
+#define IAQ_CODEC_LINE_MAX      64
+
+/* What a payload carries besides the reading */
+typedef struct
+{
+    uint8_t version;        /* Payload version, set by unpack */
+    uint8_t level;          /* IAQ rating, 1..5, set by unpack */
+    uint8_t flags;          /* IAQ_CODEC_FLAG_* */
+    uint8_t seq;            /* Per-node message counter, wraps */
+    uint8_t prev_level;     /* Level of the node's previous message, 0 if none */
+} iaq_codec_meta_t;
+
+/**
+ * @brief Pack a reading into a version 2 Sensor Values payload. The level is
+ * derived from the reading; version and level in p_meta are ignored.
+ *
+ * @param[out] p_buf At least IAQ_CODEC_VALUES_LEN bytes.
+ *
+ * @return Payload length.
+ */
+uint8_t iaq_codec_values_pack(const iaq_sample_t * p_sample, const iaq_codec_meta_t * p_meta, uint8_t * p_buf);
+
+/** @brief Set status flags in a packed version 2 payload. */
+void iaq_codec_values_flags_set(uint8_t * p_buf, uint8_t flags);
+
+/**
+ * @brief Payload version, from the first byte.
+ *
+ * @return 0 if the payload is too short for its version or of an unknown version.
+ */
+uint8_t iaq_codec_values_version(const uint8_t * p_buf, uint8_t length);
+
+/**
+ * @brief Decode a received Sensor Values payload of any known version. A
+ * version 1 payload leaves flags, seq and prev_level 0.
+ *
+ * @return false if iaq_codec_values_version() rejects it; outputs are left untouched.
+ */
+bool iaq_codec_values_unpack(const uint8_t * p_buf, uint8_t length,
+                             iaq_sample_t * p_sample, iaq_codec_meta_t * p_meta);
+
+/**
+ * @brief Format a reading as the gateway's UART JSON line, '\n' terminated.
+ *
+ * @return Line length, or a negative value / a value >= size if it does not fit (as snprintf).
+ */
+int iaq_codec_format_values(char * p_buf, size_t size, uint16_t node_addr, const iaq_sample_t * p_sample);
+
+#endif /* IAQ_CODEC_H__ */
@@ -0,0 +1,154 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iaq_ext.h"
+
+static uint32_t float_bits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float bits_float(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static uint8_t * put_u32(uint8_t * p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+static uint32_t get_u32(const uint8_t * p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint16_t iaq_ext_pack(const iaq_ext_values_t * p_values, uint8_t seq, uint32_t uptime_s, uint8_t * p_buf)
+{
+    uint8_t * p = p_buf;
+
+    *p++ = seq;
+    *p++ = p_values->fields;
+    p = put_u32(p, uptime_s);
+
+    if (p_values->fields & IAQ_EXT_FIELD_ETOH)
+    {
+        p = put_u32(p, float_bits(p_values->etoh));
+    }
+    if (p_values->fields & IAQ_EXT_FIELD_LOG_RCDA)
+    {
+        p = put_u32(p, float_bits(p_values->log_rcda));
+    }
+    if (p_values->fields & IAQ_EXT_FIELD_REL_IAQ)
+    {
+        p = put_u32(p, float_bits(p_values->rel_iaq));
+    }
+    if (p_values->fields & IAQ_EXT_FIELD_RMOX)
+    {
+        uint8_t count = (p_values->rmox_count < IAQ_EXT_RMOX_MAX) ? p_values->rmox_count : IAQ_EXT_RMOX_MAX;
+        *p++ = count;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            p = put_u32(p, float_bits(p_values->rmox[i]));
+        }
+    }
+
+    return (uint16_t)(p - p_buf);
+}
+
+bool iaq_ext_unpack(const uint8_t * p_buf, uint16_t length,
+                    iaq_ext_values_t * p_values, uint8_t * p_seq, uint32_t * p_uptime_s)
+{
+    if (length < IAQ_EXT_HEADER_LEN)
+    {
+        return false;
+    }
+
+    const uint8_t * p = &p_buf[IAQ_EXT_HEADER_LEN];
+    const uint8_t * p_end = p_buf + length;
+    iaq_ext_values_t values;
+    memset(&values, 0, sizeof(values));
+    values.fields = p_buf[1] & (IAQ_EXT_FIELD_ETOH | IAQ_EXT_FIELD_LOG_RCDA |
+                                IAQ_EXT_FIELD_REL_IAQ | IAQ_EXT_FIELD_RMOX);
+
+    float * p_scalars[] = { &values.etoh, &values.log_rcda, &values.rel_iaq };
+    for (uint32_t i = 0; i < sizeof(p_scalars) / sizeof(p_scalars[0]); i++)
+    {
+        if (values.fields & (1u << i))
+        {
+            if (p_end - p < 4)
+            {
+                return false;
+            }
+            *p_scalars[i] = bits_float(get_u32(p));
+            p += 4;
+        }
+    }
+
+    if (values.fields & IAQ_EXT_FIELD_RMOX)
+    {
+        if (p == p_end || *p > IAQ_EXT_RMOX_MAX || p_end - p - 1 < *p * 4)
+        {
+            return false;
+        }
+        values.rmox_count = *p++;
+        for (uint8_t i = 0; i < values.rmox_count; i++, p += 4)
+        {
+            values.rmox[i] = bits_float(get_u32(p));
+        }
+    }
+
+    *p_values = values;
+    *p_seq = p_buf[0];
+    *p_uptime_s = get_u32(&p_buf[2]);
+    return true;
+}
+
+int iaq_ext_format(char * p_buf, size_t size, uint16_t node_addr, uint8_t seq, uint32_t uptime_s,
+                   const iaq_ext_values_t * p_values)
+{
+    int len = snprintf(p_buf, size, "{\"node\":\"0x%04X\",\"seq\":%u,\"t\":%lu",
+                       node_addr, seq, (unsigned long)uptime_s);
+
+    if ((p_values->fields & IAQ_EXT_FIELD_ETOH) && len > 0 && len < (int)size)
+    {
+        len += snprintf(&p_buf[len], size - len, ",\"etoh\":\"%08lX\"", (unsigned long)float_bits(p_values->etoh));
+    }
+    if ((p_values->fields & IAQ_EXT_FIELD_LOG_RCDA) && len > 0 && len < (int)size)
+    {
+        len += snprintf(&p_buf[len], size - len, ",\"log_rcda\":\"%08lX\"",
+                        (unsigned long)float_bits(p_values->log_rcda));
+    }
+    if ((p_values->fields & IAQ_EXT_FIELD_REL_IAQ) && len > 0 && len < (int)size)
+    {
+        len += snprintf(&p_buf[len], size - len, ",\"rel_iaq\":\"%08lX\"",
+                        (unsigned long)float_bits(p_values->rel_iaq));
+    }
+    if ((p_values->fields & IAQ_EXT_FIELD_RMOX) && len > 0 && len < (int)size)
+    {
+        len += snprintf(&p_buf[len], size - len, ",\"rmox\":\"");
+        for (uint8_t i = 0; i < p_values->rmox_count && len > 0 && len < (int)size; i++)
+        {
+            len += snprintf(&p_buf[len], size - len, "%08lX", (unsigned long)float_bits(p_values->rmox[i]));
+        }
+        if (len > 0 && len < (int)size)
+        {
+            len += snprintf(&p_buf[len], size - len, "\"");
+        }
+    }
+    if (len > 0 && len < (int)size)
+    {
+        len += snprintf(&p_buf[len], size - len, ",\"ext\":1}\n");
+    }
+    return len;
+}
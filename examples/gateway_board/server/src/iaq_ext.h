@@ -0,0 +1,90 @@
+#ifndef IAQ_EXT_H__
+#define IAQ_EXT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Extended telemetry: the IAQ 2nd Gen outputs a live reading leaves out, for
+ * training models off the node. Sent on its own slow cadence with the vendor
+ * Ext Values message; the live path only checks whether one is due. No SDK
+ * dependencies, so tools/iaq_bench.c measures that check on the host.
+ *
+ * Ext Values payload:
+ *   [seq u8][fields u8][uptime_s u32]
+ * followed by each field present in fields, in bit order:
+ *   IAQ_EXT_FIELD_ETOH      [etoh f32]        ethanol, ppm
+ *   IAQ_EXT_FIELD_LOG_RCDA  [log_rcda f32]    log10 of the clean dry air resistance
+ *   IAQ_EXT_FIELD_REL_IAQ   [rel_iaq f32]     relative IAQ
+ *   IAQ_EXT_FIELD_RMOX      [count u8][rmox f32 * count]  MOx resistances per step, ohm
+ * Floats are the library's own values, IEEE 754 single precision, little
+ * endian: no float math on the node and nothing lost for training.
+ */
+
+#define IAQ_EXT_FIELD_ETOH      0x01
+#define IAQ_EXT_FIELD_LOG_RCDA  0x02
+#define IAQ_EXT_FIELD_REL_IAQ   0x04
+#define IAQ_EXT_FIELD_RMOX      0x08
+
+/* Measurement steps of the IAQ 2nd Gen sequence */
+#define IAQ_EXT_RMOX_MAX        13
+
+#define IAQ_EXT_HEADER_LEN      6
+#define IAQ_EXT_PAYLOAD_MAX     (IAQ_EXT_HEADER_LEN + 3 * 4 + 1 + IAQ_EXT_RMOX_MAX * 4)
+
+/* Longest UART line produced by iaq_ext_format(), including '\n' */
+#define IAQ_EXT_LINE_MAX        240
+
+typedef struct
+{
+    uint8_t fields;         /* IAQ_EXT_FIELD_* present */
+    uint8_t rmox_count;     /* Up to IAQ_EXT_RMOX_MAX */
+    float etoh;
+    float log_rcda;
+    float rel_iaq;
+    float rmox[IAQ_EXT_RMOX_MAX];
+} iaq_ext_values_t;
+
+/**
+ * @brief Whether an Ext Values message is due; if so, schedules the next one
+ * period_ms later. This is all the per-measurement path pays.
+ *
+ * @param[in,out] p_next_ms Uptime the next message is due at, 0 for right away.
+ */
+static inline bool iaq_ext_due(uint32_t * p_next_ms, uint32_t now_ms, uint32_t period_ms)
+{
+    if ((int32_t)(now_ms - *p_next_ms) < 0)
+    {
+        return false;
+    }
+    *p_next_ms = now_ms + period_ms;
+    return true;
+}
+
+/**
+ * @param[out] p_buf At least IAQ_EXT_PAYLOAD_MAX bytes.
+ *
+ * @return Payload length.
+ */
+uint16_t iaq_ext_pack(const iaq_ext_values_t * p_values, uint8_t seq, uint32_t uptime_s, uint8_t * p_buf);
+
+/**
+ * @return false if the payload is shorter than its fields say or carries more
+ * than IAQ_EXT_RMOX_MAX resistances. Unknown field bits are ignored.
+ */
+bool iaq_ext_unpack(const uint8_t * p_buf, uint16_t length,
+                    iaq_ext_values_t * p_values, uint8_t * p_seq, uint32_t * p_uptime_s);
+
+/**
+ * @brief Format as the gateway's UART JSON line, '\n' terminated. Floats are
+ * written as the 8 hex digits of their IEEE 754 bits, the gateway has no float
+ * printf; rmox is all resistances back to back so the line fits the UART FIFO:
+ * {"node":"0x0029","seq":3,"t":600,"etoh":"3E4CCCCD","log_rcda":"40A00000","rmox":"47C35000...","ext":1}
+ *
+ * @return As snprintf.
+ */
+int iaq_ext_format(char * p_buf, size_t size, uint16_t node_addr, uint8_t seq, uint32_t uptime_s,
+                   const iaq_ext_values_t * p_values);
+
+#endif /* IAQ_EXT_H__ */
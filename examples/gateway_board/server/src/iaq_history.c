@@ -0,0 +1,124 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "iaq_history.h"
+
+static void store(iaq_history_t * p_history, uint32_t bucket,
+                  uint16_t iaq_x10, uint16_t tvoc_x100, uint16_t eco2)
+{
+    uint32_t slot = bucket % IAQ_HISTORY_LEN;
+    p_history->iaq_x10[slot] = iaq_x10;
+    p_history->tvoc_x100[slot] = tvoc_x100;
+    p_history->eco2[slot] = eco2;
+    if (p_history->stored < IAQ_HISTORY_LEN)
+    {
+        p_history->stored++;
+    }
+}
+
+static void close_open_bucket(iaq_history_t * p_history)
+{
+    uint32_t n = p_history->sum_count;
+    if (n == 0)
+    {
+        store(p_history, p_history->open, IAQ_HISTORY_NO_DATA, 0, 0);
+    }
+    else
+    {
+        /* Rounded means; they stay within the range of the inputs */
+        store(p_history, p_history->open,
+              (uint16_t)((p_history->sum_iaq_x10 + n / 2) / n),
+              (uint16_t)((p_history->sum_tvoc_x100 + n / 2) / n),
+              (uint16_t)((p_history->sum_eco2 + n / 2) / n));
+    }
+
+    p_history->sum_iaq_x10 = 0;
+    p_history->sum_tvoc_x100 = 0;
+    p_history->sum_eco2 = 0;
+    p_history->sum_count = 0;
+}
+
+void iaq_history_init(iaq_history_t * p_history)
+{
+    memset(p_history, 0, sizeof(*p_history));
+}
+
+void iaq_history_add(iaq_history_t * p_history, const iaq_sample_t * p_sample, uint32_t now_ms)
+{
+    uint32_t bucket = iaq_history_bucket(now_ms);
+
+    if (!p_history->started)
+    {
+        p_history->started = true;
+        p_history->open = bucket;
+    }
+    else if (bucket > p_history->open)
+    {
+        close_open_bucket(p_history);
+
+        /* Buckets without a single sample; more than a full ring only overwrites it */
+        uint32_t empty = bucket - p_history->open - 1;
+        if (empty > IAQ_HISTORY_LEN)
+        {
+            empty = IAQ_HISTORY_LEN;
+        }
+        for (uint32_t i = 0; i < empty; i++)
+        {
+            store(p_history, bucket - empty + i, IAQ_HISTORY_NO_DATA, 0, 0);
+        }
+        p_history->open = bucket;
+    }
+
+    /* A bucket is at most a few thousand samples; the sums cannot overflow */
+    if (p_history->sum_count < UINT16_MAX)
+    {
+        p_history->sum_iaq_x10 += p_sample->iaq_x10;
+        p_history->sum_tvoc_x100 += p_sample->tvoc_x100;
+        p_history->sum_eco2 += p_sample->eco2;
+        p_history->sum_count++;
+    }
+}
+
+uint32_t iaq_history_query(const iaq_history_t * p_history, uint32_t from, uint32_t to,
+                           iaq_sample_t * p_out, uint32_t max,
+                           uint32_t * p_first, uint32_t * p_last)
+{
+    *p_first = from;
+    *p_last = to;
+    if (p_history->stored == 0)
+    {
+        return 0;
+    }
+
+    uint32_t newest = p_history->open - 1;
+    uint32_t oldest = p_history->open - p_history->stored;
+    if (from < oldest)
+    {
+        from = oldest;
+    }
+    if (to > newest)
+    {
+        to = newest;
+    }
+    *p_first = from;
+    *p_last = to;
+    if (from > to)
+    {
+        return 0;
+    }
+
+    uint32_t count = to - from + 1;
+    if (count > max)
+    {
+        count = max;
+    }
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t slot = (from + i) % IAQ_HISTORY_LEN;
+        p_out[i].iaq_x10 = p_history->iaq_x10[slot];
+        p_out[i].tvoc_x100 = p_history->tvoc_x100[slot];
+        p_out[i].eco2 = p_history->eco2[slot];
+    }
+    return count;
+}
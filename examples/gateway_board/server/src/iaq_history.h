@@ -0,0 +1,79 @@
+#ifndef IAQ_HISTORY_H__
+#define IAQ_HISTORY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "iaq_sample.h"
+
+/*
+ * RAM ring of downsampled readings: the mean of every IAQ_HISTORY_BUCKET_MS
+ * of valid samples, for the last IAQ_HISTORY_LEN buckets. Buckets are
+ * numbered from boot (uptime / IAQ_HISTORY_BUCKET_MS); one without valid
+ * samples holds IAQ_HISTORY_NO_DATA. Only closed buckets are queryable.
+ *
+ * Unlike the flash store (app_iaq_store.h), which keeps the readings that
+ * could not be published, this keeps everything, so a gateway can fill gaps
+ * of its own on demand. Lost on reset. No SDK dependencies.
+ */
+
+#ifndef IAQ_HISTORY_LEN
+#define IAQ_HISTORY_LEN         240     /* 4 h of 1 minute means, 1440 bytes */
+#endif
+#ifndef IAQ_HISTORY_BUCKET_MS
+#define IAQ_HISTORY_BUCKET_MS   60000
+#endif
+
+/* iaq_x10 of a bucket without valid samples */
+#define IAQ_HISTORY_NO_DATA     0xFFFF
+
+typedef struct
+{
+    /* Struct of arrays: no padding, and the ring stays dense per quantity */
+    uint16_t iaq_x10[IAQ_HISTORY_LEN];
+    uint16_t tvoc_x100[IAQ_HISTORY_LEN];
+    uint16_t eco2[IAQ_HISTORY_LEN];
+    uint32_t open;          /* Bucket being accumulated */
+    uint32_t stored;        /* Closed buckets in the ring, up to IAQ_HISTORY_LEN */
+    uint32_t sum_iaq_x10;
+    uint32_t sum_tvoc_x100;
+    uint32_t sum_eco2;
+    uint16_t sum_count;
+    bool started;
+} iaq_history_t;
+
+/** @brief Empty the ring. */
+void iaq_history_init(iaq_history_t * p_history);
+
+/**
+ * @brief Account one valid sample. Closes the open bucket, and any empty
+ * ones in between, once now_ms has moved past it.
+ *
+ * @param now_ms Sampling uptime, monotonic.
+ */
+void iaq_history_add(iaq_history_t * p_history, const iaq_sample_t * p_sample, uint32_t now_ms);
+
+/** @brief Bucket the given uptime falls into. */
+static inline uint32_t iaq_history_bucket(uint32_t now_ms)
+{
+    return now_ms / IAQ_HISTORY_BUCKET_MS;
+}
+
+/**
+ * @brief Read closed buckets in [from, to], oldest first.
+ *
+ * The range is clipped to what the ring holds; at most max buckets are
+ * returned, so a caller pages through a long range by asking again from
+ * *p_first + count.
+ *
+ * @param[out] p_first First bucket returned.
+ * @param[out] p_last  Last bucket of the clipped range, which may be past
+ *                     the ones returned.
+ *
+ * @return Buckets written to p_out; 0 if the range holds none.
+ */
+uint32_t iaq_history_query(const iaq_history_t * p_history, uint32_t from, uint32_t to,
+                           iaq_sample_t * p_out, uint32_t max,
+                           uint32_t * p_first, uint32_t * p_last);
+
+#endif /* IAQ_HISTORY_H__ */
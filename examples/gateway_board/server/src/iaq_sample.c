@@ -0,0 +1,105 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "iaq_sample.h"
+
+/* Rejects NaN, Inf and magnitudes above 1e10, as the float path did; both
+ * compares are false for NaN. */
+static bool is_valid_float(float val)
+{
+    return val <= 1e10f && val >= -1e10f;
+}
+
+/* Scale, round to nearest and saturate to [0, max]. Values below zero return 0. */
+static uint32_t scale_round(float val, float scale, uint32_t max)
+{
+    float scaled = val * scale;
+    if (scaled <= 0.0f)
+    {
+        return 0;
+    }
+    if (scaled >= (float)max)
+    {
+        return max;
+    }
+    return (uint32_t)(scaled + 0.5f);
+}
+
+bool iaq_sample_from_float(float iaq, float tvoc, float eco2, iaq_sample_t * p_sample)
+{
+    if (!is_valid_float(iaq) || !is_valid_float(tvoc) || !is_valid_float(eco2))
+    {
+        return false;
+    }
+
+    /* Saturate one step above the valid range so out-of-range input is caught below */
+    uint32_t iaq_x10 = scale_round(iaq, 10.0f, IAQ_SAMPLE_IAQ_X10_MAX + 1);
+    uint32_t eco2_i = scale_round(eco2, 1.0f, IAQ_SAMPLE_ECO2_MAX + 1);
+
+    if (iaq < 0.0f || iaq_x10 > IAQ_SAMPLE_IAQ_X10_MAX || eco2_i > IAQ_SAMPLE_ECO2_MAX)
+    {
+        return false;
+    }
+
+    p_sample->iaq_x10 = (uint16_t)iaq_x10;
+    p_sample->tvoc_x100 = (uint16_t)scale_round(tvoc, 100.0f, UINT16_MAX);
+    p_sample->eco2 = (uint16_t)eco2_i;
+    return true;
+}
+
+uint16_t iaq_sample_get(const iaq_sample_t * p_sample, iaq_sample_property_t property)
+{
+    switch (property)
+    {
+        case IAQ_SAMPLE_PROPERTY_IAQ:
+            return p_sample->iaq_x10;
+        case IAQ_SAMPLE_PROPERTY_TVOC:
+            return p_sample->tvoc_x100;
+        case IAQ_SAMPLE_PROPERTY_ECO2:
+            return p_sample->eco2;
+        default:
+            return 0;
+    }
+}
+
+void iaq_sample_cadence_default(sensor_cadence_t cadence[IAQ_SAMPLE_PROPERTY_COUNT])
+{
+    static const uint16_t s_delta[IAQ_SAMPLE_PROPERTY_COUNT] =
+    {
+        IAQ_SAMPLE_IAQ_THRESHOLD_X10, IAQ_SAMPLE_TVOC_THRESHOLD_X100, IAQ_SAMPLE_ECO2_THRESHOLD
+    };
+    static const uint16_t s_fast_low[IAQ_SAMPLE_PROPERTY_COUNT] =
+    {
+        IAQ_SAMPLE_IAQ_FAST_LOW_X10, IAQ_SAMPLE_TVOC_FAST_LOW_X100, IAQ_SAMPLE_ECO2_FAST_LOW
+    };
+
+    for (uint32_t i = 0; i < IAQ_SAMPLE_PROPERTY_COUNT; i++)
+    {
+        memset(&cadence[i], 0, sizeof(cadence[i]));
+        cadence[i].fast_divisor_log2 = IAQ_SAMPLE_FAST_DIVISOR_LOG2;
+        cadence[i].delta_down = s_delta[i];
+        cadence[i].delta_up = s_delta[i];
+        cadence[i].min_interval_log2 = IAQ_SAMPLE_MIN_INTERVAL_LOG2;
+        cadence[i].fast_low = s_fast_low[i];
+        cadence[i].fast_high = UINT16_MAX;
+    }
+}
+
+uint8_t iaq_sample_due(const sensor_cadence_t cadence[IAQ_SAMPLE_PROPERTY_COUNT],
+                       const iaq_sample_t * p_published, uint32_t elapsed_ms, uint32_t period_ms,
+                       const iaq_sample_t * p_sample)
+{
+    uint8_t due = 0;
+
+    for (uint32_t i = 0; i < IAQ_SAMPLE_PROPERTY_COUNT; i++)
+    {
+        iaq_sample_property_t property = (iaq_sample_property_t)i;
+        if (sensor_cadence_is_due(&cadence[i], iaq_sample_get(p_sample, property),
+                                  iaq_sample_get(p_published, property), elapsed_ms, period_ms))
+        {
+            due |= (uint8_t)(1u << i);
+        }
+    }
+    return due;
+}
@@ -0,0 +1,119 @@
+#ifndef IAQ_SAMPLE_H__
+#define IAQ_SAMPLE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sensor_cadence.h"
+
+/*
+ * Fixed-point IAQ reading.
+ *
+ * The IAQ algorithm hands us floats; they are converted exactly once, right
+ * after calc_iaq_2nd_gen(), and everything downstream (validation, cadence,
+ * payload packing, logging, UART formatting) works on these integers.
+ * tools/iaq_sample_equiv.c checks the result against the float path this
+ * replaced.
+ */
+typedef struct
+{
+    uint16_t iaq_x10;       /* IAQ index * 10, 0..IAQ_SAMPLE_IAQ_X10_MAX */
+    uint16_t tvoc_x100;     /* TVOC mg/m3 * 100, saturated at 655.35 */
+    uint16_t eco2;          /* eCO2 ppm, 0..IAQ_SAMPLE_ECO2_MAX */
+} iaq_sample_t;
+
+#define IAQ_SAMPLE_IAQ_X10_MAX  5000    /* IAQ 500.0 */
+#define IAQ_SAMPLE_ECO2_MAX     10000   /* ppm */
+
+/* Quantities of a reading, each with its own publish cadence */
+typedef enum
+{
+    IAQ_SAMPLE_PROPERTY_IAQ,
+    IAQ_SAMPLE_PROPERTY_TVOC,
+    IAQ_SAMPLE_PROPERTY_ECO2,
+    IAQ_SAMPLE_PROPERTY_COUNT
+} iaq_sample_property_t;
+
+/* Default cadence of the vendor readings. A reading is published once any
+ * quantity moved by its delta since the last published reading, or once the
+ * publish period (divided by 2^IAQ_SAMPLE_FAST_DIVISOR_LOG2 while a quantity
+ * is at or above its fast threshold) has passed. Deltas are in the units of
+ * iaq_sample_t. */
+#ifndef IAQ_SAMPLE_IAQ_THRESHOLD_X10
+#define IAQ_SAMPLE_IAQ_THRESHOLD_X10    5       /* 0.5 */
+#endif
+#ifndef IAQ_SAMPLE_TVOC_THRESHOLD_X100
+#define IAQ_SAMPLE_TVOC_THRESHOLD_X100  5       /* 0.05 mg/m3 */
+#endif
+#ifndef IAQ_SAMPLE_ECO2_THRESHOLD
+#define IAQ_SAMPLE_ECO2_THRESHOLD       10      /* ppm */
+#endif
+#ifndef IAQ_SAMPLE_IAQ_FAST_LOW_X10
+#define IAQ_SAMPLE_IAQ_FAST_LOW_X10     40      /* Rating 4 (poor) and up */
+#endif
+#ifndef IAQ_SAMPLE_TVOC_FAST_LOW_X100
+#define IAQ_SAMPLE_TVOC_FAST_LOW_X100   300     /* 3 mg/m3 */
+#endif
+#ifndef IAQ_SAMPLE_ECO2_FAST_LOW
+#define IAQ_SAMPLE_ECO2_FAST_LOW        1000    /* ppm */
+#endif
+#ifndef IAQ_SAMPLE_FAST_DIVISOR_LOG2
+#define IAQ_SAMPLE_FAST_DIVISOR_LOG2    2       /* 4x faster */
+#endif
+#ifndef IAQ_SAMPLE_MIN_INTERVAL_LOG2
+#define IAQ_SAMPLE_MIN_INTERVAL_LOG2    0       /* 1 ms: every measurement may publish */
+#endif
+
+/* Flags returned by iaq_sample_due() */
+#define IAQ_SAMPLE_CHANGED_IAQ  (1u << IAQ_SAMPLE_PROPERTY_IAQ)
+#define IAQ_SAMPLE_CHANGED_TVOC (1u << IAQ_SAMPLE_PROPERTY_TVOC)
+#define IAQ_SAMPLE_CHANGED_ECO2 (1u << IAQ_SAMPLE_PROPERTY_ECO2)
+
+/**
+ * @brief Convert algorithm outputs into a fixed-point sample.
+ *
+ * Values are rounded to the nearest step. NaN, Inf, magnitudes above 1e10,
+ * negative IAQ and out-of-range IAQ or eCO2 are rejected; TVOC and eCO2 below
+ * zero are clamped.
+ *
+ * @return false if the reading is invalid; p_sample is left untouched.
+ */
+bool iaq_sample_from_float(float iaq, float tvoc, float eco2, iaq_sample_t * p_sample);
+
+/** @brief Value of one quantity, in the units of iaq_sample_t. */
+uint16_t iaq_sample_get(const iaq_sample_t * p_sample, iaq_sample_property_t property);
+
+/** @brief Fill in the default cadence of every quantity. */
+void iaq_sample_cadence_default(sensor_cadence_t cadence[IAQ_SAMPLE_PROPERTY_COUNT]);
+
+/**
+ * @brief Decide whether a reading is due for publishing.
+ *
+ * Pure function with no SDK dependencies, so the trace replay tool runs the
+ * same publish decision as the node.
+ *
+ * @param p_published Last published reading.
+ * @param elapsed_ms  Time since it was published, or SENSOR_CADENCE_NEVER.
+ * @param period_ms   Base publish period; 0 publishes on deltas only.
+ *
+ * @return IAQ_SAMPLE_CHANGED_* flags of the quantities that are due; 0 if none.
+ */
+uint8_t iaq_sample_due(const sensor_cadence_t cadence[IAQ_SAMPLE_PROPERTY_COUNT],
+                       const iaq_sample_t * p_published, uint32_t elapsed_ms, uint32_t period_ms,
+                       const iaq_sample_t * p_sample);
+
+#define IAQ_SAMPLE_LEVEL_MAX    5
+
+/**
+ * @brief IAQ rating 1 (very good) .. IAQ_SAMPLE_LEVEL_MAX (bad) for an IAQ index * 10.
+ */
+static inline uint8_t iaq_sample_level(uint16_t iaq_x10)
+{
+    if (iaq_x10 < 20) return 1;
+    if (iaq_x10 < 30) return 2;
+    if (iaq_x10 < 40) return 3;
+    if (iaq_x10 < 50) return 4;
+    return 5;
+}
+
+#endif /* IAQ_SAMPLE_H__ */
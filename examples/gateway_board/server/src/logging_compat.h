@@ -82,23 +82,7 @@ const char* nrf_strerror_get(uint32_t err_code)
     return "err";
 }
 
-/* app_scheduler compatibility: map app_sched_event_put and app_sched_init to mesh app_scheduler
- * if present. The mesh project already compiles app_scheduler.c; just declare the functions
- * here so that app_sensor_iaq.c can call them without including the other nrf header.
- *
- * If your project already has proper prototypes in app_scheduler.h, you can omit these.
- */
-int app_sched_event_put(void * p_event_data, uint16_t event_size, void (*p_event_handler)(void * p_event_data, uint16_t event_size)) WEAK_ATTR;
-int app_sched_event_put(void * p_event_data, uint16_t event_size, void (*p_event_handler)(void * p_event_data, uint16_t event_size))
-{
-    /* If real app_sched is linked, this weak stub will be overridden. */
-    (void)p_event_data;
-    (void)event_size;
-    (void)p_event_handler;
-    return 0;
-}
-
-void app_sched_init(void) WEAK_ATTR;
-void app_sched_init(void) { /* no-op stub; real implementation will override if present */ }
+/* Events go through app_sched_prio. Never stub scheduler calls here: a weak
+ * stub that reports success silently drops every event. */
 
 #endif /* LOGGING_COMPAT_H__ */
@@ -4,7 +4,7 @@
 #include "boards.h"
 #include "simple_hal.h"
 #include "app_timer.h"
-#include "app_scheduler.h"
+#include "app_sched_prio.h"
 
 #include "nrf_mesh_assert.h"
 #include "nrf_mesh_config_core.h"
@@ -16,6 +16,7 @@
 #include "access_config.h"
 #include "proxy.h"
 #include "nrf_power.h"
+#include "nrf.h"
 #include "mesh_config_entry.h"
 #include "mesh_config.h"
 
@@ -33,12 +34,16 @@
 /* IAQ + vendor model */
 #include "mesh_vendor_model.h"
 #include "app_sensor_iaq.h"
+#include "app_twi_bus.h"
+#include "app_sensor_sig.h"
 #include "mesh_vendor_client.h"
 
 #include "app_uart_gateway.h"
-
-#define SCHED_QUEUE_SIZE       32
-#define SCHED_EVENT_DATA_SIZE  16
+#include "app_iaq_store.h"
+#include "app_power.h"
+#include "app_friendship.h"
+#include "app_buffer_stats.h"
+#include "app_sched_stats.h"
 
 
 static bool m_device_provisioned;
@@ -76,29 +81,39 @@ static void node_reset(void)
 
 static void config_server_evt_cb(const config_server_evt_t * p_evt)
 {
-    if (p_evt->type == CONFIG_SERVER_EVT_NODE_RESET)
-    {
-        node_reset();
-    }
-    else if (p_evt->type == CONFIG_SERVER_EVT_MODEL_PUBLICATION_SET)
+    switch (p_evt->type)
     {
-        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Publication set event received\n");
-        
-        // Check if it's for our vendor model (element 0, vendor model)
-        access_model_handle_t handle = mesh_vendor_model_handle_get();
-        if (handle != ACCESS_HANDLE_INVALID)
-        {
-            // Mark publication as configured
-            mesh_vendor_model_publication_set();
-        }
-    }
-    else if (p_evt->type == CONFIG_SERVER_EVT_APPKEY_ADD)
-    {
-        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "AppKey added\n");
-    }
-    else if (p_evt->type == CONFIG_SERVER_EVT_MODEL_APP_BIND)
-    {
-        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Model AppKey bound\n");
+        case CONFIG_SERVER_EVT_NODE_RESET:
+            mesh_vendor_model_publication_invalidate();
+            app_sensor_sig_publication_invalidate();
+            node_reset();
+            break;
+
+        case CONFIG_SERVER_EVT_MODEL_PUBLICATION_SET:
+            __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Publication set event received\n");
+            mesh_vendor_model_publication_invalidate();
+            app_sensor_sig_publication_invalidate();
+            break;
+
+        case CONFIG_SERVER_EVT_APPKEY_ADD:
+            __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "AppKey added\n");
+            break;
+
+        case CONFIG_SERVER_EVT_MODEL_APP_BIND:
+            __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Model AppKey bound\n");
+            mesh_vendor_model_publication_invalidate();
+            break;
+
+        /* Any of these can change which AppKey or address publishing uses */
+        case CONFIG_SERVER_EVT_MODEL_APP_UNBIND:
+        case CONFIG_SERVER_EVT_APPKEY_UPDATE:
+        case CONFIG_SERVER_EVT_APPKEY_DELETE:
+        case CONFIG_SERVER_EVT_KEY_REFRESH_PHASE_SET:
+            mesh_vendor_model_publication_invalidate();
+            break;
+
+        default:
+            break;
     }
 }
 
@@ -129,6 +144,8 @@ static void provisioning_complete_cb(void)
 #endif
 
     unicast_address_print();
+    mesh_vendor_model_alarm_ttl_apply();
+    app_friendship_start();
     hal_led_blink_stop();
     hal_led_mask_set(HAL_LED_MASK, LED_MASK_STATE_OFF);
     hal_led_blink_ms(HAL_LED_MASK, LED_BLINK_INTERVAL_MS, LED_BLINK_CNT_PROV);
@@ -153,13 +170,16 @@ static void provisioning_abort_cb(void)
     hal_led_blink_stop();
 }
 
-/* Initialize models: register the vendor model only and any other app models */
+/* Initialize models: the vendor model and the SIG sensor models */
 static void models_init_cb(void)
 {
     __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Initializing models...");
 
-    /* Initialize vendor model ONLY (handles both publish and subscribe) */
+    /* Vendor model handles both publish and subscribe */
     mesh_vendor_model_init();
+
+    /* SIG Sensor Server/Setup Server for standard clients (sensor role only) */
+    app_sensor_sig_init();
     
     __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Models initialized");
 }
@@ -201,6 +221,10 @@ static void rtt_input_handler(int key)
 {
     (void)key;
     __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, m_usage_string);
+    app_buffer_stats_log();
+    app_sched_stats_log();
+    app_twi_bus_stats_log();
+    mesh_vendor_model_alert_stats_log();
 }
 
 /* initialize(): sets up logging, timers, BLE stack, mesh stack and IAQ subsystem (init only) */
@@ -210,9 +234,12 @@ static void initialize(void)
     __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "----- IAQ BLE Mesh Server (clean) -----");
 
     /* ----- IMPORTANT: initialize scheduler BEFORE creating/starting timers ----- */
-    APP_SCHED_INIT(SCHED_EVENT_DATA_SIZE, SCHED_QUEUE_SIZE);
+    app_sched_prio_init();
 
     ERROR_CHECK(app_timer_init());
+    app_sched_stats_init();
+    app_power_init();
+    app_buffer_stats_init();
     hal_leds_init();
     ble_stack_init();
 
@@ -222,12 +249,21 @@ static void initialize(void)
 #endif
 
     mesh_init();
+    app_friendship_init();
 
-    /* Initialize IAQ subsystem (TWI, ZMOD init, IAQ algorithm). Does NOT start timers. */
+    /* History flash area for store-and-forward; needs flash_manager from mesh_init(). */
+    app_iaq_store_init();
+
+    /* Shared TWI bus for the sensor's I2C devices; before they register with it. */
+    (void)app_twi_bus_init();
+
+    /* Initialize IAQ subsystem (ZMOD init, IAQ algorithm). Does NOT start timers. */
     app_sensor_iaq_init();
 
+#if APP_FEATURE_GATEWAY
     app_uart_gateway_init();
     __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "UART gateway initialized\n");
+#endif
 }
 
 /* start(): handle provisioning or start mesh if provisioned, then start IAQ sampling timer */
@@ -253,12 +289,19 @@ static void start(void)
     else
     {
         unicast_address_print();
+        /* Publication state was restored from flash by mesh_stack_init() */
+        mesh_vendor_model_publication_reload();
     }
 
     mesh_app_uuid_print(nrf_mesh_configure_device_uuid_get());
 
     ERROR_CHECK(mesh_stack_start());
 
+    if (m_device_provisioned)
+    {
+        app_friendship_start();
+    }
+
     /* --- START IAQ timer only if vendor model was added successfully --- */
     if (mesh_vendor_model_is_ready())
     {
@@ -276,18 +319,58 @@ static void start(void)
     hal_led_blink_ms(HAL_LED_MASK, LED_BLINK_INTERVAL_MS, LED_BLINK_CNT_START);
 }
 
+#if (__FPU_USED == 1)
+/* Float math also runs in interrupt context (timer, TWI and UART handlers), so
+ * the FP registers must be stacked automatically on exception entry. Lazy
+ * stacking keeps that free for handlers that never touch the FPU. Both bits
+ * are set by reset, but make sure nothing in startup cleared them. */
+static void fpu_context_init(void)
+{
+    const uint32_t mask = FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+
+    if ((FPU->FPCCR & mask) != mask)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "FPU lazy stacking was disabled, enabling\n");
+        FPU->FPCCR |= mask;
+        __DSB();
+        __ISB();
+    }
+}
+
+/* Pending FPU exception flags (e.g. inexact from the IAQ algorithm) keep the
+ * FPU IRQ pending and prevent the CPU from sleeping. Clear them before WFE. */
+static void fpu_sleep_prepare(void)
+{
+    __set_FPSCR(__get_FPSCR() & ~0x0000009FUL);
+    (void)__get_FPSCR();
+    NVIC_ClearPendingIRQ(FPU_IRQn);
+}
+#endif
+
 /* main */
 int main(void)
 {
 
     nrf_power_dcdcen_set(1);
 
+#if (__FPU_USED == 1)
+    fpu_context_init();
+#endif
+
     initialize(); 
     start();
 
     for (;;)
     {
-        app_sched_execute();
-        (void)sd_app_evt_wait();
+        app_sched_prio_execute();
+        if (app_sched_prio_is_pending())
+        {
+            /* Budgets used up; run the next round before sleeping */
+            continue;
+        }
+#if (__FPU_USED == 1)
+        fpu_sleep_prepare();
+#endif
+        app_power_idle();
     }
 }
\ No newline at end of file
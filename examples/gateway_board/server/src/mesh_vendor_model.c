@@ -7,8 +7,23 @@
 #include "access_reliable.h"
 #include "nrf_mesh_defines.h"
 #include "nrf_mesh.h"
+#include "nrf_mesh_config_core.h"
 #include "log.h"
+#include "rand.h"
+#include "app_timer.h"
+#include "app_sched_prio.h"
 #include "app_uart_gateway.h"
+#include "app_iaq_store.h"
+#include "publish_retry.h"
+#include "iaq_sample.h"
+#include "iaq_codec.h"
+#include "node_table.h"
+#include "sensor_cadence.h"
+#include "app_sensor_iaq.h"
+#include "iaq_history.h"
+#include "iaq_bulk.h"
+#include "iaq_ext.h"
+#include "env_input.h"
 
 #include "mesh_vendor_model.h"
 #include "device_state_manager.h"
@@ -17,48 +32,170 @@
 #define VENDOR_COMPANY_ID   0x0059
 #define VENDOR_MODEL_ID     0x1234
 #define VENDOR_OPCODE_SENSOR_VALUES  0xC1
+#define VENDOR_OPCODE_POWER_STATUS   0xC3
+#define VENDOR_OPCODE_SCHED_DIAG     0xC4
+#define VENDOR_OPCODE_CADENCE_GET    0xC5
+#define VENDOR_OPCODE_CADENCE_SET    0xC6
+#define VENDOR_OPCODE_CADENCE_STATUS 0xC7
+#define VENDOR_OPCODE_SERIES_GET     0xC8
+#define VENDOR_OPCODE_SERIES_STATUS  0xC9
+#define VENDOR_OPCODE_BULK_DATA      0xCA
+#define VENDOR_OPCODE_BULK_ACK       0xCB
+#define VENDOR_OPCODE_ALERT_SET      0xCC
+#define VENDOR_OPCODE_ALERT_STATUS   0xCD
+#define VENDOR_OPCODE_EXT_VALUES     0xCE
+#define VENDOR_OPCODE_ENV_VALUES     0xCF
 #define VENDOR_PAYLOAD_MAX  8
 
+/* Sensor Values and Alert Set carry an iaq_codec payload and must stay
+ * unsegmented: 11 bytes of access payload less the 3 byte vendor opcode */
+#if IAQ_CODEC_VALUES_LEN > VENDOR_PAYLOAD_MAX
+#error "Sensor Values payload does not fit one unsegmented PDU"
+#endif
+
+/* Bulk Data: see iaq_bulk.h. Bulk Ack: [transfer u8][first_seq u32], sent by
+ * the gateway as a reply once the whole transfer is forwarded. */
+#define BULK_ACK_LEN         5
+
+#if MESH_VENDOR_BULK_PAYLOAD_MAX + 3 > APP_CONFIG_MAX_MESSAGE_BYTES
+#error "Bulk Data payload does not fit APP_CONFIG_MAX_MESSAGE_BYTES"
+#endif
+
+/* Alert Set, acknowledged: a Sensor Values payload with IAQ_CODEC_FLAG_ALARM
+ * set, its seq the alert's tid and prev_level the level before the rise.
+ * Alert Status: [tid u8][level u8]. The node keeps the tid across attempts so
+ * the gateway forwards each alert once. */
+#define ALERT_SET_MAX        IAQ_CODEC_VALUES_LEN
+#define ALERT_STATUS_LEN     2
+/* Recent (node, tid) pairs the gateway has forwarded */
+#define ALERT_DEDUP_LEN      8
+
+#if MESH_VENDOR_ALERT_TIMEOUT_MS < 2000 || MESH_VENDOR_ALERT_TIMEOUT_MS > 60000
+#error "MESH_VENDOR_ALERT_TIMEOUT_MS outside the access_reliable range"
+#endif
+
+/* Ext Values: see iaq_ext.h. Segmented, published on its own slow cadence. */
+#if IAQ_EXT_PAYLOAD_MAX + 3 > APP_CONFIG_MAX_MESSAGE_BYTES
+#error "Ext Values payload does not fit APP_CONFIG_MAX_MESSAGE_BYTES"
+#endif
+
+/* Env Values: [temp_x100 s16][rh_x100 u16], from a node with a local T/RH
+ * sensor to neighbours that use it as their compensation input (env_input.h) */
+#define ENV_VALUES_LEN       4
+
+/* Power status: [uptime_s u32][duty_permille u16][avg_current_ua u16] followed by
+ * [wakeups u16][active_ms u16] per source in app_power_src_t order */
+#define POWER_STATUS_LEN     (8 + APP_POWER_SRC_COUNT * 4)
+
+/* Scheduler diagnostics: per class in app_sched_class_t order
+ * [depth_max u8][queue_size u8][put_failures u16][latency_max_us u32], then
+ * [row_count u8] and row_count rows of [name][put_failures u16][exec_max_us u32] */
+#define SCHED_DIAG_CLASS_LEN  8
+#define SCHED_DIAG_HEADER_LEN (APP_SCHED_CLASS_COUNT * SCHED_DIAG_CLASS_LEN + 1)
+#define SCHED_DIAG_ROW_LEN    (APP_SCHED_STATS_NAME_LEN + 6)
+#define SCHED_DIAG_LEN_MAX    (SCHED_DIAG_HEADER_LEN + APP_SCHED_STATS_ROWS * SCHED_DIAG_ROW_LEN)
+
+/* Cadence Get: [property u8]. Set and Status: [property u8] followed by the
+ * encoded cadence (sensor_cadence.h). Status for an unknown property, or from a
+ * node without a sensor, carries the property only. Properties are
+ * iaq_sample_property_t. */
+#define CADENCE_MSG_LEN      (1 + SENSOR_CADENCE_ENCODED_LEN)
+
+/* Series Get: empty for the whole RAM history, or [from u32][to u32], inclusive
+ * bucket numbers (iaq_history.h). Series Status:
+ * [now u32][first u32][last u32][count u8] followed by count buckets of
+ * [iaq_x10 u16][tvoc_x100 u16][eco2 u16], iaq_x10 IAQ_HISTORY_NO_DATA for a
+ * bucket without samples. The range is clipped to [first, last]; if count does
+ * not reach last, the client asks again from first + count. */
+#define SERIES_GET_LEN       8
+#define SERIES_HEADER_LEN    13
+#define SERIES_RECORD_LEN    6
+#define SERIES_PAYLOAD_MAX   (SERIES_HEADER_LEN + MESH_VENDOR_SERIES_BATCH_MAX * SERIES_RECORD_LEN)
+
 /* Default group address for publishing - configure this or use the one set via app */
 #define DEFAULT_PUBLISH_ADDRESS  0xC000
 
+#if IAQ_CODEC_VALUES_LEN > PUBLISH_RETRY_PAYLOAD_MAX
+#error "Sensor Values payload does not fit the retry queue"
+#endif
+
 static bool s_vendor_model_ready = false;
-static bool s_publish_configured = false;
-static uint16_t s_publish_address = DEFAULT_PUBLISH_ADDRESS;
-static dsm_handle_t s_appkey_handle = DSM_HANDLE_INVALID;
-static dsm_handle_t s_publish_addr_handle = DSM_HANDLE_INVALID;
 
+/* Header fields of the next Sensor Values payload (iaq_codec.h) */
+static uint8_t s_values_seq = 0;
+static uint8_t s_values_level = 0;     // Level of the last published reading, 0 before the first
 
+/* Publication state as last read from access/DSM. Rebuilt only after a config
+ * server event invalidates it (or at first use after boot), so publishing never
+ * queries the stack in steady state. */
+typedef struct
+{
+    bool valid;                 // Cache reflects the current access/DSM state
+    bool configured;            // Publish address and publish AppKey are both set
+    uint16_t address;
+    dsm_handle_t addr_handle;
+    dsm_handle_t appkey_handle;
+    uint32_t period_ms;         // Publish period, 0 if none
+} publication_cache_t;
 
+static publication_cache_t s_pub_cache =
+{
+    .valid = false,
+    .configured = false,
+    .address = DEFAULT_PUBLISH_ADDRESS,
+    .addr_handle = DSM_HANDLE_INVALID,
+    .appkey_handle = DSM_HANDLE_INVALID,
+    .period_ms = 0
+};
 
-// Track first reception from each node for UART forwarding
-#define MAX_TRACKED_NODES 10
-static uint16_t s_received_nodes[MAX_TRACKED_NODES];
-static uint8_t s_received_node_count = 0;
+/* Live readings waiting for a retry (publish_retry.h) */
+static publish_retry_t s_retry;
+static bool s_retry_timer_running = false;
+static uint32_t s_retry_spilled = 0;   // Given up or displaced, and stored for backfill
+APP_TIMER_DEF(m_retry_timer_id);
 
-static bool is_first_reception_from_node(uint16_t src_addr)
+/* Alert in flight. The access layer holds on to payload until the transfer
+ * ends, and retransmits it within each attempt's timeout. */
+typedef struct
 {
-    // Check if we've seen this node before
-    for (uint8_t i = 0; i < s_received_node_count; i++)
-    {
-        if (s_received_nodes[i] == src_addr)
-        {
-            return false;  // Already received from this node
-        }
-    }
-    
-    // First time seeing this node - add to list
-    if (s_received_node_count < MAX_TRACKED_NODES)
-    {
-        s_received_nodes[s_received_node_count] = src_addr;
-        s_received_node_count++;
-    }
-    
-    return true;  // First reception from this node
-}
+    bool active;
+    uint8_t tid;
+    uint8_t attempts;
+    uint8_t length;
+    uint8_t payload[ALERT_SET_MAX];
+    uint32_t start_ticks;       // Start of the current attempt
+    access_reliable_t reliable;
+} alert_state_t;
+
+static alert_state_t s_alert;
+static mesh_vendor_alert_stats_t s_alert_stats;
+static uint64_t s_alert_rtt_total_ms;
+
+
+
+
+// Track first reception from each node for UART forwarding
+#if APP_PROFILE_GATEWAY_HT
+#define MAX_TRACKED_NODES APP_GATEWAY_NODE_COUNT
+#else
+#define MAX_TRACKED_NODES 10
+#endif
+NODE_TABLE_DEF(s_received_nodes, MAX_TRACKED_NODES);
 
+#if APP_FEATURE_GATEWAY
+/* Nodes whose RAM history has been asked for, and the pull being paged
+ * through. ticks is the last Series Get sent, or the end of the last pull. */
+NODE_TABLE_DEF(s_series_requested, MAX_TRACKED_NODES);
 
+typedef struct
+{
+    bool active;
+    uint16_t addr;
+    uint32_t ticks;
+} series_pull_t;
 
+static series_pull_t s_series_pull;
+#endif
 
 static access_model_handle_t m_vendor_model_handle = ACCESS_HANDLE_INVALID;
 
@@ -66,14 +203,130 @@ static void vendor_model_rx_cb(access_model_handle_t handle,
                                const access_message_rx_t * p_message,
                                void * p_args);
 
+static void vendor_model_power_rx_cb(access_model_handle_t handle,
+                                     const access_message_rx_t * p_message,
+                                     void * p_args);
+static void vendor_model_sched_diag_rx_cb(access_model_handle_t handle,
+                                          const access_message_rx_t * p_message,
+                                          void * p_args);
+static void vendor_model_cadence_get_cb(access_model_handle_t handle,
+                                        const access_message_rx_t * p_message,
+                                        void * p_args);
+static void vendor_model_cadence_set_cb(access_model_handle_t handle,
+                                        const access_message_rx_t * p_message,
+                                        void * p_args);
+static void vendor_model_series_get_cb(access_model_handle_t handle,
+                                       const access_message_rx_t * p_message,
+                                       void * p_args);
+static void vendor_model_series_status_cb(access_model_handle_t handle,
+                                          const access_message_rx_t * p_message,
+                                          void * p_args);
+#if APP_FEATURE_GATEWAY
+static bool series_request(access_model_handle_t handle, const access_message_rx_t * p_message,
+                           uint32_t from, uint32_t to);
+#endif
+static void vendor_model_bulk_data_cb(access_model_handle_t handle,
+                                      const access_message_rx_t * p_message,
+                                      void * p_args);
+static void vendor_model_bulk_ack_cb(access_model_handle_t handle,
+                                     const access_message_rx_t * p_message,
+                                     void * p_args);
+static void vendor_model_alert_set_cb(access_model_handle_t handle,
+                                      const access_message_rx_t * p_message,
+                                      void * p_args);
+static void vendor_model_alert_status_cb(access_model_handle_t handle,
+                                         const access_message_rx_t * p_message,
+                                         void * p_args);
+static void vendor_model_ext_values_cb(access_model_handle_t handle,
+                                       const access_message_rx_t * p_message,
+                                       void * p_args);
+static void vendor_model_env_values_cb(access_model_handle_t handle,
+                                       const access_message_rx_t * p_message,
+                                       void * p_args);
+static void alert_reliable_cb(access_model_handle_t model_handle, void * p_args,
+                              access_reliable_status_t status);
+static void retry_timer_handler(void * p_context);
+static void retry_timer_start(void);
+
 static const access_opcode_handler_t m_vendor_opcode_handlers[] =
 {
     {
         .opcode = { VENDOR_OPCODE_SENSOR_VALUES, VENDOR_COMPANY_ID },
         .handler = vendor_model_rx_cb
+    },
+    {
+        .opcode = { VENDOR_OPCODE_POWER_STATUS, VENDOR_COMPANY_ID },
+        .handler = vendor_model_power_rx_cb
+    },
+    {
+        .opcode = { VENDOR_OPCODE_SCHED_DIAG, VENDOR_COMPANY_ID },
+        .handler = vendor_model_sched_diag_rx_cb
+    },
+    {
+        .opcode = { VENDOR_OPCODE_CADENCE_GET, VENDOR_COMPANY_ID },
+        .handler = vendor_model_cadence_get_cb
+    },
+    {
+        .opcode = { VENDOR_OPCODE_CADENCE_SET, VENDOR_COMPANY_ID },
+        .handler = vendor_model_cadence_set_cb
+    },
+    {
+        .opcode = { VENDOR_OPCODE_SERIES_GET, VENDOR_COMPANY_ID },
+        .handler = vendor_model_series_get_cb
+    },
+    {
+        .opcode = { VENDOR_OPCODE_SERIES_STATUS, VENDOR_COMPANY_ID },
+        .handler = vendor_model_series_status_cb
+    },
+    {
+        .opcode = { VENDOR_OPCODE_BULK_DATA, VENDOR_COMPANY_ID },
+        .handler = vendor_model_bulk_data_cb
+    },
+    {
+        .opcode = { VENDOR_OPCODE_BULK_ACK, VENDOR_COMPANY_ID },
+        .handler = vendor_model_bulk_ack_cb
+    },
+    {
+        .opcode = { VENDOR_OPCODE_ALERT_SET, VENDOR_COMPANY_ID },
+        .handler = vendor_model_alert_set_cb
+    },
+    {
+        .opcode = { VENDOR_OPCODE_ALERT_STATUS, VENDOR_COMPANY_ID },
+        .handler = vendor_model_alert_status_cb
+    },
+    {
+        .opcode = { VENDOR_OPCODE_EXT_VALUES, VENDOR_COMPANY_ID },
+        .handler = vendor_model_ext_values_cb
+    },
+    {
+        .opcode = { VENDOR_OPCODE_ENV_VALUES, VENDOR_COMPANY_ID },
+        .handler = vendor_model_env_values_cb
     }
 };
 
+static uint16_t get_u16(const uint8_t * p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t * p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint8_t * put_u16(uint8_t * p, uint16_t v)
+{
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+    return p + 2;
+}
+
+static uint8_t * put_u32(uint8_t * p, uint32_t v)
+{
+    p = put_u16(p, (uint16_t)(v & 0xFFFF));
+    return put_u16(p, (uint16_t)(v >> 16));
+}
+
 uint32_t mesh_vendor_model_init(void)
 {
     access_model_add_params_t add_params;
@@ -95,7 +348,14 @@ uint32_t mesh_vendor_model_init(void)
     }
 
     s_vendor_model_ready = true;
-    s_publish_configured = false;
+    s_pub_cache.valid = false;
+
+    publish_retry_init(&s_retry);
+    status = app_timer_create(&m_retry_timer_id, APP_TIMER_MODE_SINGLE_SHOT, retry_timer_handler);
+    if (status != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Retry timer create failed: 0x%x\n", status);
+    }
     
     __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Vendor model added (company=0x%04X, model=0x%04X), handle=%u\n",
           VENDOR_COMPANY_ID, VENDOR_MODEL_ID, (unsigned)m_vendor_model_handle);
@@ -124,42 +384,120 @@ bool mesh_vendor_model_is_ready(void)
     return s_vendor_model_ready;
 }
 
-void mesh_vendor_model_publication_set(void)
+void mesh_vendor_model_publication_reload(void)
 {
-    s_publish_configured = true;
-    
+    static const uint32_t s_resolution_ms[] = { 100, 1000, 10000, 600000 };
+    access_publish_resolution_t resolution;
+    uint8_t steps;
+    uint8_t ttl;
     uint32_t status;
+
+    s_pub_cache.valid = true;
+    s_pub_cache.configured = false;
+    s_pub_cache.addr_handle = DSM_HANDLE_INVALID;
+    s_pub_cache.appkey_handle = DSM_HANDLE_INVALID;
+    s_pub_cache.period_ms = 0;
+
+    if (m_vendor_model_handle == ACCESS_HANDLE_INVALID)
+    {
+        return;
+    }
     
     // Get the configured publish address handle
-    status = access_model_publish_address_get(m_vendor_model_handle, &s_publish_addr_handle);
-    if (status == NRF_SUCCESS && s_publish_addr_handle != DSM_HANDLE_INVALID)
+    status = access_model_publish_address_get(m_vendor_model_handle, &s_pub_cache.addr_handle);
+    if (status == NRF_SUCCESS && s_pub_cache.addr_handle != DSM_HANDLE_INVALID)
     {
         nrf_mesh_address_t addr;
-        status = dsm_address_get(s_publish_addr_handle, &addr);
+        status = dsm_address_get(s_pub_cache.addr_handle, &addr);
         if (status == NRF_SUCCESS)
         {
-            s_publish_address = addr.value;
-            __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Publish address: 0x%04X\n", s_publish_address);
+            s_pub_cache.address = addr.value;
+            __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Publish address: 0x%04X\n", s_pub_cache.address);
+        }
+        else
+        {
+            s_pub_cache.addr_handle = DSM_HANDLE_INVALID;
         }
     }
+    else
+    {
+        s_pub_cache.addr_handle = DSM_HANDLE_INVALID;
+    }
     
-    // Get the first bound AppKey
-    dsm_handle_t appkey_handles[DSM_APP_MAX];
-    uint16_t appkey_count = DSM_APP_MAX;
-    
-    status = access_model_applications_get(m_vendor_model_handle, appkey_handles, &appkey_count);
-    if (status == NRF_SUCCESS && appkey_count > 0)
+    // The AppKey used by access_model_publish() is the publish AppKey, not
+    // the first bound one, so read it directly instead of listing bindings.
+    status = access_model_publish_application_get(m_vendor_model_handle, &s_pub_cache.appkey_handle);
+    if (status == NRF_SUCCESS && s_pub_cache.appkey_handle != DSM_HANDLE_INVALID)
     {
-        s_appkey_handle = appkey_handles[0];
-        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Using bound AppKey handle: %u\n", s_appkey_handle);
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Using publish AppKey handle: %u\n", s_pub_cache.appkey_handle);
     }
     else
     {
-        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "No AppKey bound to model\n");
-        s_appkey_handle = DSM_HANDLE_INVALID;
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "No publish AppKey set for model\n");
+        s_pub_cache.appkey_handle = DSM_HANDLE_INVALID;
     }
     
-    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Publication configured for vendor model\n");
+    s_pub_cache.configured = (s_pub_cache.addr_handle != DSM_HANDLE_INVALID &&
+                              s_pub_cache.appkey_handle != DSM_HANDLE_INVALID);
+
+    // Base period of the reading cadence
+    if (access_model_publish_period_get(m_vendor_model_handle, &resolution, &steps) == NRF_SUCCESS &&
+        (uint32_t)resolution < ARRAY_SIZE(s_resolution_ms))
+    {
+        s_pub_cache.period_ms = steps * s_resolution_ms[resolution];
+    }
+
+    // Alerts use the publish TTL; mesh_vendor_model_alarm_ttl_apply() only
+    // covers a publication that uses the default TTL
+    if (access_model_publish_ttl_get(m_vendor_model_handle, &ttl) == NRF_SUCCESS &&
+        ttl != ACCESS_TTL_USE_DEFAULT && ttl < MESH_VENDOR_ALARM_TTL)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Publish TTL %u is below the alarm TTL %u\n",
+              ttl, MESH_VENDOR_ALARM_TTL);
+    }
+
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Publication %s for vendor model\n",
+          s_pub_cache.configured ? "configured" : "not configured");
+
+    // New configuration may be what the queued readings were waiting for
+    if (s_pub_cache.configured && publish_retry_pending(&s_retry))
+    {
+        retry_timer_start();
+    }
+}
+
+void mesh_vendor_model_publication_invalidate(void)
+{
+    s_pub_cache.valid = false;
+}
+
+void mesh_vendor_model_alarm_ttl_apply(void)
+{
+    uint8_t ttl = access_default_ttl_get();
+    if (ttl >= MESH_VENDOR_ALARM_TTL)
+    {
+        return;
+    }
+
+    uint32_t status = access_default_ttl_set(MESH_VENDOR_ALARM_TTL);
+    if (status == NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Default TTL raised from %u to %u for alerts\n",
+              ttl, MESH_VENDOR_ALARM_TTL);
+    }
+    else
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Default TTL set failed: 0x%08X\n", status);
+    }
+}
+
+static bool publication_ready(void)
+{
+    if (!s_pub_cache.valid)
+    {
+        mesh_vendor_model_publication_reload();
+    }
+    return s_pub_cache.configured;
 }
 
 // Add this helper function at the top
@@ -176,34 +514,23 @@ static const char* get_iaq_description(uint8_t level)
     }
 }
 
-// MODIFY your existing vendor_model_rx_cb to actually process messages:
-static void vendor_model_rx_cb(access_model_handle_t handle,
-                               const access_message_rx_t * p_message,
-                               void * p_args)
+/* Received sensor values, handed from the mesh context to the scheduler */
+typedef struct
 {
-    (void)handle;
-    (void)p_args;
-
-    if (p_message->opcode.opcode != VENDOR_OPCODE_SENSOR_VALUES ||
-        p_message->opcode.company_id != VENDOR_COMPANY_ID)
-    {
-        return;
-    }
-
-    // Extract source address
-    uint16_t src_addr = p_message->meta_data.src.value;
-    
-    // Get own address to filter out own messages
-    dsm_local_unicast_address_t local_addr;
-    dsm_local_unicast_addresses_get(&local_addr);
-    
-    if (src_addr == local_addr.address_start)
-    {
-        return;  // Don't display own published data
-    }
+    uint16_t src_addr;
+    bool is_first;
+    uint8_t length;
+    uint8_t data[VENDOR_PAYLOAD_MAX];
+} sensor_rx_event_t;
 
-    // Check if this is first reception from this node
-    bool is_first = is_first_reception_from_node(src_addr);
+/* Logging and UART formatting take far longer than the mesh stack should be
+ * held up; this runs from the MESH_RX scheduler class instead. */
+static void scheduled_sensor_rx_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)event_size;
+    const sensor_rx_event_t * p_rx = p_event_data;
+    uint16_t src_addr = p_rx->src_addr;
+    bool is_first = p_rx->is_first;
     
     if (is_first)
     {
@@ -216,25 +543,21 @@ static void vendor_model_rx_cb(access_model_handle_t handle,
               "*** SENSOR DATA FROM NODE 0x%04X ***\n", src_addr);
     }
 
-    if (p_message->length >= 6)
+    iaq_sample_t sample;
+    iaq_codec_meta_t meta;
+    if (iaq_codec_values_unpack(p_rx->data, p_rx->length, &sample, &meta))
     {
-        const uint8_t *data = p_message->p_data;
-
-        uint8_t iaq_level = data[0];
-        uint16_t tvoc_x100 = (uint16_t)(data[1] | (data[2] << 8));
-        uint16_t eco2 = (uint16_t)(data[3] | (data[4] << 8));
-        uint8_t iaq_x10 = data[5];
-
         __LOG(LOG_SRC_APP, LOG_LEVEL_INFO,
-              "Node 0x%04X: IAQ=%u.%u (%s) | TVOC=%u.%02u mg/m3 | eCO2=%u ppm\n",
-              src_addr,
-              iaq_x10 / 10, iaq_x10 % 10,
-              get_iaq_description(iaq_level), 
-              tvoc_x100 / 100, tvoc_x100 % 100,
-              eco2);
+              "Node 0x%04X: v%u #%u%s IAQ=%u.%u (%s) | TVOC=%u.%02u mg/m3 | eCO2=%u ppm\n",
+              src_addr, meta.version, meta.seq,
+              (meta.flags & IAQ_CODEC_FLAG_RETRIED) ? " (late)" : "",
+              sample.iaq_x10 / 10, sample.iaq_x10 % 10,
+              get_iaq_description(meta.level), 
+              sample.tvoc_x100 / 100, sample.tvoc_x100 % 100,
+              sample.eco2);
        
         // Send ALL received data to UART (first and subsequent)
-        app_uart_send_iaq_data(src_addr, (float)iaq_x10 / 10.0f, (float)tvoc_x100 / 100.0f, (float)eco2);
+        app_uart_send_iaq_data(src_addr, sample.iaq_x10, sample.tvoc_x100, sample.eco2);
         
         if (is_first)
         {
@@ -244,121 +567,1359 @@ static void vendor_model_rx_cb(access_model_handle_t handle,
     else
     {
         __LOG(LOG_SRC_APP, LOG_LEVEL_WARN,
-              "Node 0x%04X: Invalid message length: %u\n", 
-              src_addr, p_message->length);
+              "Node 0x%04X: Invalid message length: %u\n",
+              src_addr, p_rx->length);
     }
 }
 
+#if APP_FEATURE_GATEWAY
+static uint32_t series_pull_elapsed_ms(void)
+{
+    uint32_t ticks = app_timer_cnt_diff_compute(app_timer_cnt_get(), s_series_pull.ticks);
+    return (uint32_t)(((uint64_t)ticks * 1000) / APP_TIMER_CLOCK_FREQ);
+}
 
-static void pack_payload(uint8_t iaq_level, float iaq_float, uint16_t tvoc_x100, uint16_t eco2,
-                         uint8_t * buf, uint8_t * out_len)
+/* A node may hold readings the gateway missed while it was down: ask for its
+ * RAM history while a message from it is at hand to reply to. Pulls are
+ * serialized so a gateway restart does not have every node send its pages at
+ * once; a node not pulled now is pulled with a later reading. Nodes past the
+ * node table are not tracked and never pulled. The RTC wraps after 512 s, so
+ * after a long quiet spell a pull may start one reading later than due. */
+static void series_pull_start(access_model_handle_t handle, const access_message_rx_t * p_message,
+                              uint16_t src_addr)
 {
-    buf[0] = iaq_level;                           // IAQ Level: 1-5
-    buf[1] = (uint8_t)(tvoc_x100 & 0xFF);         // TVOC low byte
-    buf[2] = (uint8_t)((tvoc_x100 >> 8) & 0xFF);  // TVOC high byte
-    buf[3] = (uint8_t)(eco2 & 0xFF);              // eCO2 low byte
-    buf[4] = (uint8_t)((eco2 >> 8) & 0xFF);       // eCO2 high byte
-    
-    // Store IAQ float × 10 (e.g., 1.2 → 12, 4.5 → 45)
-    uint8_t iaq_x10 = (uint8_t)(iaq_float * 10.0f + 0.5f);
-    buf[5] = iaq_x10;
+    uint32_t elapsed_ms = series_pull_elapsed_ms();
+    if (s_series_pull.active)
+    {
+        if (elapsed_ms < MESH_VENDOR_SERIES_PULL_TIMEOUT_MS)
+        {
+            return;
+        }
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Node 0x%04X: Series pull timed out\n", s_series_pull.addr);
+        s_series_pull.active = false;
+    }
+    else if (elapsed_ms < MESH_VENDOR_SERIES_PULL_GAP_MS)
+    {
+        return;
+    }
 
-    *out_len = 6;
-}
+    if (!node_table_contains(&s_received_nodes, src_addr) ||
+        node_table_contains(&s_series_requested, src_addr))
+    {
+        return;
+    }
 
+    /* A failed request is tried again with a later reading, after the gap */
+    s_series_pull.addr = src_addr;
+    s_series_pull.ticks = app_timer_cnt_get();
+    s_series_pull.active = series_request(handle, p_message, 0, UINT32_MAX);
+    if (s_series_pull.active)
+    {
+        (void)node_table_add(&s_series_requested, src_addr);
+    }
+}
+#endif
 
-void mesh_publish_sensor_values(float iaq, float tvoc, float eco2)
+static void vendor_model_rx_cb(access_model_handle_t handle,
+                               const access_message_rx_t * p_message,
+                               void * p_args)
 {
-    static uint32_t s_warn_count = 0;
-    
-    if (m_vendor_model_handle == ACCESS_HANDLE_INVALID)
+    (void)handle;
+    (void)p_args;
+
+    if (p_message->opcode.opcode != VENDOR_OPCODE_SENSOR_VALUES ||
+        p_message->opcode.company_id != VENDOR_COMPANY_ID)
     {
-        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Vendor model not initialized\n");
         return;
     }
 
-    // NaN check
-    if (iaq != iaq || tvoc != tvoc || eco2 != eco2)
+    // Extract source address
+    uint16_t src_addr = p_message->meta_data.src.value;
+    
+    // Get own address to filter out own messages
+    dsm_local_unicast_address_t local_addr;
+    dsm_local_unicast_addresses_get(&local_addr);
+    
+    if (src_addr == local_addr.address_start)
+    {
+        return;  // Don't display own published data
+    }
+
+    /* Drop payloads of a version this firmware cannot decode before they
+     * take a scheduler slot; a newer node is heard from again once the
+     * gateway is updated */
+    if (iaq_codec_values_version(p_message->p_data, (uint8_t)p_message->length) == 0)
     {
-        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "NaN values detected\n");
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Node 0x%04X: Unknown values version 0x%02X, %u bytes\n",
+              src_addr, (p_message->length > 0) ? p_message->p_data[0] : 0, p_message->length);
         return;
     }
 
-    if (!s_publish_configured)
+    sensor_rx_event_t rx;
+    rx.src_addr = src_addr;
+    rx.is_first = node_table_add(&s_received_nodes, src_addr);
+
+#if APP_FEATURE_GATEWAY
+    series_pull_start(handle, p_message, src_addr);
+#endif
+
+    rx.length = (p_message->length < VENDOR_PAYLOAD_MAX) ? (uint8_t)p_message->length : VENDOR_PAYLOAD_MAX;
+    memcpy(rx.data, p_message->p_data, rx.length);
+
+    /* A full queue drops the reading; app_sched_stats counts it */
+    (void)APP_SCHED_PUT(APP_SCHED_CLASS_MESH_RX, &rx, sizeof(rx), scheduled_sensor_rx_handler);
+}
+
+/* Copy buffers of the received messages too large for a scheduler event; the
+ * event carries the sender and the slot, which its handler frees */
+#define RX_COPY_MAX(a, b)    (((a) > (b)) ? (a) : (b))
+#define RX_COPY_LEN_MAX      RX_COPY_MAX(RX_COPY_MAX(POWER_STATUS_LEN, SCHED_DIAG_LEN_MAX), \
+                                         RX_COPY_MAX(IAQ_EXT_PAYLOAD_MAX, SERIES_PAYLOAD_MAX))
+
+typedef struct
+{
+    volatile bool busy;
+    uint16_t length;
+    uint8_t data[RX_COPY_LEN_MAX];
+} rx_copy_t;
+
+typedef struct
+{
+    uint16_t src_addr;
+    uint8_t slot;
+} rx_copy_event_t;
+
+static rx_copy_t s_rx_copy[MESH_VENDOR_RX_COPY_SLOTS];
+
+/* Like APP_SCHED_PUT() on the MESH_RX class, for a payload of any length up
+ * to RX_COPY_LEN_MAX */
+#define RX_COPY_PUT(src_addr, p_data, length, handler) \
+    rx_copy_put((src_addr), (p_data), (length), (handler), #handler)
+
+static void rx_copy_put(uint16_t src_addr, const uint8_t * p_data, uint16_t length,
+                        app_sched_prio_handler_t handler, const char * p_name)
+{
+    rx_copy_event_t rx;
+    rx.src_addr = src_addr;
+
+    for (rx.slot = 0; rx.slot < MESH_VENDOR_RX_COPY_SLOTS; rx.slot++)
     {
-        s_warn_count++;
-        if (s_warn_count % 10 == 1)
+        if (!s_rx_copy[rx.slot].busy)
         {
-            __LOG(LOG_SRC_APP, LOG_LEVEL_WARN,
-                  "Publish not configured (attempt %u)\n", s_warn_count);
+            break;
         }
-        return;
     }
-    
-    if (s_appkey_handle == DSM_HANDLE_INVALID)
+    if (rx.slot == MESH_VENDOR_RX_COPY_SLOTS)
     {
-        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "AppKey handle invalid\n");
+        app_sched_stats_put_failed(app_sched_stats_handler_id(handler, p_name), p_name, NRF_ERROR_NO_MEM);
         return;
     }
 
-    // Clamp and convert IAQ to 1-5 rating
-    uint8_t iaq_level;
-    if (iaq < 2.0f) 
-        iaq_level = 1;      // Level 1: Very Good
-    else if (iaq < 3.0f) 
-        iaq_level = 2;      // Level 2: Good
-    else if (iaq < 4.0f) 
-        iaq_level = 3;      // Level 3: Medium
-    else if (iaq < 5.0f) 
-        iaq_level = 4;      // Level 4: Poor
-    else 
-        iaq_level = 5;      // Level 5: Bad
-    
-    // Clamp TVOC
-    if (tvoc < 0.0f) tvoc = 0.0f;
-    if (tvoc > 655.35f) tvoc = 655.35f;
-    
-    // Clamp eCO2
-    if (eco2 < 0.0f) eco2 = 0.0f;
-    if (eco2 > 65535.0f) eco2 = 65535.0f;
+    rx_copy_t * p_copy = &s_rx_copy[rx.slot];
+    p_copy->length = (length < RX_COPY_LEN_MAX) ? length : RX_COPY_LEN_MAX;
+    memcpy(p_copy->data, p_data, p_copy->length);
+    p_copy->busy = true;
 
-    uint8_t payload[VENDOR_PAYLOAD_MAX];
-    uint8_t payload_len;
+    /* A full queue drops the message; app_sched_prio counts it */
+    if (app_sched_prio_put(APP_SCHED_CLASS_MESH_RX, &rx, sizeof(rx), handler, p_name) != NRF_SUCCESS)
+    {
+        p_copy->busy = false;
+    }
+}
 
-    uint16_t tvoc_x100 = (uint16_t)(tvoc * 100.0f + 0.5f);  // Round to nearest
-    uint16_t eco2_i = (uint16_t)(eco2 + 0.5f);
+static void rx_copy_free(const rx_copy_event_t * p_rx)
+{
+    s_rx_copy[p_rx->slot].busy = false;
+}
 
-    pack_payload(iaq_level, iaq, tvoc_x100, eco2_i, payload, &payload_len);
+static void scheduled_power_rx_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)event_size;
+    const rx_copy_event_t * p_rx = p_event_data;
+    const uint8_t *data = s_rx_copy[p_rx->slot].data;
+    app_power_report_t report;
 
-    access_message_tx_t tx;
-    memset(&tx, 0, sizeof(tx));
+    report.uptime_s = get_u32(&data[0]);
+    report.duty_permille = get_u16(&data[4]);
+    report.avg_current_ua = get_u16(&data[6]);
+    for (uint32_t i = 0; i < APP_POWER_SRC_COUNT; i++)
+    {
+        report.wakeups[i] = get_u16(&data[8 + i * 4]);
+        report.active_ms[i] = get_u16(&data[10 + i * 4]);
+    }
+    rx_copy_free(p_rx);
 
-    tx.opcode.opcode = VENDOR_OPCODE_SENSOR_VALUES;
-    tx.opcode.company_id = VENDOR_COMPANY_ID;
-    tx.p_buffer = payload;
-    tx.length = payload_len;
-    tx.force_segmented = false;
-    tx.transmic_size = NRF_MESH_TRANSMIC_SIZE_DEFAULT;
-    tx.access_token = nrf_mesh_unique_token_get();
+    app_uart_send_power_status(p_rx->src_addr, &report);
+}
 
-    uint32_t status = access_model_publish(m_vendor_model_handle, &tx);
+static void vendor_model_power_rx_cb(access_model_handle_t handle,
+                                     const access_message_rx_t * p_message,
+                                     void * p_args)
+{
+    (void)handle;
+    (void)p_args;
 
-    if (status == NRF_SUCCESS)
+    uint16_t src_addr = p_message->meta_data.src.value;
+
+    dsm_local_unicast_address_t local_addr;
+    dsm_local_unicast_addresses_get(&local_addr);
+    if (src_addr == local_addr.address_start)
     {
-        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO,
-              "Published: IAQ_Level=%u, TVOC_x100=%u, eCO2=%u\n",
-              iaq_level, tvoc_x100, eco2_i);
+        return;
     }
-    else
+
+    if (p_message->length < POWER_STATUS_LEN)
     {
-        s_publish_configured = false;
-        const char *err_str = nrf_strerror_get(status);
-        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR,
-              "Publish failed: 0x%08X (%s)\n", status, (err_str ? err_str : "unknown"));
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN,
+              "Node 0x%04X: Invalid power status length: %u\n", src_addr, p_message->length);
+        return;
     }
+
+    RX_COPY_PUT(src_addr, p_message->p_data, POWER_STATUS_LEN, scheduled_power_rx_handler);
 }
 
-access_model_handle_t mesh_vendor_model_handle_get(void)
+static void scheduled_ext_rx_handler(void * p_event_data, uint16_t event_size)
 {
-    return m_vendor_model_handle;
+    (void)event_size;
+    const rx_copy_event_t * p_rx = p_event_data;
+    const rx_copy_t * p_copy = &s_rx_copy[p_rx->slot];
+    iaq_ext_values_t values;
+    uint8_t seq;
+    uint32_t uptime_s;
+
+    bool valid = iaq_ext_unpack(p_copy->data, p_copy->length, &values, &seq, &uptime_s);
+    uint16_t length = p_copy->length;
+    rx_copy_free(p_rx);
+
+    if (!valid)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN,
+              "Node 0x%04X: Invalid ext values length: %u\n", p_rx->src_addr, length);
+        return;
+    }
+
+    app_uart_send_iaq_ext(p_rx->src_addr, seq, uptime_s, &values);
+}
+
+static void vendor_model_ext_values_cb(access_model_handle_t handle,
+                                       const access_message_rx_t * p_message,
+                                       void * p_args)
+{
+    (void)handle;
+    (void)p_args;
+
+    if (!APP_FEATURE_GATEWAY)
+    {
+        return;
+    }
+
+    uint16_t src_addr = p_message->meta_data.src.value;
+
+    dsm_local_unicast_address_t local_addr;
+    dsm_local_unicast_addresses_get(&local_addr);
+    if (src_addr == local_addr.address_start)
+    {
+        return;
+    }
+
+    if (p_message->length > IAQ_EXT_PAYLOAD_MAX)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN,
+              "Node 0x%04X: Invalid ext values length: %u\n", src_addr, p_message->length);
+        return;
+    }
+
+    RX_COPY_PUT(src_addr, p_message->p_data, p_message->length, scheduled_ext_rx_handler);
+}
+
+/* Env Values, handed to the sensor on the MESH_RX class like readings */
+typedef struct
+{
+    uint16_t src_addr;
+    env_input_value_t value;
+} env_rx_event_t;
+
+static void scheduled_env_rx_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)event_size;
+    const env_rx_event_t * p_rx = p_event_data;
+    app_sensor_iaq_env_received(p_rx->src_addr, &p_rx->value);
+}
+
+static void vendor_model_env_values_cb(access_model_handle_t handle,
+                                       const access_message_rx_t * p_message,
+                                       void * p_args)
+{
+    (void)handle;
+    (void)p_args;
+
+    /* Only a node with a sensor has use for them */
+    if (!APP_FEATURE_SENSOR)
+    {
+        return;
+    }
+
+    uint16_t src_addr = p_message->meta_data.src.value;
+
+    dsm_local_unicast_address_t local_addr;
+    dsm_local_unicast_addresses_get(&local_addr);
+    if (src_addr == local_addr.address_start || p_message->length < ENV_VALUES_LEN)
+    {
+        return;
+    }
+
+    env_rx_event_t rx;
+    rx.src_addr = src_addr;
+    rx.value.temp_x100 = (int16_t)get_u16(&p_message->p_data[0]);
+    rx.value.rh_x100 = get_u16(&p_message->p_data[2]);
+    (void)APP_SCHED_PUT(APP_SCHED_CLASS_MESH_RX, &rx, sizeof(rx), scheduled_env_rx_handler);
+}
+
+static void scheduled_diag_rx_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)event_size;
+    const rx_copy_event_t * p_rx = p_event_data;
+    const uint8_t *data = s_rx_copy[p_rx->slot].data;
+    app_sched_stats_report_t report;
+
+    for (uint32_t i = 0; i < APP_SCHED_CLASS_COUNT; i++)
+    {
+        const uint8_t *cls = &data[i * SCHED_DIAG_CLASS_LEN];
+        report.classes[i].depth_max = cls[0];
+        report.classes[i].queue_size = cls[1];
+        report.classes[i].put_failures = get_u16(&cls[2]);
+        report.classes[i].latency_max_us = get_u32(&cls[4]);
+    }
+    report.row_count = data[SCHED_DIAG_HEADER_LEN - 1];
+    for (uint32_t i = 0; i < report.row_count; i++)
+    {
+        const uint8_t *row = &data[SCHED_DIAG_HEADER_LEN + i * SCHED_DIAG_ROW_LEN];
+        memcpy(report.rows[i].name, row, APP_SCHED_STATS_NAME_LEN);
+        report.rows[i].put_failures = get_u16(&row[APP_SCHED_STATS_NAME_LEN]);
+        report.rows[i].exec_max_us = get_u32(&row[APP_SCHED_STATS_NAME_LEN + 2]);
+    }
+    rx_copy_free(p_rx);
+
+    app_uart_send_sched_diag(p_rx->src_addr, &report);
+}
+
+/* Checked here, so the handler only parses a complete report */
+static void vendor_model_sched_diag_rx_cb(access_model_handle_t handle,
+                                          const access_message_rx_t * p_message,
+                                          void * p_args)
+{
+    (void)handle;
+    (void)p_args;
+
+    uint16_t src_addr = p_message->meta_data.src.value;
+
+    dsm_local_unicast_address_t local_addr;
+    dsm_local_unicast_addresses_get(&local_addr);
+    if (src_addr == local_addr.address_start)
+    {
+        return;
+    }
+
+    const uint8_t *data = p_message->p_data;
+    uint8_t row_count = (p_message->length >= SCHED_DIAG_HEADER_LEN) ? data[SCHED_DIAG_HEADER_LEN - 1] : 0;
+    if (p_message->length < SCHED_DIAG_HEADER_LEN ||
+        row_count > APP_SCHED_STATS_ROWS ||
+        p_message->length < SCHED_DIAG_HEADER_LEN + row_count * SCHED_DIAG_ROW_LEN)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN,
+              "Node 0x%04X: Invalid scheduler diagnostics length: %u\n", src_addr, p_message->length);
+        return;
+    }
+
+    RX_COPY_PUT(src_addr, data, SCHED_DIAG_HEADER_LEN + row_count * SCHED_DIAG_ROW_LEN,
+                scheduled_diag_rx_handler);
+}
+
+static void cadence_status_reply(access_model_handle_t handle,
+                                 const access_message_rx_t * p_message,
+                                 uint8_t property)
+{
+    uint8_t payload[CADENCE_MSG_LEN];
+    uint8_t length = 1;
+    sensor_cadence_t cadence;
+
+    payload[0] = property;
+    if (property < IAQ_SAMPLE_PROPERTY_COUNT &&
+        app_sensor_iaq_cadence_get((iaq_sample_property_t)property, &cadence))
+    {
+        length += sensor_cadence_encode(&cadence, &payload[1]);
+    }
+
+    access_message_tx_t tx;
+    memset(&tx, 0, sizeof(tx));
+
+    tx.opcode.opcode = VENDOR_OPCODE_CADENCE_STATUS;
+    tx.opcode.company_id = VENDOR_COMPANY_ID;
+    tx.p_buffer = payload;
+    tx.length = length;
+    tx.force_segmented = false;
+    tx.transmic_size = NRF_MESH_TRANSMIC_SIZE_DEFAULT;
+    tx.access_token = nrf_mesh_unique_token_get();
+
+    uint32_t status = access_model_reply(handle, p_message, &tx);
+    if (status != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Cadence status reply failed: 0x%08X\n", status);
+    }
+}
+
+static void vendor_model_cadence_get_cb(access_model_handle_t handle,
+                                        const access_message_rx_t * p_message,
+                                        void * p_args)
+{
+    (void)p_args;
+
+    if (p_message->length != 1)
+    {
+        return;
+    }
+    cadence_status_reply(handle, p_message, p_message->p_data[0]);
+}
+
+static void vendor_model_cadence_set_cb(access_model_handle_t handle,
+                                        const access_message_rx_t * p_message,
+                                        void * p_args)
+{
+    (void)p_args;
+
+    if (p_message->length < 1)
+    {
+        return;
+    }
+
+    uint8_t property = p_message->p_data[0];
+    if (property < IAQ_SAMPLE_PROPERTY_COUNT)
+    {
+        sensor_cadence_t cadence;
+        if (!sensor_cadence_decode(&p_message->p_data[1], (uint16_t)(p_message->length - 1), &cadence))
+        {
+            /* Prohibited values: the message is ignored */
+            __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Node 0x%04X: Invalid cadence set\n",
+                  p_message->meta_data.src.value);
+            return;
+        }
+        (void)app_sensor_iaq_cadence_set((iaq_sample_property_t)property, &cadence);
+    }
+    cadence_status_reply(handle, p_message, property);
+}
+
+#if APP_FEATURE_GATEWAY
+static bool series_request(access_model_handle_t handle, const access_message_rx_t * p_message,
+                           uint32_t from, uint32_t to)
+{
+    uint8_t payload[SERIES_GET_LEN];
+    uint8_t *p = payload;
+
+    p = put_u32(p, from);
+    p = put_u32(p, to);
+
+    access_message_tx_t tx;
+    memset(&tx, 0, sizeof(tx));
+
+    tx.opcode.opcode = VENDOR_OPCODE_SERIES_GET;
+    tx.opcode.company_id = VENDOR_COMPANY_ID;
+    tx.p_buffer = payload;
+    tx.length = sizeof(payload);
+    tx.force_segmented = false;
+    tx.transmic_size = NRF_MESH_TRANSMIC_SIZE_DEFAULT;
+    tx.access_token = nrf_mesh_unique_token_get();
+
+    /* Sent as a reply so it goes to the node, with the key it used */
+    uint32_t status = access_model_reply(handle, p_message, &tx);
+    if (status != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Node 0x%04X: Series get failed: 0x%08X\n",
+              p_message->meta_data.src.value, status);
+        return false;
+    }
+    return true;
+}
+#endif
+
+static void vendor_model_series_get_cb(access_model_handle_t handle,
+                                       const access_message_rx_t * p_message,
+                                       void * p_args)
+{
+    (void)p_args;
+
+    /* Built in static buffers: up to 500 bytes would otherwise sit on the mesh stack */
+    static iaq_sample_t s_buckets[MESH_VENDOR_SERIES_BATCH_MAX];
+    static uint8_t s_payload[SERIES_PAYLOAD_MAX];
+
+    uint32_t from = 0;
+    uint32_t to = UINT32_MAX;
+    if (p_message->length == SERIES_GET_LEN)
+    {
+        from = get_u32(&p_message->p_data[0]);
+        to = get_u32(&p_message->p_data[4]);
+    }
+    else if (p_message->length != 0)
+    {
+        return;
+    }
+
+    uint32_t first;
+    uint32_t last;
+    uint32_t now;
+    uint32_t count = app_sensor_iaq_series_get(from, to, s_buckets, MESH_VENDOR_SERIES_BATCH_MAX,
+                                               &first, &last, &now);
+
+    uint8_t *p = s_payload;
+    p = put_u32(p, now);
+    p = put_u32(p, first);
+    p = put_u32(p, last);
+    *p++ = (uint8_t)count;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        p = put_u16(p, s_buckets[i].iaq_x10);
+        p = put_u16(p, s_buckets[i].tvoc_x100);
+        p = put_u16(p, s_buckets[i].eco2);
+    }
+
+    access_message_tx_t tx;
+    memset(&tx, 0, sizeof(tx));
+
+    tx.opcode.opcode = VENDOR_OPCODE_SERIES_STATUS;
+    tx.opcode.company_id = VENDOR_COMPANY_ID;
+    tx.p_buffer = s_payload;
+    tx.length = (uint16_t)(p - s_payload);
+    tx.force_segmented = false;
+    tx.transmic_size = NRF_MESH_TRANSMIC_SIZE_DEFAULT;
+    tx.access_token = nrf_mesh_unique_token_get();
+
+    uint32_t status = access_model_reply(handle, p_message, &tx);
+    if (status != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Series status reply failed: 0x%08X\n", status);
+    }
+}
+
+static void scheduled_series_rx_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)event_size;
+    const rx_copy_event_t * p_rx = p_event_data;
+    const rx_copy_t * p_copy = &s_rx_copy[p_rx->slot];
+    const uint8_t *data = p_copy->data;
+    uint16_t src_addr = p_rx->src_addr;
+
+    /* Only the buckets that were copied out, for a page cut short */
+    uint32_t now = get_u32(&data[0]);
+    uint32_t first = get_u32(&data[4]);
+    uint32_t last = get_u32(&data[8]);
+    uint32_t count = (p_copy->length - SERIES_HEADER_LEN) / SERIES_RECORD_LEN;
+
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO,
+          "Node 0x%04X: series %u..%u, %u buckets\n", src_addr, first, last, count);
+
+    const uint8_t *rec = &data[SERIES_HEADER_LEN];
+    for (uint32_t i = 0; i < count; i++, rec += SERIES_RECORD_LEN)
+    {
+        iaq_sample_t sample;
+        sample.iaq_x10 = get_u16(&rec[0]);
+        sample.tvoc_x100 = get_u16(&rec[2]);
+        sample.eco2 = get_u16(&rec[4]);
+        if (sample.iaq_x10 != IAQ_HISTORY_NO_DATA)
+        {
+            app_uart_send_iaq_series(src_addr, first + i, now - (first + i), &sample);
+        }
+    }
+    rx_copy_free(p_rx);
+}
+
+/* The next page is requested from here, as the reply needs the message; the
+ * buckets are forwarded from the MESH_RX class. A page of more buckets than
+ * MESH_VENDOR_SERIES_BATCH_MAX is cut short, and the rest requested again. */
+static void vendor_model_series_status_cb(access_model_handle_t handle,
+                                          const access_message_rx_t * p_message,
+                                          void * p_args)
+{
+    (void)p_args;
+
+    uint16_t src_addr = p_message->meta_data.src.value;
+    const uint8_t *data = p_message->p_data;
+
+    if (p_message->length < SERIES_HEADER_LEN ||
+        p_message->length < SERIES_HEADER_LEN + data[12] * SERIES_RECORD_LEN)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN,
+              "Node 0x%04X: Invalid series length: %u\n", src_addr, p_message->length);
+        return;
+    }
+
+    uint32_t first = get_u32(&data[4]);
+    uint32_t last = get_u32(&data[8]);
+    uint8_t count = (data[12] < MESH_VENDOR_SERIES_BATCH_MAX) ? data[12] : MESH_VENDOR_SERIES_BATCH_MAX;
+
+    RX_COPY_PUT(src_addr, data, SERIES_HEADER_LEN + count * SERIES_RECORD_LEN, scheduled_series_rx_handler);
+
+#if APP_FEATURE_GATEWAY
+    /* Page through the rest of the range of the pull in progress; a Series
+     * Status from any other node is forwarded only */
+    if (s_series_pull.active && src_addr == s_series_pull.addr)
+    {
+        if (count == 0 || first + count - 1 >= last ||
+            !series_request(handle, p_message, first + count, last))
+        {
+            s_series_pull.active = false;
+        }
+        s_series_pull.ticks = app_timer_cnt_get();
+    }
+#else
+    (void)handle;
+    (void)first;
+    (void)last;
+#endif
+}
+
+static void vendor_model_bulk_data_cb(access_model_handle_t handle,
+                                      const access_message_rx_t * p_message,
+                                      void * p_args)
+{
+    (void)p_args;
+
+    /* Only the gateway forwards and acknowledges backfill */
+    if (!APP_FEATURE_GATEWAY)
+    {
+        return;
+    }
+
+    uint16_t src_addr = p_message->meta_data.src.value;
+
+    dsm_local_unicast_address_t local_addr;
+    dsm_local_unicast_addresses_get(&local_addr);
+    if (src_addr == local_addr.address_start)
+    {
+        return;
+    }
+
+    iaq_bulk_reader_t reader;
+    if (!iaq_bulk_reader_init(&reader, p_message->p_data, p_message->length))
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN,
+              "Node 0x%04X: Invalid bulk length: %u\n", src_addr, p_message->length);
+        return;
+    }
+
+    uint8_t transfer = reader.transfer;
+    uint32_t first_seq = reader.last.seq;
+    uint8_t count = 0;
+    app_iaq_store_sample_t sample;
+    while (iaq_bulk_reader_next(&reader, &sample))
+    {
+        app_uart_send_iaq_history(src_addr, sample.seq, sample.boot, sample.timestamp_s,
+                                  sample.value.iaq_x10, sample.value.tvoc_x100, sample.value.eco2);
+        count++;
+    }
+
+    if (count != reader.count)
+    {
+        /* Not acknowledged: the node sends the whole transfer again */
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN,
+              "Node 0x%04X: Truncated bulk transfer %u (%u of %u samples)\n",
+              src_addr, transfer, count, reader.count);
+        return;
+    }
+
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Node 0x%04X: bulk transfer %u, seq %u..%u (%u bytes)\n",
+          src_addr, transfer, first_seq, first_seq + count - 1, p_message->length);
+
+    uint8_t payload[BULK_ACK_LEN];
+    payload[0] = transfer;
+    (void)put_u32(&payload[1], first_seq);
+
+    access_message_tx_t tx;
+    memset(&tx, 0, sizeof(tx));
+
+    tx.opcode.opcode = VENDOR_OPCODE_BULK_ACK;
+    tx.opcode.company_id = VENDOR_COMPANY_ID;
+    tx.p_buffer = payload;
+    tx.length = sizeof(payload);
+    tx.force_segmented = false;
+    tx.transmic_size = NRF_MESH_TRANSMIC_SIZE_DEFAULT;
+    tx.access_token = nrf_mesh_unique_token_get();
+
+    uint32_t status = access_model_reply(handle, p_message, &tx);
+    if (status != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Node 0x%04X: Bulk ack failed: 0x%08X\n", src_addr, status);
+    }
+}
+
+static void vendor_model_bulk_ack_cb(access_model_handle_t handle,
+                                     const access_message_rx_t * p_message,
+                                     void * p_args)
+{
+    (void)handle;
+    (void)p_args;
+
+    if (p_message->length != BULK_ACK_LEN)
+    {
+        return;
+    }
+    app_sensor_iaq_bulk_ack(p_message->p_data[0], get_u32(&p_message->p_data[1]));
+}
+
+static void vendor_model_alert_set_cb(access_model_handle_t handle,
+                                      const access_message_rx_t * p_message,
+                                      void * p_args)
+{
+    static struct
+    {
+        uint16_t src_addr;
+        uint8_t tid;
+    } s_recent[ALERT_DEDUP_LEN];
+    static uint8_t s_recent_next;
+
+    (void)p_args;
+
+    /* Only the gateway acknowledges alerts */
+    if (!APP_FEATURE_GATEWAY)
+    {
+        return;
+    }
+
+    uint16_t src_addr = p_message->meta_data.src.value;
+
+    iaq_sample_t sample;
+    iaq_codec_meta_t meta;
+    if (p_message->length > UINT8_MAX ||
+        !iaq_codec_values_unpack(p_message->p_data, (uint8_t)p_message->length, &sample, &meta) ||
+        meta.version < 2)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN,
+              "Node 0x%04X: Invalid alert, %u bytes\n", src_addr, p_message->length);
+        return;
+    }
+
+    uint8_t tid = meta.seq;
+    uint8_t previous_level = meta.prev_level;
+    uint8_t level = meta.level;
+
+    /* Acknowledge every copy, but forward each alert once */
+    bool duplicate = false;
+    for (uint32_t i = 0; i < ALERT_DEDUP_LEN; i++)
+    {
+        if (s_recent[i].src_addr == src_addr && s_recent[i].tid == tid)
+        {
+            duplicate = true;
+            break;
+        }
+    }
+    if (!duplicate)
+    {
+        s_recent[s_recent_next].src_addr = src_addr;
+        s_recent[s_recent_next].tid = tid;
+        s_recent_next = (s_recent_next + 1) % ALERT_DEDUP_LEN;
+
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Node 0x%04X: ALERT IAQ %u -> %u (%s), IAQ=%u.%u\n",
+              src_addr, previous_level, level, get_iaq_description(level),
+              sample.iaq_x10 / 10, sample.iaq_x10 % 10);
+        app_uart_send_iaq_alert(src_addr, tid, previous_level, level, &sample);
+    }
+
+    uint8_t payload[ALERT_STATUS_LEN] = { tid, level };
+
+    access_message_tx_t tx;
+    memset(&tx, 0, sizeof(tx));
+
+    tx.opcode.opcode = VENDOR_OPCODE_ALERT_STATUS;
+    tx.opcode.company_id = VENDOR_COMPANY_ID;
+    tx.p_buffer = payload;
+    tx.length = sizeof(payload);
+    tx.force_segmented = false;
+    tx.transmic_size = NRF_MESH_TRANSMIC_SIZE_DEFAULT;
+    tx.access_token = nrf_mesh_unique_token_get();
+
+    uint32_t status = access_model_reply(handle, p_message, &tx);
+    if (status != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Node 0x%04X: Alert status failed: 0x%08X\n", src_addr, status);
+    }
+}
+
+/* Alert Status, logged on the MESH_RX class */
+typedef struct
+{
+    uint16_t src_addr;
+    uint8_t tid;
+} alert_status_rx_event_t;
+
+static void scheduled_alert_status_rx_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)event_size;
+    const alert_status_rx_event_t * p_rx = p_event_data;
+    __LOG(LOG_SRC_APP, LOG_LEVEL_DBG1, "Alert %u acknowledged by 0x%04X\n", p_rx->tid, p_rx->src_addr);
+}
+
+/* The reply itself completes the transfer in access_reliable (alert_reliable_cb) */
+static void vendor_model_alert_status_cb(access_model_handle_t handle,
+                                         const access_message_rx_t * p_message,
+                                         void * p_args)
+{
+    (void)handle;
+    (void)p_args;
+
+    if (p_message->length == ALERT_STATUS_LEN)
+    {
+        alert_status_rx_event_t rx;
+        rx.src_addr = p_message->meta_data.src.value;
+        rx.tid = p_message->p_data[0];
+        (void)APP_SCHED_PUT(APP_SCHED_CLASS_MESH_RX, &rx, sizeof(rx), scheduled_alert_status_rx_handler);
+    }
+}
+
+/* Published with the model's publication state as configured. The alarm TTL
+ * is set once, at provisioning (mesh_vendor_model_alarm_ttl_apply()), as both
+ * it and the network transmit count are stored in flash whenever they change. */
+static uint32_t alert_attempt(void)
+{
+    memset(&s_alert.reliable, 0, sizeof(s_alert.reliable));
+
+    s_alert.reliable.model_handle = m_vendor_model_handle;
+    s_alert.reliable.message.opcode.opcode = VENDOR_OPCODE_ALERT_SET;
+    s_alert.reliable.message.opcode.company_id = VENDOR_COMPANY_ID;
+    s_alert.reliable.message.p_buffer = s_alert.payload;
+    s_alert.reliable.message.length = s_alert.length;
+    s_alert.reliable.message.force_segmented = false;
+    s_alert.reliable.message.transmic_size = NRF_MESH_TRANSMIC_SIZE_DEFAULT;
+    s_alert.reliable.message.access_token = nrf_mesh_unique_token_get();
+    s_alert.reliable.reply_opcode.opcode = VENDOR_OPCODE_ALERT_STATUS;
+    s_alert.reliable.reply_opcode.company_id = VENDOR_COMPANY_ID;
+    s_alert.reliable.timeout = MESH_VENDOR_ALERT_TIMEOUT_MS * 1000u;
+    s_alert.reliable.status_cb = alert_reliable_cb;
+
+    uint32_t status = access_model_reliable_publish(&s_alert.reliable);
+    if (status == NRF_SUCCESS)
+    {
+        s_alert.active = true;
+        s_alert.attempts++;
+        s_alert.start_ticks = app_timer_cnt_get();
+    }
+    return status;
+}
+
+static void scheduled_alert_retry_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)event_size;
+
+    /* Superseded while waiting here: the new alert is already on its way */
+    if (s_alert.active || *(const uint8_t *)p_event_data != s_alert.tid)
+    {
+        return;
+    }
+
+    uint32_t status = alert_attempt();
+    if (status != NRF_SUCCESS)
+    {
+        s_alert_stats.failed++;
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Alert %u retry failed: 0x%08X\n", s_alert.tid, status);
+    }
+}
+
+static void alert_reliable_cb(access_model_handle_t model_handle, void * p_args, access_reliable_status_t status)
+{
+    (void)model_handle;
+    (void)p_args;
+
+    /* Cancelled by mesh_publish_sensor_alert(), which accounts for it */
+    if (status == ACCESS_RELIABLE_TRANSFER_CANCELLED || !s_alert.active)
+    {
+        return;
+    }
+    s_alert.active = false;
+
+    if (status == ACCESS_RELIABLE_TRANSFER_SUCCESS)
+    {
+        uint32_t ticks = app_timer_cnt_diff_compute(app_timer_cnt_get(), s_alert.start_ticks);
+        uint32_t rtt_ms = (uint32_t)(((uint64_t)ticks * 1000) / APP_TIMER_CLOCK_FREQ);
+
+        s_alert_stats.acked++;
+        s_alert_stats.rtt_last_ms = rtt_ms;
+        if (s_alert_stats.acked == 1 || rtt_ms < s_alert_stats.rtt_min_ms)
+        {
+            s_alert_stats.rtt_min_ms = rtt_ms;
+        }
+        if (rtt_ms > s_alert_stats.rtt_max_ms)
+        {
+            s_alert_stats.rtt_max_ms = rtt_ms;
+        }
+        s_alert_rtt_total_ms += rtt_ms;
+
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Alert %u acknowledged in %u ms (attempt %u)\n",
+              s_alert.tid, rtt_ms, s_alert.attempts);
+        return;
+    }
+
+    if (s_alert.attempts >= MESH_VENDOR_ALERT_ATTEMPTS)
+    {
+        s_alert_stats.failed++;
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Alert %u not acknowledged after %u attempts\n",
+              s_alert.tid, s_alert.attempts);
+        return;
+    }
+
+    /* Not from inside the access layer's callback */
+    s_alert_stats.retries++;
+    __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Alert %u timed out, retrying\n", s_alert.tid);
+    if (APP_SCHED_PUT(APP_SCHED_CLASS_MESH_RX, &s_alert.tid, sizeof(s_alert.tid),
+                      scheduled_alert_retry_handler) != NRF_SUCCESS)
+    {
+        s_alert_stats.failed++;
+    }
+}
+
+static uint32_t publish_payload(const uint8_t * p_payload, uint8_t length)
+{
+    access_message_tx_t tx;
+    memset(&tx, 0, sizeof(tx));
+
+    tx.opcode.opcode = VENDOR_OPCODE_SENSOR_VALUES;
+    tx.opcode.company_id = VENDOR_COMPANY_ID;
+    tx.p_buffer = p_payload;
+    tx.length = length;
+    tx.force_segmented = false;
+    tx.transmic_size = NRF_MESH_TRANSMIC_SIZE_DEFAULT;
+    tx.access_token = nrf_mesh_unique_token_get();
+
+    return access_model_publish(m_vendor_model_handle, &tx);
+}
+
+/* Errors that go away on their own: no free packet buffer, bearer busy, or
+ * no sequence number available during an IV update. Everything else means
+ * the publication state itself is wrong. */
+static bool is_transient_error(uint32_t status)
+{
+    return status == NRF_ERROR_NO_MEM ||
+           status == NRF_ERROR_BUSY ||
+           status == NRF_ERROR_FORBIDDEN;
+}
+
+static void retry_timer_start(void)
+{
+    if (s_retry_timer_running)
+    {
+        return;
+    }
+
+    // Random jitter so nodes hit by the same congestion spread out
+    uint16_t rnd;
+    rand_hw_rng_get((uint8_t *)&rnd, sizeof(rnd));
+    uint32_t delay_ms = publish_retry_delay_ms(&s_retry, rnd);
+
+    if (app_timer_start(m_retry_timer_id, APP_TIMER_TICKS(delay_ms), NULL) == NRF_SUCCESS)
+    {
+        s_retry_timer_running = true;
+    }
+}
+
+/* A reading the retry queue gives up on, or that a full queue displaces, goes
+ * to the flash store so backfill sends it once the link is back */
+static void retry_spill(const publish_retry_entry_t * p_entry, void * p_context)
+{
+    (void)p_context;
+
+#if APP_FEATURE_SENSOR
+    app_iaq_store_sample_t sample;
+    iaq_codec_meta_t meta;
+    memset(&sample, 0, sizeof(sample));
+    if (iaq_codec_values_unpack(p_entry->payload, p_entry->length, &sample.value, &meta))
+    {
+        sample.timestamp_s = p_entry->timestamp_s;
+        if (app_iaq_store_append(&sample))
+        {
+            s_retry_spilled++;
+            __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Reading #%u stored for backfill after %u attempts\n",
+                  meta.seq, p_entry->attempts);
+            return;
+        }
+    }
+#endif
+    __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Reading lost after %u attempts (%u dropped, %u coalesced)\n",
+          p_entry->attempts, s_retry.dropped, s_retry.coalesced);
+}
+
+static uint32_t retry_send(const uint8_t * p_payload, uint8_t length, void * p_context)
+{
+    (void)p_context;
+
+    uint32_t status = publish_payload(p_payload, length);
+    if (status != NRF_SUCCESS && !is_transient_error(status))
+    {
+        s_pub_cache.configured = false;
+    }
+    return status;
+}
+
+static void retry_enqueue(const uint8_t * p_payload, uint8_t length, uint32_t timestamp_s)
+{
+    /* Flagged so the gateway reports the reading as late */
+    uint8_t payload[PUBLISH_RETRY_PAYLOAD_MAX];
+    memcpy(payload, p_payload, length);
+    iaq_codec_values_flags_set(payload, IAQ_CODEC_FLAG_RETRIED);
+
+    publish_retry_push(&s_retry, payload, length, timestamp_s, retry_spill, NULL);
+    retry_timer_start();
+}
+
+static void scheduled_retry_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)p_event_data;
+    (void)event_size;
+
+    if (!s_pub_cache.configured)
+    {
+        mesh_vendor_model_publication_reload();
+        if (!s_pub_cache.configured)
+        {
+            publish_retry_backoff(&s_retry);
+            retry_timer_start();
+            return;
+        }
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Publication restored\n");
+    }
+
+    uint32_t status = publish_retry_run(&s_retry, retry_send, retry_spill, NULL);
+    if (status != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Retry %u failed: 0x%08X, next in %u ms\n",
+              s_retry.entries[s_retry.head].attempts, status, s_retry.backoff_ms);
+        retry_timer_start();
+        return;
+    }
+
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO,
+          "Retry queue drained (%u coalesced, %u dropped, %u stored for backfill)\n",
+          s_retry.coalesced, s_retry.dropped, s_retry_spilled);
+}
+
+static void retry_timer_handler(void * p_context)
+{
+    (void)p_context;
+    s_retry_timer_running = false;
+    (void)APP_SCHED_PUT(APP_SCHED_CLASS_BACKGROUND, NULL, 0, scheduled_retry_handler);
+}
+
+uint32_t mesh_publish_sensor_values(const iaq_sample_t * p_sample, uint32_t timestamp_s)
+{
+    static uint32_t s_warn_count = 0;
+    
+    if (m_vendor_model_handle == ACCESS_HANDLE_INVALID)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Vendor model not initialized\n");
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if (!publication_ready())
+    {
+        s_warn_count++;
+        if (s_warn_count % 10 == 1)
+        {
+            __LOG(LOG_SRC_APP, LOG_LEVEL_WARN,
+                  "Publish not configured (attempt %u)\n", s_warn_count);
+        }
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    /* seq lets the gateway spot lost readings; a reading queued for retry
+     * keeps the one it was packed with */
+    uint8_t iaq_level = iaq_sample_level(p_sample->iaq_x10);
+    iaq_codec_meta_t meta =
+    {
+        .flags = (iaq_level >= MESH_VENDOR_ALERT_LEVEL && iaq_level > s_values_level) ? IAQ_CODEC_FLAG_ALARM : 0,
+        .seq = s_values_seq++,
+        .prev_level = s_values_level
+    };
+    s_values_level = iaq_level;
+
+    uint8_t payload[VENDOR_PAYLOAD_MAX];
+    uint8_t payload_len = iaq_codec_values_pack(p_sample, &meta, payload);
+
+    // Keep ordering: while older readings wait for a retry, queue behind them
+    if (publish_retry_pending(&s_retry))
+    {
+        retry_enqueue(payload, payload_len, timestamp_s);
+        return NRF_ERROR_BUSY;
+    }
+
+    uint32_t status = publish_payload(payload, payload_len);
+
+    if (status == NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO,
+              "Published: IAQ_Level=%u, TVOC_x100=%u, eCO2=%u\n",
+              iaq_level, p_sample->tvoc_x100, p_sample->eco2);
+        return NRF_SUCCESS;
+    }
+
+    const char *err_str = nrf_strerror_get(status);
+    __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR,
+          "Publish failed: 0x%08X (%s)\n", status, (err_str ? err_str : "unknown"));
+
+    if (is_transient_error(status))
+    {
+        retry_enqueue(payload, payload_len, timestamp_s);
+        return NRF_ERROR_BUSY;
+    }
+
+    // Configuration problem: stop publishing until the parameters are reloaded,
+    // which the retry timer does on its own so the node never stays silent.
+    s_pub_cache.configured = false;
+    retry_timer_start();
+    return status;
+}
+
+uint32_t mesh_publish_sensor_bulk(const uint8_t * p_payload, uint16_t length)
+{
+    if (m_vendor_model_handle == ACCESS_HANDLE_INVALID || !publication_ready())
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if (length < IAQ_BULK_HEADER_LEN || length > MESH_VENDOR_BULK_PAYLOAD_MAX)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    access_message_tx_t tx;
+    memset(&tx, 0, sizeof(tx));
+
+    tx.opcode.opcode = VENDOR_OPCODE_BULK_DATA;
+    tx.opcode.company_id = VENDOR_COMPANY_ID;
+    tx.p_buffer = p_payload;
+    tx.length = length;
+    tx.force_segmented = true;      // Also when a short transfer would fit one PDU: SAR acks it per hop
+    tx.transmic_size = NRF_MESH_TRANSMIC_SIZE_DEFAULT;
+    tx.access_token = nrf_mesh_unique_token_get();
+
+    uint32_t status = access_model_publish(m_vendor_model_handle, &tx);
+    if (status == NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Published bulk transfer %u, %u bytes\n", p_payload[0], length);
+    }
+    else
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Bulk publish deferred: 0x%08X\n", status);
+    }
+
+    return status;
+}
+
+uint32_t mesh_publish_sensor_alert(const iaq_sample_t * p_sample, uint8_t previous_level)
+{
+    if (m_vendor_model_handle == ACCESS_HANDLE_INVALID || !publication_ready())
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if (s_alert.active)
+    {
+        s_alert.active = false;
+        s_alert_stats.superseded++;
+        (void)access_model_reliable_cancel(m_vendor_model_handle);
+    }
+
+    s_alert.tid++;
+    s_alert.attempts = 0;
+
+    iaq_codec_meta_t meta = { .flags = IAQ_CODEC_FLAG_ALARM, .seq = s_alert.tid, .prev_level = previous_level };
+    s_alert.length = iaq_codec_values_pack(p_sample, &meta, s_alert.payload);
+
+    uint32_t status = alert_attempt();
+    if (status == NRF_SUCCESS)
+    {
+        s_alert_stats.sent++;
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Alert %u: IAQ level %u -> %u\n",
+              s_alert.tid, previous_level, iaq_sample_level(p_sample->iaq_x10));
+    }
+    else
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_ERROR, "Alert publish failed: 0x%08X\n", status);
+    }
+    return status;
+}
+
+bool mesh_vendor_model_alert_in_flight(void)
+{
+    return s_alert.active;
+}
+
+void mesh_vendor_model_alert_stats_get(mesh_vendor_alert_stats_t * p_stats)
+{
+    *p_stats = s_alert_stats;
+    p_stats->rtt_avg_ms = (s_alert_stats.acked > 0) ? (uint32_t)(s_alert_rtt_total_ms / s_alert_stats.acked) : 0;
+}
+
+void mesh_vendor_model_alert_stats_log(void)
+{
+    mesh_vendor_alert_stats_t stats;
+    mesh_vendor_model_alert_stats_get(&stats);
+
+    __LOG(LOG_SRC_APP, LOG_LEVEL_INFO,
+          "Alerts: %u sent, %u acked, %u failed, %u superseded, %u retries; RTT %u/%u/%u ms min/avg/max\n",
+          stats.sent, stats.acked, stats.failed, stats.superseded, stats.retries,
+          stats.rtt_min_ms, stats.rtt_avg_ms, stats.rtt_max_ms);
+}
+
+access_model_handle_t mesh_vendor_model_handle_get(void)
+{
+    return m_vendor_model_handle;
+}
+
+uint32_t mesh_vendor_model_publish_period_ms(void)
+{
+    if (!s_pub_cache.valid)
+    {
+        mesh_vendor_model_publication_reload();
+    }
+    return s_pub_cache.period_ms;
+}
+
+uint32_t mesh_publish_sensor_ext(const uint8_t * p_payload, uint16_t length)
+{
+    if (m_vendor_model_handle == ACCESS_HANDLE_INVALID || !publication_ready())
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if (length < IAQ_EXT_HEADER_LEN || length > IAQ_EXT_PAYLOAD_MAX)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    access_message_tx_t tx;
+    memset(&tx, 0, sizeof(tx));
+
+    tx.opcode.opcode = VENDOR_OPCODE_EXT_VALUES;
+    tx.opcode.company_id = VENDOR_COMPANY_ID;
+    tx.p_buffer = p_payload;
+    tx.length = length;
+    tx.force_segmented = false;
+    tx.transmic_size = NRF_MESH_TRANSMIC_SIZE_DEFAULT;
+    tx.access_token = nrf_mesh_unique_token_get();
+
+    uint32_t status = access_model_publish(m_vendor_model_handle, &tx);
+    if (status == NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_INFO, "Published ext values %u, %u bytes\n", p_payload[0], length);
+    }
+    return status;
+}
+
+uint32_t mesh_publish_env_values(const env_input_value_t * p_value)
+{
+    if (m_vendor_model_handle == ACCESS_HANDLE_INVALID || !publication_ready())
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    uint8_t payload[ENV_VALUES_LEN];
+    uint8_t *p = payload;
+    p = put_u16(p, (uint16_t)p_value->temp_x100);
+    (void)put_u16(p, p_value->rh_x100);
+
+    access_message_tx_t tx;
+    memset(&tx, 0, sizeof(tx));
+
+    tx.opcode.opcode = VENDOR_OPCODE_ENV_VALUES;
+    tx.opcode.company_id = VENDOR_COMPANY_ID;
+    tx.p_buffer = payload;
+    tx.length = sizeof(payload);
+    tx.force_segmented = false;
+    tx.transmic_size = NRF_MESH_TRANSMIC_SIZE_DEFAULT;
+    tx.access_token = nrf_mesh_unique_token_get();
+
+    uint32_t status = access_model_publish(m_vendor_model_handle, &tx);
+    if (status != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Env values publish failed: 0x%08X\n", status);
+    }
+    return status;
+}
+
+uint32_t mesh_publish_power_status(const app_power_report_t * p_report)
+{
+    if (m_vendor_model_handle == ACCESS_HANDLE_INVALID || !publication_ready())
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    uint8_t payload[POWER_STATUS_LEN];
+    uint8_t *p = payload;
+
+    p = put_u32(p, p_report->uptime_s);
+    p = put_u16(p, p_report->duty_permille);
+    p = put_u16(p, p_report->avg_current_ua);
+    for (uint32_t i = 0; i < APP_POWER_SRC_COUNT; i++)
+    {
+        p = put_u16(p, p_report->wakeups[i]);
+        p = put_u16(p, p_report->active_ms[i]);
+    }
+
+    access_message_tx_t tx;
+    memset(&tx, 0, sizeof(tx));
+
+    tx.opcode.opcode = VENDOR_OPCODE_POWER_STATUS;
+    tx.opcode.company_id = VENDOR_COMPANY_ID;
+    tx.p_buffer = payload;
+    tx.length = sizeof(payload);
+    tx.force_segmented = false;
+    tx.transmic_size = NRF_MESH_TRANSMIC_SIZE_DEFAULT;
+    tx.access_token = nrf_mesh_unique_token_get();
+
+    uint32_t status = access_model_publish(m_vendor_model_handle, &tx);
+    if (status != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Power status publish failed: 0x%08X\n", status);
+    }
+    return status;
+}
+
+uint32_t mesh_publish_sched_diag(const app_sched_stats_report_t * p_report)
+{
+    if (m_vendor_model_handle == ACCESS_HANDLE_INVALID || !publication_ready())
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    uint8_t payload[SCHED_DIAG_LEN_MAX];
+    uint8_t *p = payload;
+
+    for (uint32_t i = 0; i < APP_SCHED_CLASS_COUNT; i++)
+    {
+        *p++ = p_report->classes[i].depth_max;
+        *p++ = p_report->classes[i].queue_size;
+        p = put_u16(p, p_report->classes[i].put_failures);
+        p = put_u32(p, p_report->classes[i].latency_max_us);
+    }
+    *p++ = p_report->row_count;
+    for (uint32_t i = 0; i < p_report->row_count; i++)
+    {
+        memcpy(p, p_report->rows[i].name, APP_SCHED_STATS_NAME_LEN);
+        p += APP_SCHED_STATS_NAME_LEN;
+        p = put_u16(p, p_report->rows[i].put_failures);
+        p = put_u32(p, p_report->rows[i].exec_max_us);
+    }
+
+    access_message_tx_t tx;
+    memset(&tx, 0, sizeof(tx));
+
+    tx.opcode.opcode = VENDOR_OPCODE_SCHED_DIAG;
+    tx.opcode.company_id = VENDOR_COMPANY_ID;
+    tx.p_buffer = payload;
+    tx.length = (uint16_t)(p - payload);
+    tx.force_segmented = false;
+    tx.transmic_size = NRF_MESH_TRANSMIC_SIZE_DEFAULT;
+    tx.access_token = nrf_mesh_unique_token_get();
+
+    uint32_t status = access_model_publish(m_vendor_model_handle, &tx);
+    if (status != NRF_SUCCESS)
+    {
+        __LOG(LOG_SRC_APP, LOG_LEVEL_WARN, "Scheduler diagnostics publish failed: 0x%08X\n", status);
+    }
+    return status;
 }
@@ -4,13 +4,147 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "access.h"
+#include "app_iaq_store.h"
+#include "iaq_sample.h"
+#include "env_input.h"
+#include "app_power.h"
+#include "app_sched_stats.h"
+
+/* Largest Bulk Data payload (iaq_bulk.h): APP_CONFIG_MAX_MESSAGE_BYTES less
+ * the 3 byte vendor opcode, 22 segments. */
+#define MESH_VENDOR_BULK_PAYLOAD_MAX   253
+
+/* Maximum number of RAM history buckets in one (segmented) Series Status. */
+#define MESH_VENDOR_SERIES_BATCH_MAX   40
+
+/* Received messages larger than a scheduler event (APP_SCHED_PAYLOAD_MAX) wait
+ * for their MESH_RX handler in one of these copy buffers, each as large as
+ * the largest such message. With none free the message is dropped and counted
+ * as a put failure of its handler. */
+#ifndef MESH_VENDOR_RX_COPY_SLOTS
+#if APP_FEATURE_GATEWAY
+#define MESH_VENDOR_RX_COPY_SLOTS      4
+#else
+/* Without the gateway UART these messages are only parsed */
+#define MESH_VENDOR_RX_COPY_SLOTS      1
+#endif
+#endif
+
+/* Gateway: the RAM history of each node is pulled once, after the node is
+ * first heard, one node at a time. A pull starts with a reading from a node
+ * not pulled yet, at least MESH_VENDOR_SERIES_PULL_GAP_MS after the previous
+ * pull ended, and is abandoned after MESH_VENDOR_SERIES_PULL_TIMEOUT_MS
+ * without a Series Status. */
+#ifndef MESH_VENDOR_SERIES_PULL_GAP_MS
+#define MESH_VENDOR_SERIES_PULL_GAP_MS     5000
+#endif
+#ifndef MESH_VENDOR_SERIES_PULL_TIMEOUT_MS
+#define MESH_VENDOR_SERIES_PULL_TIMEOUT_MS 30000
+#endif
 
 uint32_t mesh_vendor_model_init(void);
-void mesh_publish_sensor_values(float iaq, float tvoc, float eco2);
+/*
+ * Publish one reading, captured at timestamp_s (app_iaq_store_sample_t).
+ * Returns NRF_SUCCESS when sent, NRF_ERROR_BUSY when the reading was queued for
+ * retry after a transient error (it will be sent automatically, or stored for
+ * backfill if the retries fail), or another error if the reading was not
+ * accepted at all.
+ */
+uint32_t mesh_publish_sensor_values(const iaq_sample_t * p_sample, uint32_t timestamp_s);
+
+/* Publish one bulk backfill transfer built with iaq_bulk_writer_t. */
+uint32_t mesh_publish_sensor_bulk(const uint8_t * p_payload, uint16_t length);
+
+/* Publish one Ext Values message built with iaq_ext_pack(). */
+uint32_t mesh_publish_sensor_ext(const uint8_t * p_payload, uint16_t length);
+
+/* Publish this node's T/RH for neighbours' IAQ compensation (env_input.h). */
+uint32_t mesh_publish_env_values(const env_input_value_t * p_value);
+
+/* Publish the duty-cycle/energy report from app_power. */
+uint32_t mesh_publish_power_status(const app_power_report_t * p_report);
+
+/* Publish the scheduler queue and handler statistics from app_sched_stats. */
+uint32_t mesh_publish_sched_diag(const app_sched_stats_report_t * p_report);
+
+/* IAQ level (iaq_sample_level()) from which a rise is sent as an acknowledged Alert. */
+#ifndef MESH_VENDOR_ALERT_LEVEL
+#define MESH_VENDOR_ALERT_LEVEL        4
+#endif
+
+/* Alert re-arming: after an alert, the level must fall MESH_VENDOR_ALERT_HYSTERESIS
+ * levels below the alerted one before a rise alerts again, and no alert
+ * follows another within MESH_VENDOR_ALERT_HOLDOFF_MS. */
+#ifndef MESH_VENDOR_ALERT_HYSTERESIS
+#define MESH_VENDOR_ALERT_HYSTERESIS   2
+#endif
+#ifndef MESH_VENDOR_ALERT_HOLDOFF_MS
+#define MESH_VENDOR_ALERT_HOLDOFF_MS   60000
+#endif
+
+/* Time to wait for the gateway's Alert Status, 2000..60000 ms. The access layer
+ * retransmits within it. */
+#ifndef MESH_VENDOR_ALERT_TIMEOUT_MS
+#define MESH_VENDOR_ALERT_TIMEOUT_MS   6000
+#endif
+
+/* Attempts of MESH_VENDOR_ALERT_TIMEOUT_MS each before an alert is given up. */
+#ifndef MESH_VENDOR_ALERT_ATTEMPTS
+#define MESH_VENDOR_ALERT_ATTEMPTS     3
+#endif
+
+/* Lowest default TTL, so alerts published with it reach the gateway from the
+ * far end of the mesh. Set once at provisioning: the default TTL is stored in
+ * flash whenever it changes, so it is not raised per alert. */
+#ifndef MESH_VENDOR_ALARM_TTL
+#define MESH_VENDOR_ALARM_TTL          15
+#endif
+
+typedef struct
+{
+    uint32_t sent;          // Alerts raised
+    uint32_t acked;
+    uint32_t failed;        // Not acknowledged after MESH_VENDOR_ALERT_ATTEMPTS
+    uint32_t superseded;    // Replaced by a newer alert before the ack
+    uint32_t retries;       // Attempts after the first
+    uint32_t rtt_last_ms;   // Start of the acknowledged attempt to the Status
+    uint32_t rtt_min_ms;
+    uint32_t rtt_max_ms;
+    uint32_t rtt_avg_ms;
+} mesh_vendor_alert_stats_t;
+
+/* Send an acknowledged Alert for a reading whose IAQ level rose from
+ * previous_level to MESH_VENDOR_ALERT_LEVEL or above. Routine readings stay
+ * unacknowledged. One alert is in flight at a time; a newer one replaces it.
+ * Returns NRF_SUCCESS once the access layer has accepted the first attempt. */
+uint32_t mesh_publish_sensor_alert(const iaq_sample_t * p_sample, uint8_t previous_level);
+
+/* True until the gateway has acknowledged the current alert or it was given
+ * up. Backfill holds off meanwhile so the alert does not queue behind it. */
+bool mesh_vendor_model_alert_in_flight(void);
+
+void mesh_vendor_model_alert_stats_get(mesh_vendor_alert_stats_t * p_stats);
+void mesh_vendor_model_alert_stats_log(void);
 access_model_handle_t mesh_vendor_model_handle_get(void);
+
+/* Publish period configured for the vendor model, 0 if none. The base period
+ * of the reading cadence; the model itself publishes only from the app. Read
+ * from the publication cache, so called on every reading without querying
+ * the stack. */
+uint32_t mesh_vendor_model_publish_period_ms(void);
 bool mesh_vendor_model_is_ready(void);
 
-/* Call this when config server reports publication was set */
-void mesh_vendor_model_publication_set(void);
+/* Re-read publish address and AppKey from access/DSM into the publication cache.
+ * Call once at startup on an already provisioned node. */
+void mesh_vendor_model_publication_reload(void);
+
+/* Raise the node's default TTL to MESH_VENDOR_ALARM_TTL if it is lower. Call
+ * once, when provisioning completes. */
+void mesh_vendor_model_alarm_ttl_apply(void);
+
+/* Call for every config server event that can change publication state
+ * (publication set, app bind/unbind, AppKey update/delete, key refresh, reset).
+ * The cache is rebuilt on the next publish. */
+void mesh_vendor_model_publication_invalidate(void);
 
 #endif /* MESH_VENDOR_MODEL_H__ */
@@ -0,0 +1,27 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "node_table.h"
+
+bool node_table_contains(const node_table_t * p_table, uint16_t addr)
+{
+    for (uint16_t i = 0; i < p_table->count; i++)
+    {
+        if (p_table->p_addrs[i] == addr)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool node_table_add(node_table_t * p_table, uint16_t addr)
+{
+    if (node_table_contains(p_table, addr) || p_table->count >= p_table->capacity)
+    {
+        return false;
+    }
+
+    p_table->p_addrs[p_table->count++] = addr;
+    return true;
+}
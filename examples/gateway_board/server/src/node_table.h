@@ -0,0 +1,35 @@
+#ifndef NODE_TABLE_H__
+#define NODE_TABLE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Set of node addresses the gateway has heard from. Fixed capacity; once
+ * full, further nodes are not tracked and never reported as new. No SDK
+ * dependencies (benchmarked in tools/iaq_bench.c).
+ */
+
+typedef struct
+{
+    uint16_t * p_addrs;
+    uint16_t capacity;
+    uint16_t count;
+} node_table_t;
+
+/** @brief Define an empty table with room for capacity addresses. */
+#define NODE_TABLE_DEF(name, capacity)                          \
+    static uint16_t name##_addrs[capacity];                     \
+    static node_table_t name = { name##_addrs, (capacity), 0 }
+
+/**
+ * @brief Add an address to the table.
+ *
+ * @return true if the address was added: false if it was already in the
+ *         table, or if the table is full.
+ */
+bool node_table_add(node_table_t * p_table, uint16_t addr);
+
+bool node_table_contains(const node_table_t * p_table, uint16_t addr);
+
+#endif /* NODE_TABLE_H__ */
@@ -0,0 +1,29 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "power_model.h"
+
+uint32_t power_model_avg_ua(const power_model_times_t * p_times)
+{
+    if (p_times->total == 0)
+    {
+        return 0;
+    }
+
+    uint64_t charge = (p_times->total - p_times->active) * APP_POWER_SLEEP_UA +
+                      p_times->active * APP_POWER_CPU_UA +
+                      p_times->twi * APP_POWER_TWI_UA +
+                      p_times->uart * APP_POWER_UART_UA +
+                      (p_times->radio_rx_permille * APP_POWER_RADIO_RX_UA) / 1000 +
+                      p_times->radio_tx * APP_POWER_RADIO_TX_UA;
+    return (uint32_t)(charge / p_times->total);
+}
+
+uint16_t power_model_duty_permille(const power_model_times_t * p_times)
+{
+    if (p_times->total == 0)
+    {
+        return 0;
+    }
+    return (uint16_t)((p_times->active * 1000) / p_times->total);
+}
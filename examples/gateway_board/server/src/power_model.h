@@ -0,0 +1,65 @@
+#ifndef POWER_MODEL_H__
+#define POWER_MODEL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Average current from the time spent in each power state.
+ *
+ * Each state's time is multiplied by a nominal current (nRF52832 at 3 V with
+ * DC/DC enabled; adjust APP_POWER_*_UA for other boards) and the sum divided
+ * by the total time. app_power.c feeds it the times it measured on the node;
+ * tools/power_model.c feeds it the times a profile's configured intervals
+ * imply, so both report from the same currents. No SDK dependencies.
+ */
+
+/* Nominal currents in microamps. */
+#ifndef APP_POWER_SLEEP_UA
+#define APP_POWER_SLEEP_UA              3       /* System ON, RTC running */
+#endif
+#ifndef APP_POWER_CPU_UA
+#define APP_POWER_CPU_UA                3700    /* CPU running from flash */
+#endif
+#ifndef APP_POWER_TWI_UA
+#define APP_POWER_TWI_UA                400     /* TWI enabled, HFCLK on */
+#endif
+#ifndef APP_POWER_UART_UA
+#define APP_POWER_UART_UA               600     /* UART enabled, HFCLK on */
+#endif
+#ifndef APP_POWER_RADIO_RX_UA
+#define APP_POWER_RADIO_RX_UA           5400    /* Radio scanning */
+#endif
+#ifndef APP_POWER_RADIO_TX_UA
+#define APP_POWER_RADIO_TX_UA           5300    /* Radio transmitting at 0 dBm */
+#endif
+
+/* Time per state, all in the same unit (RTC ticks, microseconds). The states
+ * overlap: the CPU may run while the TWI or the radio is on. */
+typedef struct
+{
+    uint64_t total;
+    uint64_t active;                /* CPU running; the rest of total is sleep */
+    uint64_t twi;                   /* TWI enabled */
+    uint64_t uart;                  /* UART enabled */
+    uint64_t radio_rx_permille;     /* Radio RX time weighted by its duty cycle, time * per mille */
+    uint64_t radio_tx;              /* Radio transmitting */
+} power_model_times_t;
+
+/** @brief Average current in microamps over p_times->total; 0 if no time has passed. */
+uint32_t power_model_avg_ua(const power_model_times_t * p_times);
+
+/** @brief CPU active time per mille of the total. */
+uint16_t power_model_duty_permille(const power_model_times_t * p_times);
+
+/**
+ * @brief Radio RX duty cycle of an LPN, in per mille: one receive window per
+ * poll. The receive delay before the window is spent asleep.
+ */
+static inline uint16_t power_model_lpn_rx_permille(uint32_t receive_window_ms, uint32_t poll_interval_ms)
+{
+    uint32_t permille = (1000UL * receive_window_ms) / poll_interval_ms;
+    return (uint16_t)((permille > 1000) ? 1000 : permille);
+}
+
+#endif /* POWER_MODEL_H__ */
@@ -0,0 +1,88 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "publish_retry.h"
+
+static void pop(publish_retry_t * p_retry)
+{
+    p_retry->head = (uint8_t)((p_retry->head + 1) % PUBLISH_RETRY_QUEUE_SIZE);
+    p_retry->count--;
+    if (p_retry->count == 0)
+    {
+        p_retry->backoff_ms = PUBLISH_RETRY_BACKOFF_MIN_MS;
+    }
+}
+
+void publish_retry_init(publish_retry_t * p_retry)
+{
+    memset(p_retry, 0, sizeof(*p_retry));
+    p_retry->backoff_ms = PUBLISH_RETRY_BACKOFF_MIN_MS;
+}
+
+void publish_retry_push(publish_retry_t * p_retry, const uint8_t * p_payload, uint8_t length,
+                        uint32_t timestamp_s, publish_retry_spill_t spill, void * p_context)
+{
+    publish_retry_entry_t * p_entry;
+
+    if (length > PUBLISH_RETRY_PAYLOAD_MAX)
+    {
+        length = PUBLISH_RETRY_PAYLOAD_MAX;
+    }
+
+    if (p_retry->count < PUBLISH_RETRY_QUEUE_SIZE)
+    {
+        p_entry = &p_retry->entries[(p_retry->head + p_retry->count) % PUBLISH_RETRY_QUEUE_SIZE];
+        p_retry->count++;
+    }
+    else
+    {
+        /* The head keeps its place so the oldest reading still goes first */
+        p_entry = &p_retry->entries[(p_retry->head + p_retry->count - 1) % PUBLISH_RETRY_QUEUE_SIZE];
+        p_retry->coalesced++;
+        spill(p_entry, p_context);
+    }
+
+    memcpy(p_entry->payload, p_payload, length);
+    p_entry->length = length;
+    p_entry->attempts = 0;
+    p_entry->timestamp_s = timestamp_s;
+}
+
+uint32_t publish_retry_run(publish_retry_t * p_retry, publish_retry_send_t send,
+                           publish_retry_spill_t spill, void * p_context)
+{
+    while (p_retry->count > 0)
+    {
+        publish_retry_entry_t * p_entry = &p_retry->entries[p_retry->head];
+        uint32_t status = send(p_entry->payload, p_entry->length, p_context);
+
+        if (status != 0)
+        {
+            p_entry->attempts++;
+            if (p_entry->attempts < PUBLISH_RETRY_MAX_ATTEMPTS)
+            {
+                publish_retry_backoff(p_retry);
+                return status;
+            }
+            p_retry->dropped++;
+            spill(p_entry, p_context);
+        }
+        pop(p_retry);
+    }
+    return 0;
+}
+
+void publish_retry_backoff(publish_retry_t * p_retry)
+{
+    p_retry->backoff_ms *= 2;
+    if (p_retry->backoff_ms > PUBLISH_RETRY_BACKOFF_MAX_MS)
+    {
+        p_retry->backoff_ms = PUBLISH_RETRY_BACKOFF_MAX_MS;
+    }
+}
+
+uint32_t publish_retry_delay_ms(const publish_retry_t * p_retry, uint32_t random)
+{
+    return p_retry->backoff_ms + random % (p_retry->backoff_ms / 4 + 1);
+}
@@ -0,0 +1,91 @@
+#ifndef PUBLISH_RETRY_H__
+#define PUBLISH_RETRY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Retry queue for live readings that hit a transient publish error.
+ *
+ * Readings wait in capture order and are sent again oldest first. Each failed
+ * attempt doubles the delay before the next one, from
+ * PUBLISH_RETRY_BACKOFF_MIN_MS up to PUBLISH_RETRY_BACKOFF_MAX_MS, and the
+ * delay drops back to the minimum once the queue is drained. No reading is
+ * lost to the queue itself: when it is full the newest queued reading makes
+ * room for the new one, and a reading that failed PUBLISH_RETRY_MAX_ATTEMPTS
+ * times is given up; both are handed to the caller's spill function, which
+ * puts them in the flash store for backfill (mesh_vendor_model.c).
+ *
+ * No SDK dependencies; tools/publish_retry_check.c injects publish errors.
+ */
+
+#ifndef PUBLISH_RETRY_QUEUE_SIZE
+#define PUBLISH_RETRY_QUEUE_SIZE        4
+#endif
+#ifndef PUBLISH_RETRY_BACKOFF_MIN_MS
+#define PUBLISH_RETRY_BACKOFF_MIN_MS    100
+#endif
+#ifndef PUBLISH_RETRY_BACKOFF_MAX_MS
+#define PUBLISH_RETRY_BACKOFF_MAX_MS    8000
+#endif
+#ifndef PUBLISH_RETRY_MAX_ATTEMPTS
+#define PUBLISH_RETRY_MAX_ATTEMPTS      8
+#endif
+#define PUBLISH_RETRY_PAYLOAD_MAX       8
+
+typedef struct
+{
+    uint8_t payload[PUBLISH_RETRY_PAYLOAD_MAX];
+    uint8_t length;
+    uint8_t attempts;
+    uint32_t timestamp_s;       /* Capture time, for the flash store */
+} publish_retry_entry_t;
+
+typedef struct
+{
+    publish_retry_entry_t entries[PUBLISH_RETRY_QUEUE_SIZE];
+    uint8_t head;
+    uint8_t count;
+    uint32_t backoff_ms;
+    uint32_t coalesced;         /* Displaced from a full queue */
+    uint32_t dropped;           /* Given up after PUBLISH_RETRY_MAX_ATTEMPTS */
+} publish_retry_t;
+
+/** @brief Send a payload; 0 on success, otherwise the error. */
+typedef uint32_t (*publish_retry_send_t)(const uint8_t * p_payload, uint8_t length, void * p_context);
+
+/** @brief Take over a reading the queue gives up on. */
+typedef void (*publish_retry_spill_t)(const publish_retry_entry_t * p_entry, void * p_context);
+
+void publish_retry_init(publish_retry_t * p_retry);
+
+/** @brief Queue a reading. If the queue is full, the newest queued one is spilled first. */
+void publish_retry_push(publish_retry_t * p_retry, const uint8_t * p_payload, uint8_t length,
+                        uint32_t timestamp_s, publish_retry_spill_t spill, void * p_context);
+
+/**
+ * @brief Send queued readings, oldest first, until one fails or the queue is
+ * empty.
+ *
+ * A failed reading stays at the head and the backoff doubles; once it has
+ * failed PUBLISH_RETRY_MAX_ATTEMPTS times it is spilled and the next one is
+ * tried at once.
+ *
+ * @return 0 if the queue was drained, otherwise the error of the failed send;
+ *         wait publish_retry_delay_ms() before the next call.
+ */
+uint32_t publish_retry_run(publish_retry_t * p_retry, publish_retry_send_t send,
+                           publish_retry_spill_t spill, void * p_context);
+
+/** @brief Lengthen the backoff without an attempt (e.g. publication not configured). */
+void publish_retry_backoff(publish_retry_t * p_retry);
+
+/** @brief Delay before the next attempt: the backoff plus up to 25 % jitter from random. */
+uint32_t publish_retry_delay_ms(const publish_retry_t * p_retry, uint32_t random);
+
+static inline bool publish_retry_pending(const publish_retry_t * p_retry)
+{
+    return p_retry->count > 0;
+}
+
+#endif /* PUBLISH_RETRY_H__ */
@@ -0,0 +1,105 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sensor_cadence.h"
+
+#define TRIGGER_TYPE_PERCENT    0x80
+
+static uint16_t get_u16(const uint8_t * p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint8_t * put_u16(uint8_t * p, uint16_t v)
+{
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+    return p + 2;
+}
+
+bool sensor_cadence_in_fast_range(const sensor_cadence_t * p_cadence, uint16_t value)
+{
+    if (p_cadence->fast_high >= p_cadence->fast_low)
+    {
+        return value >= p_cadence->fast_low && value <= p_cadence->fast_high;
+    }
+    return value < p_cadence->fast_high || value > p_cadence->fast_low;
+}
+
+static bool triggered(const sensor_cadence_t * p_cadence, uint16_t value, uint16_t published)
+{
+    if (value == published)
+    {
+        return false;
+    }
+
+    uint32_t delta = (value > published) ? p_cadence->delta_up : p_cadence->delta_down;
+    uint32_t change = (value > published) ? (uint32_t)(value - published) : (uint32_t)(published - value);
+    if (p_cadence->trigger_percent)
+    {
+        return change * 10000u >= delta * published;
+    }
+    return change >= delta;
+}
+
+bool sensor_cadence_is_due(const sensor_cadence_t * p_cadence, uint16_t value,
+                           uint16_t published, uint32_t elapsed_ms, uint32_t period_ms)
+{
+    if (elapsed_ms == SENSOR_CADENCE_NEVER)
+    {
+        return true;
+    }
+    if (elapsed_ms < (1u << p_cadence->min_interval_log2))
+    {
+        return false;
+    }
+
+    if (period_ms > 0)
+    {
+        if (sensor_cadence_in_fast_range(p_cadence, value))
+        {
+            period_ms >>= p_cadence->fast_divisor_log2;
+        }
+        if (elapsed_ms >= period_ms)
+        {
+            return true;
+        }
+    }
+    return triggered(p_cadence, value, published);
+}
+
+uint8_t sensor_cadence_encode(const sensor_cadence_t * p_cadence, uint8_t * p_buf)
+{
+    uint8_t * p = p_buf;
+    *p++ = (uint8_t)(p_cadence->fast_divisor_log2 | (p_cadence->trigger_percent ? TRIGGER_TYPE_PERCENT : 0));
+    p = put_u16(p, p_cadence->delta_down);
+    p = put_u16(p, p_cadence->delta_up);
+    *p++ = p_cadence->min_interval_log2;
+    p = put_u16(p, p_cadence->fast_low);
+    p = put_u16(p, p_cadence->fast_high);
+    return (uint8_t)(p - p_buf);
+}
+
+bool sensor_cadence_decode(const uint8_t * p_buf, uint16_t length, sensor_cadence_t * p_cadence)
+{
+    if (length != SENSOR_CADENCE_ENCODED_LEN)
+    {
+        return false;
+    }
+
+    uint8_t fast_divisor_log2 = p_buf[0] & (uint8_t)~TRIGGER_TYPE_PERCENT;
+    if (fast_divisor_log2 > SENSOR_CADENCE_FAST_DIVISOR_LOG2_MAX ||
+        p_buf[5] > SENSOR_CADENCE_MIN_INTERVAL_LOG2_MAX)
+    {
+        return false;
+    }
+
+    p_cadence->fast_divisor_log2 = fast_divisor_log2;
+    p_cadence->trigger_percent = (p_buf[0] & TRIGGER_TYPE_PERCENT) != 0;
+    p_cadence->delta_down = get_u16(&p_buf[1]);
+    p_cadence->delta_up = get_u16(&p_buf[3]);
+    p_cadence->min_interval_log2 = p_buf[5];
+    p_cadence->fast_low = get_u16(&p_buf[6]);
+    p_cadence->fast_high = get_u16(&p_buf[8]);
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef SENSOR_CADENCE_H__
+#define SENSOR_CADENCE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Publish cadence of one sensor property, modelled on the Mesh Sensor
+ * Cadence state. A value is due for publishing when
+ *   - the publish period has elapsed; the period is divided by
+ *     2^fast_divisor_log2 while the value is in the fast cadence range, or
+ *   - it moved from the last published value by at least delta_up or
+ *     delta_down (absolute, or in 0.01 % of the published value),
+ * and never sooner than 2^min_interval_log2 ms after the last publish.
+ *
+ * The fast range is [fast_low, fast_high]; if fast_high < fast_low it is the
+ * outside of (fast_high, fast_low). Values are uint16 in the units of the
+ * property. No SDK dependencies.
+ */
+
+#define SENSOR_CADENCE_FAST_DIVISOR_LOG2_MAX    15
+#define SENSOR_CADENCE_MIN_INTERVAL_LOG2_MAX    26
+
+/* Encoded cadence as in Sensor Cadence Set/Status, after the property ID:
+ * [divisor (7 bit) | trigger type (1 bit)][delta_down u16][delta_up u16]
+ * [min_interval u8][fast_low u16][fast_high u16] */
+#define SENSOR_CADENCE_ENCODED_LEN              10
+
+/* elapsed_ms for a property that was never published: always due */
+#define SENSOR_CADENCE_NEVER                    UINT32_MAX
+
+typedef struct
+{
+    uint8_t fast_divisor_log2;
+    bool trigger_percent;       /* Deltas in 0.01 % of the published value */
+    uint16_t delta_down;
+    uint16_t delta_up;
+    uint8_t min_interval_log2;  /* 2^n ms */
+    uint16_t fast_low;
+    uint16_t fast_high;
+} sensor_cadence_t;
+
+/** @brief true if value is in the fast cadence range. */
+bool sensor_cadence_in_fast_range(const sensor_cadence_t * p_cadence, uint16_t value);
+
+/**
+ * @brief Decide whether a value is due for publishing.
+ *
+ * @param published  Last published value.
+ * @param elapsed_ms Time since it was published, or SENSOR_CADENCE_NEVER.
+ * @param period_ms  Base publish period; 0 publishes on triggers only.
+ */
+bool sensor_cadence_is_due(const sensor_cadence_t * p_cadence, uint16_t value,
+                           uint16_t published, uint32_t elapsed_ms, uint32_t period_ms);
+
+/** @brief Encode a cadence. p_buf must hold SENSOR_CADENCE_ENCODED_LEN bytes. @return Bytes written. */
+uint8_t sensor_cadence_encode(const sensor_cadence_t * p_cadence, uint8_t * p_buf);
+
+/**
+ * @brief Decode and validate a cadence.
+ *
+ * @return false on a wrong length or prohibited values; p_cadence is left untouched.
+ */
+bool sensor_cadence_decode(const uint8_t * p_buf, uint16_t length, sensor_cadence_t * p_cadence);
+
+#endif /* SENSOR_CADENCE_H__ */
@@ -0,0 +1,49 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "twi_budget.h"
+#include "env_input.h"
+
+/* zmod4xxx.c: status register, ADC result (ZMOD4410_ADC_DATA_LEN for IAQ
+ * 2nd Gen), command register */
+const twi_budget_xfer_t twi_budget_zmod_cycle[TWI_BUDGET_ZMOD_CYCLE_COUNT] =
+{
+    { "zmod_status", 1, 1 },
+    { "zmod_adc", 1, 32 },
+    { "zmod_start", 2, 0 },
+};
+
+const twi_budget_xfer_t twi_budget_env_cycle[TWI_BUDGET_ENV_CYCLE_COUNT] =
+{
+    { "sht4x_read", 0, ENV_SHT4X_RESULT_LEN },
+    { "sht4x_measure", 1, 0 },
+};
+
+uint32_t twi_budget_xfer_us(const twi_budget_xfer_t * p_xfer, uint32_t freq_hz)
+{
+    /* Start, stop, address byte and the written bytes */
+    uint32_t clocks = 2 + 9 * (1 + p_xfer->write_len);
+    uint32_t calls = 1;
+    if (p_xfer->read_len > 0)
+    {
+        if (p_xfer->write_len > 0)
+        {
+            /* Repeated start and address again, from a second driver call */
+            clocks += 1 + 9;
+            calls++;
+        }
+        clocks += 9 * p_xfer->read_len;
+    }
+
+    return (clocks * 1000000u + freq_hz - 1) / freq_hz + calls * TWI_BUDGET_XFER_OVERHEAD_US;
+}
+
+uint32_t twi_budget_cycle_us(const twi_budget_xfer_t * p_xfers, uint32_t count, uint32_t freq_hz)
+{
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        total += twi_budget_xfer_us(&p_xfers[i], freq_hz);
+    }
+    return total;
+}
@@ -0,0 +1,54 @@
+#ifndef TWI_BUDGET_H__
+#define TWI_BUDGET_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * TWI time spent per measurement cycle.
+ *
+ * The TWI is enabled once per cycle, for the ZMOD4410 and SHT4x bus windows
+ * back to back (app_twi_bus.h), and holds the HFCLK while it is. Every
+ * transfer made in those windows is listed here; tools/twi_budget_check.c
+ * sums them at each bus speed and fails if a configuration exceeds
+ * TWI_BUDGET_CYCLE_PERMILLE of the measurement interval. That is the check of
+ * the budget; tools/twi_bus_sim.c only takes the window lengths from here to
+ * drive the bus arbiter. No SDK dependencies.
+ *
+ * A transfer is a register write, optionally followed by a repeated start
+ * and a read, as hal_i2c_read()/hal_i2c_write() issue them. Each byte takes
+ * 9 clocks (8 data and ACK), start, repeated start and stop one each, plus
+ * TWI_BUDGET_XFER_OVERHEAD_US of driver setup per nrf_drv_twi call.
+ */
+
+#ifndef TWI_BUDGET_CYCLE_PERMILLE
+#define TWI_BUDGET_CYCLE_PERMILLE   10
+#endif
+#define TWI_BUDGET_XFER_OVERHEAD_US 25
+
+typedef struct
+{
+    const char * p_name;
+    uint8_t write_len;      /* Bytes after the address byte, register included */
+    uint8_t read_len;       /* 0 for a write-only transfer */
+} twi_budget_xfer_t;
+
+/* ZMOD4410 IAQ 2nd Gen, every cycle: status, ADC result, next measurement */
+extern const twi_budget_xfer_t twi_budget_zmod_cycle[];
+#define TWI_BUDGET_ZMOD_CYCLE_COUNT 3
+
+/* Local SHT4x (env_input.h): previous result, next measurement command */
+extern const twi_budget_xfer_t twi_budget_env_cycle[];
+#define TWI_BUDGET_ENV_CYCLE_COUNT  2
+
+uint32_t twi_budget_xfer_us(const twi_budget_xfer_t * p_xfer, uint32_t freq_hz);
+
+uint32_t twi_budget_cycle_us(const twi_budget_xfer_t * p_xfers, uint32_t count, uint32_t freq_hz);
+
+/** @brief Whether a window of window_us fits the budget of one interval_ms cycle. */
+static inline bool twi_budget_fits(uint32_t window_us, uint32_t interval_ms)
+{
+    return window_us <= interval_ms * TWI_BUDGET_CYCLE_PERMILLE;
+}
+
+#endif /* TWI_BUDGET_H__ */
@@ -0,0 +1,203 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "twi_bus.h"
+
+static bool time_before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+/* Account the time since the previous call */
+static void advance(twi_bus_t * p_bus, uint32_t now_us)
+{
+    p_bus->elapsed_us += now_us - p_bus->last_us;
+    p_bus->last_us = now_us;
+}
+
+static void client_stats_reset(twi_bus_client_t * p_client)
+{
+    p_client->requests = 0;
+    p_client->grants = 0;
+    p_client->misses = 0;
+    p_client->wait_max_us = 0;
+    p_client->wait_total_us = 0;
+    p_client->hold_max_us = 0;
+    p_client->hold_total_us = 0;
+}
+
+static void grant(twi_bus_t * p_bus, uint8_t client, uint32_t now_us)
+{
+    twi_bus_client_t * p_client = &p_bus->clients[client];
+    uint32_t wait = now_us - p_client->requested_us;
+
+    p_client->pending = false;
+    p_client->grants++;
+    p_client->wait_total_us += wait;
+    if (wait > p_client->wait_max_us)
+    {
+        p_client->wait_max_us = wait;
+    }
+
+    p_bus->owner = client;
+    p_bus->grant_us = now_us;
+    p_bus->busy_from_us = now_us;
+}
+
+void twi_bus_init(twi_bus_t * p_bus, uint32_t now_us)
+{
+    memset(p_bus, 0, sizeof(*p_bus));
+    p_bus->owner = TWI_BUS_CLIENT_NONE;
+    p_bus->last_us = now_us;
+}
+
+uint8_t twi_bus_client_add(twi_bus_t * p_bus, const char * p_name, uint8_t priority)
+{
+    if (p_bus->count >= TWI_BUS_CLIENTS_MAX)
+    {
+        return TWI_BUS_CLIENT_NONE;
+    }
+
+    twi_bus_client_t * p_client = &p_bus->clients[p_bus->count];
+    memset(p_client, 0, sizeof(*p_client));
+    p_client->p_name = p_name;
+    p_client->priority = priority;
+    return p_bus->count++;
+}
+
+bool twi_bus_request(twi_bus_t * p_bus, uint8_t client, uint32_t now_us, uint32_t within_us)
+{
+    twi_bus_client_t * p_client = &p_bus->clients[client];
+    uint32_t deadline_us = now_us + within_us;
+
+    advance(p_bus, now_us);
+    p_client->requests++;
+
+    if (p_client->pending)
+    {
+        if (time_before(deadline_us, p_client->deadline_us))
+        {
+            p_client->deadline_us = deadline_us;
+        }
+        return false;
+    }
+
+    p_client->pending = true;
+    p_client->requested_us = now_us;
+    p_client->deadline_us = deadline_us;
+    return true;
+}
+
+uint8_t twi_bus_grant(twi_bus_t * p_bus, uint32_t now_us)
+{
+    advance(p_bus, now_us);
+    if (p_bus->owner != TWI_BUS_CLIENT_NONE)
+    {
+        return TWI_BUS_CLIENT_NONE;
+    }
+
+    uint8_t next = TWI_BUS_CLIENT_NONE;
+    for (uint8_t i = 0; i < p_bus->count; i++)
+    {
+        const twi_bus_client_t * p_client = &p_bus->clients[i];
+        if (!p_client->pending)
+        {
+            continue;
+        }
+        if (next == TWI_BUS_CLIENT_NONE ||
+            p_client->priority > p_bus->clients[next].priority ||
+            (p_client->priority == p_bus->clients[next].priority &&
+             time_before(p_client->deadline_us, p_bus->clients[next].deadline_us)))
+        {
+            next = i;
+        }
+    }
+
+    if (next != TWI_BUS_CLIENT_NONE)
+    {
+        grant(p_bus, next, now_us);
+    }
+    return next;
+}
+
+bool twi_bus_claim(twi_bus_t * p_bus, uint8_t client, uint32_t now_us)
+{
+    advance(p_bus, now_us);
+    if (p_bus->owner != TWI_BUS_CLIENT_NONE || twi_bus_pending(p_bus))
+    {
+        return false;
+    }
+
+    twi_bus_client_t * p_client = &p_bus->clients[client];
+    p_client->requests++;
+    p_client->requested_us = now_us;
+    p_client->deadline_us = now_us;
+    grant(p_bus, client, now_us);
+    return true;
+}
+
+void twi_bus_release(twi_bus_t * p_bus, uint8_t client, uint32_t now_us)
+{
+    if (client != p_bus->owner)
+    {
+        return;
+    }
+
+    advance(p_bus, now_us);
+
+    twi_bus_client_t * p_client = &p_bus->clients[client];
+    uint32_t hold = now_us - p_bus->grant_us;
+    p_client->hold_total_us += hold;
+    if (hold > p_client->hold_max_us)
+    {
+        p_client->hold_max_us = hold;
+    }
+    if (time_before(p_client->deadline_us, now_us))
+    {
+        p_client->misses++;
+    }
+
+    p_bus->busy_us += now_us - p_bus->busy_from_us;
+    p_bus->owner = TWI_BUS_CLIENT_NONE;
+}
+
+bool twi_bus_pending(const twi_bus_t * p_bus)
+{
+    for (uint8_t i = 0; i < p_bus->count; i++)
+    {
+        if (p_bus->clients[i].pending)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint16_t twi_bus_utilization_permille(twi_bus_t * p_bus, uint32_t now_us)
+{
+    advance(p_bus, now_us);
+
+    uint64_t busy = p_bus->busy_us;
+    if (p_bus->owner != TWI_BUS_CLIENT_NONE)
+    {
+        busy += now_us - p_bus->busy_from_us;
+    }
+    if (p_bus->elapsed_us == 0)
+    {
+        return 0;
+    }
+    return (uint16_t)((busy * 1000) / p_bus->elapsed_us);
+}
+
+void twi_bus_stats_reset(twi_bus_t * p_bus, uint32_t now_us)
+{
+    for (uint8_t i = 0; i < p_bus->count; i++)
+    {
+        client_stats_reset(&p_bus->clients[i]);
+    }
+    p_bus->last_us = now_us;
+    p_bus->elapsed_us = 0;
+    p_bus->busy_us = 0;
+    p_bus->busy_from_us = now_us;
+}
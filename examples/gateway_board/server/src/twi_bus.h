@@ -0,0 +1,105 @@
+#ifndef TWI_BUS_H__
+#define TWI_BUS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Arbitration of the shared TWI bus between I2C devices.
+ *
+ * Every device on the bus is a client with a fixed priority. A client that
+ * needs the bus posts a request with a deadline; the bus is granted to one
+ * client at a time for one window (a group of transfers, e.g. a ZMOD4410
+ * cycle) and released when the window is done. Windows are not preempted, so
+ * a request waits at most for the window in progress plus the windows of
+ * higher-priority requests. Among pending requests the highest priority wins,
+ * then the earliest deadline. A request granted late is still run; it counts
+ * as a deadline miss when its window ends after the deadline.
+ *
+ * Per client this keeps requests, grants, deadline misses, wait from request
+ * to grant and time holding the bus; for the bus, time held over time
+ * elapsed. Times are microseconds from the caller's clock, which may wrap;
+ * calls must come often enough (well under 2^31 us apart) for the elapsed
+ * time to be tracked. No SDK dependencies; app_twi_bus.c runs the windows on
+ * target and tools/twi_bus_sim.c drives it with simulated devices.
+ */
+
+#ifndef TWI_BUS_CLIENTS_MAX
+#define TWI_BUS_CLIENTS_MAX     4
+#endif
+
+#define TWI_BUS_CLIENT_NONE     0xFF
+
+typedef struct
+{
+    const char * p_name;
+    uint8_t priority;           /* Higher is served first */
+    bool pending;
+    uint32_t requested_us;
+    uint32_t deadline_us;
+
+    uint32_t requests;          /* Requests merged into a pending one included */
+    uint32_t grants;
+    uint32_t misses;            /* Windows ended after their deadline */
+    uint32_t wait_max_us;       /* Request to grant */
+    uint64_t wait_total_us;
+    uint32_t hold_max_us;       /* Grant to release */
+    uint64_t hold_total_us;
+} twi_bus_client_t;
+
+typedef struct
+{
+    twi_bus_client_t clients[TWI_BUS_CLIENTS_MAX];
+    uint8_t count;
+    uint8_t owner;              /* TWI_BUS_CLIENT_NONE while idle */
+    uint32_t grant_us;
+    uint32_t busy_from_us;      /* Grant, or the stats reset during a window */
+    uint32_t last_us;
+    uint64_t elapsed_us;        /* Since init or the last stats reset */
+    uint64_t busy_us;
+} twi_bus_t;
+
+void twi_bus_init(twi_bus_t * p_bus, uint32_t now_us);
+
+/** @return Client id, or TWI_BUS_CLIENT_NONE if the table is full. */
+uint8_t twi_bus_client_add(twi_bus_t * p_bus, const char * p_name, uint8_t priority);
+
+/**
+ * @brief Ask for a window within within_us from now.
+ *
+ * A client has at most one pending request; a second one before the grant is
+ * merged into it, keeping the earlier deadline.
+ *
+ * @return false if the request was merged into a pending one.
+ */
+bool twi_bus_request(twi_bus_t * p_bus, uint8_t client, uint32_t now_us, uint32_t within_us);
+
+/**
+ * @brief Hand the idle bus to the next pending request.
+ *
+ * @return The client that now owns the bus, or TWI_BUS_CLIENT_NONE if the bus
+ *         is owned or nothing is pending.
+ */
+uint8_t twi_bus_grant(twi_bus_t * p_bus, uint32_t now_us);
+
+/**
+ * @brief Take the bus at once, outside the queue, for work that cannot wait
+ * for a grant (sensor initialization). Counted as a request granted without
+ * waiting.
+ *
+ * @return false if the bus is owned or another request is pending.
+ */
+bool twi_bus_claim(twi_bus_t * p_bus, uint8_t client, uint32_t now_us);
+
+/** @brief End the owner's window. Ignored if client does not own the bus. */
+void twi_bus_release(twi_bus_t * p_bus, uint8_t client, uint32_t now_us);
+
+bool twi_bus_pending(const twi_bus_t * p_bus);
+
+/** @brief Time the bus was held per mille of the time elapsed, up to now_us. */
+uint16_t twi_bus_utilization_permille(twi_bus_t * p_bus, uint32_t now_us);
+
+/** @brief Clear the statistics; pending requests and the owner are kept. */
+void twi_bus_stats_reset(twi_bus_t * p_bus, uint32_t now_us);
+
+#endif /* TWI_BUS_H__ */
@@ -0,0 +1,96 @@
+#ifndef ACCESS_H__
+#define ACCESS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "nrf_mesh.h"
+
+/* Host stand-in: the access layer types and calls the application uses, with
+ * the SDK's layouts. The tool that links a model provides the functions. */
+
+#define ACCESS_COMPANY_ID_NONE  (0xFFFF)
+#define ACCESS_HANDLE_INVALID   (0xFFFF)
+
+#define ACCESS_OPCODE_SIG(opcode)   { (opcode), ACCESS_COMPANY_ID_NONE }
+
+typedef uint16_t access_model_handle_t;
+
+typedef struct
+{
+    uint16_t opcode;
+    uint16_t company_id;
+} access_opcode_t;
+
+typedef struct
+{
+    uint16_t model_id;
+    uint16_t company_id;
+} access_model_id_t;
+
+typedef enum
+{
+    ACCESS_PUBLISH_RESOLUTION_100MS = 0,
+    ACCESS_PUBLISH_RESOLUTION_1S    = 1,
+    ACCESS_PUBLISH_RESOLUTION_10S   = 2,
+    ACCESS_PUBLISH_RESOLUTION_10MIN = 3,
+} access_publish_resolution_t;
+
+typedef struct
+{
+    access_opcode_t opcode;
+    const uint8_t * p_data;
+    uint16_t length;
+} access_message_rx_t;
+
+/* Receive metadata; the models here only pass it through */
+typedef struct
+{
+    uint16_t src;
+    uint16_t dst;
+    uint8_t ttl;
+} access_message_rx_meta_t;
+
+typedef struct
+{
+    access_opcode_t opcode;
+    const uint8_t * p_buffer;
+    uint16_t length;
+    bool force_segmented;
+    nrf_mesh_transmic_size_t transmic_size;
+    nrf_mesh_tx_token_t access_token;
+} access_message_tx_t;
+
+typedef void (*access_opcode_handler_cb_t)(access_model_handle_t handle,
+                                           const access_message_rx_t * p_message,
+                                           void * p_args);
+typedef void (*access_publish_timeout_cb_t)(access_model_handle_t handle, void * p_args);
+
+typedef struct
+{
+    access_opcode_t opcode;
+    access_opcode_handler_cb_t handler;
+} access_opcode_handler_t;
+
+typedef struct
+{
+    access_model_id_t model_id;
+    uint16_t element_index;
+    const access_opcode_handler_t * p_opcode_handlers;
+    uint32_t opcode_count;
+    void * p_args;
+    access_publish_timeout_cb_t publish_timeout_cb;
+} access_model_add_params_t;
+
+uint32_t access_model_add(const access_model_add_params_t * p_model_params,
+                          access_model_handle_t * p_model_handle);
+uint32_t access_model_subscription_list_alloc(access_model_handle_t handle);
+uint32_t access_model_subscription_lists_share(access_model_handle_t owner, access_model_handle_t other);
+uint32_t access_model_publish(access_model_handle_t handle, const access_message_tx_t * p_message);
+uint32_t access_model_reply(access_model_handle_t handle, const access_message_rx_t * p_message,
+                            const access_message_tx_t * p_reply);
+uint32_t access_model_publish_period_get(access_model_handle_t handle,
+                                         access_publish_resolution_t * p_resolution,
+                                         uint8_t * p_step_number);
+
+#endif /* ACCESS_H__ */
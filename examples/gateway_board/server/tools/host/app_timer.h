@@ -0,0 +1,33 @@
+#ifndef APP_TIMER_H__
+#define APP_TIMER_H__
+
+#include <stdint.h>
+
+/* Host stand-in for the SDK's app_timer: a 24-bit RTC counter at 32768 Hz,
+ * driven by the tool that defines these functions. */
+
+#define APP_TIMER_CLOCK_FREQ 32768
+
+#define APP_TIMER_TICKS(ms) ((uint32_t)((((uint64_t)(ms)) * APP_TIMER_CLOCK_FREQ + 500) / 1000))
+
+typedef uint32_t ret_code_t;    /* sdk_errors.h */
+
+typedef enum
+{
+    APP_TIMER_MODE_SINGLE_SHOT,
+    APP_TIMER_MODE_REPEATED
+} app_timer_mode_t;
+
+typedef struct app_timer_s * app_timer_id_t;
+typedef void (*app_timer_timeout_handler_t)(void * p_context);
+
+#define APP_TIMER_DEF(timer_id) static app_timer_id_t timer_id
+
+uint32_t app_timer_cnt_get(void);
+uint32_t app_timer_cnt_diff_compute(uint32_t ticks_to, uint32_t ticks_from);
+
+ret_code_t app_timer_create(app_timer_id_t const * p_timer_id, app_timer_mode_t mode,
+                            app_timer_timeout_handler_t timeout_handler);
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void * p_context);
+
+#endif /* APP_TIMER_H__ */
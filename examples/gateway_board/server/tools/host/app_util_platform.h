@@ -0,0 +1,10 @@
+#ifndef APP_UTIL_PLATFORM_H__
+#define APP_UTIL_PLATFORM_H__
+
+/* Host stand-in: the tools inject interrupts between statements, never inside
+ * a critical region, so the region only has to keep its braces. */
+
+#define CRITICAL_REGION_ENTER() {
+#define CRITICAL_REGION_EXIT()  }
+
+#endif /* APP_UTIL_PLATFORM_H__ */
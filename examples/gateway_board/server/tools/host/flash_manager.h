@@ -0,0 +1,102 @@
+#ifndef FLASH_MANAGER_H__
+#define FLASH_MANAGER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Host stand-in for the mesh flash_manager: the types and calls the
+ * application uses, implemented by the tool that links against it
+ * (iaq_store_sim.c). */
+
+#define FLASH_MANAGER_PAGE_SIZE     4096
+
+typedef uint16_t fm_handle_t;
+
+typedef struct
+{
+    uint16_t len_words;     /* Header included */
+    fm_handle_t handle;
+} fm_header_t;
+
+typedef struct
+{
+    fm_header_t header;
+    uint32_t data[];
+} fm_entry_t;
+
+typedef struct
+{
+    uint8_t raw[FLASH_MANAGER_PAGE_SIZE];
+} flash_manager_page_t;
+
+typedef struct
+{
+    fm_handle_t mask;
+    fm_handle_t match;
+} fm_handle_filter_t;
+
+typedef enum
+{
+    FM_RESULT_SUCCESS,
+    FM_RESULT_ERROR_AREA_FULL,
+    FM_RESULT_ERROR_NOT_FOUND,
+    FM_RESULT_ERROR_FLASH_MALFUNCTION
+} fm_result_t;
+
+typedef enum
+{
+    FM_ITERATE_ACTION_CONTINUE,
+    FM_ITERATE_ACTION_STOP
+} fm_iterate_action_t;
+
+typedef enum
+{
+    FM_STATE_UNINITIALIZED,
+    FM_STATE_BUILDING,
+    FM_STATE_READY,
+    FM_STATE_DEFRAG,
+    FM_STATE_REMOVING
+} fm_state_t;
+
+typedef struct flash_manager flash_manager_t;
+
+typedef void (*flash_manager_write_complete_cb_t)(const flash_manager_t * p_manager,
+                                                  const fm_entry_t * p_entry,
+                                                  fm_result_t result);
+typedef void (*flash_manager_invalidate_complete_cb_t)(const flash_manager_t * p_manager,
+                                                       fm_handle_t handle,
+                                                       fm_result_t result);
+typedef void (*flash_manager_remove_complete_cb_t)(const flash_manager_t * p_manager);
+typedef fm_iterate_action_t (*flash_manager_read_cb_t)(const fm_entry_t * p_entry, void * p_args);
+
+typedef struct
+{
+    const flash_manager_page_t * p_area;
+    uint32_t page_count;
+    uint32_t min_available_space;
+    flash_manager_write_complete_cb_t write_complete_cb;
+    flash_manager_invalidate_complete_cb_t invalidate_complete_cb;
+    flash_manager_remove_complete_cb_t remove_complete_cb;
+} flash_manager_config_t;
+
+typedef struct
+{
+    fm_state_t state;
+} flash_manager_internal_state_t;
+
+struct flash_manager
+{
+    flash_manager_internal_state_t internal;
+    flash_manager_config_t config;
+};
+
+uint32_t flash_manager_add(flash_manager_t * p_manager, const flash_manager_config_t * p_config);
+const fm_entry_t * flash_manager_entry_get(const flash_manager_t * p_manager, fm_handle_t handle);
+uint32_t flash_manager_entry_read(const flash_manager_t * p_manager, fm_handle_t handle,
+                                  void * p_data, uint32_t * p_length);
+uint32_t flash_manager_entries_read(const flash_manager_t * p_manager, const fm_handle_filter_t * p_filter,
+                                    flash_manager_read_cb_t callback, void * p_args);
+fm_entry_t * flash_manager_entry_alloc(flash_manager_t * p_manager, fm_handle_t handle, uint32_t data_length);
+void flash_manager_entry_commit(const fm_entry_t * p_entry);
+
+#endif /* FLASH_MANAGER_H__ */
@@ -0,0 +1,17 @@
+#ifndef LOG_H__
+#define LOG_H__
+
+#include <stdio.h>
+
+/* Host stand-in: the tools check behaviour, not log output. The arguments are
+ * still compiled, as on the target. */
+
+#define LOG_SRC_APP         0
+#define LOG_LEVEL_ERROR     1
+#define LOG_LEVEL_WARN      2
+#define LOG_LEVEL_INFO      3
+#define LOG_LEVEL_DBG1      4
+
+#define __LOG(source, level, ...)   do { if (0) { (void)(source); (void)(level); printf(__VA_ARGS__); } } while (0)
+
+#endif /* LOG_H__ */
@@ -0,0 +1,11 @@
+#ifndef NRF_ERROR_H__
+#define NRF_ERROR_H__
+
+/* Host stand-in with the SDK's values for the codes the tools see. */
+
+#define NRF_SUCCESS                 (0x0)
+#define NRF_ERROR_NO_MEM            (0x4)
+#define NRF_ERROR_NOT_FOUND         (0x5)
+#define NRF_ERROR_INVALID_LENGTH    (0x9)
+
+#endif /* NRF_ERROR_H__ */
@@ -0,0 +1,24 @@
+#ifndef NRF_MESH_H__
+#define NRF_MESH_H__
+
+#include <stdint.h>
+
+/* Host stand-in: tx tokens and the TransMIC size; the tool provides the token
+ * source. */
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(a)   (sizeof(a) / sizeof((a)[0]))
+#endif
+
+typedef uint32_t nrf_mesh_tx_token_t;
+
+typedef enum
+{
+    NRF_MESH_TRANSMIC_SIZE_SMALL,
+    NRF_MESH_TRANSMIC_SIZE_LARGE,
+    NRF_MESH_TRANSMIC_SIZE_DEFAULT,
+} nrf_mesh_transmic_size_t;
+
+nrf_mesh_tx_token_t nrf_mesh_unique_token_get(void);
+
+#endif /* NRF_MESH_H__ */
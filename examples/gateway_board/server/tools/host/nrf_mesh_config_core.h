@@ -0,0 +1,8 @@
+#ifndef NRF_MESH_CONFIG_CORE_H__
+#define NRF_MESH_CONFIG_CORE_H__
+
+/* Host stand-in: the application profile, without the mesh core defaults. */
+
+#include "nrf_mesh_config_app.h"
+
+#endif /* NRF_MESH_CONFIG_CORE_H__ */
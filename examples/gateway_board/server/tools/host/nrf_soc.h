@@ -0,0 +1,10 @@
+#ifndef NRF_SOC_H__
+#define NRF_SOC_H__
+
+#include <stdint.h>
+
+/* Host stand-in: the tool's sd_app_evt_wait() sleeps until its next event. */
+
+uint32_t sd_app_evt_wait(void);
+
+#endif /* NRF_SOC_H__ */
@@ -0,0 +1,231 @@
+#ifndef SENSOR_SETUP_SERVER_H__
+#define SENSOR_SETUP_SERVER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "access.h"
+#include "nrf_mesh.h"
+
+/* Host stand-in: the SDK Sensor Setup Server (models/model_spec/sensor) types,
+ * message layouts and calls the application uses, with the SDK's layouts. The
+ * tool that links a sensor server provides the functions and drives the
+ * callbacks as the model's opcode handlers would. */
+
+#define SENSOR_SERVER_MODEL_ID          0x1100
+#define SENSOR_SETUP_SERVER_MODEL_ID    0x1101
+
+#define SENSOR_NO_PROPERTY_ID           (0)
+#define SENSOR_DESCRIPTOR_MSG_SIZE      (8)
+#define SENSOR_CADENCE_SET_MINLEN       8
+
+typedef enum
+{
+    SENSOR_OPCODE_DESCRIPTOR_GET = 0x8230,
+    SENSOR_OPCODE_DESCRIPTOR_STATUS = 0x51,
+    SENSOR_OPCODE_GET = 0x8231,
+    SENSOR_OPCODE_STATUS = 0x52,
+    SENSOR_OPCODE_COLUMN_GET = 0x8232,
+    SENSOR_OPCODE_COLUMN_STATUS = 0x53,
+    SENSOR_OPCODE_SERIES_GET = 0x8233,
+    SENSOR_OPCODE_SERIES_STATUS = 0x54,
+    SENSOR_OPCODE_CADENCE_GET = 0x8234,
+    SENSOR_OPCODE_CADENCE_SET = 0x55,
+    SENSOR_OPCODE_CADENCE_SET_UNACKNOWLEDGED = 0x56,
+    SENSOR_OPCODE_CADENCE_STATUS = 0x57,
+    SENSOR_OPCODE_SETTINGS_GET = 0x8235,
+    SENSOR_OPCODE_SETTINGS_STATUS = 0x58,
+    SENSOR_OPCODE_SETTING_GET = 0x8236,
+    SENSOR_OPCODE_SETTING_SET = 0x59,
+    SENSOR_OPCODE_SETTING_SET_UNACKNOWLEDGED = 0x5A,
+    SENSOR_OPCODE_SETTING_STATUS = 0x5B,
+} sensor_opcode_t;
+
+/* ---- Messages (sensor_messages.h) ---- */
+
+typedef struct __attribute((packed))
+{
+    uint64_t sensor_property_id : 16;
+    uint64_t sensor_positive_tolerance : 12;
+    uint64_t sensor_negative_tolerance : 12;
+    uint64_t sensor_sampling_function : 8;
+    uint64_t sensor_measurement_period : 8;
+    uint64_t sensor_update_interval : 8;
+} sensor_descriptor_pkt_t;
+
+typedef union __attribute((packed))
+{
+    uint16_t property_id;
+    sensor_descriptor_pkt_t descriptors;
+} sensor_descriptor_status_msg_pkt_t;
+
+typedef uint8_t sensor_status_msg_pkt_t;
+typedef uint8_t sensor_cadence_status_msg_pkt_t;
+
+typedef struct __attribute((packed))
+{
+    uint16_t property_id;
+} sensor_cadence_set_msg_pkt_t;
+
+typedef struct __attribute((packed))
+{
+    uint16_t property_id;
+    uint8_t raw_value_x[];
+} sensor_column_get_msg_pkt_t;
+
+typedef struct __attribute((packed))
+{
+    uint16_t property_id;
+    uint8_t raw_value_xwy[];
+} sensor_column_status_msg_pkt_t;
+
+typedef struct __attribute((packed))
+{
+    uint16_t property_id;
+    uint8_t raw_value_x1x2[];
+} sensor_series_get_msg_pkt_t;
+
+typedef struct __attribute((packed))
+{
+    uint16_t property_id;
+    uint8_t raw_value_xwy[];
+} sensor_series_status_msg_pkt_t;
+
+typedef struct __attribute((packed))
+{
+    uint16_t property_id;
+    uint16_t setting_property_ids[];
+} sensor_settings_status_msg_pkt_t;
+
+typedef struct __attribute((packed))
+{
+    uint16_t property_id;
+    uint16_t setting_property_id;
+    uint8_t setting_raw[];
+} sensor_setting_set_msg_pkt_t;
+
+typedef struct __attribute((packed))
+{
+    uint16_t property_id;
+    uint16_t setting_property_id;
+    uint8_t setting_access;
+    uint8_t setting_raw[];
+} sensor_setting_status_msg_pkt_t;
+
+/* ---- Models ---- */
+
+typedef struct __sensor_setup_server_t sensor_setup_server_t;
+
+typedef void (*sensor_descriptor_get_cb_t)(const sensor_setup_server_t * p_self,
+                                           const access_message_rx_meta_t * p_meta,
+                                           uint16_t property_id,
+                                           sensor_descriptor_status_msg_pkt_t ** pp_out,
+                                           uint16_t * p_out_bytes);
+typedef void (*sensor_state_get_cb_t)(const sensor_setup_server_t * p_self,
+                                      const access_message_rx_meta_t * p_meta,
+                                      uint16_t property_id,
+                                      sensor_status_msg_pkt_t ** pp_out,
+                                      uint16_t * p_out_bytes);
+typedef void (*sensor_column_get_cb_t)(const sensor_setup_server_t * p_self,
+                                       const access_message_rx_meta_t * p_meta,
+                                       const sensor_column_get_msg_pkt_t * p_in,
+                                       uint16_t in_bytes,
+                                       sensor_column_status_msg_pkt_t ** pp_out,
+                                       uint16_t * p_out_bytes);
+typedef void (*sensor_series_get_cb_t)(const sensor_setup_server_t * p_self,
+                                       const access_message_rx_meta_t * p_meta,
+                                       const sensor_series_get_msg_pkt_t * p_in,
+                                       uint16_t in_bytes,
+                                       sensor_series_status_msg_pkt_t ** pp_out,
+                                       uint16_t * p_out_bytes);
+typedef void (*sensor_cadence_get_cb_t)(const sensor_setup_server_t * p_self,
+                                        const access_message_rx_meta_t * p_meta,
+                                        uint16_t property_id,
+                                        sensor_cadence_status_msg_pkt_t ** pp_out,
+                                        uint16_t * p_out_bytes);
+typedef void (*sensor_cadence_set_cb_t)(const sensor_setup_server_t * p_self,
+                                        const access_message_rx_meta_t * p_meta,
+                                        uint16_t property_id,
+                                        const sensor_cadence_set_msg_pkt_t * p_in,
+                                        uint16_t in_bytes,
+                                        sensor_cadence_status_msg_pkt_t ** pp_out,
+                                        uint16_t * p_out_bytes);
+typedef void (*sensor_settings_get_cb_t)(const sensor_setup_server_t * p_self,
+                                         const access_message_rx_meta_t * p_meta,
+                                         uint16_t property_id,
+                                         sensor_settings_status_msg_pkt_t ** pp_out,
+                                         uint16_t * p_out_bytes);
+typedef void (*sensor_setting_get_cb_t)(const sensor_setup_server_t * p_self,
+                                        const access_message_rx_meta_t * p_meta,
+                                        uint16_t property_id,
+                                        uint16_t setting_property_id,
+                                        sensor_setting_status_msg_pkt_t ** pp_out,
+                                        uint16_t * p_out_bytes);
+typedef void (*sensor_setting_set_cb_t)(const sensor_setup_server_t * p_self,
+                                        const access_message_rx_meta_t * p_meta,
+                                        uint16_t property_id,
+                                        uint16_t setting_property_id,
+                                        const sensor_setting_set_msg_pkt_t * p_in,
+                                        uint16_t in_bytes,
+                                        sensor_setting_status_msg_pkt_t ** pp_out,
+                                        uint16_t * p_out_bytes);
+typedef void (*sensor_publication_schedule_cb_t)(const sensor_setup_server_t * p_self);
+
+typedef struct
+{
+    sensor_descriptor_get_cb_t descriptor_get_cb;
+    sensor_state_get_cb_t get_cb;
+    sensor_column_get_cb_t column_get_cb;
+    sensor_series_get_cb_t series_get_cb;
+    sensor_cadence_get_cb_t cadence_get_cb;
+    sensor_cadence_set_cb_t cadence_set_cb;
+    sensor_settings_get_cb_t settings_get_cb;
+    sensor_setting_get_cb_t setting_get_cb;
+    sensor_setting_set_cb_t setting_set_cb;
+    sensor_publication_schedule_cb_t publication_schedule_cb;
+} sensor_setup_server_cbs_t;
+
+typedef struct
+{
+    sensor_setup_server_cbs_t sensor_cbs;
+} sensor_setup_server_callbacks_t;
+
+typedef struct
+{
+    bool force_segmented;
+    nrf_mesh_transmic_size_t transmic_size;
+} sensor_server_settings_t;
+
+typedef struct
+{
+    access_model_handle_t model_handle;
+    sensor_server_settings_t settings;
+} sensor_server_t;
+
+typedef struct
+{
+    uint16_t element_index;
+    bool force_segmented;
+    nrf_mesh_transmic_size_t transmic_size;
+    uint16_t * property_array;
+    const sensor_setup_server_callbacks_t * p_callbacks;
+} sensor_setup_server_settings_t;
+
+struct __sensor_setup_server_t
+{
+    access_model_handle_t model_handle;
+    sensor_server_t sensor_srv;
+    sensor_setup_server_settings_t settings;
+};
+
+uint32_t sensor_setup_server_init(sensor_setup_server_t * p_server, uint16_t element_index);
+uint32_t sensor_server_status_publish(const sensor_server_t * p_server,
+                                      const sensor_status_msg_pkt_t * p_data,
+                                      uint16_t data_length,
+                                      sensor_opcode_t status_opcode);
+uint32_t sensor_server_setup_status_publish(const sensor_setup_server_t * p_s_server,
+                                            const uint8_t * p_data,
+                                            uint16_t data_length,
+                                            sensor_opcode_t status_opcode);
+
+#endif /* SENSOR_SETUP_SERVER_H__ */
@@ -0,0 +1,270 @@
+/*
+ * Host benchmarks of the per-message data path.
+ *
+ * Covers what every reading goes through between the sensor and the UART:
+ * the publish decision (iaq_sample_due), payload packing and decoding
+ * (iaq_codec), the gateway's node table lookup and the UART line formatting.
+ * The ext_* benchmarks cover extended telemetry (iaq_ext): ext_check is what
+ * it adds to every measurement, the rest runs once per message.
+ * Inputs are fixed, so runs are comparable; each result is the best of
+ * BENCH_REPETITIONS runs to keep scheduling noise out.
+ *
+ * Build and compare against the stored baseline:
+ *
+ *   cc -O2 -I../src -o iaq_bench iaq_bench.c \
+ *      ../src/iaq_sample.c ../src/sensor_cadence.c ../src/iaq_codec.c ../src/node_table.c \
+ *      ../src/iaq_ext.c
+ *   ./iaq_bench > iaq_bench.txt
+ *   cmake -DRESULT_FILE=iaq_bench.txt -DBASELINE_FILE=iaq_bench_baseline.txt \
+ *         -P ../cmake/bench_compare.cmake
+ *
+ * Output, one line per benchmark: <name> <ns per op> <iterations>
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "iaq_sample.h"
+#include "iaq_codec.h"
+#include "node_table.h"
+#include "iaq_ext.h"
+
+#define BENCH_MIN_TIME_S    0.1
+#define BENCH_REPETITIONS   10
+#define SAMPLE_COUNT        64      /* Power of two, inputs are indexed with a mask */
+#define EXT_PERIOD_MS       300000  /* APP_SENSOR_IAQ_EXT_PERIOD_S default */
+
+/* Keep the compiler from optimising the measured work away */
+#define BENCH_CLOBBER()     __asm__ volatile("" : : : "memory")
+
+typedef void (*bench_fn_t)(uint32_t iterations);
+
+static iaq_sample_t m_samples[SAMPLE_COUNT];
+static uint8_t m_payloads[SAMPLE_COUNT][IAQ_CODEC_VALUES_LEN];
+static uint16_t m_addrs[SAMPLE_COUNT];
+static iaq_ext_values_t m_ext;
+static volatile uint32_t m_sink;
+
+/* Fixed pseudo-random inputs in the ranges seen on real nodes */
+static void inputs_init(void)
+{
+    uint32_t lcg = 12345;
+    for (uint32_t i = 0; i < SAMPLE_COUNT; i++)
+    {
+        lcg = lcg * 1103515245u + 12345u;
+        m_samples[i].iaq_x10 = (uint16_t)(10 + (lcg >> 16) % 60);
+        m_samples[i].tvoc_x100 = (uint16_t)(10 + (lcg >> 8) % 200);
+        m_samples[i].eco2 = (uint16_t)(400 + (lcg >> 4) % 1200);
+        iaq_codec_meta_t meta = { .seq = (uint8_t)i };
+        (void)iaq_codec_values_pack(&m_samples[i], &meta, m_payloads[i]);
+    }
+
+    /* Magnitudes as the IAQ 2nd Gen library reports them, all fields on */
+    m_ext.fields = IAQ_EXT_FIELD_ETOH | IAQ_EXT_FIELD_LOG_RCDA | IAQ_EXT_FIELD_REL_IAQ | IAQ_EXT_FIELD_RMOX;
+    m_ext.etoh = 0.85f;
+    m_ext.log_rcda = 5.62f;
+    m_ext.rel_iaq = 104.0f;
+    m_ext.rmox_count = IAQ_EXT_RMOX_MAX;
+    for (uint32_t i = 0; i < IAQ_EXT_RMOX_MAX; i++)
+    {
+        m_ext.rmox[i] = 150000.0f + 23456.7f * (float)i;
+    }
+}
+
+static void bench_publish_decision(uint32_t iterations)
+{
+    sensor_cadence_t cadence[IAQ_SAMPLE_PROPERTY_COUNT];
+    iaq_sample_t last = m_samples[0];
+    uint32_t last_ms = 0;
+    uint32_t published = 0;
+
+    iaq_sample_cadence_default(cadence);
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        /* One measurement per second against a one minute publish period */
+        const iaq_sample_t * p_sample = &m_samples[i & (SAMPLE_COUNT - 1)];
+        uint32_t now_ms = i * 1000;
+        if (iaq_sample_due(cadence, &last, now_ms - last_ms, 60000, p_sample) != 0)
+        {
+            last = *p_sample;
+            last_ms = now_ms;
+            published++;
+        }
+        BENCH_CLOBBER();
+    }
+    m_sink = published;
+}
+
+static void bench_values_pack(uint32_t iterations)
+{
+    uint8_t buf[IAQ_CODEC_VALUES_LEN];
+    iaq_codec_meta_t meta = { 0 };
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        meta.seq = (uint8_t)i;
+        total += iaq_codec_values_pack(&m_samples[i & (SAMPLE_COUNT - 1)], &meta, buf);
+        BENCH_CLOBBER();
+    }
+    m_sink = total + buf[0];
+}
+
+static void bench_values_unpack(uint32_t iterations)
+{
+    iaq_sample_t sample;
+    iaq_codec_meta_t meta;
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        (void)iaq_codec_values_unpack(m_payloads[i & (SAMPLE_COUNT - 1)], IAQ_CODEC_VALUES_LEN,
+                                      &sample, &meta);
+        total += sample.eco2 + meta.level;
+        BENCH_CLOBBER();
+    }
+    m_sink = total;
+}
+
+/* Steady state on the gateway: every node is known, lookups hit */
+static void bench_node_table(uint16_t node_count, uint32_t iterations)
+{
+    static uint16_t addrs[256];
+    node_table_t table = { addrs, node_count, 0 };
+    for (uint16_t i = 0; i < node_count; i++)
+    {
+        (void)node_table_add(&table, (uint16_t)(0x0100 + i));
+    }
+
+    uint32_t first = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        first += node_table_add(&table, (uint16_t)(0x0100 + m_addrs[i & (SAMPLE_COUNT - 1)] % node_count));
+        BENCH_CLOBBER();
+    }
+    m_sink = first;
+}
+
+static void bench_node_table_10(uint32_t iterations)
+{
+    bench_node_table(10, iterations);
+}
+
+static void bench_node_table_200(uint32_t iterations)
+{
+    bench_node_table(200, iterations);
+}
+
+static void bench_format_values(uint32_t iterations)
+{
+    char buf[IAQ_CODEC_LINE_MAX];
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        uint32_t index = i & (SAMPLE_COUNT - 1);
+        total += (uint32_t)iaq_codec_format_values(buf, sizeof(buf), m_addrs[index], &m_samples[index]);
+        BENCH_CLOBBER();
+    }
+    m_sink = total;
+}
+
+/* The node's per-measurement hook: one due check per second, and a copy of
+ * the results when a message is due */
+static void bench_ext_check(uint32_t iterations)
+{
+    static iaq_ext_values_t captured;
+    uint32_t next_ms = 0;
+    uint32_t captures = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        if (iaq_ext_due(&next_ms, i * 1000, EXT_PERIOD_MS))
+        {
+            captured = m_ext;
+            captures++;
+        }
+        BENCH_CLOBBER();
+    }
+    m_sink = captures + captured.fields;
+}
+
+static void bench_ext_pack(uint32_t iterations)
+{
+    uint8_t buf[IAQ_EXT_PAYLOAD_MAX];
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        total += iaq_ext_pack(&m_ext, (uint8_t)i, i, buf);
+        BENCH_CLOBBER();
+    }
+    m_sink = total + buf[0];
+}
+
+static void bench_ext_format(uint32_t iterations)
+{
+    char buf[IAQ_EXT_LINE_MAX];
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        total += (uint32_t)iaq_ext_format(buf, sizeof(buf), m_addrs[i & (SAMPLE_COUNT - 1)], (uint8_t)i, i, &m_ext);
+        BENCH_CLOBBER();
+    }
+    m_sink = total;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static double time_run(bench_fn_t fn, uint32_t iterations)
+{
+    double start = now_s();
+    fn(iterations);
+    return now_s() - start;
+}
+
+static void bench_run(const char * p_name, bench_fn_t fn)
+{
+    /* Grow the iteration count until one run takes long enough to time */
+    uint32_t iterations = 1000;
+    while (time_run(fn, iterations) < BENCH_MIN_TIME_S && iterations < (1u << 30))
+    {
+        iterations *= 2;
+    }
+
+    double best = time_run(fn, iterations);
+    for (uint32_t i = 1; i < BENCH_REPETITIONS; i++)
+    {
+        double elapsed = time_run(fn, iterations);
+        if (elapsed < best)
+        {
+            best = elapsed;
+        }
+    }
+
+    printf("%-24s %10.2f %12u\n", p_name, best * 1e9 / iterations, iterations);
+}
+
+int main(void)
+{
+    inputs_init();
+    for (uint32_t i = 0; i < SAMPLE_COUNT; i++)
+    {
+        m_addrs[i] = (uint16_t)((i * 37u) & 0xFF);
+    }
+
+    printf("# benchmark                 ns/op   iterations\n");
+    bench_run("publish_decision", bench_publish_decision);
+    bench_run("values_pack", bench_values_pack);
+    bench_run("values_unpack", bench_values_unpack);
+    bench_run("node_table_10", bench_node_table_10);
+    bench_run("node_table_200", bench_node_table_200);
+    bench_run("format_values", bench_format_values);
+    bench_run("ext_check", bench_ext_check);
+    bench_run("ext_pack", bench_ext_pack);
+    bench_run("ext_format", bench_ext_format);
+    return 0;
+}
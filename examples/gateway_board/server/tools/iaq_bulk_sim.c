@@ -0,0 +1,689 @@
+/*
+ * Host simulation of history backfill over a lossy mesh link.
+ *
+ * Drains a full store of readings from one node to the gateway while the node
+ * keeps publishing live readings, once with the legacy History message (8
+ * uncompressed samples per measurement, dropped from the store as soon as the
+ * publish is accepted) and once with Bulk Data (src/iaq_bulk.h), using the
+ * node's own writer, reader and sender flow control.
+ *
+ * The radio model is deliberately coarse: the node's advertiser sends one PDU
+ * at a time, each taking -a ms of air time (network transmit count times the
+ * advertising interval); every segment and every acknowledgement is lost with
+ * probability -l. Segmented messages follow the transport SAR scheme: the
+ * gateway acknowledges the segments it has after each round, the node resends
+ * the rest, and gives up after SAR_ROUNDS rounds. Live readings queue behind
+ * whatever segments are already in the advertiser, which is what the latency
+ * figures measure.
+ *
+ * With -A, an IAQ alarm is raised every so often during the bulk drain and its
+ * latency is measured up to the end of its line on the gateway UART (115200
+ * baud, where every forwarded sample is a line of its own). "plain" sends the
+ * alarm like a live reading: once, in advertiser order, and behind every
+ * queued UART line. "fast" is the alarm path of the firmware: an acknowledged
+ * alert that the access layer retransmits every RELIABLE_RETX_MS until the
+ * gateway answers, with backfill held while it is in flight, and a UART line
+ * that waits for at most one history line.
+ *
+ * Build (window and pacing are compile-time, as on the node):
+ *
+ *   cc -O2 -I../src -I../include [-DIAQ_BULK_WINDOW=4 -DIAQ_BULK_MIN_GAP_MS=1000 ...] \
+ *      -o iaq_bulk_sim iaq_bulk_sim.c ../src/iaq_bulk.c
+ *
+ * Usage:
+ *
+ *   iaq_bulk_sim [-n <samples>] [-l <loss>] [-a <pdu_ms>] [-m <meas_ms>] [-b <bytes>] [-s <seed>]
+ *                [-A <alarm_ms>]
+ *
+ *   -n  stored readings to drain (default APP_IAQ_STORE_CAPACITY)
+ *   -l  PDU loss probability (default 0.1)
+ *   -a  advertiser air time per PDU in ms (default 60)
+ *   -m  measurement interval in ms, one live reading and one backfill step each (default 3000)
+ *   -b  largest Bulk Data payload in bytes (default 253, MESH_VENDOR_BULK_PAYLOAD_MAX)
+ *   -s  random seed (default 1)
+ *   -A  raise an alarm this often during the drain and report its latency (default 0, none)
+ *
+ * With the defaults (seed 1, IAQ_BULK_WINDOW 2, IAQ_BULK_MIN_GAP_MS 2000):
+ * legacy drains in 142 s at 16.8 B/sample, bulk in 33 s at 6.9 B/sample, and
+ * live readings see a p99 of 60 ms, one PDU. A single lost Bulk Ack costs a
+ * go-back, so bulk varies with the seed: 19-43 s over seeds 1-8, and a p99
+ * of 111 ms when a live reading lands behind a segment.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iaq_bulk.h"
+
+#define BULK_PAYLOAD_MAX    253     /* MESH_VENDOR_BULK_PAYLOAD_MAX */
+#define LEGACY_BATCH        8       /* Former MESH_VENDOR_HISTORY_BATCH_MAX */
+#define LEGACY_HEADER_LEN   5
+#define LEGACY_RECORD_LEN   12
+
+#define ACCESS_OVERHEAD     7       /* 3 byte vendor opcode, 4 byte TransMIC */
+#define SEGMENT_BYTES       12
+#define SAR_ROUNDS          4
+#define SAR_ACK_MS          350     /* Segment ack timer plus the ack's way back */
+#define GATEWAY_ACK_MS      50      /* Bulk Data received to Bulk Ack sent */
+#define SAR_SESSIONS        4
+#define QUEUE_LEN           256
+
+#define ALERT_TIMEOUT_MS    6000    /* MESH_VENDOR_ALERT_TIMEOUT_MS */
+#define RELIABLE_RETX_MS    500     /* access_reliable retransmit interval */
+#define ALERT_ATTEMPTS      3       /* MESH_VENDOR_ALERT_ATTEMPTS */
+#define UART_BYTES_PER_MS   11.52
+#define LIVE_LINE_BYTES     60
+#define HIST_LINE_BYTES     95
+#define ALERT_LINE_BYTES    100
+#define LIMIT_MS            (6u * 3600u * 1000u)
+
+typedef enum
+{
+    MODE_LEGACY,
+    MODE_BULK
+} sim_mode_t;
+
+typedef enum
+{
+    ALARM_NONE,
+    ALARM_PLAIN,
+    ALARM_FAST
+} alarm_mode_t;
+
+typedef struct
+{
+    uint32_t samples;
+    double loss;
+    uint32_t pdu_ms;
+    uint32_t meas_ms;
+    uint16_t payload_max;
+    uint32_t alarm_ms;
+} sim_config_t;
+
+typedef struct
+{
+    bool live;
+    bool alarm;
+    uint8_t session;
+    uint8_t segment;
+    uint32_t queued_ms;
+} pdu_t;
+
+typedef struct
+{
+    bool active;
+    bool delivered;             /* Whole message at the gateway */
+    uint8_t segments;
+    uint8_t round;
+    uint8_t in_air;             /* Segments of this round still in the advertiser */
+    uint32_t gateway_mask;
+    uint32_t known_mask;        /* What the node learnt from segment acks */
+    uint32_t check_ms;          /* 0: no round outstanding */
+    uint16_t length;
+    uint8_t payload[BULK_PAYLOAD_MAX];
+} sar_session_t;
+
+typedef struct
+{
+    uint32_t arrive_ms;
+    uint8_t transfer;
+    uint32_t first_seq;
+} pending_ack_t;
+
+typedef struct
+{
+    uint32_t drain_ms;
+    uint32_t delivered;
+    uint32_t duplicates;
+    uint32_t lost;
+    uint32_t segments;
+    uint32_t sar_failures;
+    uint32_t timeouts;
+    uint32_t live;
+    uint32_t latency_p50;
+    uint32_t latency_p99;
+    uint32_t latency_max;
+    uint32_t alarms;
+    uint32_t alarms_missed;
+    uint32_t alarm_p50;
+    uint32_t alarm_p99;
+    uint32_t alarm_max;
+} sim_result_t;
+
+/* Gateway UART: lines committed to the UART FIFO, and history lines waiting
+ * in the bulk lane when it is used */
+typedef struct
+{
+    bool bulk_lane;
+    double free_ms;             /* Committed lines sent by then */
+    uint32_t bulk_lines;
+} uart_model_t;
+
+static double uart_line(uart_model_t * p_uart, uint32_t now, uint32_t bytes)
+{
+    double start = (p_uart->free_ms > now) ? p_uart->free_ms : now;
+    p_uart->free_ms = start + bytes / UART_BYTES_PER_MS;
+    return p_uart->free_ms;
+}
+
+static void uart_history(uart_model_t * p_uart, uint32_t now, uint32_t lines)
+{
+    if (!p_uart->bulk_lane)
+    {
+        (void)uart_line(p_uart, now, lines * HIST_LINE_BYTES);
+        return;
+    }
+    p_uart->bulk_lines += lines;
+}
+
+static void uart_pump(uart_model_t * p_uart, uint32_t now)
+{
+    if (p_uart->bulk_lines > 0 && p_uart->free_ms <= now)
+    {
+        (void)uart_line(p_uart, now, HIST_LINE_BYTES);
+        p_uart->bulk_lines--;
+    }
+}
+
+static uint64_t m_rng;
+
+static double rand_unit(void)
+{
+    m_rng ^= m_rng << 13;
+    m_rng ^= m_rng >> 7;
+    m_rng ^= m_rng << 17;
+    return (double)(m_rng >> 11) / (double)(1ull << 53);
+}
+
+static app_iaq_store_sample_t * m_samples;
+static uint32_t m_oldest;               /* Store: first sample not yet freed */
+
+static void samples_generate(uint32_t count, uint32_t meas_ms)
+{
+    int32_t iaq = 150, tvoc = 80, eco2 = 600;
+
+    m_samples = calloc(count, sizeof(*m_samples));
+    for (uint32_t i = 0; i < count; i++)
+    {
+        iaq += (int32_t)(rand_unit() * 21.0) - 10;
+        tvoc += (int32_t)(rand_unit() * 11.0) - 5;
+        eco2 += (int32_t)(rand_unit() * 41.0) - 20;
+        iaq = iaq < 10 ? 10 : (iaq > 5000 ? 5000 : iaq);
+        tvoc = tvoc < 0 ? 0 : tvoc;
+        eco2 = eco2 < 400 ? 400 : eco2;
+
+        m_samples[i].seq = i;
+        m_samples[i].boot = 1;
+        m_samples[i].timestamp_s = i * meas_ms / 1000;
+        m_samples[i].value.iaq_x10 = (uint16_t)iaq;
+        m_samples[i].value.tvoc_x100 = (uint16_t)tvoc;
+        m_samples[i].value.eco2 = (uint16_t)eco2;
+    }
+}
+
+static int compare_u32(const void * p_a, const void * p_b)
+{
+    uint32_t a = *(const uint32_t *)p_a;
+    uint32_t b = *(const uint32_t *)p_b;
+    return (a > b) - (a < b);
+}
+
+static void run(sim_mode_t mode, alarm_mode_t alarm_mode, const sim_config_t * p_config, sim_result_t * p_result)
+{
+    static pdu_t s_queue[QUEUE_LEN];
+    static sar_session_t s_sar[SAR_SESSIONS];
+    static pending_ack_t s_acks[SAR_SESSIONS * 2];
+    uint32_t queue_head = 0, queue_count = 0;
+    uint32_t ack_count = 0;
+
+    uint32_t * p_latency = calloc(LIMIT_MS / p_config->meas_ms + 1, sizeof(uint32_t));
+    uint8_t * p_received = calloc(p_config->samples, 1);
+    uint32_t * p_alarm_latency = calloc(p_config->alarm_ms ? LIMIT_MS / p_config->alarm_ms + 1 : 1, sizeof(uint32_t));
+
+    /* Current alarm; a new one replaces it */
+    bool alarm_active = false;          /* fast: not acknowledged or given up yet */
+    bool alarm_delivered = true;
+    uint32_t alarm_detect_ms = 0;
+    uint32_t alarm_retx_ms = 0;
+    uint32_t alarm_ack_ms = 0;          /* 0: no ack on its way */
+    uint32_t alarm_delivered_count = 0;
+
+    uart_model_t uart = { .bulk_lane = (alarm_mode == ALARM_FAST) };
+
+    iaq_bulk_sender_t sender;
+    iaq_bulk_sender_init(&sender);
+
+    memset(s_sar, 0, sizeof(s_sar));
+    memset(p_result, 0, sizeof(*p_result));
+    m_oldest = 0;
+
+    bool busy = false;
+    pdu_t on_air = { 0 };
+    uint32_t air_done_ms = 0;
+
+    uint32_t now;
+    for (now = 0; now < LIMIT_MS; now++)
+    {
+        /* Alarm raised by the measurement handler */
+        if (alarm_mode != ALARM_NONE && now > 0 && now % p_config->alarm_ms == 0)
+        {
+            if (!alarm_delivered)
+            {
+                p_result->alarms_missed++;
+            }
+            p_result->alarms++;
+            alarm_delivered = false;
+            alarm_detect_ms = now;
+            alarm_active = (alarm_mode == ALARM_FAST);
+            alarm_retx_ms = now + RELIABLE_RETX_MS;
+            alarm_ack_ms = 0;
+            if (queue_count < QUEUE_LEN)
+            {
+                s_queue[(queue_head + queue_count++) % QUEUE_LEN] = (pdu_t){ .alarm = true, .queued_ms = now };
+            }
+        }
+
+        /* Alert retransmissions until acknowledged or given up */
+        if (alarm_active)
+        {
+            if (alarm_ack_ms != 0 && now >= alarm_ack_ms)
+            {
+                alarm_active = false;
+            }
+            else if (now - alarm_detect_ms >= ALERT_TIMEOUT_MS * ALERT_ATTEMPTS)
+            {
+                alarm_active = false;
+            }
+            else if (now >= alarm_retx_ms)
+            {
+                alarm_retx_ms = now + RELIABLE_RETX_MS;
+                if (queue_count < QUEUE_LEN)
+                {
+                    s_queue[(queue_head + queue_count++) % QUEUE_LEN] = (pdu_t){ .alarm = true, .queued_ms = now };
+                }
+            }
+        }
+
+        /* Measurement: live reading first, then one backfill step */
+        if (now % p_config->meas_ms == 0)
+        {
+            if (queue_count < QUEUE_LEN)
+            {
+                s_queue[(queue_head + queue_count++) % QUEUE_LEN] = (pdu_t){ .live = true, .queued_ms = now };
+            }
+
+            int free_session = -1;
+            for (int i = 0; i < SAR_SESSIONS; i++)
+            {
+                if (!s_sar[i].active)
+                {
+                    free_session = i;
+                    break;
+                }
+            }
+
+            sar_session_t * p_sar = free_session >= 0 ? &s_sar[free_session] : NULL;
+            uint32_t first_seq = 0;
+            bool start = false;
+
+            if (mode == MODE_LEGACY)
+            {
+                /* The store was acked as soon as the publish was accepted */
+                if (p_sar != NULL && m_oldest < p_config->samples)
+                {
+                    uint32_t count = p_config->samples - m_oldest;
+                    count = count > LEGACY_BATCH ? LEGACY_BATCH : count;
+                    p_sar->length = (uint16_t)(LEGACY_HEADER_LEN + count * LEGACY_RECORD_LEN);
+                    p_sar->payload[0] = (uint8_t)count;
+                    memcpy(&p_sar->payload[1], &m_oldest, sizeof(m_oldest));
+                    m_oldest += count;
+                    start = true;
+                }
+            }
+            else
+            {
+                (void)iaq_bulk_sender_check_timeout(&sender, now);
+                if (p_sar != NULL && m_oldest < p_config->samples && !alarm_active &&
+                    iaq_bulk_sender_ready(&sender, m_oldest, now, &first_seq) &&
+                    first_seq < p_config->samples)
+                {
+                    iaq_bulk_writer_t writer;
+                    iaq_bulk_writer_init(&writer, p_sar->payload, p_config->payload_max, sender.next_transfer);
+                    for (uint32_t seq = first_seq; seq < p_config->samples; seq++)
+                    {
+                        if (!iaq_bulk_writer_add(&writer, &m_samples[seq]))
+                        {
+                            break;
+                        }
+                    }
+                    p_sar->length = writer.length;
+                    (void)iaq_bulk_sender_sent(&sender, first_seq, writer.count, now);
+                    start = true;
+                }
+            }
+
+            if (start)
+            {
+                p_sar->active = true;
+                p_sar->delivered = false;
+                p_sar->segments = (uint8_t)((p_sar->length + ACCESS_OVERHEAD + SEGMENT_BYTES - 1) / SEGMENT_BYTES);
+                p_sar->round = 1;
+                p_sar->gateway_mask = 0;
+                p_sar->known_mask = 0;
+                p_sar->check_ms = 0;
+                p_sar->in_air = p_sar->segments;
+                for (uint8_t i = 0; i < p_sar->segments && queue_count < QUEUE_LEN; i++)
+                {
+                    s_queue[(queue_head + queue_count++) % QUEUE_LEN] =
+                        (pdu_t){ .session = (uint8_t)free_session, .segment = i, .queued_ms = now };
+                }
+            }
+        }
+
+        /* Advertiser */
+        if (busy && now >= air_done_ms)
+        {
+            busy = false;
+            if (on_air.live)
+            {
+                p_latency[p_result->live++] = now - on_air.queued_ms;
+                if (rand_unit() >= p_config->loss)
+                {
+                    (void)uart_line(&uart, now, LIVE_LINE_BYTES);
+                }
+            }
+            else if (on_air.alarm)
+            {
+                if (rand_unit() >= p_config->loss)
+                {
+                    /* The gateway forwards each alert once and acknowledges every copy */
+                    if (!alarm_delivered)
+                    {
+                        alarm_delivered = true;
+                        p_alarm_latency[alarm_delivered_count++] =
+                            (uint32_t)(uart_line(&uart, now, ALERT_LINE_BYTES) - alarm_detect_ms);
+                    }
+                    if (alarm_active && alarm_ack_ms == 0 && rand_unit() >= p_config->loss)
+                    {
+                        alarm_ack_ms = now + GATEWAY_ACK_MS;
+                    }
+                }
+            }
+            else
+            {
+                sar_session_t * p_sar = &s_sar[on_air.session];
+                p_result->segments++;
+                if (rand_unit() >= p_config->loss)
+                {
+                    p_sar->gateway_mask |= 1u << on_air.segment;
+                }
+                if (--p_sar->in_air == 0)
+                {
+                    p_sar->check_ms = now + SAR_ACK_MS;
+                }
+
+                uint32_t all = (p_sar->segments == 32) ? UINT32_MAX : (1u << p_sar->segments) - 1;
+                if (!p_sar->delivered && p_sar->gateway_mask == all)
+                {
+                    p_sar->delivered = true;
+                    if (mode == MODE_LEGACY)
+                    {
+                        uint32_t first;
+                        memcpy(&first, &p_sar->payload[1], sizeof(first));
+                        for (uint32_t i = 0; i < p_sar->payload[0]; i++)
+                        {
+                            p_received[first + i]++;
+                        }
+                        uart_history(&uart, now, p_sar->payload[0]);
+                    }
+                    else
+                    {
+                        iaq_bulk_reader_t reader;
+                        app_iaq_store_sample_t sample;
+                        if (iaq_bulk_reader_init(&reader, p_sar->payload, p_sar->length))
+                        {
+                            uint32_t first = reader.last.seq;
+                            uint8_t count = 0;
+                            while (iaq_bulk_reader_next(&reader, &sample))
+                            {
+                                if (memcmp(&sample, &m_samples[sample.seq], sizeof(sample)) != 0)
+                                {
+                                    fprintf(stderr, "Decode mismatch at seq %u\n", sample.seq);
+                                    exit(1);
+                                }
+                                p_received[sample.seq]++;
+                                count++;
+                            }
+                            uart_history(&uart, now, count);
+                            if (count == reader.count && ack_count < sizeof(s_acks) / sizeof(s_acks[0]) &&
+                                rand_unit() >= p_config->loss)
+                            {
+                                s_acks[ack_count++] = (pending_ack_t){ now + GATEWAY_ACK_MS, reader.transfer, first };
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        if (!busy && queue_count > 0)
+        {
+            on_air = s_queue[queue_head];
+            queue_head = (queue_head + 1) % QUEUE_LEN;
+            queue_count--;
+            air_done_ms = now + p_config->pdu_ms;
+            busy = true;
+        }
+        uart_pump(&uart, now);
+
+        /* Transport SAR rounds */
+        for (int i = 0; i < SAR_SESSIONS; i++)
+        {
+            sar_session_t * p_sar = &s_sar[i];
+            if (!p_sar->active || p_sar->check_ms == 0 || now < p_sar->check_ms)
+            {
+                continue;
+            }
+            p_sar->check_ms = 0;
+
+            if (rand_unit() >= p_config->loss)
+            {
+                p_sar->known_mask = p_sar->gateway_mask;
+            }
+            uint32_t all = (p_sar->segments == 32) ? UINT32_MAX : (1u << p_sar->segments) - 1;
+            if (p_sar->known_mask == all)
+            {
+                p_sar->active = false;
+                continue;
+            }
+            if (p_sar->round++ == SAR_ROUNDS)
+            {
+                p_sar->active = false;
+                p_result->sar_failures++;
+                continue;
+            }
+            for (uint8_t s = 0; s < p_sar->segments && queue_count < QUEUE_LEN; s++)
+            {
+                if (!(p_sar->known_mask & (1u << s)))
+                {
+                    s_queue[(queue_head + queue_count++) % QUEUE_LEN] =
+                        (pdu_t){ .session = (uint8_t)i, .segment = s, .queued_ms = now };
+                    p_sar->in_air++;
+                }
+            }
+        }
+
+        /* Bulk Acks reaching the node */
+        for (uint32_t i = 0; i < ack_count; )
+        {
+            if (now < s_acks[i].arrive_ms)
+            {
+                i++;
+                continue;
+            }
+            uint32_t delivered_seq;
+            if (iaq_bulk_sender_ack(&sender, s_acks[i].transfer, s_acks[i].first_seq, &delivered_seq) &&
+                delivered_seq > m_oldest)
+            {
+                m_oldest = delivered_seq;
+            }
+            s_acks[i] = s_acks[--ack_count];
+        }
+
+        bool sessions_idle = true;
+        for (int i = 0; i < SAR_SESSIONS; i++)
+        {
+            sessions_idle = sessions_idle && !s_sar[i].active;
+        }
+        if (m_oldest >= p_config->samples && sessions_idle && ack_count == 0)
+        {
+            break;
+        }
+    }
+
+    p_result->drain_ms = now;
+    p_result->timeouts = sender.timeouts;
+    for (uint32_t i = 0; i < p_config->samples; i++)
+    {
+        if (p_received[i] == 0)
+        {
+            p_result->lost++;
+        }
+        else
+        {
+            p_result->delivered++;
+            p_result->duplicates += p_received[i] - 1u;
+        }
+    }
+
+    if (!alarm_delivered)
+    {
+        p_result->alarms_missed++;
+    }
+    if (alarm_delivered_count > 0)
+    {
+        qsort(p_alarm_latency, alarm_delivered_count, sizeof(uint32_t), compare_u32);
+        p_result->alarm_p50 = p_alarm_latency[alarm_delivered_count / 2];
+        p_result->alarm_p99 = p_alarm_latency[(alarm_delivered_count * 99) / 100];
+        p_result->alarm_max = p_alarm_latency[alarm_delivered_count - 1];
+    }
+
+    if (p_result->live > 0)
+    {
+        qsort(p_latency, p_result->live, sizeof(uint32_t), compare_u32);
+        p_result->latency_p50 = p_latency[p_result->live / 2];
+        p_result->latency_p99 = p_latency[(p_result->live * 99) / 100];
+        p_result->latency_max = p_latency[p_result->live - 1];
+    }
+
+    free(p_latency);
+    free(p_received);
+    free(p_alarm_latency);
+}
+
+static void report(const char * p_name, const sim_result_t * p_result)
+{
+    double drain_s = p_result->drain_ms / 1000.0;
+
+    printf("%-8s %8.0f %8.2f %6u %6u %8u %8.1f %6u %6u %6u %6u %6u\n",
+           p_name, drain_s,
+           drain_s > 0 ? p_result->delivered / drain_s : 0.0,
+           p_result->lost, p_result->duplicates, p_result->segments,
+           p_result->delivered ? (double)p_result->segments * SEGMENT_BYTES / p_result->delivered : 0.0,
+           p_result->sar_failures, p_result->timeouts,
+           p_result->latency_p50, p_result->latency_p99, p_result->latency_max);
+}
+
+int main(int argc, char ** argv)
+{
+    sim_config_t config =
+    {
+        .samples = APP_IAQ_STORE_CAPACITY,
+        .loss = 0.1,
+        .pdu_ms = 60,
+        .meas_ms = 3000,
+        .payload_max = BULK_PAYLOAD_MAX,
+    };
+    uint64_t seed = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "-n") == 0)
+        {
+            config.samples = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-l") == 0)
+        {
+            config.loss = strtod(argv[i + 1], NULL);
+        }
+        else if (strcmp(argv[i], "-a") == 0)
+        {
+            config.pdu_ms = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-m") == 0)
+        {
+            config.meas_ms = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-b") == 0)
+        {
+            config.payload_max = (uint16_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-s") == 0)
+        {
+            seed = strtoull(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-A") == 0)
+        {
+            config.alarm_ms = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (argc % 2 == 0 || config.samples == 0 || config.pdu_ms == 0 || config.meas_ms == 0 ||
+        config.payload_max < IAQ_BULK_HEADER_LEN || config.payload_max > BULK_PAYLOAD_MAX)
+    {
+        fprintf(stderr, "usage: %s [-n <samples>] [-l <loss>] [-a <pdu_ms>] [-m <meas_ms>] "
+                "[-b <bytes>] [-s <seed>] [-A <alarm_ms>]\n", argv[0]);
+        return 2;
+    }
+
+    m_rng = seed * 0x9E3779B97F4A7C15ull + 1;
+    samples_generate(config.samples, config.meas_ms);
+
+    printf("%u samples, loss %.2f, %u ms per PDU, measurement every %u ms; "
+           "bulk window %u, gap %u ms, ack timeout %u ms, %u byte payload\n",
+           config.samples, config.loss, config.pdu_ms, config.meas_ms,
+           IAQ_BULK_WINDOW, IAQ_BULK_MIN_GAP_MS, IAQ_BULK_ACK_TIMEOUT_MS, config.payload_max);
+    printf("%-8s %8s %8s %6s %6s %8s %8s %6s %6s %6s %6s %6s\n",
+           "mode", "drain_s", "smp/s", "lost", "dup", "segments", "B/smp",
+           "sarerr", "tmo", "p50ms", "p99ms", "maxms");
+
+    sim_result_t result;
+    run(MODE_LEGACY, ALARM_NONE, &config, &result);
+    report("legacy", &result);
+    run(MODE_BULK, ALARM_NONE, &config, &result);
+    report("bulk", &result);
+
+    if (config.alarm_ms > 0)
+    {
+        static const char * const s_names[] = { "none", "plain", "fast" };
+
+        printf("\nAlarm every %u ms during the bulk drain, latency to the end of its UART line\n",
+               config.alarm_ms);
+        printf("%-8s %8s %8s %8s %8s %8s %8s\n", "alarm", "drain_s", "alarms", "missed", "p50ms", "p99ms", "maxms");
+        for (alarm_mode_t alarm_mode = ALARM_PLAIN; alarm_mode <= ALARM_FAST; alarm_mode++)
+        {
+            run(MODE_BULK, alarm_mode, &config, &result);
+            printf("%-8s %8.0f %8u %8u %8u %8u %8u\n", s_names[alarm_mode],
+                   result.drain_ms / 1000.0, result.alarms, result.alarms_missed,
+                   result.alarm_p50, result.alarm_p99, result.alarm_max);
+        }
+    }
+
+    free(m_samples);
+    return 0;
+}
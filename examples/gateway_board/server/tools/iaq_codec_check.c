@@ -0,0 +1,208 @@
+/*
+ * Host round trip of the Sensor Values payload (src/iaq_codec.h).
+ *
+ * Packs and decodes every iaq_x10 x eCO2 pair a field can hold, every TVOC
+ * value against every seq, and values past each field's range, with the
+ * remaining fields driven by a fixed pseudo-random sequence. Also checks that
+ * version 1 payloads still decode, that unknown versions and short payloads
+ * are rejected, and that setting flags leaves the other fields alone.
+ *
+ * Build and run; the exit status is non-zero on the first mismatch:
+ *
+ *   cc -O2 -I../src -o iaq_codec_check iaq_codec_check.c ../src/iaq_codec.c
+ *   ./iaq_codec_check
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "iaq_sample.h"
+#include "iaq_codec.h"
+
+#define FIELD_MAX(bits)     ((1u << (bits)) - 1u)
+
+static uint32_t m_lcg = 12345;
+static uint64_t m_checked;
+
+static uint32_t next_random(void)
+{
+    m_lcg = m_lcg * 1103515245u + 12345u;
+    return m_lcg >> 8;
+}
+
+static uint16_t saturate(uint32_t value, uint32_t bits)
+{
+    return (uint16_t)((value > FIELD_MAX(bits)) ? FIELD_MAX(bits) : value);
+}
+
+static void fail(const char * p_what, const iaq_sample_t * p_sample, const iaq_codec_meta_t * p_meta)
+{
+    fprintf(stderr, "FAIL %s: iaq_x10 %u tvoc_x100 %u eco2 %u flags 0x%02X seq %u prev_level %u\n",
+            p_what, p_sample->iaq_x10, p_sample->tvoc_x100, p_sample->eco2,
+            p_meta->flags, p_meta->seq, p_meta->prev_level);
+    exit(1);
+}
+
+static void round_trip(uint32_t iaq_x10, uint32_t tvoc_x100, uint32_t eco2,
+                       uint8_t flags, uint8_t seq, uint8_t prev_level)
+{
+    iaq_sample_t in = { (uint16_t)iaq_x10, (uint16_t)tvoc_x100, (uint16_t)eco2 };
+    iaq_codec_meta_t meta_in = { 0, 0, flags, seq, prev_level };
+    uint8_t buf[IAQ_CODEC_VALUES_LEN];
+
+    if (iaq_codec_values_pack(&in, &meta_in, buf) != IAQ_CODEC_VALUES_LEN)
+    {
+        fail("pack length", &in, &meta_in);
+    }
+
+    iaq_sample_t out;
+    iaq_codec_meta_t meta_out;
+    if (!iaq_codec_values_unpack(buf, IAQ_CODEC_VALUES_LEN, &out, &meta_out))
+    {
+        fail("unpack rejected", &in, &meta_in);
+    }
+
+    uint16_t iaq_expected = saturate(iaq_x10, IAQ_CODEC_IAQ_BITS);
+    if (out.iaq_x10 != iaq_expected ||
+        out.tvoc_x100 != saturate(tvoc_x100, IAQ_CODEC_TVOC_BITS) ||
+        out.eco2 != saturate(eco2, IAQ_CODEC_ECO2_BITS) ||
+        meta_out.version != IAQ_CODEC_VERSION ||
+        meta_out.level != iaq_sample_level(iaq_expected) ||
+        meta_out.flags != flags ||
+        meta_out.seq != seq ||
+        meta_out.prev_level != prev_level)
+    {
+        fail("round trip", &in, &meta_in);
+    }
+    m_checked++;
+}
+
+static void check_v1(void)
+{
+    /* [iaq_level u8][tvoc_x100 u16][eco2 u16][iaq_x10 u8] */
+    for (uint32_t level = 1; level <= IAQ_SAMPLE_LEVEL_MAX; level++)
+    {
+        for (uint32_t iaq_x10 = 0; iaq_x10 <= UINT8_MAX; iaq_x10++)
+        {
+            uint16_t tvoc_x100 = (uint16_t)next_random();
+            uint16_t eco2 = (uint16_t)(next_random() % (IAQ_SAMPLE_ECO2_MAX + 1));
+            uint8_t buf[IAQ_CODEC_VALUES_V1_LEN] =
+            {
+                (uint8_t)level, (uint8_t)tvoc_x100, (uint8_t)(tvoc_x100 >> 8),
+                (uint8_t)eco2, (uint8_t)(eco2 >> 8), (uint8_t)iaq_x10
+            };
+
+            iaq_sample_t out;
+            iaq_codec_meta_t meta;
+            iaq_sample_t in = { (uint16_t)iaq_x10, tvoc_x100, eco2 };
+            if (!iaq_codec_values_unpack(buf, sizeof(buf), &out, &meta) ||
+                meta.version != 1 || meta.level != level || meta.flags != 0 || meta.seq != 0 ||
+                meta.prev_level != 0 || out.iaq_x10 != iaq_x10 || out.tvoc_x100 != tvoc_x100 ||
+                out.eco2 != eco2)
+            {
+                fail("version 1", &in, &meta);
+            }
+            if (iaq_codec_values_unpack(buf, sizeof(buf) - 1, &out, &meta))
+            {
+                fail("short version 1 accepted", &in, &meta);
+            }
+            m_checked++;
+        }
+    }
+}
+
+static void check_rejects(void)
+{
+    iaq_sample_t sample = { 250, 1234, 800 };
+    iaq_codec_meta_t meta = { 0, 0, 0, 7, 3 };
+    uint8_t buf[IAQ_CODEC_VALUES_LEN];
+
+    (void)iaq_codec_values_pack(&sample, &meta, buf);
+    for (uint8_t length = 0; length < IAQ_CODEC_VALUES_LEN; length++)
+    {
+        if (iaq_codec_values_unpack(buf, length, &sample, &meta))
+        {
+            fail("short version 2 accepted", &sample, &meta);
+        }
+    }
+
+    for (uint32_t version = 0; version <= FIELD_MAX(IAQ_CODEC_VERSION_BITS); version++)
+    {
+        uint8_t expected = (version == 0) ? 1 : (version == IAQ_CODEC_VERSION) ? IAQ_CODEC_VERSION : 0;
+        buf[0] = (uint8_t)((version << IAQ_CODEC_VERSION_POS) | 1);
+        if (iaq_codec_values_version(buf, sizeof(buf)) != expected)
+        {
+            fail("version dispatch", &sample, &meta);
+        }
+    }
+}
+
+static void check_flags_set(void)
+{
+    for (uint32_t i = 0; i < 100000; i++)
+    {
+        uint32_t r = next_random();
+        iaq_sample_t in = { (uint16_t)(r % (IAQ_SAMPLE_IAQ_X10_MAX + 1)), (uint16_t)next_random(),
+                            (uint16_t)(next_random() % (IAQ_SAMPLE_ECO2_MAX + 1)) };
+        iaq_codec_meta_t meta_in = { 0, 0, (uint8_t)(r & FIELD_MAX(IAQ_CODEC_FLAGS_BITS)), (uint8_t)(r >> 5),
+                                     (uint8_t)((r >> 13) % (IAQ_SAMPLE_LEVEL_MAX + 1)) };
+        uint8_t added = (uint8_t)((r >> 16) & FIELD_MAX(IAQ_CODEC_FLAGS_BITS));
+        uint8_t buf[IAQ_CODEC_VALUES_LEN];
+
+        (void)iaq_codec_values_pack(&in, &meta_in, buf);
+        iaq_codec_values_flags_set(buf, added);
+
+        iaq_sample_t out;
+        iaq_codec_meta_t meta_out;
+        if (!iaq_codec_values_unpack(buf, sizeof(buf), &out, &meta_out) ||
+            meta_out.flags != (meta_in.flags | added) || meta_out.seq != meta_in.seq ||
+            meta_out.prev_level != meta_in.prev_level || out.iaq_x10 != in.iaq_x10 ||
+            out.tvoc_x100 != in.tvoc_x100 || out.eco2 != in.eco2)
+        {
+            fail("flags set", &in, &meta_in);
+        }
+        m_checked++;
+    }
+}
+
+int main(void)
+{
+    /* Every iaq_x10 x eCO2 pair the fields hold */
+    for (uint32_t iaq_x10 = 0; iaq_x10 <= FIELD_MAX(IAQ_CODEC_IAQ_BITS); iaq_x10++)
+    {
+        for (uint32_t eco2 = 0; eco2 <= FIELD_MAX(IAQ_CODEC_ECO2_BITS); eco2++)
+        {
+            uint32_t r = next_random();
+            round_trip(iaq_x10, (uint16_t)r, eco2, (uint8_t)(r & FIELD_MAX(IAQ_CODEC_FLAGS_BITS)),
+                       (uint8_t)(r >> 5), (uint8_t)((r >> 13) & FIELD_MAX(IAQ_CODEC_PREV_LEVEL_BITS)));
+        }
+    }
+
+    /* Every TVOC value against every seq, flags and previous level */
+    for (uint32_t tvoc_x100 = 0; tvoc_x100 <= UINT16_MAX; tvoc_x100++)
+    {
+        for (uint32_t seq = 0; seq <= FIELD_MAX(IAQ_CODEC_SEQ_BITS); seq++)
+        {
+            uint32_t r = next_random();
+            round_trip(r % (IAQ_SAMPLE_IAQ_X10_MAX + 1), tvoc_x100, (r >> 12) % (IAQ_SAMPLE_ECO2_MAX + 1),
+                       (uint8_t)(seq & FIELD_MAX(IAQ_CODEC_FLAGS_BITS)), (uint8_t)seq,
+                       (uint8_t)((tvoc_x100 + seq) & FIELD_MAX(IAQ_CODEC_PREV_LEVEL_BITS)));
+        }
+    }
+
+    /* Past the field ranges: sent saturated */
+    for (uint32_t value = 0; value <= UINT16_MAX; value++)
+    {
+        round_trip(value, UINT16_MAX, value, 0, 0, 0);
+    }
+
+    check_v1();
+    check_rejects();
+    check_flags_set();
+
+    printf("iaq_codec: %llu payloads OK, version %u, %u of %u bits used\n",
+           (unsigned long long)m_checked, IAQ_CODEC_VERSION, IAQ_CODEC_LAYOUT_BITS, IAQ_CODEC_VALUES_LEN * 8);
+    return 0;
+}
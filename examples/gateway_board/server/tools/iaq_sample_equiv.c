@@ -0,0 +1,397 @@
+/*
+ * Host equivalence check of the fixed-point data path (src/iaq_sample.h)
+ * against the float path it replaced.
+ *
+ * The legacy path is reproduced below as it was: validation and range check
+ * on the node, IAQ rating from the float, rounding into the version 1 payload,
+ * and the gateway's float round trip into the UART line. Float to integer
+ * casts behave as on the Cortex-M4 (VCVT truncates and saturates, then the
+ * result is narrowed). The current path is iaq_sample_from_float(), the
+ * version 2 payload round trip and iaq_codec_format_values().
+ *
+ * Each quantity is swept in fine steps over its range and past it, around
+ * every rating and rounding boundary, and through NaN, Inf and huge values.
+ * Checked:
+ *  - both paths accept the same readings, except where the legacy range check
+ *    truncated before comparing (IAQ in (-1, 0) and [500.05, 501), eCO2 in
+ *    [10000.5, 10001)) or narrowed to 16 bits (|IAQ| >= 32768, eCO2 >= 65536),
+ *    which let those readings through;
+ *  - accepted readings carry the same IAQ*10, TVOC*100 and eCO2 values;
+ *  - the rating differs only within 0.05 below a rating boundary, where the
+ *    value now rounds up into the next one;
+ *  - the publish threshold decision differs only within one rounding step
+ *    of each value of the threshold;
+ *  - the new UART line prints exactly the transmitted values. The legacy line
+ *    did not (2.3 came out as 2.2); those lines are counted, not failed.
+ *
+ * Build and run; the exit status is non-zero on a failed check:
+ *
+ *   cc -O2 -I../src -o iaq_sample_equiv iaq_sample_equiv.c ../src/iaq_sample.c \
+ *      ../src/sensor_cadence.c ../src/iaq_codec.c -lm
+ *   ./iaq_sample_equiv [-n <threshold pairs>]
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "iaq_sample.h"
+#include "iaq_codec.h"
+
+#define NODE_ADDR       0x0029
+
+typedef struct
+{
+    bool valid;
+    uint8_t level;
+    uint16_t iaq_x10;
+    uint16_t tvoc_x100;
+    uint16_t eco2;
+    char line[96];
+} result_t;
+
+typedef struct
+{
+    uint64_t readings;
+    uint64_t accepted;
+    uint64_t accept_diff;           /* In the expected bands */
+    uint64_t level_diff;            /* Within 0.05 below a boundary */
+    uint64_t legacy_line_wrong;
+} stats_t;
+
+static uint32_t m_lcg = 12345;
+static uint32_t m_failures;
+static stats_t m_stats;
+
+static uint32_t next_random(void)
+{
+    m_lcg = m_lcg * 1103515245u + 12345u;
+    return m_lcg >> 8;
+}
+
+/* The values are a reading, or a threshold pair and the threshold */
+static void check(bool ok, const char * p_what, float a, float b, float c)
+{
+    if (!ok)
+    {
+        if (m_failures < 20)
+        {
+            fprintf(stderr, "FAIL %s: %.9g, %.9g, %.9g\n", p_what, a, b, c);
+        }
+        m_failures++;
+    }
+}
+
+/* VCVT.S32.F32 and VCVT.U32.F32: truncate toward zero, saturate, NaN to 0 */
+static int32_t vcvt_s32(float val)
+{
+    if (val != val)
+    {
+        return 0;
+    }
+    if (val >= 2147483648.0f)
+    {
+        return INT32_MAX;
+    }
+    if (val <= -2147483648.0f)
+    {
+        return INT32_MIN;
+    }
+    return (int32_t)val;
+}
+
+static uint32_t vcvt_u32(float val)
+{
+    if (val != val || val <= -1.0f)
+    {
+        return 0;
+    }
+    if (val >= 4294967296.0f)
+    {
+        return UINT32_MAX;
+    }
+    return (uint32_t)val;
+}
+
+/* The node's and the gateway's code before the fixed-point conversion */
+static bool legacy_is_valid_float(float val)
+{
+    if (val != val)
+    {
+        return false;
+    }
+    if (val > 1e10f || val < -1e10f)
+    {
+        return false;
+    }
+    return true;
+}
+
+static void legacy_path(float iaq, float tvoc, float eco2, result_t * p_result)
+{
+    memset(p_result, 0, sizeof(*p_result));
+
+    if (!legacy_is_valid_float(iaq) || !legacy_is_valid_float(tvoc) || !legacy_is_valid_float(eco2))
+    {
+        return;
+    }
+    int16_t iaq_int = (int16_t)vcvt_s32(iaq);
+    uint16_t eco2_int = (uint16_t)vcvt_u32(eco2);
+    if (iaq_int < 0 || iaq_int > 500 || eco2_int > 10000)
+    {
+        return;
+    }
+    p_result->valid = true;
+
+    /* mesh_publish_sensor_values() */
+    if (iaq < 2.0f)
+        p_result->level = 1;
+    else if (iaq < 3.0f)
+        p_result->level = 2;
+    else if (iaq < 4.0f)
+        p_result->level = 3;
+    else if (iaq < 5.0f)
+        p_result->level = 4;
+    else
+        p_result->level = 5;
+
+    if (tvoc < 0.0f) tvoc = 0.0f;
+    if (tvoc > 655.35f) tvoc = 655.35f;
+    if (eco2 < 0.0f) eco2 = 0.0f;
+    if (eco2 > 65535.0f) eco2 = 65535.0f;
+
+    p_result->tvoc_x100 = (uint16_t)vcvt_u32(tvoc * 100.0f + 0.5f);
+    p_result->eco2 = (uint16_t)vcvt_u32(eco2 + 0.5f);
+    p_result->iaq_x10 = (uint8_t)vcvt_u32(iaq * 10.0f + 0.5f);
+
+    /* Gateway: decoded values back to float, then app_uart_send_iaq_data() */
+    float g_iaq = (float)p_result->iaq_x10 / 10.0f;
+    float g_tvoc = (float)p_result->tvoc_x100 / 100.0f;
+    float g_eco2 = (float)p_result->eco2;
+    snprintf(p_result->line, sizeof(p_result->line),
+             "{\"node\":\"0x%04X\",\"iaq\":%d.%d,\"tvoc\":%d.%02d,\"eco2\":%d}\n", NODE_ADDR,
+             (int)g_iaq, (int)((g_iaq - (int)g_iaq) * 10),
+             (int)g_tvoc, (int)((g_tvoc - (int)g_tvoc) * 100),
+             (int)(g_eco2 + 0.5f));
+}
+
+static void current_path(float iaq, float tvoc, float eco2, result_t * p_result)
+{
+    memset(p_result, 0, sizeof(*p_result));
+
+    iaq_sample_t sample;
+    if (!iaq_sample_from_float(iaq, tvoc, eco2, &sample))
+    {
+        return;
+    }
+    p_result->valid = true;
+
+    iaq_codec_meta_t meta = { 0 };
+    uint8_t payload[IAQ_CODEC_VALUES_LEN];
+    uint8_t length = iaq_codec_values_pack(&sample, &meta, payload);
+
+    iaq_sample_t received;
+    iaq_codec_meta_t received_meta;
+    if (!iaq_codec_values_unpack(payload, length, &received, &received_meta))
+    {
+        p_result->valid = false;
+        return;
+    }
+    p_result->level = received_meta.level;
+    p_result->iaq_x10 = received.iaq_x10;
+    p_result->tvoc_x100 = received.tvoc_x100;
+    p_result->eco2 = received.eco2;
+    (void)iaq_codec_format_values(p_result->line, sizeof(p_result->line), NODE_ADDR, &received);
+}
+
+/* The line the values should produce */
+static void exact_line(const result_t * p_result, char * p_buf, size_t size)
+{
+    snprintf(p_buf, size, "{\"node\":\"0x%04X\",\"iaq\":%u.%u,\"tvoc\":%u.%02u,\"eco2\":%u}\n", NODE_ADDR,
+             p_result->iaq_x10 / 10, p_result->iaq_x10 % 10,
+             p_result->tvoc_x100 / 100, p_result->tvoc_x100 % 100, p_result->eco2);
+}
+
+/* Where the legacy range check let a reading through: it truncated before
+ * comparing, and narrowed to 16 bits, which wraps far out-of-range values */
+static bool in_accept_band(float iaq, float eco2)
+{
+    return (iaq > -1.0f && iaq < 0.0f) || (iaq >= 500.05f && iaq < 501.0f) ||
+           (eco2 >= 10000.5f && eco2 < 10001.0f) ||
+           iaq <= -32768.0f || iaq >= 32768.0f || eco2 >= 65536.0f;
+}
+
+static void compare(float iaq, float tvoc, float eco2)
+{
+    result_t legacy;
+    result_t current;
+    legacy_path(iaq, tvoc, eco2, &legacy);
+    current_path(iaq, tvoc, eco2, &current);
+    m_stats.readings++;
+
+    if (legacy.valid != current.valid)
+    {
+        check(in_accept_band(iaq, eco2) && legacy.valid, "accepted by one path only", iaq, tvoc, eco2);
+        m_stats.accept_diff++;
+        return;
+    }
+    if (!current.valid)
+    {
+        return;
+    }
+    m_stats.accepted++;
+
+    /* The legacy payload had one byte for IAQ*10 */
+    if (current.iaq_x10 <= UINT8_MAX)
+    {
+        check(legacy.iaq_x10 == current.iaq_x10, "IAQ*10 differs", iaq, tvoc, eco2);
+    }
+    check(legacy.tvoc_x100 == current.tvoc_x100, "TVOC*100 differs", iaq, tvoc, eco2);
+    check(legacy.eco2 == current.eco2, "eCO2 differs", iaq, tvoc, eco2);
+
+    if (legacy.level != current.level)
+    {
+        float boundary = (float)(legacy.level + 1);
+        check(current.level == legacy.level + 1 && iaq >= boundary - 0.05f && iaq < boundary,
+              "rating differs away from a boundary", iaq, tvoc, eco2);
+        m_stats.level_diff++;
+    }
+
+    char expected[96];
+    exact_line(&current, expected, sizeof(expected));
+    check(strcmp(current.line, expected) == 0, "UART line does not print the values", iaq, tvoc, eco2);
+    if (current.iaq_x10 <= UINT8_MAX && strcmp(legacy.line, expected) != 0)
+    {
+        m_stats.legacy_line_wrong++;
+    }
+}
+
+/* Every step over the range, plus the neighbouring floats of each rounding
+ * and rating boundary */
+static void sweep(int quantity, float from, float to, float step, float boundary_step)
+{
+    const float nominal[3] = { 1.5f, 0.35f, 600.0f };
+    float values[3];
+
+    for (float v = from; v <= to; v += step)
+    {
+        memcpy(values, nominal, sizeof(values));
+        values[quantity] = v;
+        compare(values[0], values[1], values[2]);
+    }
+    for (float b = floorf(from / boundary_step) * boundary_step; b <= to; b += boundary_step)
+    {
+        const float edges[] = { b, b - boundary_step / 2, b + boundary_step / 2 };
+        for (uint32_t e = 0; e < sizeof(edges) / sizeof(edges[0]); e++)
+        {
+            float v = edges[e];
+            for (int k = 0; k < 3; k++)
+            {
+                v = nextafterf(v, -INFINITY);
+            }
+            for (int k = 0; k < 7; k++, v = nextafterf(v, INFINITY))
+            {
+                memcpy(values, nominal, sizeof(values));
+                values[quantity] = v;
+                compare(values[0], values[1], values[2]);
+            }
+        }
+    }
+}
+
+static void specials(void)
+{
+    const float cases[] = { NAN, -NAN, INFINITY, -INFINITY, 1e11f, -1e11f, 1e10f, -1e10f, 3.4e38f, -0.0f, 0.0f,
+                            500.0f, 500.04f, 500.05f, 500.96f, 501.0f, 10000.49f, 10000.5f, 10000.99f, 10001.0f,
+                            655.35f, 655.354f, 655.355f, 65535.0f, 70000.0f, -0.99f, -1.0f, -1.01f };
+    const uint32_t count = sizeof(cases) / sizeof(cases[0]);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        compare(cases[i], 0.35f, 600.0f);
+        compare(1.5f, cases[i], 600.0f);
+        compare(1.5f, 0.35f, cases[i]);
+        for (uint32_t j = 0; j < count; j++)
+        {
+            compare(cases[i], cases[j], cases[(i + j) % count]);
+        }
+    }
+}
+
+static float random_float(float from, float to)
+{
+    return from + (to - from) * (float)(next_random() % 1000000) / 1000000.0f;
+}
+
+/* Legacy: |a - b| >= threshold on floats; now: on the rounded steps */
+static uint32_t threshold_pairs(const char * p_name, float range, float threshold, float step,
+                                uint16_t threshold_fixed, uint32_t pairs)
+{
+    uint32_t diff = 0;
+
+    for (uint32_t i = 0; i < pairs; i++)
+    {
+        float a = random_float(0.0f, range);
+        float b = a + random_float(-2.0f * threshold, 2.0f * threshold);
+        b = (b < 0.0f) ? -b : b;
+
+        bool legacy = fabsf(a - b) >= threshold;
+        int32_t fa = (int32_t)vcvt_u32(a / step + 0.5f);
+        int32_t fb = (int32_t)vcvt_u32(b / step + 0.5f);
+        bool current = abs(fa - fb) >= threshold_fixed;
+
+        if (legacy != current)
+        {
+            check(fabsf(fabsf(a - b) - threshold) <= step * 1.001f, p_name, a, b, threshold);
+            diff++;
+        }
+    }
+    return diff;
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t pairs = 1000000;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            pairs = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n <threshold pairs>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    sweep(0, -2.0f, 30.0f, 0.0007f, 0.1f);
+    sweep(0, 490.0f, 510.0f, 0.003f, 0.1f);
+    sweep(1, -1.0f, 700.0f, 0.0007f, 0.01f);
+    sweep(2, -2.0f, 11000.0f, 0.007f, 1.0f);
+    specials();
+
+    printf("# %llu readings, %llu accepted by both paths\n", (unsigned long long)m_stats.readings,
+           (unsigned long long)m_stats.accepted);
+    printf("  accepted by the legacy path only (truncating or wrapping range check): %llu\n",
+           (unsigned long long)m_stats.accept_diff);
+    printf("  rating one higher (within 0.05 below a boundary): %llu\n", (unsigned long long)m_stats.level_diff);
+    printf("  legacy UART lines that misprinted the values: %llu\n", (unsigned long long)m_stats.legacy_line_wrong);
+
+    uint32_t iaq_diff = threshold_pairs("IAQ threshold", 5.0f, 0.5f, 0.1f, IAQ_SAMPLE_IAQ_THRESHOLD_X10, pairs);
+    uint32_t tvoc_diff = threshold_pairs("TVOC threshold", 10.0f, 0.05f, 0.01f, IAQ_SAMPLE_TVOC_THRESHOLD_X100, pairs);
+    uint32_t eco2_diff = threshold_pairs("eCO2 threshold", 5000.0f, 10.0f, 1.0f, IAQ_SAMPLE_ECO2_THRESHOLD, pairs);
+    printf("# %u pairs per quantity: threshold decision differs in %u (IAQ), %u (TVOC), %u (eCO2), "
+           "all within one step of the threshold\n", pairs, iaq_diff, tvoc_diff, eco2_diff);
+
+    if (m_failures > 0)
+    {
+        fprintf(stderr, "%u checks failed\n", m_failures);
+        return 1;
+    }
+    printf("iaq_sample: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,844 @@
+/*
+ * Flash simulator for the IAQ history store (src/app_iaq_store.c).
+ *
+ * Runs the real store against a host model of the mesh flash_manager
+ * (host/flash_manager.h) on a simulated area of APP_IAQ_STORE_FLASH_PAGE_COUNT
+ * pages. The model has the flash_manager behaviour the store relies on, not
+ * a copy of the SDK's implementation:
+ *  - entries wait in a RAM pool of -q bytes and are written one at a time,
+ *    at the nRF52832's worst-case word write time. The header goes first with
+ *    the length only, then the data, then the handle; an entry is readable
+ *    once its handle is written and the older copy of that handle is then
+ *    invalidated. An entry that does not fit the rest of a page is preceded
+ *    by padding;
+ *  - when the area is full it is compacted page by page through a recovery
+ *    page, two page erases per page at the worst-case erase time, and
+ *    nothing is written meanwhile;
+ *  - a power loss drops the RAM pool, leaves the entry being written torn
+ *    (length and part of the data, no handle) and leaves a compaction
+ *    undone, as the recovery page restores it.
+ *
+ * Every boot runs in a child process, so the store starts from its static
+ * initial state as after a reset; only the flash area survives.
+ *
+ * Benchmark: appends at a range of rates with the link down. Reports flash
+ * time per append, compactions, the longest stall from allocation to a
+ * readable entry, and samples dropped because the pool was full. Checked:
+ * at the measurement interval nothing is dropped and no stall outlasts it.
+ *
+ * Power-loss run: boots of random length, with the link down or draining
+ * history to the gateway at random, each ended by a power loss at a random
+ * point. Checked after every reboot:
+ *  - every sample that reached flash and was not acknowledged or overwritten
+ *    by the ring is pending and reads back unchanged;
+ *  - samples acknowledged with a persisted cursor are not pending;
+ *  - sequence numbers continue after the highest one in flash;
+ *  - the boot counter is one above the last persisted one.
+ * Checked during every boot: the pending count never exceeds
+ * APP_IAQ_STORE_CAPACITY, the oldest pending sample is the drain cursor or
+ * APP_IAQ_STORE_CAPACITY back from the newest once the ring has wrapped,
+ * and peeked samples are consecutive and match what was appended.
+ *
+ * Build and run; the exit status is non-zero on a failed check:
+ *
+ *   cc -O2 -Ihost -I../src -I../include -o iaq_store_sim iaq_store_sim.c ../src/app_iaq_store.c
+ *   ./iaq_store_sim [-n <power cycles>] [-q <pool bytes>]
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "app_iaq_store.h"
+#include "flash_manager.h"
+#include "nrf_error.h"
+
+/* Handle layout of app_iaq_store.c */
+#define STORE_SAMPLE_HANDLE_BASE    0x1000
+#define STORE_SAMPLE_HANDLE_MASK    0xF000
+#define STORE_META_HANDLE           0x2000
+
+#define SIM_PAGES               APP_IAQ_STORE_FLASH_PAGE_COUNT
+#define SIM_PAGE_WORDS          (FLASH_MANAGER_PAGE_SIZE / 4)
+#define SIM_PAGE_HEADER_WORDS   2
+#define SIM_PAGE_MAGIC          0x4D46u
+#define SIM_HANDLE_BLANK        0xFFFF
+#define SIM_HANDLE_PADDING      0xFFFE
+#define SIM_HANDLE_INVALID      0x0000
+#define SIM_ENTRY_WORDS_MAX     8
+#define SIM_QUEUE_SLOTS         64
+
+/* nRF52832 product specification, worst case */
+#define SIM_WRITE_NS            67500ULL
+#define SIM_ERASE_NS            89700000ULL
+
+#define STEP_NS                 1000000000ULL   /* APP_SENSOR_IAQ_MEAS_INTERVAL_MS */
+#define BACKFILL_CHUNK          40
+#define BOOT_STEPS_MAX          1000
+
+typedef enum
+{
+    PHASE_IDLE,
+    PHASE_WRITE,
+    PHASE_DEFRAG,
+} phase_t;
+
+typedef struct
+{
+    bool committed;
+    fm_handle_t handle;
+    uint16_t len_words;
+    uint64_t alloc_ns;
+    uint32_t raw[1 + SIM_ENTRY_WORDS_MAX];      /* An fm_entry_t */
+} sim_op_t;
+
+typedef struct
+{
+    uint64_t appends;
+    uint64_t dropped;
+    uint64_t defrags;
+    uint64_t area_full;
+    uint64_t busy_ns;
+    uint64_t defrag_max_ns;
+    uint64_t stall_max_ns;
+    uint64_t lost_in_ram;
+    uint64_t torn;
+    uint64_t resent;
+    uint64_t boot_reused;
+    uint64_t overwritten;
+} sim_stats_t;
+
+/* Survives a power loss: the flash area, what it holds, and the counters */
+typedef struct
+{
+    uint32_t flash[SIM_PAGES][SIM_PAGE_WORDS];
+
+    app_iaq_store_sample_t slot[APP_IAQ_STORE_CAPACITY];
+    bool slot_valid[APP_IAQ_STORE_CAPACITY];
+    bool has_samples;
+    uint32_t max_seq;
+    uint32_t drained_seq;
+    uint16_t boot;
+    bool boot_persisted;
+
+    uint32_t acked_seq;         /* Drain cursor in RAM when power was lost */
+    uint16_t last_boot;         /* Boot counter of the last samples appended */
+    uint32_t sample_counter;    /* Makes every appended sample unique */
+
+    sim_stats_t stats;
+    uint32_t failures;
+} sim_shared_t;
+
+static sim_shared_t * m_shared;
+static uint32_t m_lcg = 12345;
+static uint32_t m_pool_bytes = 256;
+
+/* RAM of the current boot */
+static flash_manager_t * mp_manager;
+static int32_t m_index[0x10000];
+static uint32_t m_wp_page;
+static uint32_t m_wp_word;
+static sim_op_t m_queue[SIM_QUEUE_SLOTS];
+static uint32_t m_queue_head;
+static uint32_t m_queue_count;
+static uint32_t m_queue_bytes;
+static phase_t m_phase;
+static uint64_t m_now_ns;
+static uint64_t m_busy_until_ns;
+static uint64_t m_write_start_ns;
+static bool m_defrag_done;
+
+static uint32_t next_random(void)
+{
+    m_lcg = m_lcg * 1103515245u + 12345u;
+    return m_lcg >> 8;
+}
+
+static void check(bool ok, const char * p_what)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL %s\n", p_what);
+        m_shared->failures++;
+    }
+}
+
+static uint32_t * word_at(int32_t pos)
+{
+    return &m_shared->flash[pos / SIM_PAGE_WORDS][pos % SIM_PAGE_WORDS];
+}
+
+static fm_handle_t header_handle(uint32_t header)
+{
+    return (fm_handle_t)(header >> 16);
+}
+
+static uint16_t header_len(uint32_t header)
+{
+    return (uint16_t)(header & 0xFFFF);
+}
+
+static bool handle_is_entry(fm_handle_t handle)
+{
+    return handle != SIM_HANDLE_BLANK && handle != SIM_HANDLE_PADDING && handle != SIM_HANDLE_INVALID;
+}
+
+/*****************************************************************************
+ * flash_manager model
+ *****************************************************************************/
+
+static void page_format(uint32_t page)
+{
+    memset(m_shared->flash[page], 0xFF, sizeof(m_shared->flash[page]));
+    m_shared->flash[page][0] = SIM_PAGE_MAGIC;
+    m_shared->flash[page][1] = page;
+}
+
+/* Rebuild the handle index and the write position from the area */
+static void index_build(void)
+{
+    memset(m_index, 0xFF, sizeof(m_index));
+    m_wp_page = 0;
+    m_wp_word = SIM_PAGE_HEADER_WORDS;
+
+    for (uint32_t page = 0; page < SIM_PAGES; page++)
+    {
+        if (m_shared->flash[page][0] != SIM_PAGE_MAGIC)
+        {
+            page_format(page);
+        }
+
+        uint32_t word = SIM_PAGE_HEADER_WORDS;
+        while (word < SIM_PAGE_WORDS && m_shared->flash[page][word] != 0xFFFFFFFF)
+        {
+            uint32_t header = m_shared->flash[page][word];
+            if (handle_is_entry(header_handle(header)))
+            {
+                /* Written in address order, so a later copy wins */
+                m_index[header_handle(header)] = (int32_t)(page * SIM_PAGE_WORDS + word);
+            }
+            word += header_len(header);
+        }
+        if (word > SIM_PAGE_HEADER_WORDS)
+        {
+            m_wp_page = page;
+            m_wp_word = word;
+        }
+    }
+}
+
+/* What the flash now holds, for the checks */
+static void truth_update(fm_handle_t handle, const uint32_t * p_data)
+{
+    if ((handle & STORE_SAMPLE_HANDLE_MASK) == STORE_SAMPLE_HANDLE_BASE)
+    {
+        const app_iaq_store_sample_t * p_sample = (const app_iaq_store_sample_t *)p_data;
+        uint32_t slot = handle - STORE_SAMPLE_HANDLE_BASE;
+        check(p_sample->seq % APP_IAQ_STORE_CAPACITY == slot, "sample in its ring slot");
+        m_shared->slot[slot] = *p_sample;
+        m_shared->slot_valid[slot] = true;
+        if (!m_shared->has_samples || p_sample->seq > m_shared->max_seq)
+        {
+            m_shared->max_seq = p_sample->seq;
+        }
+        m_shared->has_samples = true;
+    }
+    else if (handle == STORE_META_HANDLE)
+    {
+        m_shared->drained_seq = p_data[0];
+        m_shared->boot = (uint16_t)p_data[1];
+        m_shared->boot_persisted = true;
+    }
+}
+
+static void queue_pop(void)
+{
+    m_queue_bytes -= m_queue[m_queue_head].len_words * 4;
+    m_queue_head = (m_queue_head + 1) % SIM_QUEUE_SLOTS;
+    m_queue_count--;
+}
+
+static uint32_t valid_words(void)
+{
+    uint32_t words = 0;
+    for (uint32_t handle = 0; handle < 0x10000; handle++)
+    {
+        if (m_index[handle] >= 0)
+        {
+            words += header_len(*word_at(m_index[handle]));
+        }
+    }
+    return words;
+}
+
+static void defrag_complete(void)
+{
+    static uint32_t s_entries[SIM_PAGES * SIM_PAGE_WORDS];
+    uint32_t length = 0;
+
+    /* Live entries in address order, which is the order they were written */
+    for (uint32_t page = 0; page < SIM_PAGES; page++)
+    {
+        uint32_t word = SIM_PAGE_HEADER_WORDS;
+        while (word < SIM_PAGE_WORDS && m_shared->flash[page][word] != 0xFFFFFFFF)
+        {
+            uint32_t header = m_shared->flash[page][word];
+            int32_t pos = (int32_t)(page * SIM_PAGE_WORDS + word);
+            if (handle_is_entry(header_handle(header)) && m_index[header_handle(header)] == pos)
+            {
+                memcpy(&s_entries[length], &m_shared->flash[page][word], header_len(header) * 4);
+                length += header_len(header);
+            }
+            word += header_len(header);
+        }
+    }
+
+    for (uint32_t page = 0; page < SIM_PAGES; page++)
+    {
+        page_format(page);
+    }
+
+    uint32_t page = 0;
+    uint32_t word = SIM_PAGE_HEADER_WORDS;
+    for (uint32_t i = 0; i < length; i += header_len(s_entries[i]))
+    {
+        uint16_t len = header_len(s_entries[i]);
+        if (word + len > SIM_PAGE_WORDS)
+        {
+            m_shared->flash[page][word] = (uint32_t)(SIM_PAGE_WORDS - word) | ((uint32_t)SIM_HANDLE_PADDING << 16);
+            page++;
+            word = SIM_PAGE_HEADER_WORDS;
+        }
+        memcpy(&m_shared->flash[page][word], &s_entries[i], len * 4);
+        word += len;
+    }
+    index_build();
+}
+
+static void write_complete(void)
+{
+    sim_op_t * p_op = &m_queue[m_queue_head];
+    int32_t pos = (int32_t)(m_wp_page * SIM_PAGE_WORDS + m_wp_word);
+    uint32_t * p_word = word_at(pos);
+
+    memcpy(p_word + 1, &p_op->raw[1], (p_op->len_words - 1) * 4);
+    p_word[0] = p_op->len_words | ((uint32_t)p_op->handle << 16);
+    if (m_index[p_op->handle] >= 0)
+    {
+        uint32_t * p_old = word_at(m_index[p_op->handle]);
+        *p_old = header_len(*p_old) | ((uint32_t)SIM_HANDLE_INVALID << 16);
+    }
+    m_index[p_op->handle] = pos;
+    m_wp_word += p_op->len_words;
+
+    truth_update(p_op->handle, &p_op->raw[1]);
+    if (m_busy_until_ns - p_op->alloc_ns > m_shared->stats.stall_max_ns)
+    {
+        m_shared->stats.stall_max_ns = m_busy_until_ns - p_op->alloc_ns;
+    }
+    if (mp_manager->config.write_complete_cb != NULL)
+    {
+        mp_manager->config.write_complete_cb(mp_manager, (const fm_entry_t *)p_word, FM_RESULT_SUCCESS);
+    }
+    queue_pop();
+}
+
+static void op_start(uint64_t start_ns)
+{
+    sim_op_t * p_op = &m_queue[m_queue_head];
+    uint64_t duration = 0;
+
+    if (m_wp_word + p_op->len_words > SIM_PAGE_WORDS)
+    {
+        if (m_wp_word < SIM_PAGE_WORDS)
+        {
+            m_shared->flash[m_wp_page][m_wp_word] =
+                (uint32_t)(SIM_PAGE_WORDS - m_wp_word) | ((uint32_t)SIM_HANDLE_PADDING << 16);
+            duration += SIM_WRITE_NS;
+        }
+        m_wp_page++;
+        m_wp_word = SIM_PAGE_HEADER_WORDS;
+    }
+
+    if (m_wp_page >= SIM_PAGES)
+    {
+        if (m_defrag_done)
+        {
+            /* Still full after compaction */
+            m_shared->stats.area_full++;
+            m_wp_page = SIM_PAGES - 1;
+            m_wp_word = SIM_PAGE_WORDS;
+            if (mp_manager->config.write_complete_cb != NULL)
+            {
+                mp_manager->config.write_complete_cb(mp_manager, (const fm_entry_t *)p_op->raw,
+                                                     FM_RESULT_ERROR_AREA_FULL);
+            }
+            queue_pop();
+            m_defrag_done = false;
+            m_busy_until_ns = start_ns;
+            return;
+        }
+        duration += SIM_PAGES * 2 * SIM_ERASE_NS + 2 * valid_words() * SIM_WRITE_NS;
+        m_phase = PHASE_DEFRAG;
+        mp_manager->internal.state = FM_STATE_DEFRAG;
+        m_busy_until_ns = start_ns + duration;
+        m_shared->stats.busy_ns += duration;
+        if (duration > m_shared->stats.defrag_max_ns)
+        {
+            m_shared->stats.defrag_max_ns = duration;
+        }
+        return;
+    }
+
+    /* Header with the length, data, handle, and the old copy's handle */
+    m_write_start_ns = start_ns + duration;
+    duration += (p_op->len_words + 1 + (m_index[p_op->handle] >= 0 ? 1 : 0)) * SIM_WRITE_NS;
+    m_phase = PHASE_WRITE;
+    m_busy_until_ns = start_ns + duration;
+    m_shared->stats.busy_ns += duration;
+    m_defrag_done = false;
+}
+
+/* Let the flash work through its queue up to until_ns */
+static void sim_run(uint64_t until_ns)
+{
+    for (;;)
+    {
+        if (m_phase != PHASE_IDLE)
+        {
+            if (m_busy_until_ns > until_ns)
+            {
+                return;
+            }
+            if (m_phase == PHASE_WRITE)
+            {
+                write_complete();
+            }
+            else
+            {
+                defrag_complete();
+                m_shared->stats.defrags++;
+                mp_manager->internal.state = FM_STATE_READY;
+                m_defrag_done = true;
+            }
+            m_phase = PHASE_IDLE;
+        }
+
+        if (m_queue_count == 0 || !m_queue[m_queue_head].committed)
+        {
+            return;
+        }
+        sim_op_t * p_op = &m_queue[m_queue_head];
+        op_start((m_busy_until_ns > p_op->alloc_ns) ? m_busy_until_ns : p_op->alloc_ns);
+    }
+}
+
+static void sim_power_loss(uint64_t at_ns)
+{
+    sim_run(at_ns);
+
+    if (m_phase == PHASE_WRITE && at_ns > m_write_start_ns)
+    {
+        sim_op_t * p_op = &m_queue[m_queue_head];
+        uint32_t words = (uint32_t)((at_ns - m_write_start_ns) / SIM_WRITE_NS);
+        uint32_t * p_word = &m_shared->flash[m_wp_page][m_wp_word];
+        if (words > 0)
+        {
+            p_word[0] = p_op->len_words | ((uint32_t)SIM_HANDLE_BLANK << 16);
+            uint32_t data = (words - 1 < p_op->len_words - 1u) ? words - 1 : p_op->len_words - 1u;
+            memcpy(p_word + 1, &p_op->raw[1], data * 4);
+            m_shared->stats.torn++;
+        }
+    }
+
+    for (uint32_t i = 0; i < m_queue_count; i++)
+    {
+        if ((m_queue[(m_queue_head + i) % SIM_QUEUE_SLOTS].handle & STORE_SAMPLE_HANDLE_MASK) ==
+            STORE_SAMPLE_HANDLE_BASE)
+        {
+            m_shared->stats.lost_in_ram++;
+        }
+    }
+}
+
+uint32_t flash_manager_add(flash_manager_t * p_manager, const flash_manager_config_t * p_config)
+{
+    p_manager->config = *p_config;
+    p_manager->internal.state = FM_STATE_READY;
+    mp_manager = p_manager;
+    index_build();
+    return NRF_SUCCESS;
+}
+
+const fm_entry_t * flash_manager_entry_get(const flash_manager_t * p_manager, fm_handle_t handle)
+{
+    (void)p_manager;
+    return (m_index[handle] >= 0) ? (const fm_entry_t *)word_at(m_index[handle]) : NULL;
+}
+
+uint32_t flash_manager_entry_read(const flash_manager_t * p_manager, fm_handle_t handle,
+                                  void * p_data, uint32_t * p_length)
+{
+    const fm_entry_t * p_entry = flash_manager_entry_get(p_manager, handle);
+    if (p_entry == NULL)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    uint32_t length = (p_entry->header.len_words - 1u) * 4;
+    if (*p_length < length)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+    memcpy(p_data, p_entry->data, length);
+    *p_length = length;
+    return NRF_SUCCESS;
+}
+
+uint32_t flash_manager_entries_read(const flash_manager_t * p_manager, const fm_handle_filter_t * p_filter,
+                                    flash_manager_read_cb_t callback, void * p_args)
+{
+    uint32_t count = 0;
+    (void)p_manager;
+
+    for (uint32_t handle = 0; handle < 0x10000; handle++)
+    {
+        if (m_index[handle] >= 0 && (handle & p_filter->mask) == p_filter->match)
+        {
+            count++;
+            if (callback((const fm_entry_t *)word_at(m_index[handle]), p_args) == FM_ITERATE_ACTION_STOP)
+            {
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+fm_entry_t * flash_manager_entry_alloc(flash_manager_t * p_manager, fm_handle_t handle, uint32_t data_length)
+{
+    uint16_t len_words = (uint16_t)(1 + (data_length + 3) / 4);
+    (void)p_manager;
+
+    if (len_words - 1 > SIM_ENTRY_WORDS_MAX || m_queue_count == SIM_QUEUE_SLOTS ||
+        m_queue_bytes + len_words * 4u > m_pool_bytes)
+    {
+        return NULL;
+    }
+
+    sim_op_t * p_op = &m_queue[(m_queue_head + m_queue_count) % SIM_QUEUE_SLOTS];
+    memset(p_op, 0, sizeof(*p_op));
+    p_op->handle = handle;
+    p_op->len_words = len_words;
+    p_op->alloc_ns = m_now_ns;
+    p_op->raw[0] = len_words | ((uint32_t)handle << 16);
+    m_queue_count++;
+    m_queue_bytes += len_words * 4u;
+    return (fm_entry_t *)p_op->raw;
+}
+
+void flash_manager_entry_commit(const fm_entry_t * p_entry)
+{
+    for (uint32_t i = 0; i < m_queue_count; i++)
+    {
+        sim_op_t * p_op = &m_queue[(m_queue_head + i) % SIM_QUEUE_SLOTS];
+        if ((const fm_entry_t *)p_op->raw == p_entry)
+        {
+            p_op->committed = true;
+        }
+    }
+}
+
+/*****************************************************************************
+ * Boots
+ *****************************************************************************/
+
+static uint64_t m_step_ns = STEP_NS;
+static uint32_t m_next_seq;
+static uint32_t m_drained_seq;
+static bool m_boot_checked;
+
+static bool append_one(void)
+{
+    app_iaq_store_sample_t sample;
+    uint32_t counter = m_shared->sample_counter++;
+
+    memset(&sample, 0, sizeof(sample));
+    sample.timestamp_s = counter;
+    sample.value.iaq_x10 = (uint16_t)(counter % (IAQ_SAMPLE_IAQ_X10_MAX + 1));
+    sample.value.tvoc_x100 = (uint16_t)(counter * 7);
+    sample.value.eco2 = (uint16_t)(400 + counter % 2000);
+
+    uint16_t persisted_boot = m_shared->boot_persisted ? m_shared->boot : 0;
+    m_shared->stats.appends++;
+    if (!app_iaq_store_append(&sample))
+    {
+        m_shared->stats.dropped++;
+        return false;
+    }
+    check(sample.seq == m_next_seq, "sequence numbers continue");
+    m_next_seq++;
+
+    if (!m_boot_checked)
+    {
+        /* The counter write of the previous boot may have been lost with the power */
+        check(sample.boot == (uint16_t)(persisted_boot + 1), "boot counter one above the persisted one");
+        if (sample.boot == m_shared->last_boot)
+        {
+            m_shared->stats.boot_reused++;
+        }
+        m_shared->last_boot = sample.boot;
+        m_boot_checked = true;
+    }
+    return true;
+}
+
+static uint32_t expected_oldest(void)
+{
+    uint32_t oldest = (m_next_seq > APP_IAQ_STORE_CAPACITY) ? m_next_seq - APP_IAQ_STORE_CAPACITY : 0;
+    return (m_drained_seq > oldest) ? m_drained_seq : oldest;
+}
+
+/* Peek from the oldest pending sample; each must match what the flash holds */
+static uint32_t peek_check(uint32_t max_count)
+{
+    app_iaq_store_sample_t samples[BACKFILL_CHUNK];
+    uint32_t oldest = app_iaq_store_oldest_seq();
+    uint32_t total = 0;
+
+    while (total < max_count)
+    {
+        uint32_t want = (max_count - total < BACKFILL_CHUNK) ? max_count - total : BACKFILL_CHUNK;
+        uint32_t count = app_iaq_store_peek_from(oldest + total, samples, want);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t seq = oldest + total + i;
+            uint32_t slot = seq % APP_IAQ_STORE_CAPACITY;
+            check(samples[i].seq == seq, "peeked samples consecutive");
+            check(m_shared->slot_valid[slot] &&
+                  memcmp(&samples[i], &m_shared->slot[slot], sizeof(samples[i])) == 0,
+                  "peeked sample matches the flash");
+        }
+        total += count;
+        if (count < want)
+        {
+            break;
+        }
+    }
+    return total;
+}
+
+static void check_after_reboot(void)
+{
+    m_next_seq = m_shared->has_samples ? m_shared->max_seq + 1 : 0;
+    m_drained_seq = m_shared->drained_seq;
+
+    uint32_t pending = app_iaq_store_pending_count();
+    check(app_iaq_store_oldest_seq() == expected_oldest(), "drain cursor and ring rebuilt from flash");
+    check(pending == m_next_seq - expected_oldest(), "pending count rebuilt from flash");
+    check(peek_check(pending) == pending, "every pending sample in flash after reboot");
+
+    if (m_shared->acked_seq > m_drained_seq)
+    {
+        m_shared->stats.resent += m_shared->acked_seq - m_drained_seq;
+    }
+}
+
+static void backfill(void)
+{
+    uint32_t oldest = app_iaq_store_oldest_seq();
+    uint32_t count = peek_check(BACKFILL_CHUNK);
+
+    /* The gateway acknowledges most transfers */
+    if (count > 0 && next_random() % 10 < 8)
+    {
+        app_iaq_store_ack_until(oldest + count);
+        m_drained_seq = (oldest + count < m_next_seq) ? oldest + count : m_next_seq;
+    }
+}
+
+/* One boot: a sample per step, history drained while the link is up, then
+ * power lost loss_ns into the last step, or the flash left to finish */
+static void boot_run(uint32_t steps, bool link_toggles, uint64_t loss_ns)
+{
+    bool online = false;
+
+    app_iaq_store_init();
+    check_after_reboot();
+
+    for (uint32_t step = 0; step < steps; step++)
+    {
+        m_now_ns = step * m_step_ns;
+        sim_run(m_now_ns);
+
+        /* A full ring makes room by giving up its oldest pending sample */
+        bool full = app_iaq_store_pending_count() == APP_IAQ_STORE_CAPACITY;
+        if (append_one() && full)
+        {
+            m_shared->stats.overwritten++;
+        }
+
+        if (link_toggles && next_random() % 100 == 0)
+        {
+            online = !online;
+        }
+        if (online)
+        {
+            backfill();
+        }
+
+        check(app_iaq_store_pending_count() <= APP_IAQ_STORE_CAPACITY, "pending within capacity");
+        check(app_iaq_store_oldest_seq() == expected_oldest(), "oldest pending follows the ring and cursor");
+    }
+
+    if (loss_ns > 0)
+    {
+        sim_power_loss((steps - 1) * m_step_ns + loss_ns);
+    }
+    else
+    {
+        sim_run(UINT64_MAX);
+    }
+    m_shared->acked_seq = m_drained_seq;
+}
+
+/* Each boot in its own process, so the store's statics start from scratch */
+static void boot(uint32_t steps, bool link_toggles, uint64_t loss_ns)
+{
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror("fork");
+        exit(2);
+    }
+    if (pid == 0)
+    {
+        boot_run(steps, link_toggles, loss_ns);
+        fflush(stderr);
+        _exit(0);
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        fprintf(stderr, "FAIL boot did not complete\n");
+        m_shared->failures++;
+    }
+}
+
+static void shared_reset(void)
+{
+    uint32_t failures = m_shared->failures;
+    memset(m_shared, 0, sizeof(*m_shared));
+    m_shared->failures = failures;
+}
+
+static void bench(void)
+{
+    static const uint32_t intervals_us[] = { 1000000, 100000, 10000, 2000, 1000, 500 };
+    const uint32_t appends = 4 * APP_IAQ_STORE_CAPACITY * SIM_PAGES;
+
+    printf("# benchmark: %u appends, link down, %u byte pool\n", appends, m_pool_bytes);
+    printf("%11s %8s %11s %8s %13s %12s\n", "interval_us", "dropped", "us/append", "defrags",
+           "defrag_max_ms", "stall_max_ms");
+    for (uint32_t i = 0; i < sizeof(intervals_us) / sizeof(intervals_us[0]); i++)
+    {
+        shared_reset();
+        m_step_ns = intervals_us[i] * 1000ULL;
+        boot(appends, false, 0);
+
+        const sim_stats_t * p_stats = &m_shared->stats;
+        uint64_t written = p_stats->appends - p_stats->dropped;
+        printf("%11u %8llu %11.1f %8llu %13.1f %12.1f\n", intervals_us[i],
+               (unsigned long long)p_stats->dropped,
+               written ? p_stats->busy_ns / 1000.0 / written : 0.0,
+               (unsigned long long)p_stats->defrags, p_stats->defrag_max_ns / 1e6,
+               p_stats->stall_max_ns / 1e6);
+
+        check(p_stats->defrags > 0, "benchmark ran into compaction");
+        check(p_stats->area_full == 0, "compaction always makes room");
+        if (m_step_ns >= STEP_NS)
+        {
+            check(p_stats->dropped == 0, "nothing dropped at the measurement interval");
+            check(p_stats->stall_max_ns < STEP_NS, "worst stall shorter than the measurement interval");
+        }
+    }
+    m_step_ns = STEP_NS;
+}
+
+static void power_cycles(uint32_t cycles)
+{
+    shared_reset();
+    for (uint32_t i = 0; i < cycles; i++)
+    {
+        uint32_t steps = 1 + next_random() % BOOT_STEPS_MAX;
+        /* Half the losses land while the step's writes are in flight */
+        uint64_t loss_ns = (next_random() % 2) ? 1 + next_random() % 5000000 : 1 + next_random() % STEP_NS;
+        boot(steps, true, loss_ns);
+    }
+    /* One more boot checks what the last power loss left */
+    boot(1, false, 0);
+
+    const sim_stats_t * p_stats = &m_shared->stats;
+    printf("# %u power cycles: %llu appends (%llu dropped), %llu pending overwritten, %llu compactions\n", cycles,
+           (unsigned long long)p_stats->appends, (unsigned long long)p_stats->dropped,
+           (unsigned long long)p_stats->overwritten, (unsigned long long)p_stats->defrags);
+    printf("# lost at power loss: %llu samples still in RAM, %llu torn entries, %llu samples resent, "
+           "%llu boot counters reused\n",
+           (unsigned long long)p_stats->lost_in_ram, (unsigned long long)p_stats->torn,
+           (unsigned long long)p_stats->resent, (unsigned long long)p_stats->boot_reused);
+
+    check(p_stats->overwritten > 0 && p_stats->defrags > 0 && p_stats->torn > 0, "run exercised wrap, compaction and torn writes");
+    check(p_stats->area_full == 0, "compaction always makes room");
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t cycles = 300;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            cycles = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc)
+        {
+            m_pool_bytes = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n <power cycles>] [-q <pool bytes>]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (cycles == 0 || m_pool_bytes < (1 + SIM_ENTRY_WORDS_MAX) * 4)
+    {
+        fprintf(stderr, "need at least one power cycle and a %u byte pool\n", (1 + SIM_ENTRY_WORDS_MAX) * 4);
+        return 2;
+    }
+
+    m_shared = mmap(NULL, sizeof(*m_shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (m_shared == MAP_FAILED)
+    {
+        perror("mmap");
+        return 2;
+    }
+
+    bench();
+    power_cycles(cycles);
+
+    if (m_shared->failures > 0)
+    {
+        fprintf(stderr, "%u checks failed\n", m_shared->failures);
+        return 1;
+    }
+    printf("iaq_store_sim: all checks passed\n");
+    return 0;
+}
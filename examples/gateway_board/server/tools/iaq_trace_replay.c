@@ -0,0 +1,255 @@
+/*
+ * Host replay of an IAQ trace (see src/app_iaq_trace.h).
+ *
+ * Feeds the recorded calc_iaq_2nd_gen() outputs through the node's own
+ * downstream code, iaq_sample_from_float() and iaq_sample_due(), with the
+ * same first-reading and stabilisation handling as app_sensor_iaq.c, and
+ * reports how often the node would publish and what the pipeline costs per
+ * sample on the host. The IAQ library itself is ARM-only, so the raw ADC
+ * frames are carried in the trace but not re-run here.
+ *
+ * Build (the default cadence can be overridden to try other publish policies):
+ *
+ *   cc -O2 -I../src [-DIAQ_SAMPLE_IAQ_THRESHOLD_X10=10 ...] \
+ *      -o iaq_trace_replay iaq_trace_replay.c ../src/iaq_sample.c ../src/sensor_cadence.c
+ *
+ * Usage:
+ *
+ *   iaq_trace_replay [-r <repeat>] [-P <period_ms>] [-p] <trace file>
+ *
+ *   -r  replay the trace this many times for the timing figures (default 1)
+ *   -P  vendor model publish period, the base of the cadence (default 0, none)
+ *   -p  print every publish as CSV: timestamp_ms,iaq_x10,tvoc_x100,eco2,flags
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "iaq_sample.h"
+#include "app_iaq_trace.h"
+
+#define CALC_STATUS_OK              0   /* IAQ_2ND_GEN_OK */
+#define CALC_STATUS_STABILIZATION   1   /* IAQ_2ND_GEN_STABILIZATION */
+
+typedef struct
+{
+    uint32_t records;
+    uint32_t dropped;       /* Sequence gaps: records lost on RTT */
+    uint32_t stabilizing;
+    uint32_t calc_errors;
+    uint32_t invalid;       /* Rejected by iaq_sample_from_float() */
+    uint32_t publishes;
+    uint32_t changed_iaq;
+    uint32_t changed_tvoc;
+    uint32_t changed_eco2;
+} replay_stats_t;
+
+static app_iaq_trace_record_t * load_trace(const char * p_path, size_t * p_count, uint32_t * p_skipped)
+{
+    FILE * p_file = fopen(p_path, "rb");
+    if (p_file == NULL)
+    {
+        perror(p_path);
+        return NULL;
+    }
+
+    fseek(p_file, 0, SEEK_END);
+    long size = ftell(p_file);
+    fseek(p_file, 0, SEEK_SET);
+
+    uint8_t * p_raw = malloc((size_t)size);
+    app_iaq_trace_record_t * p_records = malloc((size_t)size);
+    if (p_raw == NULL || p_records == NULL || fread(p_raw, 1, (size_t)size, p_file) != (size_t)size)
+    {
+        fprintf(stderr, "%s: read failed\n", p_path);
+        fclose(p_file);
+        free(p_raw);
+        free(p_records);
+        return NULL;
+    }
+    fclose(p_file);
+
+    /* Records are fixed size but the capture may start mid-record; resync on the header */
+    size_t count = 0;
+    size_t pos = 0;
+    *p_skipped = 0;
+    while (pos + sizeof(app_iaq_trace_record_t) <= (size_t)size)
+    {
+        app_iaq_trace_record_t record;
+        memcpy(&record, &p_raw[pos], sizeof(record));
+        if (record.sync != APP_IAQ_TRACE_SYNC || record.version != APP_IAQ_TRACE_VERSION)
+        {
+            pos++;
+            (*p_skipped)++;
+            continue;
+        }
+        p_records[count++] = record;
+        pos += sizeof(record);
+    }
+
+    free(p_raw);
+    *p_count = count;
+    return p_records;
+}
+
+static void replay(const app_iaq_trace_record_t * p_records, size_t count, uint32_t period_ms,
+                   bool print, replay_stats_t * p_stats)
+{
+    sensor_cadence_t cadence[IAQ_SAMPLE_PROPERTY_COUNT];
+    iaq_sample_t last = { 0 };
+    uint32_t last_ms = 0;
+    bool first_reading = true;
+
+    iaq_sample_cadence_default(cadence);
+
+    memset(p_stats, 0, sizeof(*p_stats));
+    for (size_t i = 0; i < count; i++)
+    {
+        const app_iaq_trace_record_t * p_record = &p_records[i];
+
+        p_stats->records++;
+        if (i > 0)
+        {
+            p_stats->dropped += p_record->seq - p_records[i - 1].seq - 1;
+        }
+
+        if (p_record->calc_status == CALC_STATUS_STABILIZATION)
+        {
+            p_stats->stabilizing++;
+            continue;
+        }
+        if (p_record->calc_status != CALC_STATUS_OK)
+        {
+            p_stats->calc_errors++;
+            continue;
+        }
+
+        iaq_sample_t sample;
+        if (!iaq_sample_from_float(p_record->iaq, p_record->tvoc, p_record->eco2, &sample))
+        {
+            p_stats->invalid++;
+            continue;
+        }
+
+        uint8_t changed;
+        if (first_reading)
+        {
+            first_reading = false;
+            changed = IAQ_SAMPLE_CHANGED_IAQ | IAQ_SAMPLE_CHANGED_TVOC | IAQ_SAMPLE_CHANGED_ECO2;
+        }
+        else
+        {
+            changed = iaq_sample_due(cadence, &last, p_record->timestamp_ms - last_ms, period_ms, &sample);
+            if (changed == 0)
+            {
+                continue;
+            }
+        }
+
+        last = sample;
+        last_ms = p_record->timestamp_ms;
+        p_stats->publishes++;
+        p_stats->changed_iaq += (changed & IAQ_SAMPLE_CHANGED_IAQ) ? 1 : 0;
+        p_stats->changed_tvoc += (changed & IAQ_SAMPLE_CHANGED_TVOC) ? 1 : 0;
+        p_stats->changed_eco2 += (changed & IAQ_SAMPLE_CHANGED_ECO2) ? 1 : 0;
+
+        if (print)
+        {
+            printf("%u,%u,%u,%u,%u\n", p_record->timestamp_ms, sample.iaq_x10,
+                   sample.tvoc_x100, sample.eco2, changed);
+        }
+    }
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char ** argv)
+{
+    const char * p_path = NULL;
+    unsigned repeat = 1;
+    uint32_t period_ms = 0;
+    bool print = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            repeat = (unsigned)strtoul(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc)
+        {
+            period_ms = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-p") == 0)
+        {
+            print = true;
+        }
+        else
+        {
+            p_path = argv[i];
+        }
+    }
+    if (p_path == NULL || repeat == 0)
+    {
+        fprintf(stderr, "usage: %s [-r <repeat>] [-P <period_ms>] [-p] <trace file>\n", argv[0]);
+        return 2;
+    }
+
+    size_t count;
+    uint32_t skipped;
+    app_iaq_trace_record_t * p_records = load_trace(p_path, &count, &skipped);
+    if (p_records == NULL)
+    {
+        return 1;
+    }
+    if (count == 0)
+    {
+        fprintf(stderr, "%s: no trace records\n", p_path);
+        free(p_records);
+        return 1;
+    }
+
+    replay_stats_t stats;
+    replay(p_records, count, period_ms, print, &stats);
+
+    double start = now_s();
+    for (unsigned i = 0; i < repeat; i++)
+    {
+        replay_stats_t timed;
+        replay(p_records, count, period_ms, false, &timed);
+    }
+    double elapsed = now_s() - start;
+
+    double span_s = (double)(p_records[count - 1].timestamp_ms - p_records[0].timestamp_ms) / 1000.0;
+    double samples = (double)count * repeat;
+
+    fprintf(stderr, "Deltas: IAQ %d.%d, TVOC %d.%02d mg/m3, eCO2 %d ppm; period %u ms, /%u from IAQ %d.%d, "
+            "TVOC %d.%02d mg/m3, eCO2 %d ppm\n",
+            IAQ_SAMPLE_IAQ_THRESHOLD_X10 / 10, IAQ_SAMPLE_IAQ_THRESHOLD_X10 % 10,
+            IAQ_SAMPLE_TVOC_THRESHOLD_X100 / 100, IAQ_SAMPLE_TVOC_THRESHOLD_X100 % 100,
+            IAQ_SAMPLE_ECO2_THRESHOLD, period_ms, 1u << IAQ_SAMPLE_FAST_DIVISOR_LOG2,
+            IAQ_SAMPLE_IAQ_FAST_LOW_X10 / 10, IAQ_SAMPLE_IAQ_FAST_LOW_X10 % 10,
+            IAQ_SAMPLE_TVOC_FAST_LOW_X100 / 100, IAQ_SAMPLE_TVOC_FAST_LOW_X100 % 100,
+            IAQ_SAMPLE_ECO2_FAST_LOW);
+    fprintf(stderr, "Records: %u over %.0f s (%u dropped on RTT, %u bytes skipped)\n",
+            stats.records, span_s, stats.dropped, skipped);
+    fprintf(stderr, "Stabilizing %u, calc errors %u, invalid %u\n",
+            stats.stabilizing, stats.calc_errors, stats.invalid);
+    fprintf(stderr, "Publishes: %u (%.1f per hour), IAQ %u, TVOC %u, eCO2 %u\n",
+            stats.publishes, span_s > 0 ? stats.publishes * 3600.0 / span_s : 0.0,
+            stats.changed_iaq, stats.changed_tvoc, stats.changed_eco2);
+    fprintf(stderr, "Pipeline: %.1f ns per sample, %.0fx real time\n",
+            elapsed * 1e9 / samples, elapsed > 0 ? span_s * repeat / elapsed : 0.0);
+
+    free(p_records);
+    return 0;
+}
@@ -0,0 +1,1088 @@
+/*
+ * Host discrete-event simulation of gateway capacity: the gateway and N
+ * sensor nodes in one mesh, every node a relay.
+ *
+ * Each node runs the firmware's publish path on every measurement
+ * (APP_SENSOR_IAQ_MEAS_INTERVAL_MS): iaq_sample_from_float(), then
+ * iaq_sample_due() with the default cadence against the publish period (-p),
+ * then iaq_codec_values_pack() for the Sensor Values payload. The gateway
+ * decodes each new message with iaq_codec_values_unpack(), tracks the nodes it
+ * has heard in a node_table of APP_GATEWAY_NODE_COUNT, and queues the
+ * iaq_codec_format_values() line on a UART sink with the firmware's TX buffer
+ * (app_uart_gateway.c) at 115200 baud. Latency runs from the measurement to
+ * the end of the line on the UART.
+ *
+ * The readings are correlated. Nodes share rooms of about ZONE_NODES, laid
+ * out over the floor, and the people in a room raise eCO2, TVOC and IAQ at
+ * all its nodes together. Everybody arrives at ARRIVAL_S, and some rooms fill
+ * and empty again later. So triggers and the fast cadence come in bursts from
+ * nodes that are close to each other.
+ *
+ * Radio: nodes are placed at random in a square around the gateway, sized
+ * for -k neighbours in range on average. An advertising event sends a packet
+ * on channels 37, 38 and 39 back to back. The originator sends -x events per
+ * message and a relay one, each ADV_INTERVAL_MS plus 0-10 ms apart. A receiver
+ * scans one channel at a time, switching every SCAN_INTERVAL_MS, and hears
+ * nothing while it sends. Two packets that overlap on one channel at a
+ * receiver are both lost there. The relays of one flood send the same packet
+ * at nearly the same time, so these collisions are correlated, not
+ * independent draws. Fading and scan gaps lose each remaining copy with
+ * probability -l. A node relays a packet it has not seen yet (message cache)
+ * if it arrived with a TTL of 2 or more. The relayed copy has a TTL one lower
+ * and waits in a queue of RELAY_QUEUE_LEN packets behind the node's own.
+ *
+ * Events (measurements, advertising events and the start and end of every
+ * packet) are kept in a binary heap ordered by time, then by insertion. So a
+ * seed gives one exact run.
+ *
+ * Checked on every run:
+ *  - each UART line is the line for the reading the node packed;
+ *  - the node table reports each node as new exactly once, up to its capacity;
+ *  - no packet is received after more hops than its TTL allows.
+ * Without -n, node counts 25, 50, 100 and APP_GATEWAY_NODE_COUNT are swept,
+ * and the first is run twice to check that the same seed gives the same
+ * result. With -c, a run also fails if it delivers less than
+ * MIN_DELIVERY_PERMILLE of the messages or loads the UART above
+ * MAX_UART_PERMILLE.
+ *
+ * Build (the gateway's high-throughput profile, as on the gateway):
+ *
+ *   cc -O2 -DAPP_PROFILE_GATEWAY_HT=1 -I../src -I../include -o mesh_capacity_sim \
+ *      mesh_capacity_sim.c ../src/iaq_sample.c ../src/sensor_cadence.c ../src/iaq_codec.c \
+ *      ../src/node_table.c -lm
+ *
+ * Usage:
+ *
+ *   mesh_capacity_sim [-n <nodes>] [-k <neighbours>] [-t <ttl>] [-x <tx_count>] [-l <loss>]
+ *                     [-p <period_s>] [-d <duration_s>] [-s <seed>] [-c]
+ *
+ *   -n  sensor nodes (default: sweep 25, 50, 100, APP_GATEWAY_NODE_COUNT)
+ *   -k  mean neighbours in radio range (default 12)
+ *   -t  TTL of the published messages (default ACCESS_DEFAULT_TTL)
+ *   -x  advertising events per originated message, network transmit count (default 2)
+ *   -l  loss of a copy that does not collide (default 0.1)
+ *   -p  publish period of the vendor model in s (default 60)
+ *   -d  simulated time in s (default 300)
+ *   -s  random seed (default 1)
+ *   -c  fail on missed delivery or UART targets
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "nrf_mesh_config_app.h"
+#include "iaq_sample.h"
+#include "iaq_codec.h"
+#include "node_table.h"
+
+#if !APP_PROFILE_GATEWAY_HT
+#error "Build with -DAPP_PROFILE_GATEWAY_HT=1: the capacity figures are those of the HT gateway"
+#endif
+
+#define MEAS_INTERVAL_MS        1000    /* APP_SENSOR_IAQ_MEAS_INTERVAL_MS */
+#define PACKET_US               376     /* 47 bytes on 1M PHY: unsegmented Sensor Values */
+#define CHANNEL_GAP_US          150     /* Channel switch within an advertising event */
+#define ADV_INTERVAL_MS         20      /* BEARER_ADV_INT_DEFAULT_MS */
+#define ADV_DELAY_MAX_MS        10      /* advDelay */
+#define SCAN_INTERVAL_MS        2000    /* BEARER_SCAN_INT_DEFAULT_MS, window = interval */
+#define RELAY_DELAY_MAX_MS      10
+#define RELAY_QUEUE_LEN         8
+#define NODE_MSG_CACHE_LEN      32      /* MSG_CACHE_ENTRY_COUNT without the HT profile */
+#define GATEWAY_MSG_CACHE_LEN   MSG_CACHE_ENTRY_COUNT
+#define CHANNEL_COUNT           3
+
+#define UART_LINE_MAX           128
+#define UART_BYTES_PER_MS       11.52
+/* As app_uart_gateway.c sizes it */
+#define UART_TX_BUF_NEEDED      (APP_GATEWAY_BURST_MSGS * UART_LINE_MAX)
+#define UART_TX_BUF_SIZE        (UART_TX_BUF_NEEDED <= 512 ? 512 : UART_TX_BUF_NEEDED <= 1024 ? 1024 : \
+                                 UART_TX_BUF_NEEDED <= 2048 ? 2048 : 4096)
+
+#define ZONE_NODES              8
+#define ARRIVAL_S               60      /* Everybody arrives */
+#define ZONE_CHANGE_MEAN_S      600     /* Mean time between a room filling or emptying */
+#define ECO2_OUTDOOR            420.0
+#define ECO2_OCCUPIED_EXCESS    1200.0  /* Steady state above outdoor air, full room */
+#define ROOM_TAU_S              600.0   /* Time constant of the room air */
+
+#define MIN_DELIVERY_PERMILLE   990
+#define MAX_UART_PERMILLE       800
+
+#define GATEWAY_ADDR            0x0001
+#define NODE_ADDR_BASE          0x0100
+#define TX_NONE                 UINT32_MAX
+#define US_PER_MS               1000ull
+
+typedef enum
+{
+    EV_MEASURE,
+    EV_ADV,
+    EV_RELAY,
+    EV_TX_START,
+    EV_TX_END
+} event_type_t;
+
+typedef struct
+{
+    uint64_t time_us;
+    uint64_t order;
+    uint32_t arg;           /* Message for EV_RELAY and EV_TX_START, transmission for EV_TX_END */
+    uint16_t node;
+    uint8_t type;
+    uint8_t ttl;
+    uint8_t channel;
+} event_t;
+
+typedef struct
+{
+    uint32_t msg;
+    uint8_t ttl;
+    uint8_t events_left;    /* Advertising events still to send */
+} packet_t;
+
+typedef struct
+{
+    uint32_t tx;            /* Packet being received, TX_NONE if none */
+    uint64_t end_us;
+    bool collided;
+} rx_slot_t;
+
+typedef struct
+{
+    uint16_t node;
+    uint32_t msg;
+    uint8_t ttl;
+    uint8_t channel;
+} tx_t;
+
+typedef struct
+{
+    double x;
+    double y;
+    uint16_t addr;
+    uint16_t zone;
+    uint32_t first_neighbour;   /* Into m_neighbours */
+    uint32_t neighbour_count;
+
+    /* Application, as in app_sensor_iaq.c */
+    sensor_cadence_t cadence[IAQ_SAMPLE_PROPERTY_COUNT];
+    iaq_sample_t published;
+    uint32_t published_ms;
+    bool first_reading;
+    uint8_t seq;
+    double sensitivity;         /* This sensor's share of the room's excess */
+
+    /* Advertiser */
+    packet_t current;
+    bool adv_scheduled;
+    packet_t queue[RELAY_QUEUE_LEN];
+    uint32_t queue_head;
+    uint32_t queue_count;
+    uint64_t tx_end_us;
+    uint32_t scan_phase_ms;
+
+    /* Receiver */
+    rx_slot_t rx[CHANNEL_COUNT];
+    uint32_t cache[GATEWAY_MSG_CACHE_LEN > NODE_MSG_CACHE_LEN ? GATEWAY_MSG_CACHE_LEN : NODE_MSG_CACHE_LEN];
+    uint32_t cache_len;
+    uint32_t cache_next;
+} node_t;
+
+typedef struct
+{
+    uint16_t node;
+    uint8_t ttl;
+    bool delivered;
+    uint8_t length;
+    uint8_t payload[IAQ_CODEC_VALUES_LEN];
+    iaq_sample_t sample;
+    uint64_t origin_us;
+} message_t;
+
+typedef struct
+{
+    double occupancy;           /* 0..1 */
+    double excess;              /* eCO2 above outdoor air, ppm */
+    uint64_t next_change_ms;
+} zone_t;
+
+typedef struct
+{
+    uint32_t nodes;
+    uint32_t neighbours;
+    uint8_t ttl;
+    uint8_t tx_count;
+    double loss;
+    uint32_t period_s;
+    uint32_t duration_s;
+    uint64_t seed;
+    bool check;
+} sim_config_t;
+
+/* Integers only, so two runs compare with memcmp() */
+typedef struct
+{
+    uint32_t unreachable;       /* Nodes with no path to the gateway */
+    uint32_t originated;
+    uint32_t delivered;
+    uint32_t first_heard;
+    uint64_t packets;           /* Sent, per channel */
+    uint64_t receptions;
+    uint64_t collisions;        /* Copies lost to an overlap at a receiver */
+    uint64_t relayed;
+    uint64_t relay_drops;       /* Relay queue full */
+    uint64_t ttl_expired;       /* New to a node, not relayed for its TTL */
+    uint32_t uart_drops;
+    uint32_t uart_permille;
+    uint32_t hops_x10;          /* Mean hops of the delivered messages */
+    uint32_t max_hops;
+    uint32_t latency_p50_ms;
+    uint32_t latency_p90_ms;
+    uint32_t latency_p99_ms;
+    uint32_t latency_max_ms;
+} sim_result_t;
+
+static uint32_t m_failures;
+static uint64_t m_rng;
+
+static node_t * mp_nodes;          /* [0] is the gateway */
+static uint32_t m_node_count;
+static uint32_t * mp_neighbours;
+static zone_t * mp_zones;
+static uint32_t m_zone_count;
+static uint32_t m_zone_side;
+static double m_side;
+
+static message_t * mp_messages;
+static uint32_t m_message_count;
+static uint32_t m_message_cap;
+
+static tx_t * mp_tx;
+static uint32_t m_tx_count;
+static uint32_t m_tx_cap;
+
+static event_t * mp_heap;
+static uint32_t m_heap_count;
+static uint32_t m_heap_cap;
+static uint64_t m_event_order;
+
+static uint32_t * mp_latency;
+static uint32_t * mp_hops;
+
+NODE_TABLE_DEF(s_gateway_nodes, APP_GATEWAY_NODE_COUNT);
+static bool * mp_heard;
+
+static void check(bool ok, const char * p_what)
+{
+    if (!ok)
+    {
+        if (m_failures < 20)
+        {
+            fprintf(stderr, "FAIL %s\n", p_what);
+        }
+        m_failures++;
+    }
+}
+
+static double rand_unit(void)
+{
+    m_rng ^= m_rng << 13;
+    m_rng ^= m_rng >> 7;
+    m_rng ^= m_rng << 17;
+    return (double)(m_rng >> 11) / (double)(1ull << 53);
+}
+
+static uint64_t rand_us(uint64_t max_us)
+{
+    return (uint64_t)(rand_unit() * (double)(max_us + 1));
+}
+
+/* Sum of three uniforms, roughly normal with the given deviation */
+static double rand_noise(double sigma)
+{
+    return (rand_unit() + rand_unit() + rand_unit() - 1.5) * 2.0 * sigma;
+}
+
+static void * grow(void * p, uint32_t * p_cap, size_t size)
+{
+    *p_cap = (*p_cap == 0) ? 1024 : *p_cap * 2;
+    p = realloc(p, *p_cap * size);
+    if (p == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        exit(2);
+    }
+    return p;
+}
+
+/* ---- Event queue ---- */
+
+static bool event_before(const event_t * p_a, const event_t * p_b)
+{
+    return (p_a->time_us != p_b->time_us) ? (p_a->time_us < p_b->time_us) : (p_a->order < p_b->order);
+}
+
+static void event_push(event_t event)
+{
+    if (m_heap_count == m_heap_cap)
+    {
+        mp_heap = grow(mp_heap, &m_heap_cap, sizeof(*mp_heap));
+    }
+    event.order = m_event_order++;
+
+    uint32_t i = m_heap_count++;
+    while (i > 0 && event_before(&event, &mp_heap[(i - 1) / 2]))
+    {
+        mp_heap[i] = mp_heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    mp_heap[i] = event;
+}
+
+static event_t event_pop(void)
+{
+    event_t top = mp_heap[0];
+    event_t last = mp_heap[--m_heap_count];
+
+    uint32_t i = 0;
+    for (;;)
+    {
+        uint32_t child = 2 * i + 1;
+        if (child >= m_heap_count)
+        {
+            break;
+        }
+        if (child + 1 < m_heap_count && event_before(&mp_heap[child + 1], &mp_heap[child]))
+        {
+            child++;
+        }
+        if (!event_before(&mp_heap[child], &last))
+        {
+            break;
+        }
+        mp_heap[i] = mp_heap[child];
+        i = child;
+    }
+    if (m_heap_count > 0)
+    {
+        mp_heap[i] = last;
+    }
+    return top;
+}
+
+static void event_at(uint64_t time_us, event_type_t type, uint16_t node, uint32_t arg, uint8_t ttl, uint8_t channel)
+{
+    event_t event = { .time_us = time_us, .type = (uint8_t)type, .node = node, .arg = arg,
+                      .ttl = ttl, .channel = channel };
+    event_push(event);
+}
+
+/* ---- Topology and rooms ---- */
+
+static void topology_build(const sim_config_t * p_config)
+{
+    /* Side of the square for the mean neighbour count, radio range 1 */
+    m_side = sqrt((double)(p_config->nodes + 1) * M_PI / (double)p_config->neighbours);
+    m_zone_side = (uint32_t)ceil(sqrt((double)p_config->nodes / ZONE_NODES));
+    m_zone_count = m_zone_side * m_zone_side;
+
+    mp_nodes[0].x = m_side / 2.0;
+    mp_nodes[0].y = m_side / 2.0;
+    for (uint32_t i = 1; i < m_node_count; i++)
+    {
+        mp_nodes[i].x = rand_unit() * m_side;
+        mp_nodes[i].y = rand_unit() * m_side;
+    }
+
+    uint32_t total = 0;
+    for (uint32_t pass = 0; pass < 2; pass++)
+    {
+        total = 0;
+        for (uint32_t i = 0; i < m_node_count; i++)
+        {
+            node_t * p_node = &mp_nodes[i];
+            p_node->first_neighbour = total;
+            p_node->neighbour_count = 0;
+            for (uint32_t j = 0; j < m_node_count; j++)
+            {
+                double dx = mp_nodes[j].x - p_node->x;
+                double dy = mp_nodes[j].y - p_node->y;
+                if (j != i && dx * dx + dy * dy <= 1.0)
+                {
+                    if (pass == 1)
+                    {
+                        mp_neighbours[total] = j;
+                    }
+                    total++;
+                    p_node->neighbour_count++;
+                }
+            }
+        }
+        if (pass == 0)
+        {
+            mp_neighbours = malloc((total + 1) * sizeof(*mp_neighbours));
+        }
+    }
+}
+
+/* Nodes with no path to the gateway, whatever the TTL */
+static uint32_t unreachable_count(void)
+{
+    uint8_t * p_seen = calloc(m_node_count, 1);
+    uint32_t * p_fifo = malloc(m_node_count * sizeof(*p_fifo));
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+    p_seen[0] = 1;
+    p_fifo[tail++] = 0;
+    while (head < tail)
+    {
+        const node_t * p_node = &mp_nodes[p_fifo[head++]];
+        for (uint32_t k = 0; k < p_node->neighbour_count; k++)
+        {
+            uint32_t j = mp_neighbours[p_node->first_neighbour + k];
+            if (!p_seen[j])
+            {
+                p_seen[j] = 1;
+                p_fifo[tail++] = j;
+            }
+        }
+    }
+
+    uint32_t count = m_node_count - tail;
+    free(p_seen);
+    free(p_fifo);
+    return count;
+}
+
+static void zones_step(uint64_t now_ms)
+{
+    for (uint32_t z = 0; z < m_zone_count; z++)
+    {
+        zone_t * p_zone = &mp_zones[z];
+        if (now_ms == ARRIVAL_S * 1000ull)
+        {
+            p_zone->occupancy = 0.5 + 0.5 * rand_unit();
+            p_zone->next_change_ms = now_ms + (uint64_t)(-log(1.0 - rand_unit()) * ZONE_CHANGE_MEAN_S * 1000.0);
+        }
+        else if (now_ms > ARRIVAL_S * 1000ull && now_ms >= p_zone->next_change_ms)
+        {
+            p_zone->occupancy = (p_zone->occupancy > 0.0) ? 0.0 : rand_unit();
+            p_zone->next_change_ms = now_ms + (uint64_t)(-log(1.0 - rand_unit()) * ZONE_CHANGE_MEAN_S * 1000.0);
+        }
+
+        double target = p_zone->occupancy * ECO2_OCCUPIED_EXCESS;
+        p_zone->excess += (target - p_zone->excess) * (MEAS_INTERVAL_MS / 1000.0) / ROOM_TAU_S;
+    }
+}
+
+static uint16_t zone_of(double x, double y)
+{
+    uint32_t zx = (uint32_t)(x / m_side * m_zone_side);
+    uint32_t zy = (uint32_t)(y / m_side * m_zone_side);
+    zx = (zx < m_zone_side) ? zx : m_zone_side - 1;
+    zy = (zy < m_zone_side) ? zy : m_zone_side - 1;
+    return (uint16_t)(zy * m_zone_side + zx);
+}
+
+/* ---- Advertiser ---- */
+
+static void adv_schedule(node_t * p_node, uint16_t index, uint64_t time_us)
+{
+    if (!p_node->adv_scheduled)
+    {
+        p_node->adv_scheduled = true;
+        event_at(time_us, EV_ADV, index, 0, 0, 0);
+    }
+}
+
+static bool queue_put(node_t * p_node, packet_t packet)
+{
+    if (p_node->queue_count == RELAY_QUEUE_LEN)
+    {
+        return false;
+    }
+    p_node->queue[(p_node->queue_head + p_node->queue_count++) % RELAY_QUEUE_LEN] = packet;
+    return true;
+}
+
+/* One advertising event of the current packet: the packet on each channel */
+static void adv_event(node_t * p_node, uint16_t index, uint64_t now_us)
+{
+    p_node->adv_scheduled = false;
+    if (p_node->current.events_left == 0)
+    {
+        if (p_node->queue_count == 0)
+        {
+            return;
+        }
+        p_node->current = p_node->queue[p_node->queue_head];
+        p_node->queue_head = (p_node->queue_head + 1) % RELAY_QUEUE_LEN;
+        p_node->queue_count--;
+    }
+
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++)
+    {
+        event_at(now_us + ch * (PACKET_US + CHANNEL_GAP_US), EV_TX_START, index,
+                 p_node->current.msg, p_node->current.ttl, ch);
+    }
+    p_node->current.events_left--;
+
+    if (p_node->current.events_left > 0 || p_node->queue_count > 0)
+    {
+        adv_schedule(p_node, index, now_us + CHANNEL_COUNT * (PACKET_US + CHANNEL_GAP_US) +
+                                    ADV_INTERVAL_MS * US_PER_MS + rand_us(ADV_DELAY_MAX_MS * US_PER_MS));
+    }
+}
+
+/* ---- Radio ---- */
+
+static uint8_t scan_channel(const node_t * p_node, uint64_t now_us)
+{
+    return (uint8_t)(((now_us / US_PER_MS + p_node->scan_phase_ms) / SCAN_INTERVAL_MS) % CHANNEL_COUNT);
+}
+
+static void tx_start(uint16_t index, uint32_t msg, uint8_t ttl, uint8_t ch, uint64_t now_us, sim_result_t * p_result)
+{
+    node_t * p_node = &mp_nodes[index];
+    uint64_t end_us = now_us + PACKET_US;
+
+    if (m_tx_count == m_tx_cap)
+    {
+        mp_tx = grow(mp_tx, &m_tx_cap, sizeof(*mp_tx));
+    }
+    uint32_t tx = m_tx_count++;
+    mp_tx[tx] = (tx_t){ .node = index, .msg = msg, .ttl = ttl, .channel = ch };
+    p_result->packets++;
+
+    /* Half duplex: whatever the node was receiving is lost */
+    for (uint8_t c = 0; c < CHANNEL_COUNT; c++)
+    {
+        if (p_node->rx[c].tx != TX_NONE && p_node->rx[c].end_us > now_us)
+        {
+            p_node->rx[c].collided = true;
+        }
+    }
+    p_node->tx_end_us = end_us;
+
+    for (uint32_t k = 0; k < p_node->neighbour_count; k++)
+    {
+        node_t * p_rx = &mp_nodes[mp_neighbours[p_node->first_neighbour + k]];
+        if (p_rx->tx_end_us > now_us || scan_channel(p_rx, now_us) != ch)
+        {
+            continue;
+        }
+
+        rx_slot_t * p_slot = &p_rx->rx[ch];
+        if (p_slot->tx != TX_NONE && p_slot->end_us > now_us)
+        {
+            /* Both are lost; the slot stays busy until the later one ends */
+            p_slot->collided = true;
+            p_slot->tx = tx;
+            p_slot->end_us = (end_us > p_slot->end_us) ? end_us : p_slot->end_us;
+        }
+        else
+        {
+            *p_slot = (rx_slot_t){ .tx = tx, .end_us = end_us, .collided = false };
+        }
+    }
+
+    event_at(end_us, EV_TX_END, index, tx, ttl, ch);
+}
+
+static bool cache_add(node_t * p_node, uint32_t msg)
+{
+    for (uint32_t i = 0; i < p_node->cache_len; i++)
+    {
+        if (p_node->cache[i] == msg)
+        {
+            return false;
+        }
+    }
+    p_node->cache[p_node->cache_next] = msg;
+    p_node->cache_next = (p_node->cache_next + 1) % p_node->cache_len;
+    return true;
+}
+
+static void uart_line(const char * p_line, int length, uint64_t now_us, uint64_t origin_us,
+                      sim_result_t * p_result, uint64_t * p_uart_free_us, uint64_t * p_uart_busy_us)
+{
+    /* Bytes still in the TX buffer */
+    uint64_t backlog_us = (*p_uart_free_us > now_us) ? *p_uart_free_us - now_us : 0;
+    double buffered = (double)backlog_us / 1000.0 * UART_BYTES_PER_MS;
+    if (buffered + length > UART_TX_BUF_SIZE)
+    {
+        p_result->uart_drops++;
+        return;
+    }
+
+    (void)p_line;
+    uint64_t line_us = (uint64_t)((double)length / UART_BYTES_PER_MS * 1000.0);
+    *p_uart_free_us = ((*p_uart_free_us > now_us) ? *p_uart_free_us : now_us) + line_us;
+    *p_uart_busy_us += line_us;
+    mp_latency[p_result->delivered] = (uint32_t)((*p_uart_free_us - origin_us) / US_PER_MS);
+}
+
+/* The gateway's vendor_model_rx_cb() and scheduled_sensor_rx_handler() */
+static void gateway_rx(uint32_t msg, uint8_t ttl, uint64_t now_us, sim_result_t * p_result,
+                       uint64_t * p_uart_free_us, uint64_t * p_uart_busy_us)
+{
+    message_t * p_msg = &mp_messages[msg];
+    const node_t * p_src = &mp_nodes[p_msg->node];
+    iaq_sample_t sample;
+    iaq_codec_meta_t meta;
+
+    check(!p_msg->delivered, "gateway message cache lets a message through once");
+    p_msg->delivered = true;
+
+    bool unpacked = iaq_codec_values_unpack(p_msg->payload, p_msg->length, &sample, &meta);
+    check(unpacked, "payload decodes at the gateway");
+    if (!unpacked)
+    {
+        return;
+    }
+
+    if (node_table_add(&s_gateway_nodes, p_src->addr))
+    {
+        check(!mp_heard[p_msg->node], "node reported new once");
+        mp_heard[p_msg->node] = true;
+        p_result->first_heard++;
+    }
+
+    char line[UART_LINE_MAX];
+    char expected[UART_LINE_MAX];
+    int length = iaq_codec_format_values(line, sizeof(line), p_src->addr, &sample);
+    int expected_length = iaq_codec_format_values(expected, sizeof(expected), p_src->addr, &p_msg->sample);
+    check(length > 0 && length < (int)sizeof(line) && length == expected_length &&
+          memcmp(line, expected, (size_t)length) == 0, "UART line is the packed reading");
+
+    uint32_t hops = (uint32_t)(p_msg->ttl - ttl) + 1;
+    mp_hops[p_result->delivered] = hops;
+    p_result->max_hops = (hops > p_result->max_hops) ? hops : p_result->max_hops;
+
+    uint32_t drops = p_result->uart_drops;
+    uart_line(line, length, now_us, p_msg->origin_us, p_result, p_uart_free_us, p_uart_busy_us);
+    if (p_result->uart_drops == drops)
+    {
+        p_result->delivered++;
+    }
+}
+
+static void tx_end(uint32_t tx, uint64_t now_us, const sim_config_t * p_config, sim_result_t * p_result,
+                   uint64_t * p_uart_free_us, uint64_t * p_uart_busy_us)
+{
+    const tx_t * p_tx = &mp_tx[tx];
+    const node_t * p_node = &mp_nodes[p_tx->node];
+
+    for (uint32_t k = 0; k < p_node->neighbour_count; k++)
+    {
+        uint32_t r = mp_neighbours[p_node->first_neighbour + k];
+        node_t * p_rx = &mp_nodes[r];
+        rx_slot_t * p_slot = &p_rx->rx[p_tx->channel];
+        if (p_slot->tx != tx)
+        {
+            /* Not listening on this channel, or taken over by a later packet */
+            continue;
+        }
+        p_slot->tx = TX_NONE;
+        if (p_slot->collided)
+        {
+            p_result->collisions++;
+            continue;
+        }
+        if (rand_unit() < p_config->loss)
+        {
+            continue;
+        }
+
+        p_result->receptions++;
+        check(p_tx->ttl >= 1 && (uint32_t)(mp_messages[p_tx->msg].ttl - p_tx->ttl) + 1 <= p_config->ttl,
+              "received within its TTL");
+        if (!cache_add(p_rx, p_tx->msg))
+        {
+            continue;
+        }
+
+        if (r == 0)
+        {
+            gateway_rx(p_tx->msg, p_tx->ttl, now_us, p_result, p_uart_free_us, p_uart_busy_us);
+        }
+
+        /* Every node relays, the gateway too */
+        if (p_tx->ttl >= 2)
+        {
+            event_at(now_us + rand_us(RELAY_DELAY_MAX_MS * US_PER_MS), EV_RELAY, (uint16_t)r,
+                     p_tx->msg, (uint8_t)(p_tx->ttl - 1), 0);
+        }
+        else
+        {
+            p_result->ttl_expired++;
+        }
+    }
+}
+
+/* ---- Sensor nodes ---- */
+
+/* The measurement path of app_sensor_iaq.c: reading, cadence, publish */
+static void node_measure(uint16_t index, uint64_t now_us, const sim_config_t * p_config, sim_result_t * p_result)
+{
+    node_t * p_node = &mp_nodes[index];
+    const zone_t * p_zone = &mp_zones[p_node->zone];
+    uint32_t now_ms = (uint32_t)(now_us / US_PER_MS);
+
+    double excess = p_zone->excess * p_node->sensitivity;
+    float eco2 = (float)(ECO2_OUTDOOR + excess + rand_noise(2.0));
+    float tvoc = (float)(0.2 + excess / 300.0 + rand_noise(0.005));
+    float iaq = (float)(1.0 + excess / 350.0 + rand_noise(0.02));
+
+    iaq_sample_t sample;
+    if (!iaq_sample_from_float(iaq, tvoc, eco2, &sample))
+    {
+        return;
+    }
+
+    bool due = p_node->first_reading ||
+               iaq_sample_due(p_node->cadence, &p_node->published, now_ms - p_node->published_ms,
+                              p_config->period_s * 1000u, &sample) != 0;
+    if (!due)
+    {
+        return;
+    }
+    p_node->first_reading = false;
+    p_node->published = sample;
+    p_node->published_ms = now_ms;
+
+    if (m_message_count == m_message_cap)
+    {
+        mp_messages = grow(mp_messages, &m_message_cap, sizeof(*mp_messages));
+        mp_latency = realloc(mp_latency, m_message_cap * sizeof(*mp_latency));
+        mp_hops = realloc(mp_hops, m_message_cap * sizeof(*mp_hops));
+    }
+    uint32_t msg = m_message_count++;
+    message_t * p_msg = &mp_messages[msg];
+    iaq_codec_meta_t meta = { .seq = p_node->seq++ };
+
+    memset(p_msg, 0, sizeof(*p_msg));
+    p_msg->node = index;
+    p_msg->ttl = p_config->ttl;
+    p_msg->sample = sample;
+    p_msg->origin_us = now_us;
+    p_msg->length = iaq_codec_values_pack(&sample, &meta, p_msg->payload);
+    p_result->originated++;
+
+    (void)cache_add(p_node, msg);
+    packet_t packet = { .msg = msg, .ttl = p_config->ttl, .events_left = p_config->tx_count };
+    if (queue_put(p_node, packet))
+    {
+        adv_schedule(p_node, index, now_us);
+    }
+    else
+    {
+        p_result->relay_drops++;
+    }
+}
+
+/* ---- Run ---- */
+
+static int compare_u32(const void * p_a, const void * p_b)
+{
+    uint32_t a = *(const uint32_t *)p_a;
+    uint32_t b = *(const uint32_t *)p_b;
+    return (a > b) - (a < b);
+}
+
+static void run(const sim_config_t * p_config, sim_result_t * p_result)
+{
+    memset(p_result, 0, sizeof(*p_result));
+    m_rng = p_config->seed * 0x9E3779B97F4A7C15ull + 1;
+    m_node_count = p_config->nodes + 1;
+    m_message_count = 0;
+    m_tx_count = 0;
+    m_heap_count = 0;
+    m_event_order = 0;
+    s_gateway_nodes.count = 0;
+
+    mp_nodes = calloc(m_node_count, sizeof(*mp_nodes));
+    mp_heard = calloc(m_node_count, sizeof(*mp_heard));
+    topology_build(p_config);
+    mp_zones = calloc(m_zone_count, sizeof(*mp_zones));
+    p_result->unreachable = unreachable_count();
+
+    for (uint32_t i = 0; i < m_node_count; i++)
+    {
+        node_t * p_node = &mp_nodes[i];
+        p_node->addr = (i == 0) ? GATEWAY_ADDR : (uint16_t)(NODE_ADDR_BASE + i);
+        p_node->zone = zone_of(p_node->x, p_node->y);
+        p_node->first_reading = true;
+        p_node->sensitivity = 0.8 + 0.4 * rand_unit();
+        p_node->scan_phase_ms = (uint32_t)(rand_unit() * SCAN_INTERVAL_MS * CHANNEL_COUNT);
+        p_node->cache_len = (i == 0) ? GATEWAY_MSG_CACHE_LEN : NODE_MSG_CACHE_LEN;
+        memset(p_node->cache, 0xFF, sizeof(p_node->cache));
+        for (uint8_t c = 0; c < CHANNEL_COUNT; c++)
+        {
+            p_node->rx[c].tx = TX_NONE;
+        }
+        iaq_sample_cadence_default(p_node->cadence);
+        if (i > 0)
+        {
+            event_at(rand_us(MEAS_INTERVAL_MS * US_PER_MS - 1), EV_MEASURE, (uint16_t)i, 0, 0, 0);
+        }
+    }
+
+    uint64_t end_us = (uint64_t)p_config->duration_s * 1000000ull;
+    uint64_t zone_ms = 0;
+    uint64_t uart_free_us = 0;
+    uint64_t uart_busy_us = 0;
+    uint64_t last_us = 0;
+
+    while (m_heap_count > 0)
+    {
+        event_t event = event_pop();
+        node_t * p_node = &mp_nodes[event.node];
+        last_us = event.time_us;
+
+        /* Rooms move on once per measurement interval */
+        while (zone_ms <= event.time_us / US_PER_MS && zone_ms * US_PER_MS < end_us)
+        {
+            zones_step(zone_ms);
+            zone_ms += MEAS_INTERVAL_MS;
+        }
+
+        switch (event.type)
+        {
+            case EV_MEASURE:
+                node_measure(event.node, event.time_us, p_config, p_result);
+                if (event.time_us + MEAS_INTERVAL_MS * US_PER_MS < end_us)
+                {
+                    event_at(event.time_us + MEAS_INTERVAL_MS * US_PER_MS, EV_MEASURE, event.node, 0, 0, 0);
+                }
+                break;
+
+            case EV_ADV:
+                adv_event(p_node, event.node, event.time_us);
+                break;
+
+            case EV_RELAY:
+            {
+                packet_t packet = { .msg = event.arg, .ttl = event.ttl, .events_left = 1 };
+                if (queue_put(p_node, packet))
+                {
+                    p_result->relayed++;
+                    adv_schedule(p_node, event.node, event.time_us);
+                }
+                else
+                {
+                    p_result->relay_drops++;
+                }
+                break;
+            }
+
+            case EV_TX_START:
+                tx_start(event.node, event.arg, event.ttl, event.channel, event.time_us, p_result);
+                break;
+
+            case EV_TX_END:
+                tx_end(event.arg, event.time_us, p_config, p_result, &uart_free_us, &uart_busy_us);
+                break;
+        }
+    }
+
+    uint64_t span_us = (last_us > end_us) ? last_us : end_us;
+    p_result->uart_permille = (uint32_t)(uart_busy_us * 1000 / span_us);
+
+    uint32_t n = p_result->delivered;
+    if (n > 0)
+    {
+        uint64_t hops_total = 0;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            hops_total += mp_hops[i];
+        }
+        p_result->hops_x10 = (uint32_t)(hops_total * 10 / n);
+
+        qsort(mp_latency, n, sizeof(*mp_latency), compare_u32);
+        p_result->latency_p50_ms = mp_latency[n / 2];
+        p_result->latency_p90_ms = mp_latency[(uint64_t)n * 90 / 100];
+        p_result->latency_p99_ms = mp_latency[(uint64_t)n * 99 / 100];
+        p_result->latency_max_ms = mp_latency[n - 1];
+    }
+
+    /* Node table: every node heard, up to its capacity, reported new once */
+    uint32_t heard = 0;
+    for (uint32_t i = 0; i < m_message_count; i++)
+    {
+        if (mp_messages[i].delivered && !mp_heard[mp_messages[i].node])
+        {
+            mp_heard[mp_messages[i].node] = true;
+            heard++;
+        }
+    }
+    heard += p_result->first_heard;
+    check(p_result->first_heard == ((heard < APP_GATEWAY_NODE_COUNT) ? heard : APP_GATEWAY_NODE_COUNT),
+          "node table reports every heard node up to its capacity");
+
+    free(mp_nodes);
+    free(mp_heard);
+    free(mp_neighbours);
+    free(mp_zones);
+}
+
+static void report(const sim_config_t * p_config, const sim_result_t * p_result)
+{
+    double minutes = p_config->duration_s / 60.0;
+    uint32_t delivery = (p_result->originated > 0) ?
+                        (uint32_t)((uint64_t)p_result->delivered * 1000 / p_result->originated) : 0;
+    uint64_t copies = p_result->receptions + p_result->collisions;
+    uint32_t collided = (copies > 0) ? (uint32_t)(p_result->collisions * 1000 / copies) : 0;
+    const char * p_status = "ok";
+
+    if (delivery < MIN_DELIVERY_PERMILLE)
+    {
+        p_status = "LOSS";
+    }
+    if (p_result->uart_permille > MAX_UART_PERMILLE)
+    {
+        p_status = "UART";
+    }
+
+    printf("%6u %6u %8.1f %8u %8u %6u %4u.%u %4u %6u/%u/%u %6u %6u %5u  %s\n",
+           p_config->nodes, p_result->unreachable,
+           p_result->originated / minutes / p_config->nodes,
+           p_result->originated, delivery, collided,
+           p_result->hops_x10 / 10, p_result->hops_x10 % 10, p_result->max_hops,
+           p_result->latency_p50_ms, p_result->latency_p90_ms, p_result->latency_p99_ms,
+           (uint32_t)p_result->relay_drops, p_result->uart_drops, p_result->uart_permille, p_status);
+
+    if (p_config->check)
+    {
+        check(delivery >= MIN_DELIVERY_PERMILLE, "delivery target met");
+        check(p_result->uart_permille <= MAX_UART_PERMILLE, "UART load target met");
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    sim_config_t config =
+    {
+        .nodes = 0,
+        .neighbours = 12,
+        .ttl = ACCESS_DEFAULT_TTL,
+        .tx_count = 2,
+        .loss = 0.1,
+        .period_s = 60,
+        .duration_s = 300,
+        .seed = 1,
+    };
+
+    int i = 1;
+    while (i < argc)
+    {
+        if (strcmp(argv[i], "-c") == 0)
+        {
+            config.check = true;
+            i++;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            break;
+        }
+        if (strcmp(argv[i], "-n") == 0)
+        {
+            config.nodes = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-k") == 0)
+        {
+            config.neighbours = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-t") == 0)
+        {
+            config.ttl = (uint8_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-x") == 0)
+        {
+            config.tx_count = (uint8_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-l") == 0)
+        {
+            config.loss = strtod(argv[i + 1], NULL);
+        }
+        else if (strcmp(argv[i], "-p") == 0)
+        {
+            config.period_s = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-d") == 0)
+        {
+            config.duration_s = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-s") == 0)
+        {
+            config.seed = strtoull(argv[i + 1], NULL, 0);
+        }
+        else
+        {
+            break;
+        }
+        i += 2;
+    }
+    if (i < argc || config.neighbours == 0 || config.ttl < 2 || config.ttl > 127 ||
+        config.tx_count == 0 || config.loss < 0.0 || config.loss >= 1.0 || config.duration_s == 0 ||
+        config.nodes > UINT16_MAX - NODE_ADDR_BASE)
+    {
+        fprintf(stderr, "usage: %s [-n <nodes>] [-k <neighbours>] [-t <ttl>] [-x <tx_count>] [-l <loss>] "
+                "[-p <period_s>] [-d <duration_s>] [-s <seed>] [-c]\n", argv[0]);
+        return 2;
+    }
+
+    static const uint32_t s_sweep[] = { 25, 50, 100, APP_GATEWAY_NODE_COUNT };
+    const uint32_t * p_counts = s_sweep;
+    uint32_t count = sizeof(s_sweep) / sizeof(s_sweep[0]);
+    if (config.nodes > 0)
+    {
+        p_counts = &config.nodes;
+        count = 1;
+    }
+
+    printf("%u s, %u neighbours, TTL %u, %u transmissions, loss %.2f, publish period %u s, "
+           "UART buffer %u bytes, node table %u\n",
+           config.duration_s, config.neighbours, config.ttl, config.tx_count, config.loss,
+           config.period_s, UART_TX_BUF_SIZE, APP_GATEWAY_NODE_COUNT);
+    printf("%6s %6s %8s %8s %8s %6s %6s %4s %13s %6s %6s %5s\n",
+           "nodes", "unrch", "msg/n/m", "msgs", "deliv", "coll", "hops", "max",
+           "p50/90/99 ms", "rdrop", "udrop", "uart");
+
+    for (uint32_t k = 0; k < count; k++)
+    {
+        sim_config_t run_config = config;
+        sim_result_t result;
+        run_config.nodes = p_counts[k];
+        run(&run_config, &result);
+        report(&run_config, &result);
+
+        if (config.nodes == 0 && k == 0)
+        {
+            sim_result_t again;
+            run(&run_config, &again);
+            check(memcmp(&result, &again, sizeof(result)) == 0, "same seed, same result");
+        }
+    }
+    printf("(deliv, coll and uart in per mille; coll of the copies heard)\n");
+
+    free(mp_messages);
+    free(mp_latency);
+    free(mp_hops);
+    free(mp_tx);
+    free(mp_heap);
+
+    if (m_failures > 0)
+    {
+        printf("mesh_capacity_sim: %u checks failed\n", m_failures);
+        return 1;
+    }
+    printf("mesh_capacity_sim: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,311 @@
+/*
+ * Host duty-cycle and current model per node profile (src/power_model.h).
+ *
+ * Walks one hour of a profile's periodic events - measurement cycles with
+ * their TWI window (src/twi_budget.h), published messages, LPN polls and
+ * receive windows - adds up the time in each power state and turns it into
+ * an average current and a battery life with the same currents app_power
+ * uses. Profiles:
+ *  - relay:   mains sensor node, scanner always on (APP_PROFILE_LPN=0);
+ *  - gateway: relay plus the UART to the host, powered while it forwards
+ *             one line per node and publish interval (auto power-down);
+ *  - lpn:     battery sensor node polling a Friend (APP_PROFILE_LPN=1),
+ *             also swept over the poll interval.
+ *
+ * The "report" column is what the node's own power report would show for
+ * the same profile: app_power cannot see radio TX time. CPU time per
+ * measurement and per radio event are assumptions; compare them with
+ * active_ms/wakeups in a node's power report and pass the measured values.
+ *
+ * Checked: each state alone gives its own current, the LPN RX duty cycle the
+ * firmware sets (power_model_lpn_rx_permille) matches the receive windows
+ * walked here to within its per mille rounding, the LPN draws less than the
+ * relay, and its current does not grow with the poll interval.
+ *
+ * Build and run; the exit status is non-zero on a failed check:
+ *
+ *   cc -O2 -Ihost -I../src -I../include -o power_model power_model.c ../src/power_model.c ../src/twi_budget.c
+ *   ./power_model [-m <measurement interval ms>] [-p <publish interval ms>] [-i <poll interval ms>]
+ *                 [-w <receive window ms>] [-c <CPU us per measurement>] [-x <transmissions per message>]
+ *                 [-f <TWI Hz>] [-e] [-b <battery mAh>] [-n <nodes behind the gateway>]
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "power_model.h"
+#include "twi_budget.h"
+#include "iaq_codec.h"
+#include "app_friendship.h"
+
+#define HOUR_US             (3600ULL * 1000000ULL)
+
+/* One advertising event: the PDU on each of the three advertising channels,
+ * 41 bytes at 1 Mbit/s for a network PDU carrying an 8 byte vendor payload,
+ * plus the radio ramp-up before each. */
+#define ADV_CHANNELS        3
+#define ADV_PDU_US          328
+#define ADV_RAMP_US         140
+#define ADV_EVENT_TX_US     (ADV_CHANNELS * (ADV_PDU_US + ADV_RAMP_US))
+
+/* CPU time the SoftDevice and mesh stack spend around one radio event */
+#define CPU_PER_RADIO_US    200
+
+/* Gateway UART at 115200 baud, 10 bits per byte, a full line per reading */
+#define UART_LINE_US        ((IAQ_CODEC_LINE_MAX * 10 * 1000000ULL) / 115200)
+
+typedef enum
+{
+    PROFILE_RELAY,
+    PROFILE_GATEWAY,
+    PROFILE_LPN,
+} profile_t;
+
+typedef struct
+{
+    uint32_t meas_interval_ms;
+    uint32_t cpu_per_meas_us;
+    uint32_t twi_per_meas_us;
+    uint32_t publish_interval_ms;
+    uint32_t tx_per_message;
+    uint32_t poll_interval_ms;
+    uint32_t receive_window_ms;
+    uint32_t gateway_nodes;
+} params_t;
+
+static const char * const m_profile_names[] = { "relay", "gateway", "lpn" };
+static const uint32_t m_poll_sweep_ms[] = { 1000, 2000, 5000, 10000, 20000, 30000, 60000, 120000 };
+static uint32_t m_failures;
+
+static void check(bool ok, const char * p_what)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL %s\n", p_what);
+        m_failures++;
+    }
+}
+
+/* Time per state over one hour of periodic events. The LPN receive windows
+ * are summed here one by one, not taken from the firmware's duty cycle. */
+static power_model_times_t profile_walk(profile_t profile, const params_t * p_params)
+{
+    power_model_times_t times;
+    memset(&times, 0, sizeof(times));
+    times.total = HOUR_US;
+
+    for (uint64_t t = 0; t < HOUR_US; t += p_params->meas_interval_ms * 1000ULL)
+    {
+        times.active += p_params->cpu_per_meas_us;
+        times.twi += p_params->twi_per_meas_us;
+    }
+    for (uint64_t t = 0; t < HOUR_US; t += p_params->publish_interval_ms * 1000ULL)
+    {
+        times.radio_tx += p_params->tx_per_message * ADV_EVENT_TX_US;
+        times.active += p_params->tx_per_message * CPU_PER_RADIO_US;
+    }
+
+    if (profile == PROFILE_LPN)
+    {
+        /* A Friend Poll goes out once, then the receive delay is slept
+         * through and the radio listens for one receive window */
+        for (uint64_t t = 0; t < HOUR_US; t += p_params->poll_interval_ms * 1000ULL)
+        {
+            times.radio_tx += ADV_EVENT_TX_US;
+            times.radio_rx_permille += p_params->receive_window_ms * 1000ULL * 1000;
+            times.active += 2 * CPU_PER_RADIO_US;
+        }
+    }
+    else
+    {
+        times.radio_rx_permille = times.total * 1000;
+    }
+
+    if (profile == PROFILE_GATEWAY)
+    {
+        for (uint64_t t = 0; t < HOUR_US; t += p_params->publish_interval_ms * 1000ULL)
+        {
+            times.uart += p_params->gateway_nodes * UART_LINE_US;
+            times.active += p_params->gateway_nodes * CPU_PER_RADIO_US;
+        }
+    }
+    return times;
+}
+
+/* The same profile as the node's power report accounts it: RX from the duty
+ * cycle app_friendship sets, no TX time. */
+static power_model_times_t profile_report(profile_t profile, const params_t * p_params)
+{
+    power_model_times_t times = profile_walk(profile, p_params);
+    times.radio_tx = 0;
+    if (profile == PROFILE_LPN)
+    {
+        times.radio_rx_permille = times.total *
+            power_model_lpn_rx_permille(p_params->receive_window_ms, p_params->poll_interval_ms);
+    }
+    return times;
+}
+
+static double battery_days(uint32_t avg_ua, uint32_t battery_mah)
+{
+    return (avg_ua == 0) ? 0.0 : (battery_mah * 1000.0) / avg_ua / 24.0;
+}
+
+static uint32_t profile_print(profile_t profile, const params_t * p_params, uint32_t battery_mah)
+{
+    power_model_times_t times = profile_walk(profile, p_params);
+    power_model_times_t report = profile_report(profile, p_params);
+    uint32_t avg = power_model_avg_ua(&times);
+    uint32_t report_avg = power_model_avg_ua(&report);
+    uint32_t poll = (profile == PROFILE_LPN) ? p_params->poll_interval_ms : 0;
+
+    printf("%-8s %8u %7u %8u %9u %10.1f\n", m_profile_names[profile], poll,
+           power_model_duty_permille(&times), avg, report_avg, battery_days(avg, battery_mah));
+
+    if (profile == PROFILE_LPN)
+    {
+        /* Truncating the duty cycle to per mille loses at most 1 per mille of RX */
+        check(report.radio_rx_permille <= times.radio_rx_permille &&
+              times.radio_rx_permille - report.radio_rx_permille <= times.total,
+              "LPN duty cycle matches the receive windows");
+    }
+    return avg;
+}
+
+static void check_states(void)
+{
+    power_model_times_t times;
+
+    memset(&times, 0, sizeof(times));
+    check(power_model_avg_ua(&times) == 0, "no time, no current");
+
+    times.total = HOUR_US;
+    check(power_model_avg_ua(&times) == APP_POWER_SLEEP_UA, "asleep");
+    check(power_model_duty_permille(&times) == 0, "asleep duty");
+
+    times.active = HOUR_US;
+    check(power_model_avg_ua(&times) == APP_POWER_CPU_UA, "CPU always on");
+    check(power_model_duty_permille(&times) == 1000, "CPU duty");
+
+    times.active = 0;
+    times.radio_rx_permille = HOUR_US * 1000;
+    check(power_model_avg_ua(&times) == APP_POWER_SLEEP_UA + APP_POWER_RADIO_RX_UA, "scanner always on");
+
+    times.radio_rx_permille = HOUR_US * 500;
+    check(power_model_avg_ua(&times) == APP_POWER_SLEEP_UA + APP_POWER_RADIO_RX_UA / 2, "scanner half the time");
+
+    times.radio_rx_permille = 0;
+    times.twi = HOUR_US;
+    times.uart = HOUR_US;
+    times.radio_tx = HOUR_US;
+    check(power_model_avg_ua(&times) ==
+          APP_POWER_SLEEP_UA + APP_POWER_TWI_UA + APP_POWER_UART_UA + APP_POWER_RADIO_TX_UA,
+          "peripherals always on");
+
+    check(power_model_lpn_rx_permille(100, 10) == 1000, "RX duty capped");
+    check(power_model_lpn_rx_permille(255, APP_LPN_POLL_INTERVAL_MS) ==
+          (1000UL * 255) / APP_LPN_POLL_INTERVAL_MS, "RX duty at the configured poll interval");
+}
+
+static bool parse_u32(const char * p_arg, uint32_t * p_val)
+{
+    char * p_end;
+    unsigned long val = strtoul(p_arg, &p_end, 0);
+    if (*p_end != '\0' || val == 0 || val > UINT32_MAX / 1000)
+    {
+        return false;
+    }
+    *p_val = (uint32_t)val;
+    return true;
+}
+
+int main(int argc, char ** argv)
+{
+    params_t params =
+    {
+        .meas_interval_ms = 1000,           /* APP_SENSOR_IAQ_MEAS_INTERVAL_MS */
+        .cpu_per_meas_us = 2500,
+        .publish_interval_ms = 10000,
+        .tx_per_message = 2,
+        .poll_interval_ms = APP_LPN_POLL_INTERVAL_MS,
+        .receive_window_ms = 50,
+        .gateway_nodes = 10,
+    };
+    uint32_t twi_freq_hz = 100000;          /* APP_TWI_BUS_FREQ_HZ */
+    uint32_t battery_mah = 2400;
+    bool env_local = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        uint32_t * p_val = NULL;
+        if (strcmp(argv[i], "-e") == 0)
+        {
+            env_local = true;
+            continue;
+        }
+        if (strcmp(argv[i], "-m") == 0) p_val = &params.meas_interval_ms;
+        else if (strcmp(argv[i], "-p") == 0) p_val = &params.publish_interval_ms;
+        else if (strcmp(argv[i], "-i") == 0) p_val = &params.poll_interval_ms;
+        else if (strcmp(argv[i], "-w") == 0) p_val = &params.receive_window_ms;
+        else if (strcmp(argv[i], "-c") == 0) p_val = &params.cpu_per_meas_us;
+        else if (strcmp(argv[i], "-x") == 0) p_val = &params.tx_per_message;
+        else if (strcmp(argv[i], "-f") == 0) p_val = &twi_freq_hz;
+        else if (strcmp(argv[i], "-b") == 0) p_val = &battery_mah;
+        else if (strcmp(argv[i], "-n") == 0) p_val = &params.gateway_nodes;
+
+        if (p_val == NULL || i + 1 >= argc || !parse_u32(argv[++i], p_val))
+        {
+            fprintf(stderr, "usage: %s [-m <ms>] [-p <ms>] [-i <ms>] [-w <ms>] [-c <us>] [-x <count>] "
+                    "[-f <Hz>] [-e] [-b <mAh>] [-n <nodes>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    params.twi_per_meas_us = twi_budget_cycle_us(twi_budget_zmod_cycle, TWI_BUDGET_ZMOD_CYCLE_COUNT, twi_freq_hz);
+    if (env_local)
+    {
+        params.twi_per_meas_us += twi_budget_cycle_us(twi_budget_env_cycle, TWI_BUDGET_ENV_CYCLE_COUNT, twi_freq_hz);
+    }
+
+    check_states();
+
+    printf("# measurement %u ms (%u us CPU, %u us TWI at %u Hz%s), publish every %u ms x%u, "
+           "receive window %u ms, %u mAh, %u nodes behind the gateway\n",
+           params.meas_interval_ms, params.cpu_per_meas_us, params.twi_per_meas_us, twi_freq_hz,
+           env_local ? ", local SHT4x" : "", params.publish_interval_ms, params.tx_per_message,
+           params.receive_window_ms, battery_mah, params.gateway_nodes);
+    printf("%-8s %8s %7s %8s %9s %10s\n", "profile", "poll_ms", "duty_pm", "avg_uA", "report_uA", "days");
+
+    uint32_t relay = profile_print(PROFILE_RELAY, &params, battery_mah);
+    uint32_t gateway = profile_print(PROFILE_GATEWAY, &params, battery_mah);
+    uint32_t lpn = profile_print(PROFILE_LPN, &params, battery_mah);
+    check(relay >= APP_POWER_RADIO_RX_UA, "relay draws at least the scanner current");
+    check(gateway > relay, "gateway adds the UART");
+    check(lpn < relay, "LPN draws less than the relay");
+
+    printf("# lpn poll interval sweep\n");
+    uint32_t prev = UINT32_MAX;
+    params_t sweep = params;
+    for (uint32_t i = 0; i < sizeof(m_poll_sweep_ms) / sizeof(m_poll_sweep_ms[0]); i++)
+    {
+        sweep.poll_interval_ms = m_poll_sweep_ms[i];
+        if (sweep.receive_window_ms >= sweep.poll_interval_ms)
+        {
+            continue;
+        }
+        uint32_t avg = profile_print(PROFILE_LPN, &sweep, battery_mah);
+        check(avg <= prev, "LPN current does not grow with the poll interval");
+        prev = avg;
+    }
+
+    if (m_failures > 0)
+    {
+        fprintf(stderr, "%u checks failed\n", m_failures);
+        return 1;
+    }
+    printf("power_model: all checks passed\n");
+    return 0;
+}
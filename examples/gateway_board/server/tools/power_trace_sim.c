@@ -0,0 +1,632 @@
+/*
+ * Host run of the sleep-state accounting (src/app_power.c) over an event trace.
+ *
+ * The trace lists what wakes the node: the measurement timer with its TWI
+ * window, the TWI completion, SoftDevice radio events, and the gateway's
+ * UART lines byte by byte (app_uart takes an interrupt per TX byte). Each
+ * event carries the CPU time of its handler and the peripheral it switches
+ * on or off. The real app_power.c runs in a main loop like main.c's, with
+ * sd_app_evt_wait() sleeping until the next trace event or the power report
+ * timer, on a 24-bit RTC at 32768 Hz that wraps several times in a run.
+ *
+ * The tool keeps its own account of the trace in RTC ticks and checks every
+ * power report app_power publishes, and the final one, against it: wake-ups
+ * and active time per source, uptime, duty cycle, and the average current
+ * from power_model. It then reports the UART throughput the trace carried
+ * and its cost: bytes per second, share of the baud rate, UART on-time and
+ * wake-ups per byte, and the current the UART and its interrupts add.
+ *
+ * Without a trace file one is generated from the options; -o writes it out.
+ * One event per line, times in nanoseconds:
+ *
+ *   <time> <timer|twi|radio|uart> <cpu time> [on|off <twi|uart>]
+ *
+ * A radio event is a wake-up nobody claims, as the SoftDevice's are.
+ *
+ * Build and run; the exit status is non-zero on a failed check:
+ *
+ *   cc -O2 -Ihost -I../src -I../include -o power_trace_sim power_trace_sim.c \
+ *      ../src/app_power.c ../src/power_model.c ../src/twi_budget.c
+ *   ./power_trace_sim [-s <seconds>] [-r <radio events/s>] [-n <gateway nodes>]
+ *                     [-p <publish interval ms>] [-o <trace out>] [<trace in>]
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_power.h"
+#include "app_sched_prio.h"
+#include "app_timer.h"
+#include "iaq_codec.h"
+#include "mesh_vendor_model.h"
+#include "nrf_error.h"
+#include "nrf_soc.h"
+#include "twi_budget.h"
+
+#define NS_PER_S            1000000000ULL
+#define RTC_MASK            0xFFFFFF
+#define RTC_START           (RTC_MASK - 1000)   /* Wraps early in the run */
+
+#define MEAS_INTERVAL_NS    (1000ULL * 1000000) /* APP_SENSOR_IAQ_MEAS_INTERVAL_MS */
+#define MEAS_CPU_NS         2500000
+#define TWI_DONE_CPU_NS     50000
+#define TWI_FREQ_HZ         100000              /* APP_TWI_BUS_FREQ_HZ */
+#define RADIO_CPU_NS        300000
+#define UART_BYTE_CPU_NS    5000
+#define UART_BAUD           115200
+#define UART_BYTE_NS        ((10 * NS_PER_S) / UART_BAUD)
+#define REPORT_CPU_NS       1000000
+
+#define SRC_UNCLAIMED       APP_POWER_SRC_RADIO
+
+typedef enum
+{
+    ACTION_NONE,
+    ACTION_ON,
+    ACTION_OFF,
+} action_t;
+
+typedef struct
+{
+    uint64_t t_ns;
+    uint32_t cpu_ns;
+    uint8_t src;
+    uint8_t action;
+    uint8_t periph;
+} trace_event_t;
+
+/* The tool's own account, in RTC ticks since app_power_init() */
+typedef struct
+{
+    uint64_t sleep;
+    uint64_t active[APP_POWER_SRC_COUNT];
+    uint32_t wakeups[APP_POWER_SRC_COUNT];
+    uint64_t periph[APP_POWER_SRC_COUNT];
+    uint64_t periph_since[APP_POWER_SRC_COUNT];
+    bool periph_on[APP_POWER_SRC_COUNT];
+    uint64_t period_start;
+    uint8_t period_src;
+    bool period_slept;
+} account_t;
+
+static const char * const m_src_names[APP_POWER_SRC_COUNT] = { "timer", "twi", "radio", "uart" };
+
+static trace_event_t * mp_trace;
+static uint32_t m_trace_count;
+static uint32_t m_trace_pos;
+
+static uint64_t m_now_ns;
+static uint64_t m_work_ns;
+static bool m_done;
+static account_t m_account;
+
+static app_timer_timeout_handler_t m_timer_handler;
+static uint64_t m_timer_period_ticks;
+static uint64_t m_timer_next_ticks;
+
+static app_sched_prio_handler_t m_sched_handler;
+
+static uint32_t m_reports;
+static uint32_t m_lcg = 12345;
+static uint32_t m_failures;
+
+static uint32_t next_random(void)
+{
+    m_lcg = m_lcg * 1103515245u + 12345u;
+    return m_lcg >> 8;
+}
+
+static void check(bool ok, const char * p_what)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL %s\n", p_what);
+        m_failures++;
+    }
+}
+
+static uint64_t ns_to_ticks(uint64_t ns)
+{
+    return (ns * APP_TIMER_CLOCK_FREQ) / NS_PER_S;
+}
+
+static uint64_t ticks_to_ns(uint64_t ticks)
+{
+    return (ticks * NS_PER_S + APP_TIMER_CLOCK_FREQ - 1) / APP_TIMER_CLOCK_FREQ;
+}
+
+static uint16_t sat_u16(uint64_t val)
+{
+    return (val > UINT16_MAX) ? UINT16_MAX : (uint16_t)val;
+}
+
+/*****************************************************************************
+ * SDK and application stand-ins
+ *****************************************************************************/
+
+uint32_t app_timer_cnt_get(void)
+{
+    return (uint32_t)((ns_to_ticks(m_now_ns) + RTC_START) & RTC_MASK);
+}
+
+uint32_t app_timer_cnt_diff_compute(uint32_t ticks_to, uint32_t ticks_from)
+{
+    return (ticks_to - ticks_from) & RTC_MASK;
+}
+
+ret_code_t app_timer_create(app_timer_id_t const * p_timer_id, app_timer_mode_t mode,
+                            app_timer_timeout_handler_t timeout_handler)
+{
+    (void)p_timer_id;
+    check(mode == APP_TIMER_MODE_REPEATED, "report timer repeats");
+    m_timer_handler = timeout_handler;
+    return NRF_SUCCESS;
+}
+
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void * p_context)
+{
+    (void)timer_id;
+    (void)p_context;
+    m_timer_period_ticks = timeout_ticks;
+    m_timer_next_ticks = ns_to_ticks(m_now_ns) + timeout_ticks;
+    return NRF_SUCCESS;
+}
+
+uint32_t app_sched_prio_put(app_sched_class_t cls, const void * p_event_data, uint16_t event_size,
+                            app_sched_prio_handler_t handler, const char * p_name)
+{
+    (void)cls;
+    (void)p_event_data;
+    (void)event_size;
+    (void)p_name;
+    check(m_sched_handler == NULL, "one report at a time");
+    m_sched_handler = handler;
+    return NRF_SUCCESS;
+}
+
+static void account_check(const app_power_report_t * p_report, uint64_t now, const char * p_when);
+
+uint32_t mesh_publish_power_status(const app_power_report_t * p_report)
+{
+    /* The scheduled report runs first thing in the timer's wake-up */
+    account_check(p_report, ns_to_ticks(m_now_ns), "periodic report");
+    m_reports++;
+    return NRF_SUCCESS;
+}
+
+/*****************************************************************************
+ * The tool's own account
+ *****************************************************************************/
+
+static void account_wake(uint64_t now, uint8_t src, bool slept)
+{
+    m_account.period_start = now;
+    m_account.period_src = src;
+    m_account.period_slept = slept;
+}
+
+static void account_idle(uint64_t now)
+{
+    m_account.active[m_account.period_src] += now - m_account.period_start;
+    if (m_account.period_slept)
+    {
+        m_account.wakeups[m_account.period_src]++;
+    }
+}
+
+static void account_periph(uint64_t now, uint8_t periph, action_t action)
+{
+    if (action == ACTION_ON && !m_account.periph_on[periph])
+    {
+        m_account.periph_on[periph] = true;
+        m_account.periph_since[periph] = now;
+    }
+    else if (action == ACTION_OFF && m_account.periph_on[periph])
+    {
+        m_account.periph_on[periph] = false;
+        m_account.periph[periph] += now - m_account.periph_since[periph];
+    }
+}
+
+static uint64_t account_periph_ticks(uint64_t now, uint8_t periph)
+{
+    return m_account.periph[periph] + (m_account.periph_on[periph] ? now - m_account.periph_since[periph] : 0);
+}
+
+/* Periods still running at now are in the duty cycle, not in the per-source figures */
+static void account_check(const app_power_report_t * p_report, uint64_t now, const char * p_when)
+{
+    power_model_times_t times =
+    {
+        .total = now,
+        .active = now - m_account.sleep,
+        .twi = account_periph_ticks(now, APP_POWER_SRC_TWI),
+        .uart = account_periph_ticks(now, APP_POWER_SRC_UART),
+        .radio_rx_permille = now * APP_POWER_SCAN_DUTY_PERMILLE,
+        .radio_tx = 0,
+    };
+    bool ok = p_report->uptime_s == (uint32_t)((now * 1000 / APP_TIMER_CLOCK_FREQ) / 1000) &&
+              p_report->duty_permille == power_model_duty_permille(&times) &&
+              p_report->avg_current_ua == sat_u16(power_model_avg_ua(&times));
+
+    for (uint32_t i = 0; i < APP_POWER_SRC_COUNT; i++)
+    {
+        ok = ok && p_report->wakeups[i] == sat_u16(m_account.wakeups[i]) &&
+             p_report->active_ms[i] == sat_u16(m_account.active[i] * 1000 / APP_TIMER_CLOCK_FREQ);
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "%s at tick %llu: app_power %u s %u pm %u uA, trace %u pm %u uA\n", p_when,
+                (unsigned long long)now, p_report->uptime_s, p_report->duty_permille, p_report->avg_current_ua,
+                power_model_duty_permille(&times), power_model_avg_ua(&times));
+    }
+    check(ok, "power report matches the trace");
+}
+
+/*****************************************************************************
+ * Main loop
+ *****************************************************************************/
+
+uint32_t sd_app_evt_wait(void)
+{
+    uint64_t idle = ns_to_ticks(m_now_ns);
+    bool timer = false;
+    uint64_t at_ns;
+
+    if (m_trace_pos == m_trace_count)
+    {
+        m_done = true;
+        return NRF_SUCCESS;
+    }
+
+    at_ns = mp_trace[m_trace_pos].t_ns;
+    if (m_timer_handler != NULL && ticks_to_ns(m_timer_next_ticks) <= at_ns)
+    {
+        at_ns = ticks_to_ns(m_timer_next_ticks);
+        timer = true;
+    }
+    if (at_ns > m_now_ns)
+    {
+        m_now_ns = at_ns;
+    }
+
+    /* An event due while the CPU was busy runs without a wake-up */
+    uint64_t now = ns_to_ticks(m_now_ns);
+    m_account.sleep += now - idle;
+
+    if (timer)
+    {
+        m_timer_next_ticks += m_timer_period_ticks;
+        account_wake(now, APP_POWER_SRC_TIMER, now != idle);
+        m_timer_handler(NULL);
+        m_work_ns = REPORT_CPU_NS;
+        return NRF_SUCCESS;
+    }
+
+    const trace_event_t * p_event = &mp_trace[m_trace_pos++];
+    account_wake(now, p_event->src, now != idle);
+    if (p_event->src != SRC_UNCLAIMED)
+    {
+        app_power_wake_mark((app_power_src_t)p_event->src);
+    }
+    if (p_event->action == ACTION_ON)
+    {
+        app_power_periph_on((app_power_src_t)p_event->periph);
+    }
+    else if (p_event->action == ACTION_OFF)
+    {
+        app_power_periph_off((app_power_src_t)p_event->periph);
+    }
+    account_periph(now, p_event->periph, (action_t)p_event->action);
+    m_work_ns = p_event->cpu_ns;
+    return NRF_SUCCESS;
+}
+
+static void run(void)
+{
+    m_now_ns = 0;
+    memset(&m_account, 0, sizeof(m_account));
+    account_wake(0, SRC_UNCLAIMED, false);
+    app_power_init();
+
+    for (;;)
+    {
+        if (m_sched_handler != NULL)
+        {
+            app_sched_prio_handler_t handler = m_sched_handler;
+            m_sched_handler = NULL;
+            handler(NULL, 0);
+        }
+        m_now_ns += m_work_ns;
+        m_work_ns = 0;
+        if (m_done)
+        {
+            break;
+        }
+        account_idle(ns_to_ticks(m_now_ns));
+        app_power_idle();
+    }
+
+    app_power_report_t report;
+    app_power_report_get(&report);
+    account_check(&report, ns_to_ticks(m_now_ns), "final report");
+
+    printf("# %u events, %u power reports; final report: uptime %u s, duty %u.%u %%, %u uA\n",
+           m_trace_count, m_reports, report.uptime_s, report.duty_permille / 10, report.duty_permille % 10,
+           report.avg_current_ua);
+    printf("%-6s %8s %10s\n", "source", "wakeups", "active_ms");
+    for (uint32_t i = 0; i < APP_POWER_SRC_COUNT; i++)
+    {
+        printf("%-6s %8u %10u\n", m_src_names[i], report.wakeups[i], report.active_ms[i]);
+    }
+}
+
+/*****************************************************************************
+ * Trace
+ *****************************************************************************/
+
+static trace_event_t * trace_add(uint64_t t_ns, uint8_t src, uint32_t cpu_ns, action_t action, uint8_t periph)
+{
+    static uint32_t s_capacity;
+    if (m_trace_count == s_capacity)
+    {
+        s_capacity = s_capacity ? 2 * s_capacity : 4096;
+        mp_trace = realloc(mp_trace, s_capacity * sizeof(*mp_trace));
+        if (mp_trace == NULL)
+        {
+            perror("realloc");
+            exit(2);
+        }
+    }
+    trace_event_t * p_event = &mp_trace[m_trace_count++];
+    p_event->t_ns = t_ns;
+    p_event->src = src;
+    p_event->cpu_ns = cpu_ns;
+    p_event->action = (uint8_t)action;
+    p_event->periph = periph;
+    return p_event;
+}
+
+static int trace_compare(const void * p_a, const void * p_b)
+{
+    const trace_event_t * p_ea = p_a;
+    const trace_event_t * p_eb = p_b;
+    return (p_ea->t_ns > p_eb->t_ns) - (p_ea->t_ns < p_eb->t_ns);
+}
+
+static void trace_generate(uint32_t seconds, uint32_t radio_per_s, uint32_t nodes, uint32_t publish_ms)
+{
+    uint64_t end_ns = seconds * NS_PER_S;
+    uint64_t twi_ns = twi_budget_cycle_us(twi_budget_zmod_cycle, TWI_BUDGET_ZMOD_CYCLE_COUNT, TWI_FREQ_HZ) * 1000ULL;
+
+    for (uint64_t t = MEAS_INTERVAL_NS; t < end_ns; t += MEAS_INTERVAL_NS)
+    {
+        trace_add(t, APP_POWER_SRC_TIMER, MEAS_CPU_NS, ACTION_ON, APP_POWER_SRC_TWI);
+        trace_add(t + twi_ns, APP_POWER_SRC_TWI, TWI_DONE_CPU_NS, ACTION_OFF, APP_POWER_SRC_TWI);
+    }
+
+    for (uint64_t i = 0; i < (uint64_t)radio_per_s * seconds; i++)
+    {
+        trace_add(((uint64_t)next_random() * next_random()) % end_ns, SRC_UNCLAIMED, RADIO_CPU_NS,
+                  ACTION_NONE, 0);
+    }
+
+    /* Each node's reading arrives over the radio and goes out on the UART as
+     * one line; the gateway sends lines back to back */
+    uint64_t uart_free = 0;
+    for (uint64_t t = 0; t + publish_ms * 1000000ULL < end_ns; t += publish_ms * 1000000ULL)
+    {
+        for (uint32_t node = 0; node < nodes; node++)
+        {
+            uint64_t rx = t + ((uint64_t)next_random() * 1000) % (publish_ms * 1000000ULL);
+            uint64_t start = (rx + RADIO_CPU_NS > uart_free) ? rx + RADIO_CPU_NS : uart_free;
+            uint32_t bytes = 32 + next_random() % (IAQ_CODEC_LINE_MAX - 31);
+
+            trace_add(rx, SRC_UNCLAIMED, RADIO_CPU_NS, ACTION_NONE, 0);
+            trace_add(start, SRC_UNCLAIMED, 0, ACTION_ON, APP_POWER_SRC_UART);
+            for (uint32_t b = 1; b <= bytes; b++)
+            {
+                trace_add(start + b * UART_BYTE_NS, APP_POWER_SRC_UART, UART_BYTE_CPU_NS,
+                          (b == bytes) ? ACTION_OFF : ACTION_NONE, APP_POWER_SRC_UART);
+            }
+            uart_free = start + bytes * UART_BYTE_NS + UART_BYTE_CPU_NS;
+        }
+    }
+
+    qsort(mp_trace, m_trace_count, sizeof(*mp_trace), trace_compare);
+}
+
+static int src_parse(const char * p_name)
+{
+    for (int i = 0; i < APP_POWER_SRC_COUNT; i++)
+    {
+        if (strcmp(p_name, m_src_names[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool trace_load(const char * p_path)
+{
+    FILE * p_file = fopen(p_path, "r");
+    if (p_file == NULL)
+    {
+        perror(p_path);
+        return false;
+    }
+
+    char line[128];
+    uint32_t line_no = 0;
+    uint64_t last = 0;
+    while (fgets(line, sizeof(line), p_file) != NULL)
+    {
+        unsigned long long t_ns;
+        unsigned long cpu_ns;
+        char src[8];
+        char action[8] = "";
+        char periph[8] = "";
+
+        line_no++;
+        if (line[0] == '#' || line[0] == '\n')
+        {
+            continue;
+        }
+        int fields = sscanf(line, "%llu %7s %lu %7s %7s", &t_ns, src, &cpu_ns, action, periph);
+        int src_id = (fields >= 3) ? src_parse(src) : -1;
+        int periph_id = (fields == 5) ? src_parse(periph) : 0;
+        action_t act = (fields < 5) ? ACTION_NONE : (strcmp(action, "on") == 0) ? ACTION_ON :
+                       (strcmp(action, "off") == 0) ? ACTION_OFF : (action_t)-1;
+        if (src_id < 0 || periph_id < 0 || (fields != 3 && fields != 5) || (int)act < 0 || t_ns < last)
+        {
+            fprintf(stderr, "%s:%u: expected <time> <source> <cpu> [on|off <peripheral>] in time order\n",
+                    p_path, line_no);
+            fclose(p_file);
+            return false;
+        }
+        trace_add(t_ns, (uint8_t)src_id, (uint32_t)cpu_ns, act, (uint8_t)periph_id);
+        last = t_ns;
+    }
+    fclose(p_file);
+    return true;
+}
+
+static bool trace_save(const char * p_path)
+{
+    FILE * p_file = fopen(p_path, "w");
+    if (p_file == NULL)
+    {
+        perror(p_path);
+        return false;
+    }
+    fprintf(p_file, "# time_ns source cpu_ns [on|off peripheral]\n");
+    for (uint32_t i = 0; i < m_trace_count; i++)
+    {
+        const trace_event_t * p_event = &mp_trace[i];
+        fprintf(p_file, "%llu %s %u", (unsigned long long)p_event->t_ns, m_src_names[p_event->src],
+                p_event->cpu_ns);
+        if (p_event->action != ACTION_NONE)
+        {
+            fprintf(p_file, " %s %s", (p_event->action == ACTION_ON) ? "on" : "off", m_src_names[p_event->periph]);
+        }
+        fprintf(p_file, "\n");
+    }
+    fclose(p_file);
+    return true;
+}
+
+/* UART throughput and cost, from the trace itself */
+static void uart_summary(void)
+{
+    uint64_t bytes = 0;
+    uint64_t lines = 0;
+    uint64_t on_ns = 0;
+    uint64_t since = 0;
+    uint64_t cpu_ns = 0;
+
+    for (uint32_t i = 0; i < m_trace_count; i++)
+    {
+        const trace_event_t * p_event = &mp_trace[i];
+        if (p_event->src == APP_POWER_SRC_UART)
+        {
+            bytes++;
+            cpu_ns += p_event->cpu_ns;
+        }
+        if (p_event->periph == APP_POWER_SRC_UART && p_event->action == ACTION_ON)
+        {
+            since = p_event->t_ns;
+            lines++;
+        }
+        else if (p_event->periph == APP_POWER_SRC_UART && p_event->action == ACTION_OFF)
+        {
+            on_ns += p_event->t_ns - since;
+        }
+    }
+    if (bytes == 0 || m_now_ns == 0)
+    {
+        printf("# UART: no traffic\n");
+        return;
+    }
+
+    double seconds = (double)m_now_ns / NS_PER_S;
+    double cost_ua = ((double)on_ns * APP_POWER_UART_UA + (double)cpu_ns * APP_POWER_CPU_UA) / m_now_ns;
+    printf("# UART: %llu lines, %llu bytes, %.1f B/s (%.2f %% of %u baud), on %.1f us per byte, "
+           "%.1f wake-ups/s, %.1f uA\n",
+           (unsigned long long)lines, (unsigned long long)bytes, bytes / seconds,
+           100.0 * bytes * 10 / (seconds * UART_BAUD), UART_BAUD, (double)on_ns / 1000 / bytes,
+           m_account.wakeups[APP_POWER_SRC_UART] / seconds, cost_ua);
+
+    check(on_ns >= bytes * UART_BYTE_NS, "UART on at least as long as the bytes take on the wire");
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t seconds = 3600;
+    uint32_t radio_per_s = 20;
+    uint32_t nodes = 10;
+    uint32_t publish_ms = 10000;
+    const char * p_out = NULL;
+    const char * p_in = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        uint32_t * p_val = NULL;
+        if (strcmp(argv[i], "-s") == 0) p_val = &seconds;
+        else if (strcmp(argv[i], "-r") == 0) p_val = &radio_per_s;
+        else if (strcmp(argv[i], "-n") == 0) p_val = &nodes;
+        else if (strcmp(argv[i], "-p") == 0) p_val = &publish_ms;
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            p_out = argv[++i];
+            continue;
+        }
+        else if (argv[i][0] != '-' && p_in == NULL)
+        {
+            p_in = argv[i];
+            continue;
+        }
+
+        if (p_val == NULL || i + 1 >= argc || (*p_val = (uint32_t)strtoul(argv[++i], NULL, 0)) == 0)
+        {
+            fprintf(stderr, "usage: %s [-s <seconds>] [-r <radio events/s>] [-n <gateway nodes>] "
+                    "[-p <publish interval ms>] [-o <trace out>] [<trace in>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (p_in != NULL)
+    {
+        if (!trace_load(p_in))
+        {
+            return 2;
+        }
+    }
+    else
+    {
+        trace_generate(seconds, radio_per_s, nodes, publish_ms);
+        printf("# generated %u s: measurement every %llu ms, %u radio events/s, %u nodes every %u ms\n",
+               seconds, MEAS_INTERVAL_NS / 1000000, radio_per_s, nodes, publish_ms);
+    }
+    if (p_out != NULL && !trace_save(p_out))
+    {
+        return 2;
+    }
+
+    run();
+    uart_summary();
+    check(m_reports >= (uint32_t)(m_now_ns / (APP_POWER_REPORT_INTERVAL_MS * 1000000ULL)),
+          "a report every APP_POWER_REPORT_INTERVAL_MS");
+
+    free(mp_trace);
+    if (m_failures > 0)
+    {
+        fprintf(stderr, "%u checks failed\n", m_failures);
+        return 1;
+    }
+    printf("power_trace: all checks passed\n");
+    return 0;
+}
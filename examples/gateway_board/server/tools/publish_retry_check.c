@@ -0,0 +1,291 @@
+/*
+ * Error-injection check of the live reading retry queue (src/publish_retry.h).
+ *
+ * A fake publish fails on demand, in bursts or at random, and a fake flash
+ * store takes the spilled readings. Checked:
+ *  - the backoff doubles from the minimum to the cap, stays there, and drops
+ *    back to the minimum once the queue drains; the jitter stays within 25 %;
+ *  - a reading that fails PUBLISH_RETRY_MAX_ATTEMPTS times is counted as
+ *    dropped, spilled with its capture time, and the next one goes at once;
+ *  - a full queue displaces its newest reading, counted as coalesced and
+ *    spilled, and the oldest keeps its place at the head;
+ *  - over a long random run every reading is either published or spilled,
+ *    exactly once, and the published ones go out in capture order.
+ *
+ * Build and run; the exit status is non-zero on a failed check:
+ *
+ *   cc -O2 -I../src -o publish_retry_check publish_retry_check.c ../src/publish_retry.c
+ *   ./publish_retry_check [-n <readings>]
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "publish_retry.h"
+
+#define ERROR_BUSY  0x11        /* Any non-zero status; the queue does not interpret it */
+#define LOG_MAX     200000
+
+typedef struct
+{
+    uint32_t fail_next;         /* Fail this many sends, then succeed */
+    uint32_t fail_permille;     /* Random failures after that */
+    uint32_t sends;
+    uint32_t published[LOG_MAX];
+    uint32_t published_count;
+    uint32_t spilled[LOG_MAX];
+    uint32_t spilled_ts[LOG_MAX];
+    uint32_t spilled_count;
+} fake_link_t;
+
+static uint32_t m_lcg = 12345;
+static uint32_t m_failures;
+static fake_link_t m_link;
+
+static uint32_t next_random(void)
+{
+    m_lcg = m_lcg * 1103515245u + 12345u;
+    return m_lcg >> 8;
+}
+
+static void check(bool ok, const char * p_what)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL %s\n", p_what);
+        m_failures++;
+    }
+}
+
+/* The reading's sequence number is the payload's first four bytes */
+static void payload_make(uint8_t * p_payload, uint32_t seq)
+{
+    memset(p_payload, 0, PUBLISH_RETRY_PAYLOAD_MAX);
+    memcpy(p_payload, &seq, sizeof(seq));
+}
+
+static uint32_t payload_seq(const uint8_t * p_payload)
+{
+    uint32_t seq;
+    memcpy(&seq, p_payload, sizeof(seq));
+    return seq;
+}
+
+static uint32_t fake_send(const uint8_t * p_payload, uint8_t length, void * p_context)
+{
+    fake_link_t * p_link = p_context;
+    (void)length;
+
+    p_link->sends++;
+    if (p_link->fail_next > 0)
+    {
+        p_link->fail_next--;
+        return ERROR_BUSY;
+    }
+    if (p_link->fail_permille > 0 && next_random() % 1000 < p_link->fail_permille)
+    {
+        return ERROR_BUSY;
+    }
+    if (p_link->published_count < LOG_MAX)
+    {
+        p_link->published[p_link->published_count++] = payload_seq(p_payload);
+    }
+    return 0;
+}
+
+static void fake_spill(const publish_retry_entry_t * p_entry, void * p_context)
+{
+    fake_link_t * p_link = p_context;
+
+    if (p_link->spilled_count < LOG_MAX)
+    {
+        p_link->spilled[p_link->spilled_count] = payload_seq(p_entry->payload);
+        p_link->spilled_ts[p_link->spilled_count] = p_entry->timestamp_s;
+        p_link->spilled_count++;
+    }
+}
+
+static void push(publish_retry_t * p_retry, uint32_t seq)
+{
+    uint8_t payload[PUBLISH_RETRY_PAYLOAD_MAX];
+    payload_make(payload, seq);
+    /* Capture time derived from the sequence, to check it survives the spill */
+    publish_retry_push(p_retry, payload, sizeof(payload), 1000 + seq, fake_spill, &m_link);
+}
+
+static void check_backoff(void)
+{
+    publish_retry_t retry;
+    publish_retry_init(&retry);
+    memset(&m_link, 0, sizeof(m_link));
+
+    check(!publish_retry_pending(&retry), "empty after init");
+    check(retry.backoff_ms == PUBLISH_RETRY_BACKOFF_MIN_MS, "backoff starts at the minimum");
+
+    push(&retry, 1);
+    m_link.fail_next = PUBLISH_RETRY_MAX_ATTEMPTS - 1;
+
+    uint32_t expected = PUBLISH_RETRY_BACKOFF_MIN_MS;
+    for (uint32_t i = 0; i + 1 < PUBLISH_RETRY_MAX_ATTEMPTS; i++)
+    {
+        check(publish_retry_run(&retry, fake_send, fake_spill, &m_link) == ERROR_BUSY, "failed send reported");
+        expected = (expected * 2 > PUBLISH_RETRY_BACKOFF_MAX_MS) ? PUBLISH_RETRY_BACKOFF_MAX_MS : expected * 2;
+        check(retry.backoff_ms == expected, "backoff doubles up to the cap");
+        check(retry.entries[retry.head].attempts == i + 1, "attempts counted");
+
+        for (uint32_t j = 0; j < 1000; j++)
+        {
+            uint32_t delay = publish_retry_delay_ms(&retry, next_random());
+            check(delay >= retry.backoff_ms && delay <= retry.backoff_ms + retry.backoff_ms / 4,
+                  "jitter within 25 %");
+        }
+    }
+
+    /* Without an attempt, e.g. while publication is not configured */
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        publish_retry_backoff(&retry);
+    }
+    check(retry.backoff_ms == PUBLISH_RETRY_BACKOFF_MAX_MS, "backoff capped");
+
+    check(publish_retry_run(&retry, fake_send, fake_spill, &m_link) == 0, "drained on success");
+    check(!publish_retry_pending(&retry), "empty after drain");
+    check(retry.backoff_ms == PUBLISH_RETRY_BACKOFF_MIN_MS, "backoff reset after drain");
+    check(m_link.published_count == 1 && m_link.published[0] == 1, "reading published after retries");
+    check(retry.dropped == 0 && m_link.spilled_count == 0, "nothing dropped below the attempt limit");
+}
+
+static void check_drop(void)
+{
+    publish_retry_t retry;
+    publish_retry_init(&retry);
+    memset(&m_link, 0, sizeof(m_link));
+
+    push(&retry, 7);
+    push(&retry, 8);
+    m_link.fail_next = PUBLISH_RETRY_MAX_ATTEMPTS;
+
+    for (uint32_t i = 0; i + 1 < PUBLISH_RETRY_MAX_ATTEMPTS; i++)
+    {
+        check(publish_retry_run(&retry, fake_send, fake_spill, &m_link) == ERROR_BUSY, "failed send reported");
+    }
+    check(retry.dropped == 0, "not dropped before the last attempt");
+
+    /* The last attempt gives the head up; the next reading goes in the same run */
+    check(publish_retry_run(&retry, fake_send, fake_spill, &m_link) == 0, "next reading sent after a drop");
+    check(retry.dropped == 1, "drop counted");
+    check(m_link.spilled_count == 1 && m_link.spilled[0] == 7, "dropped reading spilled");
+    check(m_link.spilled_ts[0] == 1007, "spilled with its capture time");
+    check(m_link.published_count == 1 && m_link.published[0] == 8, "next reading published");
+    check(m_link.sends == PUBLISH_RETRY_MAX_ATTEMPTS + 1, "send count");
+}
+
+static void check_coalesce(void)
+{
+    publish_retry_t retry;
+    publish_retry_init(&retry);
+    memset(&m_link, 0, sizeof(m_link));
+
+    for (uint32_t seq = 0; seq < PUBLISH_RETRY_QUEUE_SIZE; seq++)
+    {
+        push(&retry, seq);
+    }
+    check(retry.coalesced == 0 && m_link.spilled_count == 0, "no coalescing below capacity");
+
+    push(&retry, 100);
+    push(&retry, 101);
+    check(retry.count == PUBLISH_RETRY_QUEUE_SIZE, "queue stays at capacity");
+    check(retry.coalesced == 2, "coalescing counted");
+    check(m_link.spilled_count == 2, "displaced readings spilled");
+    check(m_link.spilled[0] == PUBLISH_RETRY_QUEUE_SIZE - 1 && m_link.spilled[1] == 100,
+          "the newest queued reading is displaced");
+    check(payload_seq(retry.entries[retry.head].payload) == 0, "the oldest keeps the head");
+
+    check(publish_retry_run(&retry, fake_send, fake_spill, &m_link) == 0, "drained");
+    check(m_link.published_count == PUBLISH_RETRY_QUEUE_SIZE, "publish count");
+    check(m_link.published[PUBLISH_RETRY_QUEUE_SIZE - 1] == 101, "the newest reading goes last");
+}
+
+/* Readings arrive between runs while the link fails at random, in bursts */
+static void check_conservation(uint32_t readings)
+{
+    publish_retry_t retry;
+    publish_retry_init(&retry);
+    memset(&m_link, 0, sizeof(m_link));
+
+    for (uint32_t seq = 0; seq < readings; seq++)
+    {
+        push(&retry, seq);
+        if (next_random() % 500 == 0)
+        {
+            m_link.fail_next = next_random() % (3 * PUBLISH_RETRY_MAX_ATTEMPTS);
+        }
+        m_link.fail_permille = (next_random() % 4 == 0) ? 600 : 50;
+        (void)publish_retry_run(&retry, fake_send, fake_spill, &m_link);
+    }
+    m_link.fail_next = 0;
+    m_link.fail_permille = 0;
+    check(publish_retry_run(&retry, fake_send, fake_spill, &m_link) == 0, "final drain");
+
+    printf("# %u readings: %u published, %u spilled (%u coalesced, %u dropped), %u sends\n", readings,
+           m_link.published_count, m_link.spilled_count, retry.coalesced, retry.dropped, m_link.sends);
+
+    check(retry.coalesced > 0 && retry.dropped > 0, "run exercised both spill paths");
+    check(m_link.spilled_count == retry.coalesced + retry.dropped, "every spill counted once");
+    check(m_link.published_count + m_link.spilled_count == readings, "every reading published or spilled");
+
+    uint8_t * p_seen = calloc(readings, 1);
+    for (uint32_t i = 0; i < m_link.published_count; i++)
+    {
+        check(i == 0 || m_link.published[i] > m_link.published[i - 1], "published in capture order");
+        p_seen[m_link.published[i]]++;
+    }
+    for (uint32_t i = 0; i < m_link.spilled_count; i++)
+    {
+        check(m_link.spilled_ts[i] == 1000 + m_link.spilled[i], "spilled with its capture time");
+        p_seen[m_link.spilled[i]]++;
+    }
+    for (uint32_t seq = 0; seq < readings; seq++)
+    {
+        check(p_seen[seq] == 1, "reading delivered exactly once");
+    }
+    free(p_seen);
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t readings = 100000;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            readings = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n <readings>]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (readings == 0 || readings > LOG_MAX)
+    {
+        fprintf(stderr, "readings must be 1..%u\n", LOG_MAX);
+        return 2;
+    }
+
+    check_backoff();
+    check_drop();
+    check_coalesce();
+    check_conservation(readings);
+
+    if (m_failures > 0)
+    {
+        fprintf(stderr, "%u checks failed\n", m_failures);
+        return 1;
+    }
+    printf("publish_retry: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,432 @@
+/*
+ * Host simulation of the priority scheduler (src/app_sched_prio.h) under mesh
+ * RX floods and timing jitter.
+ *
+ * The real app_sched_prio.c runs against a fake 24-bit RTC (tools/host/).
+ * Interrupt sources post events while handlers run, as the timer, radio and
+ * UART interrupts do on the node: the measurement timer every second with
+ * jitter, received messages at a random rate, a UART TX empty event per
+ * forwarded message, and a background report. Every handler takes a random
+ * time. The clock starts just before the RTC wraps and runs well past 512 s.
+ *
+ * Two loads are run. The nominal one must not lose an event. The flood one
+ * sends bursts of three mesh RX queues' worth of messages 1 ms apart: the
+ * failed puts must be counted. In both, every measurement event must start as
+ * soon as the handler running when it was posted returns, each pass of the
+ * main loop must stay within the class budgets, every class must run in FIFO
+ * order, and the per-class depth, put failure, run and latency figures must
+ * match the simulation.
+ *
+ * Build and run, also with -DAPP_PROFILE_GATEWAY_HT=1; the exit status is
+ * non-zero on a failed check:
+ *
+ *   cc -O2 -Ihost -I../src -I../include -o sched_flood_sim sched_flood_sim.c ../src/app_sched_prio.c
+ *   ./sched_flood_sim [-t <simulated s>]
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_sched_prio.h"
+#include "app_sched_stats.h"
+#include "app_timer.h"
+#include "nrf_error.h"
+
+#define TICKS_PER_MS        33          /* 32768 Hz, rounded up */
+#define RTC_MASK            0xFFFFFFu
+#define MEAS_EXEC_MAX_MS    6
+
+typedef enum
+{
+    SRC_MEAS,
+    SRC_RX,
+    SRC_UART,
+    SRC_REPORT,
+    SRC_COUNT
+} source_t;
+
+typedef struct
+{
+    const char * p_name;
+    uint32_t rx_gap_ms;                 /* Mean gap between received messages */
+    uint32_t flood_period_ms;           /* 0: no floods */
+    uint32_t flood_msgs;
+} load_t;
+
+typedef struct
+{
+    uint64_t put_ticks;
+    uint32_t seq;
+} payload_t;
+
+typedef struct
+{
+    uint32_t puts;
+    uint32_t put_failures;
+    uint32_t runs;
+    uint32_t next_seq;
+    uint32_t last_seq;
+    uint32_t depth;
+    uint32_t depth_max;
+    uint64_t latency_max;
+    uint64_t exec_max;
+} class_sim_t;
+
+static uint64_t m_now;
+static uint64_t m_next[SRC_COUNT];
+static uint32_t m_uart_pending;         /* TX empty events still to come */
+static uint32_t m_flood_left;
+static const load_t * mp_load;
+static class_sim_t m_classes[APP_SCHED_CLASS_COUNT];
+static uint32_t m_pass_runs[APP_SCHED_CLASS_COUNT];
+static uint32_t m_hook_put_failures;
+static uint32_t m_hook_runs;
+static uint64_t m_meas_latency_max;
+static uint64_t m_other_exec_max;
+static uint64_t m_handler_end;          /* End of the running handler, 0 if none */
+static uint64_t m_meas_deadline[APP_SCHED_SENSOR_QUEUE_SIZE + 1];
+
+static uint32_t m_lcg = 12345;
+static uint32_t m_failures;
+
+static uint32_t next_random(void)
+{
+    m_lcg = m_lcg * 1103515245u + 12345u;
+    return m_lcg >> 8;
+}
+
+static void check(bool ok, const char * p_set, const char * p_what)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL %s: %s\n", p_set, p_what);
+        m_failures++;
+    }
+}
+
+uint32_t app_timer_cnt_get(void)
+{
+    return (uint32_t)(m_now & RTC_MASK);
+}
+
+uint32_t app_timer_cnt_diff_compute(uint32_t ticks_to, uint32_t ticks_from)
+{
+    return (ticks_to - ticks_from) & RTC_MASK;
+}
+
+/* app_sched_stats hooks: one id per class handler */
+uint8_t app_sched_stats_handler_id(app_sched_prio_handler_t handler, const char * p_name)
+{
+    (void)handler;
+    (void)p_name;
+    return 0;
+}
+
+void app_sched_stats_put_failed(uint8_t id, const char * p_name, uint32_t status)
+{
+    (void)id;
+    (void)p_name;
+    check(status == NRF_ERROR_NO_MEM, mp_load->p_name, "put failure status");
+    m_hook_put_failures++;
+}
+
+void app_sched_stats_handler_ran(uint8_t id, uint32_t ticks)
+{
+    (void)id;
+    (void)ticks;
+    m_hook_runs++;
+}
+
+static uint32_t ticks_to_us(uint64_t ticks)
+{
+    return (uint32_t)((ticks * 1000000) / APP_TIMER_CLOCK_FREQ);
+}
+
+static void advance(uint64_t until);
+
+/* Common part of every handler: order, latency and a random run time */
+static void handled(app_sched_class_t cls, void * p_event_data, uint32_t exec_min_ms, uint32_t exec_max_ms)
+{
+    class_sim_t * p_class = &m_classes[cls];
+    payload_t payload;
+    memcpy(&payload, p_event_data, sizeof(payload));
+
+    check(p_class->runs == 0 || payload.seq > p_class->last_seq, mp_load->p_name, "FIFO order within a class");
+    p_class->last_seq = payload.seq;
+    p_class->runs++;
+    p_class->depth--;
+    m_pass_runs[cls]++;
+
+    uint64_t latency = m_now - payload.put_ticks;
+    p_class->latency_max = (latency > p_class->latency_max) ? latency : p_class->latency_max;
+    if (cls == APP_SCHED_CLASS_SENSOR)
+    {
+        m_meas_latency_max = (latency > m_meas_latency_max) ? latency : m_meas_latency_max;
+        check(m_now <= m_meas_deadline[payload.seq % (APP_SCHED_SENSOR_QUEUE_SIZE + 1)], mp_load->p_name,
+              "measurement waited for more than the running handler");
+    }
+
+    uint64_t exec = (exec_min_ms + next_random() % (exec_max_ms - exec_min_ms + 1)) * TICKS_PER_MS;
+    p_class->exec_max = (exec > p_class->exec_max) ? exec : p_class->exec_max;
+    if (cls != APP_SCHED_CLASS_SENSOR)
+    {
+        m_other_exec_max = (exec > m_other_exec_max) ? exec : m_other_exec_max;
+    }
+    m_handler_end = m_now + exec;
+    advance(m_handler_end);
+    m_handler_end = 0;
+}
+
+static void scheduled_meas_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)event_size;
+    handled(APP_SCHED_CLASS_SENSOR, p_event_data, 2, MEAS_EXEC_MAX_MS);
+}
+
+static void scheduled_rx_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)event_size;
+    handled(APP_SCHED_CLASS_MESH_RX, p_event_data, 1, 3);
+
+    /* The forwarded line leaves the UART about 5 ms later */
+    if (m_uart_pending++ == 0)
+    {
+        m_next[SRC_UART] = m_now + 5 * TICKS_PER_MS;
+    }
+}
+
+static void scheduled_uart_tx_empty(void * p_event_data, uint16_t event_size)
+{
+    (void)event_size;
+    handled(APP_SCHED_CLASS_UART_TX, p_event_data, 0, 1);
+}
+
+static void scheduled_report_handler(void * p_event_data, uint16_t event_size)
+{
+    (void)event_size;
+    handled(APP_SCHED_CLASS_BACKGROUND, p_event_data, 10, 40);
+}
+
+static const app_sched_prio_handler_t m_handlers[APP_SCHED_CLASS_COUNT] =
+{
+    scheduled_meas_handler, scheduled_rx_handler, scheduled_uart_tx_empty, scheduled_report_handler
+};
+
+/* Interrupt context: post an event carrying its put time and sequence */
+static void isr_put(app_sched_class_t cls)
+{
+    class_sim_t * p_class = &m_classes[cls];
+    payload_t payload = { m_now, p_class->next_seq++ };
+
+    if (cls == APP_SCHED_CLASS_SENSOR)
+    {
+        /* Starts once the running handler and the measurements ahead are done */
+        uint64_t deadline = (m_handler_end > 0) ? m_handler_end : m_now;
+        deadline += p_class->depth * MEAS_EXEC_MAX_MS * TICKS_PER_MS + 1;
+        m_meas_deadline[payload.seq % (APP_SCHED_SENSOR_QUEUE_SIZE + 1)] = deadline;
+    }
+
+    p_class->puts++;
+    uint32_t status = app_sched_prio_put(cls, &payload, sizeof(payload), m_handlers[cls], "sim");
+    if (status == NRF_SUCCESS)
+    {
+        p_class->depth++;
+        p_class->depth_max = (p_class->depth > p_class->depth_max) ? p_class->depth : p_class->depth_max;
+    }
+    else
+    {
+        check(status == NRF_ERROR_NO_MEM, mp_load->p_name, "put status");
+        p_class->put_failures++;
+    }
+}
+
+static void fire(source_t src)
+{
+    switch (src)
+    {
+        case SRC_MEAS:
+            isr_put(APP_SCHED_CLASS_SENSOR);
+            /* 1 s with up to 2 ms of timer jitter */
+            m_next[SRC_MEAS] = m_now + 32768 - 33 + next_random() % (2 * TICKS_PER_MS + 1);
+            break;
+
+        case SRC_RX:
+            isr_put(APP_SCHED_CLASS_MESH_RX);
+            if (m_flood_left > 0)
+            {
+                m_flood_left--;
+                m_next[SRC_RX] = m_now + TICKS_PER_MS;
+            }
+            else
+            {
+                m_next[SRC_RX] = m_now + 1 + next_random() % (2 * mp_load->rx_gap_ms * TICKS_PER_MS);
+                if (mp_load->flood_period_ms > 0 && next_random() % (mp_load->flood_period_ms / mp_load->rx_gap_ms) == 0)
+                {
+                    m_flood_left = mp_load->flood_msgs;
+                }
+            }
+            break;
+
+        case SRC_UART:
+            isr_put(APP_SCHED_CLASS_UART_TX);
+            m_uart_pending = 0;
+            m_next[SRC_UART] = UINT64_MAX;
+            break;
+
+        case SRC_REPORT:
+            isr_put(APP_SCHED_CLASS_BACKGROUND);
+            m_next[SRC_REPORT] = m_now + 10 * 32768;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* Let time pass, firing the interrupts that fall due */
+static void advance(uint64_t until)
+{
+    for (;;)
+    {
+        source_t src = SRC_COUNT;
+        for (uint32_t i = 0; i < SRC_COUNT; i++)
+        {
+            if (m_next[i] <= until && (src == SRC_COUNT || m_next[i] < m_next[src]))
+            {
+                src = (source_t)i;
+            }
+        }
+        if (src == SRC_COUNT)
+        {
+            break;
+        }
+        m_now = (m_next[src] > m_now) ? m_next[src] : m_now;
+        fire(src);
+    }
+    m_now = until;
+}
+
+static void run(const load_t * p_load, uint64_t duration_s)
+{
+    mp_load = p_load;
+    memset(m_classes, 0, sizeof(m_classes));
+    m_hook_put_failures = 0;
+    m_hook_runs = 0;
+    m_meas_latency_max = 0;
+    m_other_exec_max = 0;
+    m_uart_pending = 0;
+    m_flood_left = 0;
+
+    /* Start just before the RTC wraps, so it is crossed early */
+    m_now = RTC_MASK - 2 * 32768;
+    uint64_t start = m_now;
+    uint64_t end = start + duration_s * 32768;
+    m_next[SRC_MEAS] = start + 100;
+    m_next[SRC_RX] = start + 200;
+    m_next[SRC_UART] = UINT64_MAX;
+    m_next[SRC_REPORT] = start + 5 * 32768;
+
+    app_sched_prio_init();
+
+    while (m_now < end)
+    {
+        memset(m_pass_runs, 0, sizeof(m_pass_runs));
+        app_sched_prio_execute();
+
+        check(m_pass_runs[APP_SCHED_CLASS_MESH_RX] <= APP_SCHED_MESH_RX_BUDGET, p_load->p_name, "mesh RX budget");
+        check(m_pass_runs[APP_SCHED_CLASS_UART_TX] <= APP_SCHED_UART_TX_BUDGET, p_load->p_name, "UART TX budget");
+        check(m_pass_runs[APP_SCHED_CLASS_BACKGROUND] <= APP_SCHED_BACKGROUND_BUDGET, p_load->p_name,
+              "background budget");
+
+        /* Sleep until the next interrupt; a pass of the main loop takes a tick */
+        uint64_t wake = m_now + 1;
+        if (!app_sched_prio_is_pending())
+        {
+            wake = UINT64_MAX;
+            for (uint32_t i = 0; i < SRC_COUNT; i++)
+            {
+                wake = (m_next[i] < wake) ? m_next[i] : wake;
+            }
+        }
+        advance(wake);
+    }
+
+    static const char * const class_names[APP_SCHED_CLASS_COUNT] = { "sensor", "mesh_rx", "uart_tx", "background" };
+    uint32_t put_failures = 0;
+    uint32_t runs = 0;
+
+    printf("# %s: %llu s, mesh RX every %u ms on average", p_load->p_name, (unsigned long long)duration_s,
+           p_load->rx_gap_ms);
+    if (p_load->flood_period_ms > 0)
+    {
+        printf(", floods of %u every %u s on average", p_load->flood_msgs, p_load->flood_period_ms / 1000);
+    }
+    printf("\n  %-10s %8s %8s %10s %8s %12s\n", "class", "puts", "failed", "depth", "runs", "latency max");
+    for (uint32_t cls = 0; cls < APP_SCHED_CLASS_COUNT; cls++)
+    {
+        const class_sim_t * p_class = &m_classes[cls];
+        app_sched_class_stats_t stats;
+        app_sched_prio_class_stats_get((app_sched_class_t)cls, &stats);
+
+        printf("  %-10s %8u %8u %6u/%-3u %8u %9u us\n", class_names[cls], p_class->puts, stats.put_failures,
+               stats.depth_max, stats.size, stats.runs, stats.latency_max_us);
+
+        check(stats.put_failures == p_class->put_failures, p_load->p_name, "put failure count");
+        check(stats.depth_max == p_class->depth_max, p_load->p_name, "depth high-watermark");
+        check(stats.depth_max <= stats.size, p_load->p_name, "depth within the queue");
+        check(stats.runs + p_class->depth == p_class->puts - p_class->put_failures, p_load->p_name,
+              "every accepted event runs once");
+        check(stats.latency_max_us == ticks_to_us(p_class->latency_max), p_load->p_name, "latency max");
+        put_failures += p_class->put_failures;
+        runs += stats.runs;
+    }
+    check(m_hook_put_failures == put_failures, p_load->p_name, "put failures reported to app_sched_stats");
+    check(m_hook_runs == runs, p_load->p_name, "runs reported to app_sched_stats");
+
+    /* The sensor queue is drained before every other event */
+    check(m_classes[APP_SCHED_CLASS_SENSOR].put_failures == 0, p_load->p_name, "measurement event lost");
+    printf("  measurement latency max %u us, longest other handler %u us\n", ticks_to_us(m_meas_latency_max),
+           ticks_to_us(m_other_exec_max));
+}
+
+int main(int argc, char ** argv)
+{
+    uint64_t duration_s = 1200;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            duration_s = strtoull(argv[++i], NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-t <simulated s>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const load_t nominal = { "nominal", 50, 0, 0 };
+    const load_t flood = { "flood", 50, 5000, 3 * APP_SCHED_MESH_RX_QUEUE_SIZE };
+
+    run(&nominal, duration_s);
+    for (uint32_t cls = 0; cls < APP_SCHED_CLASS_COUNT; cls++)
+    {
+        check(m_classes[cls].put_failures == 0, "nominal", "event lost at the nominal rate");
+    }
+
+    run(&flood, duration_s);
+    check(m_classes[APP_SCHED_CLASS_MESH_RX].put_failures > 0, "flood", "flood did not overrun the queue");
+    check(m_classes[APP_SCHED_CLASS_MESH_RX].depth_max == APP_SCHED_MESH_RX_QUEUE_SIZE, "flood",
+          "flood did not fill the queue");
+
+    if (m_failures > 0)
+    {
+        fprintf(stderr, "%u checks failed\n", m_failures);
+        return 1;
+    }
+    printf("app_sched_prio: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,663 @@
+/*
+ * Host check of the SIG Sensor Server and Setup Server (src/app_sensor_sig.c).
+ *
+ * The real app_sensor_sig.c is linked against a stubbed SDK Sensor Setup
+ * Server model that records its settings, logs every status it publishes, and
+ * is driven the way the model's opcode handlers drive the callbacks: a reply
+ * is sent when the callback returns a non-empty status, and for Cadence Set
+ * only on the acknowledged opcode. Checked:
+ *  - the model is initialised on element 0 with the property array and all
+ *    callbacks;
+ *  - Descriptor, Sensor, Column, Series and Setting statuses byte for byte,
+ *    for all properties, one property and an unknown one;
+ *  - Cadence Get/Set/Set Unacknowledged: the 12-byte status, the status
+ *    publication after a change, and prohibited cadences left without effect;
+ *  - Sensor Status publications: the eCO2 and TVOC conversion and saturation,
+ *    the delta triggers, the status minimum interval, the model's publish
+ *    timeout, the fast cadence divisor, and a retry after a failed publish;
+ *  - the publish period is read once per invalidation, not per reading;
+ *  - over a long random run with a publish timeout every period, every
+ *    publication, and every reading not published, against the cadence
+ *    rules in src/sensor_cadence.h.
+ *
+ * Build and run; the exit status is non-zero on a failed check:
+ *
+ *   cc -O2 -Ihost -I../src -I../include -o sensor_sig_check sensor_sig_check.c \
+ *      ../src/app_sensor_sig.c ../src/sensor_cadence.c
+ *   ./sensor_sig_check [-n <readings>]
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "access.h"
+#include "nrf_mesh.h"
+#include "nrf_error.h"
+#include "sensor_setup_server.h"
+#include "app_sensor_sig.h"
+
+#define LOG_MAX             8
+#define PAYLOAD_MAX         32
+
+#define HANDLE_SERVER       0
+#define HANDLE_SETUP        1
+
+#define VALUE_UNKNOWN       0xFFFF
+#define VALUE_MAX           0xFFFE
+
+typedef struct
+{
+    access_model_handle_t handle;
+    uint16_t opcode;
+    uint8_t data[PAYLOAD_MAX];
+    uint16_t length;
+} sent_t;
+
+static sensor_setup_server_t * mp_server;
+static uint16_t m_init_element = 0xFFFF;
+static uint32_t m_init_count;
+
+static sent_t m_replies[LOG_MAX];
+static uint32_t m_reply_count;
+static sent_t m_publishes[LOG_MAX];
+static uint32_t m_publish_count;
+static uint32_t m_publish_fail;
+
+static access_publish_resolution_t m_resolution = ACCESS_PUBLISH_RESOLUTION_1S;
+static uint8_t m_steps;
+static uint32_t m_period_reads;
+
+static uint32_t m_lcg = 12345;
+static uint32_t m_failures;
+
+static uint32_t next_random(void)
+{
+    m_lcg = m_lcg * 1103515245u + 12345u;
+    return m_lcg >> 8;
+}
+
+static void check(bool ok, const char * p_what)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL %s\n", p_what);
+        m_failures++;
+    }
+}
+
+/* ---- Sensor model and access layer stubs ---- */
+
+static uint16_t get_u16(const uint8_t * p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void log_sent(sent_t * p_log, uint32_t * p_count, access_model_handle_t handle, uint16_t opcode,
+                     const void * p_data, uint16_t length)
+{
+    check(length <= PAYLOAD_MAX, "status payload fits");
+    if (*p_count == LOG_MAX || length > PAYLOAD_MAX)
+    {
+        return;
+    }
+
+    sent_t * p_sent = &p_log[(*p_count)++];
+    p_sent->handle = handle;
+    p_sent->opcode = opcode;
+    p_sent->length = length;
+    memcpy(p_sent->data, p_data, length);
+}
+
+uint32_t sensor_setup_server_init(sensor_setup_server_t * p_server, uint16_t element_index)
+{
+    mp_server = p_server;
+    m_init_element = element_index;
+    m_init_count++;
+    p_server->model_handle = HANDLE_SETUP;
+    p_server->sensor_srv.model_handle = HANDLE_SERVER;
+    return NRF_SUCCESS;
+}
+
+uint32_t sensor_server_status_publish(const sensor_server_t * p_server,
+                                      const sensor_status_msg_pkt_t * p_data,
+                                      uint16_t data_length,
+                                      sensor_opcode_t status_opcode)
+{
+    check(p_server == &mp_server->sensor_srv, "status published on the Sensor Server");
+    if (m_publish_fail > 0)
+    {
+        m_publish_fail--;
+        return NRF_ERROR_NO_MEM;
+    }
+    log_sent(m_publishes, &m_publish_count, p_server->model_handle, (uint16_t)status_opcode, p_data, data_length);
+    return NRF_SUCCESS;
+}
+
+uint32_t sensor_server_setup_status_publish(const sensor_setup_server_t * p_s_server,
+                                            const uint8_t * p_data,
+                                            uint16_t data_length,
+                                            sensor_opcode_t status_opcode)
+{
+    check(p_s_server == mp_server, "setup status published on the Setup Server");
+    log_sent(m_publishes, &m_publish_count, p_s_server->model_handle, (uint16_t)status_opcode, p_data, data_length);
+    return NRF_SUCCESS;
+}
+
+uint32_t access_model_publish_period_get(access_model_handle_t handle,
+                                         access_publish_resolution_t * p_resolution,
+                                         uint8_t * p_step_number)
+{
+    check(handle == HANDLE_SERVER, "publish period read from the server");
+    m_period_reads++;
+    *p_resolution = m_resolution;
+    *p_step_number = m_steps;
+    return NRF_SUCCESS;
+}
+
+/* ---- Model dispatch ---- */
+
+static const sensor_setup_server_cbs_t * cbs(void)
+{
+    return &mp_server->settings.p_callbacks->sensor_cbs;
+}
+
+static void clear_log(void)
+{
+    m_reply_count = 0;
+    m_publish_count = 0;
+}
+
+static void respond(access_model_handle_t handle, sensor_opcode_t opcode, const void * p_out, uint16_t bytes)
+{
+    check(p_out != NULL, "callback returns a status buffer");
+    if (bytes != 0)
+    {
+        log_sent(m_replies, &m_reply_count, handle, (uint16_t)opcode, p_out, bytes);
+    }
+}
+
+static void descriptor_get(uint16_t property_id)
+{
+    sensor_descriptor_status_msg_pkt_t * p_out = NULL;
+    uint16_t bytes = 0;
+    clear_log();
+    cbs()->descriptor_get_cb(mp_server, NULL, property_id, &p_out, &bytes);
+    respond(HANDLE_SERVER, SENSOR_OPCODE_DESCRIPTOR_STATUS, p_out, bytes);
+}
+
+static void sensor_get(uint16_t property_id)
+{
+    sensor_status_msg_pkt_t * p_out = NULL;
+    uint16_t bytes = 0;
+    clear_log();
+    cbs()->get_cb(mp_server, NULL, property_id, &p_out, &bytes);
+    respond(HANDLE_SERVER, SENSOR_OPCODE_STATUS, p_out, bytes);
+}
+
+static void column_get(const uint8_t * p_in, uint16_t length)
+{
+    sensor_column_status_msg_pkt_t * p_out = NULL;
+    uint16_t bytes = 0;
+    clear_log();
+    cbs()->column_get_cb(mp_server, NULL, (const sensor_column_get_msg_pkt_t *)p_in, length, &p_out, &bytes);
+    respond(HANDLE_SERVER, SENSOR_OPCODE_COLUMN_STATUS, p_out, bytes);
+}
+
+static void series_get(const uint8_t * p_in, uint16_t length)
+{
+    sensor_series_status_msg_pkt_t * p_out = NULL;
+    uint16_t bytes = 0;
+    clear_log();
+    cbs()->series_get_cb(mp_server, NULL, (const sensor_series_get_msg_pkt_t *)p_in, length, &p_out, &bytes);
+    respond(HANDLE_SERVER, SENSOR_OPCODE_SERIES_STATUS, p_out, bytes);
+}
+
+static void cadence_get(uint16_t property_id)
+{
+    sensor_cadence_status_msg_pkt_t * p_out = NULL;
+    uint16_t bytes = 0;
+    clear_log();
+    cbs()->cadence_get_cb(mp_server, NULL, property_id, &p_out, &bytes);
+    respond(HANDLE_SETUP, SENSOR_OPCODE_CADENCE_STATUS, p_out, bytes);
+}
+
+/* The model replies only to the acknowledged Cadence Set */
+static void cadence_set_raw(bool ack, const uint8_t * p_msg, uint16_t length)
+{
+    sensor_cadence_status_msg_pkt_t * p_out = NULL;
+    uint16_t bytes = 0;
+    clear_log();
+    cbs()->cadence_set_cb(mp_server, NULL, get_u16(p_msg), (const sensor_cadence_set_msg_pkt_t *)p_msg, length,
+                          &p_out, &bytes);
+    check(p_out != NULL, "callback returns a status buffer");
+    if (ack && bytes != 0)
+    {
+        log_sent(m_replies, &m_reply_count, HANDLE_SETUP, SENSOR_OPCODE_CADENCE_STATUS, p_out, bytes);
+    }
+}
+
+static void cadence_set(bool ack, uint16_t property_id, uint8_t divisor_byte, uint16_t delta,
+                        uint8_t min_interval_log2, uint16_t fast_low, uint16_t fast_high)
+{
+    uint8_t msg[12] =
+    {
+        (uint8_t)property_id, (uint8_t)(property_id >> 8), divisor_byte,
+        (uint8_t)delta, (uint8_t)(delta >> 8), (uint8_t)delta, (uint8_t)(delta >> 8),
+        min_interval_log2,
+        (uint8_t)fast_low, (uint8_t)(fast_low >> 8), (uint8_t)fast_high, (uint8_t)(fast_high >> 8),
+    };
+    cadence_set_raw(ack, msg, sizeof(msg));
+}
+
+/* Publish timeout of the Sensor Server */
+static void publish_timeout(void)
+{
+    clear_log();
+    cbs()->publication_schedule_cb(mp_server);
+}
+
+static bool sent_is(const sent_t * p_sent, access_model_handle_t handle, uint16_t opcode,
+                    const uint8_t * p_data, uint16_t length)
+{
+    return p_sent->handle == handle && p_sent->opcode == opcode &&
+           p_sent->length == length && memcmp(p_sent->data, p_data, length) == 0;
+}
+
+static bool replied(access_model_handle_t handle, uint16_t opcode, const uint8_t * p_data, uint16_t length)
+{
+    return m_reply_count == 1 && m_publish_count == 0 &&
+           sent_is(&m_replies[0], handle, opcode, p_data, length);
+}
+
+static bool silent(void)
+{
+    return m_reply_count == 0 && m_publish_count == 0;
+}
+
+static void update(uint16_t eco2, uint16_t tvoc_x100, uint32_t now_ms)
+{
+    iaq_sample_t sample = { 0, tvoc_x100, eco2 };
+    clear_log();
+    app_sensor_sig_update(&sample, now_ms);
+}
+
+/* Value of a property in the last Sensor Status publication, or VALUE_UNKNOWN if absent */
+static uint16_t published_value(uint16_t property_id)
+{
+    if (m_publish_count != 1 || m_publishes[0].opcode != SENSOR_OPCODE_STATUS)
+    {
+        return VALUE_UNKNOWN;
+    }
+    const sent_t * p_sent = &m_publishes[0];
+    for (uint16_t i = 0; i + 4 <= p_sent->length; i += 4)
+    {
+        uint16_t header = get_u16(&p_sent->data[i]);
+        if ((header & 1) == 0 && ((header >> 1) & 0xF) == 1 && (header >> 5) == property_id)
+        {
+            return get_u16(&p_sent->data[i + 2]);
+        }
+    }
+    return VALUE_UNKNOWN;
+}
+
+/* ---- Checks ---- */
+
+static void check_init(void)
+{
+    check(app_sensor_sig_init() == NRF_SUCCESS, "init succeeds");
+    check(m_init_count == 1 && m_init_element == 0, "model initialised once, on element 0");
+    if (mp_server == NULL || mp_server->settings.p_callbacks == NULL)
+    {
+        fprintf(stderr, "FAIL model has no callbacks\n");
+        exit(1);
+    }
+
+    const sensor_setup_server_cbs_t * p_cbs = cbs();
+    check(p_cbs->descriptor_get_cb && p_cbs->get_cb && p_cbs->column_get_cb && p_cbs->series_get_cb &&
+          p_cbs->cadence_get_cb && p_cbs->cadence_set_cb && p_cbs->settings_get_cb &&
+          p_cbs->setting_get_cb && p_cbs->setting_set_cb && p_cbs->publication_schedule_cb,
+          "all callbacks set");
+
+    const uint16_t * p_array = mp_server->settings.property_array;
+    check(p_array != NULL && p_array[0] == 2 && p_array[1] == 0x0077 && p_array[2] == 0x0078,
+          "property array: count, CO2, VOC");
+    check(mp_server->settings.transmic_size == NRF_MESH_TRANSMIC_SIZE_DEFAULT &&
+          !mp_server->settings.force_segmented, "default TransMIC, unsegmented");
+}
+
+static void check_get(void)
+{
+    static const uint8_t all_unknown[] = { 0xE2, 0x0E, 0xFF, 0xFF, 0x02, 0x0F, 0xFF, 0xFF };
+    static const uint8_t voc_unknown[] = { 0x02, 0x0F, 0xFF, 0xFF };
+    static const uint8_t other_unknown[] = { 0xFF, 0x34, 0x12 };
+
+    /* No reading yet: Format A with the unknown value */
+    sensor_get(SENSOR_NO_PROPERTY_ID);
+    check(replied(HANDLE_SERVER, SENSOR_OPCODE_STATUS, all_unknown, sizeof(all_unknown)),
+          "Sensor Get, all, before a reading");
+    sensor_get(0x0078);
+    check(replied(HANDLE_SERVER, SENSOR_OPCODE_STATUS, voc_unknown, sizeof(voc_unknown)),
+          "Sensor Get, VOC, before a reading");
+    sensor_get(0x1234);
+    check(replied(HANDLE_SERVER, SENSOR_OPCODE_STATUS, other_unknown, sizeof(other_unknown)),
+          "Sensor Get, unknown property");
+    publish_timeout();
+    check(silent(), "publish timeout before a reading publishes nothing");
+
+    /* 800 ppm; 1.00 mg/m3 is 531 ppb */
+    m_steps = 0;
+    update(800, 100, 0);
+    static const uint8_t all_values[] = { 0xE2, 0x0E, 0x20, 0x03, 0x02, 0x0F, 0x13, 0x02 };
+    check(m_publish_count == 1 &&
+          sent_is(&m_publishes[0], HANDLE_SERVER, SENSOR_OPCODE_STATUS, all_values, sizeof(all_values)),
+          "first reading published with both properties");
+    sensor_get(SENSOR_NO_PROPERTY_ID);
+    check(replied(HANDLE_SERVER, SENSOR_OPCODE_STATUS, all_values, sizeof(all_values)),
+          "Sensor Get, all, after a reading");
+}
+
+static void check_descriptor(void)
+{
+    static const uint8_t all[] =
+    {
+        0x77, 0x00, 0, 0, 0, 0x01, 0x00, 64,
+        0x78, 0x00, 0, 0, 0, 0x01, 0x00, 64,
+    };
+    static const uint8_t other_id[] = { 0x34, 0x12 };
+
+    descriptor_get(SENSOR_NO_PROPERTY_ID);
+    check(replied(HANDLE_SERVER, SENSOR_OPCODE_DESCRIPTOR_STATUS, all, sizeof(all)), "Descriptor Get, all");
+    descriptor_get(0x0077);
+    check(replied(HANDLE_SERVER, SENSOR_OPCODE_DESCRIPTOR_STATUS, all, 8), "Descriptor Get, CO2");
+    descriptor_get(0x0078);
+    check(replied(HANDLE_SERVER, SENSOR_OPCODE_DESCRIPTOR_STATUS, &all[8], 8), "Descriptor Get, VOC");
+    descriptor_get(0x1234);
+    check(replied(HANDLE_SERVER, SENSOR_OPCODE_DESCRIPTOR_STATUS, other_id, 2), "Descriptor Get, unknown property");
+}
+
+static void check_column_series_settings(void)
+{
+    static const uint8_t column[] = { 0x77, 0x00, 0x10, 0x00 };
+    static const uint8_t series[] = { 0x78, 0x00, 0x10, 0x00, 0x20, 0x00 };
+    static const uint8_t setting[] = { 0x77, 0x00, 0x34, 0x12 };
+
+    column_get(column, sizeof(column));
+    check(replied(HANDLE_SERVER, SENSOR_OPCODE_COLUMN_STATUS, column, sizeof(column)),
+          "Column Get echoes ID and column");
+    series_get(series, sizeof(series));
+    check(replied(HANDLE_SERVER, SENSOR_OPCODE_SERIES_STATUS, series, 2), "Series Get replies with the ID only");
+
+    sensor_settings_status_msg_pkt_t * p_settings = NULL;
+    sensor_setting_status_msg_pkt_t * p_setting = NULL;
+    uint16_t bytes = 0;
+    cbs()->settings_get_cb(mp_server, NULL, 0x0077, &p_settings, &bytes);
+    check(p_settings != NULL && bytes == 2 && memcmp(p_settings, setting, 2) == 0, "Settings Get: no settings");
+    cbs()->setting_get_cb(mp_server, NULL, 0x0077, 0x1234, &p_setting, &bytes);
+    check(p_setting != NULL && bytes == 4 && memcmp(p_setting, setting, 4) == 0, "Setting Get: unknown setting");
+    p_setting = NULL;
+    cbs()->setting_set_cb(mp_server, NULL, 0x0077, 0x1234, (const sensor_setting_set_msg_pkt_t *)setting, 4,
+                          &p_setting, &bytes);
+    check(p_setting != NULL && bytes == 4 && memcmp(p_setting, setting, 4) == 0, "Setting Set: unknown setting");
+}
+
+static void check_cadence(void)
+{
+    /* Defaults from app_sensor_sig.h */
+    const uint8_t co2_default[] =
+    {
+        0x77, 0x00, APP_SENSOR_SIG_FAST_DIVISOR_LOG2,
+        (uint8_t)APP_SENSOR_SIG_CO2_DELTA, (uint8_t)(APP_SENSOR_SIG_CO2_DELTA >> 8),
+        (uint8_t)APP_SENSOR_SIG_CO2_DELTA, (uint8_t)(APP_SENSOR_SIG_CO2_DELTA >> 8),
+        APP_SENSOR_SIG_MIN_INTERVAL_LOG2,
+        (uint8_t)APP_SENSOR_SIG_CO2_FAST_LOW, (uint8_t)(APP_SENSOR_SIG_CO2_FAST_LOW >> 8),
+        0xFF, 0xFF,
+    };
+    static const uint8_t other_id[] = { 0x34, 0x12 };
+
+    cadence_get(0x0077);
+    check(replied(HANDLE_SETUP, SENSOR_OPCODE_CADENCE_STATUS, co2_default, sizeof(co2_default)),
+          "Cadence Get, CO2 default");
+    cadence_get(0x1234);
+    check(replied(HANDLE_SETUP, SENSOR_OPCODE_CADENCE_STATUS, other_id, 2), "Cadence Get, unknown property");
+
+    /* Acknowledged set: reply and publish the new state */
+    static const uint8_t co2_new[] = { 0x77, 0x00, 0x83, 0xF4, 0x01, 0xF4, 0x01, 0x0A, 0xD0, 0x07, 0xE8, 0x03 };
+    cadence_set(true, 0x0077, 0x83, 500, 10, 2000, 1000);
+    check(m_reply_count == 1 &&
+          sent_is(&m_replies[0], HANDLE_SETUP, SENSOR_OPCODE_CADENCE_STATUS, co2_new, sizeof(co2_new)),
+          "Cadence Set replies with the new cadence");
+    check(m_publish_count == 1 &&
+          sent_is(&m_publishes[0], HANDLE_SETUP, SENSOR_OPCODE_CADENCE_STATUS, co2_new, sizeof(co2_new)),
+          "Cadence Set publishes the new cadence");
+    cadence_get(0x0077);
+    check(replied(HANDLE_SETUP, SENSOR_OPCODE_CADENCE_STATUS, co2_new, sizeof(co2_new)), "Cadence Get after Set");
+
+    /* Prohibited divisor and minimum interval, and a short cadence: no effect, no reply */
+    cadence_set(true, 0x0077, 16, 1, 1, 0, 0);
+    check(silent(), "Cadence Set, divisor 2^16, ignored");
+    cadence_set(true, 0x0077, 1, 1, 27, 0, 0);
+    check(silent(), "Cadence Set, min interval 2^27, ignored");
+    cadence_set_raw(true, co2_new, sizeof(co2_new) - 1);
+    check(silent(), "Cadence Set, short, ignored");
+    cadence_get(0x0077);
+    check(replied(HANDLE_SETUP, SENSOR_OPCODE_CADENCE_STATUS, co2_new, sizeof(co2_new)),
+          "ignored sets leave the cadence");
+
+    /* Unknown property: the acknowledged set replies with the ID, nothing is published */
+    cadence_set(true, 0x1234, 1, 1, 1, 0, 0);
+    check(replied(HANDLE_SETUP, SENSOR_OPCODE_CADENCE_STATUS, other_id, 2), "Cadence Set, unknown property");
+    cadence_set(false, 0x1234, 1, 1, 1, 0, 0);
+    check(silent(), "Cadence Set Unacknowledged, unknown property");
+
+    /* Unacknowledged set back to the default: publish only */
+    cadence_set(false, 0x0077, APP_SENSOR_SIG_FAST_DIVISOR_LOG2, APP_SENSOR_SIG_CO2_DELTA,
+                APP_SENSOR_SIG_MIN_INTERVAL_LOG2, APP_SENSOR_SIG_CO2_FAST_LOW, 0xFFFF);
+    check(m_reply_count == 0 && m_publish_count == 1 &&
+          sent_is(&m_publishes[0], HANDLE_SETUP, SENSOR_OPCODE_CADENCE_STATUS, co2_default, sizeof(co2_default)),
+          "Cadence Set Unacknowledged publishes only");
+}
+
+/* After check_get(): both published at t = 0, CO2 800 ppm, VOC 531 ppb, no publish period */
+static void check_publish(void)
+{
+    const uint32_t min_ms = 1u << APP_SENSOR_SIG_MIN_INTERVAL_LOG2;
+    uint32_t t = 0;
+
+    update(800 + APP_SENSOR_SIG_CO2_DELTA, 100, min_ms - 1);
+    check(m_publish_count == 0, "delta held back by the minimum interval");
+    update(800 + APP_SENSOR_SIG_CO2_DELTA - 1, 100, min_ms);
+    check(m_publish_count == 0, "change below the delta not published");
+    t = min_ms;
+    update(800 - APP_SENSOR_SIG_CO2_DELTA, 100, t);
+    check(published_value(0x0077) == 800 - APP_SENSOR_SIG_CO2_DELTA && published_value(0x0078) == VALUE_UNKNOWN,
+          "CO2 delta down publishes CO2 alone");
+    t += 100 * min_ms;
+    update(800 - APP_SENSOR_SIG_CO2_DELTA, 100, t);
+    check(m_publish_count == 0, "unchanged values stay quiet between publish timeouts");
+
+    /* The publish timeout publishes both, whatever the cadence */
+    publish_timeout();
+    check(published_value(0x0077) == 800 - APP_SENSOR_SIG_CO2_DELTA && published_value(0x0078) == 531,
+          "publish timeout: both published");
+
+    /* Publish period 10 s, read once until the next invalidation */
+    m_resolution = ACCESS_PUBLISH_RESOLUTION_1S;
+    m_steps = 10;
+    app_sensor_sig_publication_invalidate();
+    m_period_reads = 0;
+
+    /* In the fast range with the minimum interval lifted: period / 4 for CO2 only */
+    cadence_set(false, 0x0077, 2, 0xFFFF, 0, 1000, 0xFFFF);
+    update(1200, 100, t);
+    check(m_publish_count == 0, "below the delta and before the period");
+    update(1200, 100, t + 2499);
+    check(m_publish_count == 0, "fast cadence period not elapsed");
+    update(1200, 100, t + 2500);
+    check(published_value(0x0077) == 1200 && published_value(0x0078) == VALUE_UNKNOWN,
+          "fast cadence: CO2 after a quarter period");
+    t += 2500;
+    update(1200, 100, t + 2499);
+    check(m_publish_count == 0, "fast cadence period not elapsed again");
+    check(m_period_reads == 1, "publish period read once");
+
+    /* A failed publish leaves the value due on the next reading */
+    m_publish_fail = 1;
+    t += 2500;
+    update(1200, 100, t);
+    check(m_publish_count == 0, "failed publish");
+    update(1200, 100, t + 1);
+    check(published_value(0x0077) == 1200, "retried after a failed publish");
+
+    /* Saturation: TVOC 655.35 mg/m3 is above the VOC range */
+    cadence_set(false, 0x0078, 0, 1, 0, 0xFFFF, 0);
+    update(1200, 65535, t + 2);
+    check(published_value(0x0078) == VALUE_MAX, "VOC saturates at 0xFFFE");
+
+    /* Restore both defaults */
+    cadence_set(false, 0x0077, APP_SENSOR_SIG_FAST_DIVISOR_LOG2, APP_SENSOR_SIG_CO2_DELTA,
+                APP_SENSOR_SIG_MIN_INTERVAL_LOG2, APP_SENSOR_SIG_CO2_FAST_LOW, 0xFFFF);
+    cadence_set(false, 0x0078, APP_SENSOR_SIG_FAST_DIVISOR_LOG2, APP_SENSOR_SIG_VOC_DELTA,
+                APP_SENSOR_SIG_MIN_INTERVAL_LOG2, APP_SENSOR_SIG_VOC_FAST_LOW, 0xFFFF);
+}
+
+/* Random readings, one per second with jitter, under the default cadence and a
+ * 60 s period, with the model's publish timeout every period. Each property is
+ * checked against its own record of what it last published. */
+static void check_random(uint32_t readings)
+{
+    static const struct
+    {
+        uint16_t id;
+        uint32_t delta;
+        uint32_t fast_low;
+    } props[2] =
+    {
+        { 0x0077, APP_SENSOR_SIG_CO2_DELTA, APP_SENSOR_SIG_CO2_FAST_LOW },
+        { 0x0078, APP_SENSOR_SIG_VOC_DELTA, APP_SENSOR_SIG_VOC_FAST_LOW },
+    };
+    const uint32_t min_ms = 1u << APP_SENSOR_SIG_MIN_INTERVAL_LOG2;
+    const uint32_t period_ms = 60000;
+
+    uint16_t values[2];
+    uint16_t published[2];
+    uint32_t published_ms[2];
+    uint32_t t = 1000000;
+    uint32_t next_timeout = t + period_ms;
+    uint32_t eco2 = 700;
+    uint32_t tvoc_x100 = 80;
+    uint32_t publishes = 0;
+    uint32_t timeouts = 0;
+
+    m_resolution = ACCESS_PUBLISH_RESOLUTION_10S;
+    m_steps = 6;
+    app_sensor_sig_publication_invalidate();
+    m_period_reads = 0;
+
+    /* Start from a publication of both */
+    update((uint16_t)eco2, (uint16_t)tvoc_x100, t);
+    publish_timeout();
+    check(m_publish_count == 1, "random run starts published");
+    for (uint32_t p = 0; p < 2; p++)
+    {
+        values[p] = published[p] = published_value(props[p].id);
+        published_ms[p] = t;
+    }
+
+    for (uint32_t i = 0; i < readings; i++)
+    {
+        uint32_t last_t = t;
+        t += 900 + next_random() % 200;
+
+        /* The period elapses between readings: both go out with the last reading */
+        if (t >= next_timeout)
+        {
+            next_timeout += period_ms;
+            publish_timeout();
+            for (uint32_t p = 0; p < 2; p++)
+            {
+                if (published_value(props[p].id) != values[p])
+                {
+                    fprintf(stderr, "FAIL publish timeout before reading %u property 0x%04X: %u, not %u\n",
+                            i, props[p].id, published_value(props[p].id), values[p]);
+                    m_failures++;
+                    return;
+                }
+                published[p] = values[p];
+                published_ms[p] = last_t;
+            }
+            timeouts++;
+        }
+
+        /* Random walk with occasional jumps, across the fast thresholds */
+        eco2 = (eco2 - 400 + 1200 + next_random() % 41 - 20 + ((next_random() % 64 == 0) ? 300 : 0)) % 1200 + 400;
+        tvoc_x100 = (tvoc_x100 + 400 + next_random() % 9 - 4 + ((next_random() % 64 == 0) ? 100 : 0)) % 400;
+        update((uint16_t)eco2, (uint16_t)tvoc_x100, t);
+
+        values[0] = (uint16_t)eco2;
+        values[1] = (uint16_t)(tvoc_x100 * APP_SENSOR_SIG_VOC_PPB_PER_MG_M3 / 100);
+        for (uint32_t p = 0; p < 2; p++)
+        {
+            uint32_t elapsed = t - published_ms[p];
+            uint32_t change = (values[p] > published[p]) ? values[p] - published[p] : published[p] - values[p];
+            bool fast = values[p] >= props[p].fast_low;
+            bool due = elapsed >= min_ms &&
+                       (change >= props[p].delta ||
+                        (fast && elapsed >= (period_ms >> APP_SENSOR_SIG_FAST_DIVISOR_LOG2)));
+            uint16_t sent = published_value(props[p].id);
+
+            if (due != (sent != VALUE_UNKNOWN) || (due && sent != values[p]))
+            {
+                fprintf(stderr, "FAIL reading %u property 0x%04X: value %u, last %u %u ms ago, %s\n",
+                        i, props[p].id, values[p], published[p], elapsed, due ? "not published" : "published");
+                m_failures++;
+                return;
+            }
+            if (due)
+            {
+                published[p] = values[p];
+                published_ms[p] = t;
+                publishes++;
+            }
+        }
+    }
+    check(m_period_reads == 1, "random run reads the publish period once");
+    printf("random run: %u readings, %u publish timeouts, %u triggered property publications\n",
+           readings, timeouts, publishes);
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t readings = 200000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            readings = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n <readings>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    check_init();
+    check_get();
+    check_descriptor();
+    check_column_series_settings();
+    check_cadence();
+    check_publish();
+    check_random(readings);
+
+    if (m_failures > 0)
+    {
+        fprintf(stderr, "sensor_sig: %u checks failed\n", m_failures);
+        return 1;
+    }
+    printf("sensor_sig: all checks passed\n");
+    return 0;
+}
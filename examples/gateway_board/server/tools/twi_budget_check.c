@@ -0,0 +1,190 @@
+/*
+ * Host check of the TWI traffic per measurement cycle (src/twi_budget.h) and
+ * of the compensation input pipeline (src/env_input.h).
+ *
+ * Sums the modelled transfers of one measurement window, with and without the
+ * local SHT4x, at each TWI speed, and fails if a window exceeds
+ * TWI_BUDGET_CYCLE_PERMILLE of the measurement interval. Also decodes every
+ * SHT4x raw value against the datasheet formula, checks CRC rejection and the
+ * source fallback order.
+ *
+ * Build and run; the exit status is non-zero on a failed check:
+ *
+ *   cc -O2 -I../src -o twi_budget_check twi_budget_check.c ../src/twi_budget.c ../src/env_input.c
+ *   ./twi_budget_check [-m <measurement interval ms>]
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "twi_budget.h"
+#include "env_input.h"
+
+static const uint32_t m_freqs_hz[] = { 100000, 250000, 400000 };
+static uint32_t m_failures;
+
+static void check(bool ok, const char * p_what)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL %s\n", p_what);
+        m_failures++;
+    }
+}
+
+static void print_xfers(const twi_budget_xfer_t * p_xfers, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        printf("  %-16s", p_xfers[i].p_name);
+        for (uint32_t f = 0; f < sizeof(m_freqs_hz) / sizeof(m_freqs_hz[0]); f++)
+        {
+            printf(" %8u", twi_budget_xfer_us(&p_xfers[i], m_freqs_hz[f]));
+        }
+        printf("\n");
+    }
+}
+
+static void check_budget(uint32_t interval_ms)
+{
+    printf("# TWI window per %u ms cycle, us (budget %u us)\n", interval_ms,
+           interval_ms * TWI_BUDGET_CYCLE_PERMILLE);
+    printf("  %-16s %8s %8s %8s\n", "transfer", "100k", "250k", "400k");
+    print_xfers(twi_budget_zmod_cycle, TWI_BUDGET_ZMOD_CYCLE_COUNT);
+    print_xfers(twi_budget_env_cycle, TWI_BUDGET_ENV_CYCLE_COUNT);
+
+    for (uint32_t f = 0; f < sizeof(m_freqs_hz) / sizeof(m_freqs_hz[0]); f++)
+    {
+        uint32_t zmod_us = twi_budget_cycle_us(twi_budget_zmod_cycle, TWI_BUDGET_ZMOD_CYCLE_COUNT, m_freqs_hz[f]);
+        uint32_t env_us = twi_budget_cycle_us(twi_budget_env_cycle, TWI_BUDGET_ENV_CYCLE_COUNT, m_freqs_hz[f]);
+        printf("  %3u kHz: zmod %u us, + sht4x %u us = %u us (%u.%u %% of the cycle)\n",
+               m_freqs_hz[f] / 1000, zmod_us, env_us, zmod_us + env_us,
+               (zmod_us + env_us) / (interval_ms * 10), ((zmod_us + env_us) / interval_ms) % 10);
+
+        char what[64];
+        snprintf(what, sizeof(what), "window over budget at %u kHz", m_freqs_hz[f] / 1000);
+        check(twi_budget_fits(zmod_us + env_us, interval_ms), what);
+        /* The SHT4x result is read and its conversion started in one window;
+         * the conversion must be done by the next one */
+        check(ENV_SHT4X_CONVERSION_MS * 1000 + zmod_us + env_us < interval_ms * 1000,
+              "SHT4x conversion does not finish within a cycle");
+    }
+}
+
+static uint8_t crc8(uint8_t msb, uint8_t lsb)
+{
+    uint8_t data[2] = { msb, lsb };
+    uint8_t crc = 0xFF;
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        crc ^= data[i];
+        for (uint32_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void check_sht4x(void)
+{
+    /* Datasheet example: 0xBEEF has CRC 0x92 */
+    check(crc8(0xBE, 0xEF) == 0x92, "CRC reference");
+
+    for (uint32_t ticks = 0; ticks <= UINT16_MAX; ticks++)
+    {
+        uint8_t raw[ENV_SHT4X_RESULT_LEN] =
+        {
+            (uint8_t)(ticks >> 8), (uint8_t)ticks, crc8((uint8_t)(ticks >> 8), (uint8_t)ticks),
+            (uint8_t)(ticks >> 8), (uint8_t)ticks, crc8((uint8_t)(ticks >> 8), (uint8_t)ticks)
+        };
+        env_input_value_t value;
+        if (!env_input_sht4x_decode(raw, &value))
+        {
+            check(false, "SHT4x valid frame rejected");
+            return;
+        }
+
+        double temp_x100 = (-45.0 + 175.0 * ticks / 65535.0) * 100.0;
+        double rh_x100 = (-6.0 + 125.0 * ticks / 65535.0) * 100.0;
+        rh_x100 = (rh_x100 < 0) ? 0 : (rh_x100 > ENV_INPUT_RH_X100_MAX) ? ENV_INPUT_RH_X100_MAX : rh_x100;
+        if (fabs(value.temp_x100 - temp_x100) > 0.5 || fabs(value.rh_x100 - rh_x100) > 0.5)
+        {
+            fprintf(stderr, "ticks %u: %d/%u vs %.2f/%.2f\n", ticks, value.temp_x100, value.rh_x100,
+                    temp_x100, rh_x100);
+            check(false, "SHT4x conversion");
+            return;
+        }
+
+        /* Every decoded value is accepted as an input */
+        env_input_t env;
+        env_input_init(&env);
+        check(env_input_update(&env, ENV_INPUT_SOURCE_LOCAL, &value, 0), "SHT4x value out of input range");
+
+        raw[2] ^= 0x01;
+        check(!env_input_sht4x_decode(raw, &value), "SHT4x CRC error accepted");
+    }
+}
+
+static void check_sources(void)
+{
+    env_input_t env;
+    env_input_value_t value;
+    env_input_value_t local = { 2150, 4200 };
+    env_input_value_t mesh = { 1900, 5500 };
+    env_input_value_t bad = { 2000, ENV_INPUT_RH_X100_MAX + 1 };
+
+    env_input_init(&env);
+    check(env_input_get(&env, 1000, &value) == ENV_INPUT_SOURCE_DEFAULT &&
+          value.temp_x100 == ENV_INPUT_DEFAULT_TEMP_X100 && value.rh_x100 == ENV_INPUT_DEFAULT_RH_X100,
+          "defaults without a source");
+
+    check(env_input_update(&env, ENV_INPUT_SOURCE_MESH, &mesh, 1000), "mesh update");
+    check(!env_input_update(&env, ENV_INPUT_SOURCE_MESH, &bad, 1000), "out of range accepted");
+    check(env_input_get(&env, 2000, &value) == ENV_INPUT_SOURCE_MESH && value.rh_x100 == mesh.rh_x100,
+          "mesh used without local");
+
+    check(env_input_update(&env, ENV_INPUT_SOURCE_LOCAL, &local, 2000), "local update");
+    check(env_input_get(&env, 3000, &value) == ENV_INPUT_SOURCE_LOCAL && value.temp_x100 == local.temp_x100,
+          "local preferred");
+
+    /* Local goes stale first, then mesh */
+    check(env_input_update(&env, ENV_INPUT_SOURCE_MESH, &mesh, 100000), "mesh refresh");
+    check(env_input_get(&env, 2000 + ENV_INPUT_MAX_AGE_MS + 1, &value) == ENV_INPUT_SOURCE_MESH,
+          "stale local falls back to mesh");
+    check(env_input_get(&env, 100000 + ENV_INPUT_MAX_AGE_MS + 1, &value) == ENV_INPUT_SOURCE_DEFAULT,
+          "stale mesh falls back to defaults");
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t interval_ms = 1000;    /* APP_SENSOR_IAQ_MEAS_INTERVAL_MS */
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            interval_ms = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-m <measurement interval ms>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    check_budget(interval_ms);
+    check_sht4x();
+    check_sources();
+
+    if (m_failures > 0)
+    {
+        fprintf(stderr, "%u checks failed\n", m_failures);
+        return 1;
+    }
+    printf("twi_budget: all checks passed\n");
+    return 0;
+}
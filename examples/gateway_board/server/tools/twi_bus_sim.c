@@ -0,0 +1,314 @@
+/*
+ * Host simulation of the shared TWI bus arbiter (src/twi_bus.h) on a fake bus.
+ *
+ * Several simulated I2C devices request windows at their own period, with
+ * jitter; a window holds the bus for its transfers as modelled by
+ * src/twi_budget.h, and each grant is delayed by a random scheduler latency
+ * (a handler of another class finishing first). The clock runs past the
+ * 32-bit microsecond wrap.
+ *
+ * Two device sets are run. The nominal one, ZMOD4410 and SHT4x as on the
+ * sensor node plus a pressure sensor and an EEPROM logger, must meet every
+ * deadline. The overloaded one gives the EEPROM a window longer than the
+ * pressure sensor's deadline: the misses must be counted, and the ZMOD4410,
+ * at the highest priority, must still meet every deadline. Both check that
+ * the arbiter's wait, hold and utilization figures match the simulation.
+ *
+ * This checks arbitration, not the TWI time budget: window lengths come from
+ * src/twi_budget.h, and whether they fit the measurement cycle is checked by
+ * tools/twi_budget_check.c alone.
+ *
+ * Build and run; the exit status is non-zero on a failed check:
+ *
+ *   cc -O2 -I../src -o twi_bus_sim twi_bus_sim.c ../src/twi_bus.c ../src/twi_budget.c
+ *   ./twi_bus_sim [-t <simulated s>] [-f <bus Hz>] [-l <max dispatch latency us>]
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "twi_bus.h"
+#include "twi_budget.h"
+
+#define DEVICES_MAX TWI_BUS_CLIENTS_MAX
+
+typedef struct
+{
+    const char * p_name;
+    uint8_t priority;
+    uint32_t period_us;
+    uint32_t phase_us;
+    uint32_t jitter_us;             /* Added to each period, 0..jitter_us */
+    uint32_t within_us;
+    const twi_budget_xfer_t * p_xfers;
+    uint32_t xfer_count;
+    uint32_t extra_us;              /* Time in the window besides the transfers */
+} device_t;
+
+typedef struct
+{
+    uint64_t next_request;
+    uint64_t requested;
+    uint64_t deadline;
+    bool pending;
+    uint32_t client;
+    uint32_t requests;
+    uint32_t grants;
+    uint32_t misses;
+    uint64_t wait_max;
+    uint64_t hold_total;
+} device_state_t;
+
+static const twi_budget_xfer_t m_lps22_xfers[] =
+{
+    { "lps22_status", 1, 1 },
+    { "lps22_data", 1, 5 },
+};
+
+/* 32-byte page write; the write cycle is polled for within the window */
+static const twi_budget_xfer_t m_eeprom_xfers[] =
+{
+    { "eeprom_page", 2 + 32, 0 },
+};
+
+static uint32_t m_lcg = 12345;
+static uint32_t m_failures;
+
+static uint32_t next_random(void)
+{
+    m_lcg = m_lcg * 1103515245u + 12345u;
+    return m_lcg >> 8;
+}
+
+static void check(bool ok, const char * p_set, const char * p_what)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "FAIL %s: %s\n", p_set, p_what);
+        m_failures++;
+    }
+}
+
+static uint32_t window_us(const device_t * p_device, uint32_t freq_hz)
+{
+    return twi_budget_cycle_us(p_device->p_xfers, p_device->xfer_count, freq_hz) + p_device->extra_us;
+}
+
+static void schedule_next(const device_t * p_device, device_state_t * p_state)
+{
+    p_state->next_request += p_device->period_us;
+    if (p_device->jitter_us > 0)
+    {
+        p_state->next_request += next_random() % (p_device->jitter_us + 1);
+    }
+}
+
+/* Event-driven run: requests, dispatch after the scheduler latency, release
+ * after the window. Returns the bus utilization the arbiter reports. */
+static uint16_t run(const char * p_set, const device_t * p_devices, uint32_t count,
+                    device_state_t * p_states, uint64_t duration_us, uint32_t freq_hz, uint32_t latency_max_us)
+{
+    /* Start just before the 32-bit wrap, so it is crossed early */
+    const uint64_t start = UINT32_MAX - 1000000ull;
+    twi_bus_t bus;
+    twi_bus_init(&bus, (uint32_t)start);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        memset(&p_states[i], 0, sizeof(p_states[i]));
+        p_states[i].client = twi_bus_client_add(&bus, p_devices[i].p_name, p_devices[i].priority);
+        p_states[i].next_request = start + p_devices[i].phase_us;
+    }
+
+    uint64_t now = start;
+    uint64_t end = start + duration_us;
+    uint64_t dispatch_at = UINT64_MAX;
+    uint64_t release_at = UINT64_MAX;
+    uint64_t busy = 0;
+    uint32_t owner = TWI_BUS_CLIENT_NONE;
+
+    while (now < end)
+    {
+        uint64_t next = end;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (p_states[i].next_request < next)
+            {
+                next = p_states[i].next_request;
+            }
+        }
+        next = (dispatch_at < next) ? dispatch_at : next;
+        next = (release_at < next) ? release_at : next;
+        now = next;
+        if (now >= end)
+        {
+            break;
+        }
+
+        if (now == release_at)
+        {
+            device_state_t * p_state = &p_states[owner];
+            twi_bus_release(&bus, (uint8_t)p_state->client, (uint32_t)now);
+            if (now > p_state->deadline)
+            {
+                p_state->misses++;
+            }
+            release_at = UINT64_MAX;
+            owner = TWI_BUS_CLIENT_NONE;
+            if (twi_bus_pending(&bus))
+            {
+                dispatch_at = now + next_random() % (latency_max_us + 1);
+            }
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            device_state_t * p_state = &p_states[i];
+            if (p_state->next_request != now)
+            {
+                continue;
+            }
+            p_state->requests++;
+            bool queued = twi_bus_request(&bus, (uint8_t)p_state->client, (uint32_t)now, p_devices[i].within_us);
+            check(queued == !p_state->pending, p_set, "merge of a pending request");
+            if (!p_state->pending)
+            {
+                p_state->pending = true;
+                p_state->requested = now;
+                p_state->deadline = now + p_devices[i].within_us;
+            }
+            schedule_next(&p_devices[i], p_state);
+            if (owner == TWI_BUS_CLIENT_NONE && dispatch_at == UINT64_MAX)
+            {
+                dispatch_at = now + next_random() % (latency_max_us + 1);
+            }
+        }
+
+        if (now == dispatch_at)
+        {
+            dispatch_at = UINT64_MAX;
+            uint8_t client = twi_bus_grant(&bus, (uint32_t)now);
+            check(client != TWI_BUS_CLIENT_NONE, p_set, "nothing granted with requests pending");
+            if (client == TWI_BUS_CLIENT_NONE)
+            {
+                continue;
+            }
+
+            /* Clients were added in device order */
+            device_state_t * p_state = &p_states[client];
+            for (uint32_t i = 0; i < count; i++)
+            {
+                check(!p_states[i].pending || p_devices[i].priority <= p_devices[client].priority,
+                      p_set, "lower priority granted first");
+            }
+            uint64_t hold = window_us(&p_devices[client], freq_hz);
+            uint64_t wait = now - p_state->requested;
+            p_state->pending = false;
+            p_state->grants++;
+            p_state->wait_max = (wait > p_state->wait_max) ? wait : p_state->wait_max;
+            p_state->hold_total += hold;
+            busy += hold;
+            owner = client;
+            release_at = now + hold;
+        }
+    }
+
+    if (owner != TWI_BUS_CLIENT_NONE)
+    {
+        /* Count the window in progress up to the end, as the arbiter does */
+        busy -= release_at - end;
+    }
+
+    printf("# %s: %llu s at %u kHz, dispatch latency up to %u us\n", p_set,
+           (unsigned long long)(duration_us / 1000000), freq_hz / 1000, latency_max_us);
+    printf("  %-10s %4s %8s %8s %10s %10s %6s\n", "device", "prio", "window", "deadline", "wait avg", "wait max",
+           "misses");
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const twi_bus_client_t * p_client = &bus.clients[p_states[i].client];
+        const device_state_t * p_state = &p_states[i];
+        printf("  %-10s %4u %8u %8u %10llu %10u %6u\n", p_devices[i].p_name, p_devices[i].priority,
+               window_us(&p_devices[i], freq_hz), p_devices[i].within_us,
+               (unsigned long long)(p_client->grants ? p_client->wait_total_us / p_client->grants : 0),
+               p_client->wait_max_us, p_client->misses);
+
+        check(p_client->requests == p_state->requests, p_set, "request count");
+        check(p_client->grants == p_state->grants, p_set, "grant count");
+        check(p_client->misses == p_state->misses, p_set, "deadline miss count");
+        check(p_client->wait_max_us == p_state->wait_max, p_set, "wait max");
+        check(p_client->hold_total_us == p_state->hold_total - ((owner == i) ? window_us(&p_devices[i], freq_hz) : 0),
+              p_set, "hold total");
+    }
+
+    uint16_t utilization = twi_bus_utilization_permille(&bus, (uint32_t)end);
+    printf("  utilization %u.%u %%\n", utilization / 10, utilization % 10);
+    check(utilization == (uint16_t)((busy * 1000) / duration_us), p_set, "utilization");
+    return utilization;
+}
+
+int main(int argc, char ** argv)
+{
+    uint64_t duration_s = 2 * 3600;
+    uint32_t freq_hz = 100000;
+    uint32_t latency_max_us = 2000;     /* One MESH_RX handler */
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            duration_s = strtoull(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+        {
+            freq_hz = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+        {
+            latency_max_us = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-t <simulated s>] [-f <bus Hz>] [-l <max dispatch latency us>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    /* As on the sensor node (app_sensor_iaq.c), plus two devices sharing the bus */
+    const device_t nominal[DEVICES_MAX] =
+    {
+        { "zmod4410", 2, 1000000, 0, 0, 100000, twi_budget_zmod_cycle, TWI_BUDGET_ZMOD_CYCLE_COUNT, 0 },
+        { "sht4x", 1, 1000000, 0, 0, 500000, twi_budget_env_cycle, TWI_BUDGET_ENV_CYCLE_COUNT, 0 },
+        { "lps22", 1, 200000, 37000, 5000, 50000, m_lps22_xfers, 2, 0 },
+        { "eeprom", 0, 10000000, 3000, 100000, 2000000, m_eeprom_xfers, 1, 5000 },
+    };
+    device_state_t states[DEVICES_MAX];
+
+    (void)run("nominal", nominal, DEVICES_MAX, states, duration_s * 1000000, freq_hz, latency_max_us);
+    for (uint32_t i = 0; i < DEVICES_MAX; i++)
+    {
+        check(states[i].grants > 0, "nominal", "device never served");
+        check(states[i].misses == 0, "nominal", "deadline missed");
+    }
+
+    /* The EEPROM's window outlasts the pressure sensor's deadline */
+    device_t overload[DEVICES_MAX];
+    memcpy(overload, nominal, sizeof(overload));
+    overload[2].period_us = 50000;
+    overload[2].within_us = 20000;
+    overload[3].period_us = 1000000;
+    overload[3].extra_us = 60000;
+
+    (void)run("overload", overload, DEVICES_MAX, states, duration_s * 1000000, freq_hz, latency_max_us);
+    check(states[0].misses == 0, "overload", "highest priority missed a deadline");
+    check(states[2].misses > 0, "overload", "misses not counted");
+
+    if (m_failures > 0)
+    {
+        fprintf(stderr, "%u checks failed\n", m_failures);
+        return 1;
+    }
+    printf("twi_bus: all checks passed\n");
+    return 0;
+}